@@ -29,16 +29,42 @@
 #include <string>
 
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <time.h>
 
 #include <sys/types.h>
 #include <fcntl.h>
+#include <sys/ioctl.h>
+#ifdef KFS_OS_NAME_LINUX
+#   include <linux/fs.h>
+#   include <linux/fiemap.h>
+#endif
 
 namespace KFS
 {
 using std::string;
 
+static int64_t
+GetFileExtentCount(int fd)
+{
+#if defined(KFS_OS_NAME_LINUX) && defined(FS_IOC_FIEMAP)
+    // With zero extent count the kernel only returns the number of extents
+    // mapped. Preallocated, but not yet written extents are counted as well,
+    // therefore the number reflects the on disk layout.
+    struct fiemap map;
+    memset(&map, 0, sizeof(map));
+    map.fm_start        = 0;
+    map.fm_length       = FIEMAP_MAX_OFFSET;
+    map.fm_extent_count = 0;
+    return (ioctl(fd, FS_IOC_FIEMAP, &map) == 0 ?
+        int64_t(map.fm_mapped_extents) : int64_t(-1));
+#else
+    (void)fd;
+    return -1;
+#endif
+}
+
 bool IsValidChunkFile(
     const string&      dirname,
     const char*        filename,
@@ -52,7 +78,8 @@ bool IsValidChunkFile(
     int64_t&           outChunkSize,
     int64_t&           outFileSystemId,
     int&               outIoTimeSec,
-    bool&              outReadFlag)
+    bool&              outReadFlag,
+    int64_t*           outExtentCountPtr)
 {
     const int   kNumComponents = 3;
     long long   components[kNumComponents];
@@ -62,6 +89,9 @@ bool IsValidChunkFile(
     int         i;
 
     outReadFlag = false;
+    if (outExtentCountPtr) {
+        *outExtentCountPtr = -1;
+    }
     for (i = 0; i < kNumComponents; i++) {
         components[i] = strtoll(ptr, &end, 10);
         if (components[i] < 0) {
@@ -121,6 +151,9 @@ bool IsValidChunkFile(
         }
         const ssize_t rd = read(fd, chunkHeaderBuffer.GetPtr(),
             chunkHeaderBuffer.GetSize());
+        if (outExtentCountPtr && rd == chunkHeaderBuffer.GetSize()) {
+            *outExtentCountPtr = GetFileExtentCount(fd);
+        }
         close(fd);
         outIoTimeSec = time(0) - start;
         if (rd != chunkHeaderBuffer.GetSize()) {
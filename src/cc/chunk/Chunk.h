@@ -396,7 +396,8 @@ bool IsValidChunkFile(
     int64_t&           outChunkSize,
     int64_t&           outFileSystemId,
     int&               outIoTimeSec,
-    bool&              outReadFlag);
+    bool&              outReadFlag,
+    int64_t*           outExtentCountPtr = 0);
 
 static inline size_t GetChunkHeaderSize(kfsSeq_t chunkVersion) {
     return (chunkVersion < 0 ?
@@ -53,6 +53,7 @@
 #include <sys/time.h>
 #include <sys/resource.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/types.h>
 
@@ -128,6 +129,8 @@ struct ChunkManager::ChunkDirInfo : public ITimeout
           dirCountSpaceAvailable(0),
           pendingSpaceReservationSize(0),
           fileSystemId(-1),
+          sampledChunkFileCount(0),
+          sampledChunkExtentCount(0),
           supportsSpaceReservatonFlag(false),
           fsSpaceAvailInFlightFlag(false),
           checkDirFlightFlag(false),
@@ -161,7 +164,8 @@ struct ChunkManager::ChunkDirInfo : public ITimeout
           availableChunksCb(),
           evacuateChunksOp(&evacuateChunksCb),
           availableChunksOp(&availableChunksCb),
-          chunkDirInfoOp(*this)
+          chunkDirInfoOp(*this),
+          scrubber(*this)
     {
         fsSpaceAvailCb.SetHandler(this,
             &ChunkDirInfo::FsSpaceAvailDone);
@@ -241,6 +245,7 @@ struct ChunkManager::ChunkDirInfo : public ITimeout
         if (evacuateDoneFlag) {
             evacuateCompletedCount++;
         }
+        scrubber.Stop();
         if (notStableSpace > 0) {
             UpdateNotStableSpace(-notStableSpace);
         }
@@ -617,6 +622,10 @@ struct ChunkManager::ChunkDirInfo : public ITimeout
             "Canceled-count: "        << ctrs.mReqeustCanceledCount  << "\r\n"
             "Canceled-bytes: "        << ctrs.mReqeustCanceledBytes  << "\r\n"
             "File-system-id: "        << mChunkDir.fileSystemId << "\r\n"
+            "Sampled-chunk-files: "   << mChunkDir.sampledChunkFileCount <<
+                "\r\n"
+            "Sampled-chunk-extents: " << mChunkDir.sampledChunkExtentCount <<
+                "\r\n"
             ;
             mChunkDir.readCounters.Display(
                 "Read-",         "\r\n", inStream);
@@ -655,6 +664,68 @@ struct ChunkManager::ChunkDirInfo : public ITimeout
         Counters            mLastReadCounters;
         Counters            mLastWriteCounters;
     };
+    // Background chunk data scrubber. Reads stable chunks at the configured
+    // rate, and verifies the data checksums by the means of the regular read
+    // path, that reports checksum mismatches to the meta server. The reads
+    // are issued only when the disk queue has no more than the configured
+    // number of pending requests, in order to yield to the foreground io.
+    class Scrubber : public KfsCallbackObj
+    {
+    public:
+        Scrubber(
+            ChunkDirInfo& chunkDir)
+            : KfsCallbackObj(),
+              mChunkDir(chunkDir),
+              mReadOp(),
+              mChunkId(-1),
+              mChunkVersion(-1),
+              mOffset(0),
+              mByteCredit(0),
+              mLastRunTime(-1),
+              mInFlightFlag(false),
+              mStartingFlag(false)
+        {
+            mReadOp.clnt = this;
+            SET_HANDLER(this, &Scrubber::HandleDone);
+        }
+        void Run(int64_t nowUsec);
+        void Stop()
+        {
+            mChunkId     = -1;
+            mOffset      = 0;
+            mByteCredit  = 0;
+            mLastRunTime = -1;
+        }
+        int HandleDone(int code, void* data);
+    private:
+        enum { kMaxChunksToCheck = 64 };
+
+        ChunkDirInfo& mChunkDir;
+        ReadOp        mReadOp;
+        kfsChunkId_t  mChunkId;
+        int64_t       mChunkVersion;
+        int64_t       mOffset;
+        int64_t       mByteCredit;
+        int64_t       mLastRunTime;
+        bool          mInFlightFlag;
+        bool          mStartingFlag;
+
+        void StartNext()
+        {
+            if (mStartingFlag) {
+                return;
+            }
+            mStartingFlag = true;
+            while (! mInFlightFlag && Start())
+                {}
+            mStartingFlag = false;
+        }
+        bool Start();
+        static bool IsScrubbable(const ChunkInfoHandle& cih);
+    private:
+        Scrubber(const Scrubber&);
+        Scrubber& operator=(const Scrubber&);
+    };
 
     string                 dirname;
     bool                   bufferedIoFlag;
@@ -683,6 +754,8 @@ struct ChunkManager::ChunkDirInfo : public ITimeout
     ChunkDirInfo*          dirCountSpaceAvailable;
     int64_t                pendingSpaceReservationSize;
     int64_t                fileSystemId;
+    int64_t                sampledChunkFileCount;
+    int64_t                sampledChunkExtentCount;
     bool                   supportsSpaceReservatonFlag:1;
     bool                   fsSpaceAvailInFlightFlag:1;
     bool                   checkDirFlightFlag:1;
@@ -716,6 +789,7 @@ struct ChunkManager::ChunkDirInfo : public ITimeout
     EvacuateChunksOp       evacuateChunksOp;
     AvailableChunksOp      availableChunksOp;
     ChunkDirInfoOp         chunkDirInfoOp;
+    Scrubber               scrubber;
 
     enum ChunkListType
     {
@@ -2134,6 +2208,7 @@ ChunkManager::ChunkManager()
       mNullBlockChecksum(0),
       mCounters(),
       mDirChecker(),
+      mLocalReadServer(),
       mCleanupChunkDirsFlag(true),
       mStaleChunksDir("lost+found"),
       mDirtyChunksDir("dirty"),
@@ -2191,7 +2266,10 @@ ChunkManager::ChunkManager()
       mLogChunkServerCountersInterval(60),
       mLogChunkServerCountersLastTime(globalNetManager().Now() - 365 * 24 * 60 * 60),
       mLogChunkServerCountersLogLevel(MsgLogger::kLogLevelNOTICE),
-      mChunkHeaderBuffer()
+      mChunkHeaderBuffer(),
+      mScrubberMaxBytesPerSec(0),
+      mScrubberReadSize(1 << 20),
+      mScrubberMaxPendingIoRequests(2)
 {
     mDirChecker.SetInterval(180 * 1000);
     srand48((long)globalNetManager().Now());
@@ -2302,6 +2380,9 @@ ChunkManager::Shutdown()
     // Force meta server connection down first.
     gMetaServerSM.Shutdown();
     mDirChecker.Stop();
+    mLocalReadServer.Stop();
+    // Do not start new scrub reads from io completion.
+    mScrubberMaxBytesPerSec = 0;
     gClientManager.Shutdown();
     // Run delete queue before removing chunk table entries.
     RunStaleChunksQueue();
@@ -2410,6 +2491,18 @@ ChunkManager::SetParameters(const Properties& prop)
     mReadChecksumMismatchMaxRetryCount = prop.getValue(
         "chunkServer.readChecksumMismatchMaxRetryCount",
         mReadChecksumMismatchMaxRetryCount);
+    mScrubberMaxBytesPerSec = (int64_t)prop.getValue(
+        "chunkServer.scrubber.maxBytesPerSec",
+        (double)mScrubberMaxBytesPerSec);
+    mScrubberReadSize = prop.getValue(
+        "chunkServer.scrubber.readSize",
+        mScrubberReadSize);
+    mScrubberReadSize = (int)max(int64_t(CHECKSUM_BLOCKSIZE),
+        min(int64_t(CHUNKSIZE), (int64_t)mScrubberReadSize) /
+            CHECKSUM_BLOCKSIZE * CHECKSUM_BLOCKSIZE);
+    mScrubberMaxPendingIoRequests = prop.getValue(
+        "chunkServer.scrubber.maxPendingIoRequests",
+        mScrubberMaxPendingIoRequests);
     mRequireChunkHeaderChecksumFlag = prop.getValue(
         "chunkServer.requireChunkHeaderChecksum",
         mRequireChunkHeaderChecksumFlag ? 1 : 0) != 0;
@@ -2508,6 +2601,12 @@ ChunkManager::SetParameters(const Properties& prop)
     netManager.SetMaxAcceptsPerRead(prop.getValue(
         "chunkServer.net.maxAcceptsPerRead",
         netManager.GetMaxAcceptsPerRead()));
+    netManager.SetEdgeTriggered(prop.getValue(
+        "chunkServer.net.edgeTriggered",
+        netManager.IsEdgeTriggered() ? 1 : 0) != 0);
+    netManager.SetBusyPollUsec(prop.getValue(
+        "chunkServer.net.busyPollUsec",
+        netManager.GetBusyPollUsec()));
     const bool useOsResolverFlag = prop.getValue(
         "chunkServer.useOsResolver",
         netManager.GetResolverOsFlag() ? 1 : 0) != 0;
@@ -2519,6 +2618,7 @@ ChunkManager::SetParameters(const Properties& prop)
         netManager.GetResolverCacheExpiration());
     netManager.SetResolverParameters(
         useOsResolverFlag, maxCacheSize, resolverCacheExpiration);
+    Resolver::SetParameters("chunkServer.resolver", prop);
 
     DiskIo::SetParameters(prop);
     Replicator::SetParameters(prop);
@@ -2652,6 +2752,8 @@ ChunkManager::SetParameters(const Properties& prop)
     mDirChecker.SetFsIdPrefix(mFsIdFileNamePrefix);
     SetDirCheckerIoTimeout();
     ClientSM::SetParameters(prop);
+    KfsOp::SetParameters(prop);
+    mLocalReadServer.SetParameters(prop);
     SetStorageTiers(prop);
     SetBufferedIo(prop);
     string errMsg;
@@ -2940,7 +3042,9 @@ ChunkManager::Init(const vector<string>& chunkDirs, const Properties& prop)
     SetBufferedIo(prop);
 
     string errMsg;
-    if (! DiskIo::Init(prop, &errMsg)) {
+    // Numa nodes are parsed and validated by the client manager.
+    if (! DiskIo::Init(prop, &errMsg, gClientManager.GetNumaNodeCount(),
+            gClientManager.GetNumaNodes())) {
         KFS_LOG_STREAM_ERROR <<
             "DiskIo::Init failure: " << errMsg <<
         KFS_LOG_EOM;
@@ -4043,6 +4147,9 @@ ChunkManager::Start()
         gChunkManager.Shutdown();
         return false;
     }
+    // Short circuit local reads are an optimization, continue without these
+    // if the unix domain socket cannot be setup.
+    mLocalReadServer.Start();
     return true;
 }
 
@@ -5539,6 +5646,77 @@ ChunkManager::GetChecksum(kfsChunkId_t chunkId, int64_t chunkVersion,
         min(MAX_CHUNK_CHECKSUM_BLOCKS - 1, checksumBlock)];
 }
 
+int
+ChunkManager::OpenChunkForLocalRead(kfsChunkId_t chunkId, int64_t chunkVersion,
+    int64_t& handle, int& headerSize)
+{
+    handle     = -1;
+    headerSize = 0;
+    if (! mLocalReadServer.IsRunning()) {
+        return -ENOTSUP;
+    }
+    if (chunkVersion < 0) {
+        // Object store blocks have no chunk file.
+        return -EINVAL;
+    }
+    const bool kAddObjectBlockMappingFlag = false;
+    ChunkInfoHandle* const cih =
+        GetChunkInfoHandle(chunkId, chunkVersion, kAddObjectBlockMappingFlag);
+    if (! cih) {
+        return -EBADF;
+    }
+    // The client verifies checksums against the ones returned with the chunk
+    // meta data, therefore only stable chunks with the checksums loaded can
+    // be read directly.
+    if (cih->IsStale() || ! IsChunkStable(cih) || ! cih->IsChunkReadable() ||
+            ! cih->chunkInfo.AreChecksumsLoaded()) {
+        return -EAGAIN;
+    }
+    // The chunk file is normally open at this point, as the meta data was
+    // just read. Do not open the chunk file by its path name, as directory
+    // lookup might block the event loop thread. The disk queue descriptor is
+    // read write, and might have O_DIRECT set, therefore it can not be passed
+    // to the client as is. Re-open the file read only through the proc file
+    // system link of the duplicate of the disk queue descriptor. The link
+    // refers to the already open file, and the duplicate ensures that the
+    // descriptor does not get closed and re-used by the disk queue meanwhile.
+    if (! cih->IsFileOpen()) {
+        return -EAGAIN;
+    }
+#ifdef KFS_OS_NAME_LINUX
+    const int dfd = cih->dataFH->DupFd();
+    int       fd  = dfd;
+    if (0 <= dfd) {
+        char name[64];
+        snprintf(name, sizeof(name), "/proc/self/fd/%d", dfd);
+        fd = open(name, O_RDONLY);
+        fd = fd < 0 ? (0 < errno ? -errno : -EIO) : fd;
+        close(dfd);
+    }
+#else
+    const int fd = -ENOTSUP;
+#endif
+    if (fd < 0) {
+        mCounters.mLocalReadOpenErrorCount++;
+        KFS_LOG_STREAM_ERROR <<
+            "local read open: " << MakeChunkPathname(cih) <<
+            " error: " << QCUtils::SysError(-fd) <<
+        KFS_LOG_EOM;
+        return fd;
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    handle = mLocalReadServer.Add(fd);
+    if (handle <= 0) {
+        mCounters.mLocalReadOpenErrorCount++;
+        const int err = (int)handle;
+        handle = -1;
+        return (err < 0 ? err : -EIO);
+    }
+    headerSize = (int)GetChunkHeaderSize(chunkVersion);
+    mCounters.mLocalReadOpenCount++;
+    return 0;
+}
+
 vector<uint32_t>
 ChunkManager::GetChecksums(kfsChunkId_t chunkId, int64_t chunkVersion,
     int64_t offset, size_t numBytes)
@@ -6601,10 +6779,22 @@ ChunkManager::Timeout()
             ! gMetaServerSM.IsUp()) {
         LogChunkServerCounters();
     }
+    RunScrubbers();
     gLeaseClerk.Timeout();
     gAtomicRecordAppendManager.Timeout();
 }
 
+void
+ChunkManager::RunScrubbers()
+{
+    const int64_t now = microseconds();
+    for (ChunkDirs::iterator it = mChunkDirs.begin();
+            it != mChunkDirs.end();
+            ++it) {
+        it->scrubber.Run(now);
+    }
+}
+
 template<typename TT, typename WT> void
 ChunkManager::ScavengePendingWrites(
     time_t now, TT& table, WT& pendingWrites)
@@ -6877,6 +7067,8 @@ ChunkManager::StartDiskIo()
         it->totalSpace                  = it->usedSpace;
         it->supportsSpaceReservatonFlag =
             dit->second.mSupportsSpaceReservatonFlag;
+        it->sampledChunkFileCount       = dit->second.mSampledChunkFileCount;
+        it->sampledChunkExtentCount     = dit->second.mSampledChunkExtentCount;
         it->availableChunks.Clear();
         it->availableChunks.Swap(dit->second.mChunkInfos);
         string errMsg;
@@ -7888,6 +8080,182 @@ ChunkManager::ChunkDirInfo::StopEvacuation()
     return true;
 }
 
+void
+ChunkManager::ChunkDirInfo::Scrubber::Run(int64_t nowUsec)
+{
+    const int64_t rate = gChunkManager.mScrubberMaxBytesPerSec;
+    if (rate <= 0 || mChunkDir.availableSpace < 0 || ! mChunkDir.diskQueue) {
+        if (! mInFlightFlag) {
+            Stop();
+        }
+        return;
+    }
+    if (mLastRunTime < 0) {
+        mLastRunTime = nowUsec;
+    }
+    // Allow at most one second or one read worth of burst.
+    const int64_t elapsed = min(int64_t(1000 * 1000),
+        max(int64_t(0), nowUsec - mLastRunTime));
+    mLastRunTime = nowUsec;
+    mByteCredit  = min(max(rate, int64_t(gChunkManager.mScrubberReadSize)),
+        mByteCredit + elapsed * rate / (1000 * 1000));
+    StartNext();
+}
+
+bool
+ChunkManager::ChunkDirInfo::Scrubber::IsScrubbable(const ChunkInfoHandle& cih)
+{
+    return (
+        0 <= cih.chunkInfo.chunkVersion &&
+        0 < cih.chunkInfo.chunkSize &&
+        ! cih.IsStale() &&
+        cih.IsChunkReadable() &&
+        gChunkManager.IsChunkStable(&cih)
+    );
+}
+
+bool
+ChunkManager::ChunkDirInfo::Scrubber::Start()
+{
+    const int readSize = gChunkManager.mScrubberReadSize;
+    if (mByteCredit < readSize || gChunkManager.mScrubberMaxBytesPerSec <= 0 ||
+            mChunkDir.availableSpace < 0 || ! mChunkDir.diskQueue) {
+        return false;
+    }
+    int     freeRequestCount;
+    int     requestCount;
+    int64_t readBlockCount;
+    int64_t writeBlockCount;
+    int     blockSize;
+    if (! DiskIo::GetDiskQueuePendingCount(
+            mChunkDir.diskQueue,
+            freeRequestCount,
+            requestCount,
+            readBlockCount,
+            writeBlockCount,
+            blockSize)) {
+        return false;
+    }
+    if (gChunkManager.mScrubberMaxPendingIoRequests < requestCount) {
+        gChunkManager.mCounters.mScrubYieldCount++;
+        return false;
+    }
+    const bool       kAddObjectBlockMappingFlag = false;
+    ChunkInfoHandle* cih                        = 0;
+    if (0 <= mChunkId) {
+        cih = gChunkManager.GetChunkInfoHandle(
+            mChunkId, mChunkVersion, kAddObjectBlockMappingFlag);
+        if (! cih || &cih->GetDirInfo() != &mChunkDir ||
+                ! IsScrubbable(*cih) ||
+                cih->chunkInfo.chunkSize <= mOffset) {
+            cih      = 0;
+            mChunkId = -1;
+        }
+    }
+    if (! cih) {
+        // The scrubbed chunks are moved to the end of the list, therefore
+        // the chunks at the front of the list are the ones that were
+        // scrubbed, or added, least recently.
+        ChunkDirInfo::ChunkLists& list = mChunkDir.chunkLists[kChunkDirList];
+        for (int i = min(int(kMaxChunksToCheck), mChunkDir.chunkCount);
+                0 < i && (cih = ChunkDirList::Front(list));
+                i--) {
+            ChunkDirList::Remove(list, *cih);
+            ChunkDirList::PushBack(list, *cih);
+            if (IsScrubbable(*cih)) {
+                break;
+            }
+            cih = 0;
+        }
+        if (! cih) {
+            return false;
+        }
+        mChunkId      = cih->chunkInfo.chunkId;
+        mChunkVersion = cih->chunkInfo.chunkVersion;
+        mOffset       = 0;
+    }
+    mReadOp.chunkId      = mChunkId;
+    mReadOp.chunkVersion = mChunkVersion;
+    mReadOp.offset       = mOffset;
+    mReadOp.numBytes     = (size_t)min(int64_t(readSize),
+        cih->chunkInfo.chunkSize - mOffset);
+    mReadOp.numBytesIO   = 0;
+    mReadOp.retryCnt     = 0;
+    mReadOp.status       = 0;
+    mReadOp.statusMsg.clear();
+    mReadOp.checksum.clear();
+    mReadOp.dataBuf.Clear();
+    mReadOp.skipVerifyDiskChecksumFlag = false;
+    mByteCredit -= (int64_t)mReadOp.numBytes;
+    mInFlightFlag = true;
+    mReadOp.Execute();
+    return true;
+}
+
+int
+ChunkManager::ChunkDirInfo::Scrubber::HandleDone(int code, void* data)
+{
+    if (EVENT_CMD_DONE != code || &mReadOp != data || ! mInFlightFlag) {
+        die("scrubber: invalid completion");
+        return -1;
+    }
+    mInFlightFlag = false;
+    const int     status     = mReadOp.status;
+    const int64_t numBytesIO = max(ssize_t(0), mReadOp.numBytesIO);
+    mReadOp.diskIo.reset();
+    mReadOp.dataBuf.Clear();
+    mReadOp.checksum.clear();
+    ChunkManager::Counters& counters = gChunkManager.mCounters;
+    if (0 <= status) {
+        counters.mScrubByteCount += numBytesIO;
+        mOffset += numBytesIO;
+        if (numBytesIO < (int64_t)mReadOp.numBytes || numBytesIO <= 0) {
+            counters.mScrubChunkCount++;
+            KFS_LOG_STREAM_DEBUG <<
+                "scrub done:"
+                " dir: "     << mChunkDir.dirname <<
+                " chunk: "   << mChunkId <<
+                " version: " << mChunkVersion <<
+                " bytes: "   << mOffset <<
+            KFS_LOG_EOM;
+            mChunkId = -1;
+        }
+    } else if (-EAGAIN == status || -ESERVERBUSY == status) {
+        // Chunk closed, or server is busy; retry the same read later.
+        KFS_LOG_STREAM_DEBUG <<
+            "scrub read:"
+            " dir: "     << mChunkDir.dirname <<
+            " chunk: "   << mChunkId <<
+            " version: " << mChunkVersion <<
+            " offset: "  << mReadOp.offset <<
+            " status: "  << status <<
+            " "          << mReadOp.statusMsg <<
+        KFS_LOG_EOM;
+        mByteCredit = min(int64_t(0), mByteCredit);
+    } else {
+        // Checksum mismatch and io errors are reported to the meta server by
+        // the read path.
+        if (-EBADCKSUM == status) {
+            counters.mScrubChecksumErrorCount++;
+        } else {
+            counters.mScrubErrorCount++;
+        }
+        KFS_LOG_STREAM(-EBADVERS == status ?
+                MsgLogger::kLogLevelINFO : MsgLogger::kLogLevelERROR) <<
+            "scrub read failed:"
+            " dir: "     << mChunkDir.dirname <<
+            " chunk: "   << mChunkId <<
+            " version: " << mChunkVersion <<
+            " offset: "  << mReadOp.offset <<
+            " status: "  << status <<
+            " "          << mReadOp.statusMsg <<
+        KFS_LOG_EOM;
+        mChunkId = -1;
+    }
+    StartNext();
+    return 0;
+}
+
 void
 ChunkManager::MetaServerConnectionLost()
 {
@@ -7993,6 +8361,10 @@ ChunkManager::CheckChunkDirs()
                 it->dirLock                     = dit->second.mLockFdPtr;
                 it->supportsSpaceReservatonFlag =
                     dit->second.mSupportsSpaceReservatonFlag;
+                it->sampledChunkFileCount       =
+                    dit->second.mSampledChunkFileCount;
+                it->sampledChunkExtentCount     =
+                    dit->second.mSampledChunkExtentCount;
                 it->corruptedChunksCount        = 0;
                 it->lostChunksCount             = 0;
                 it->evacuateCheckIoErrorsCount  = 0;
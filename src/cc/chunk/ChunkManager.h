@@ -33,6 +33,7 @@
 #include "KfsOps.h"
 #include "DiskIo.h"
 #include "DirChecker.h"
+#include "LocalReadServer.h"
 
 #include "kfsio/ITimeout.h"
 #include "kfsio/CryptoKeys.h"
@@ -95,6 +96,13 @@ public:
         Counter mHelloResumeCount;
         Counter mHelloResumeFailedCount;
         Counter mPartialHelloResumeFailedCount;
+        Counter mScrubChunkCount;
+        Counter mScrubByteCount;
+        Counter mScrubChecksumErrorCount;
+        Counter mScrubErrorCount;
+        Counter mScrubYieldCount;
+        Counter mLocalReadOpenCount;
+        Counter mLocalReadOpenErrorCount;
 
         void Clear()
         {
@@ -116,6 +124,13 @@ public:
             mHelloResumeCount                    = 0;
             mHelloResumeFailedCount              = 0;
             mPartialHelloResumeFailedCount       = 0;
+            mScrubChunkCount                     = 0;
+            mScrubByteCount                      = 0;
+            mScrubChecksumErrorCount             = 0;
+            mScrubErrorCount                     = 0;
+            mScrubYieldCount                     = 0;
+            mLocalReadOpenCount                  = 0;
+            mLocalReadOpenErrorCount             = 0;
         }
     };
 
@@ -217,6 +232,20 @@ public:
         kfsChunkId_t chunkId, int64_t chunkVersion,
         bool addObjectBlockMappingFlag = true) const;
 
+    /// Open stable chunk file read only, and register the descriptor with
+    /// the local read server.
+    /// @param[out] handle  handle to exchange for the descriptor
+    /// @param[out] headerSize  chunk file header size
+    /// @retval 0 on success; negative error code otherwise
+    int OpenChunkForLocalRead(kfsChunkId_t chunkId, int64_t chunkVersion,
+        int64_t& handle, int& headerSize);
+    const string& GetLocalReadSocketPath() const {
+        return mLocalReadServer.GetSocketPath();
+    }
+    void GetLocalReadCounters(int64_t& passedCount, int64_t& expiredCount) {
+        mLocalReadServer.GetCounters(passedCount, expiredCount);
+    }
+
     /// Given a byte range, return the checksums for that range.
     vector<uint32_t> GetChecksums(kfsChunkId_t chunkId,
         int64_t chunkVersion, int64_t offset, size_t numBytes);
@@ -940,6 +969,7 @@ private:
 
     Counters   mCounters;
     DirChecker mDirChecker;
+    LocalReadServer mLocalReadServer;
     bool       mCleanupChunkDirsFlag;
     string     mStaleChunksDir;
     string     mDirtyChunksDir;
@@ -1017,6 +1047,12 @@ private:
 
     ChunkHeaderBuffer           mChunkHeaderBuffer;
 
+    // Background chunk data scrubber parameters, the scrubber runs in each
+    // chunk directory, see ChunkDirInfo::Scrubber.
+    int64_t                     mScrubberMaxBytesPerSec;
+    int                         mScrubberReadSize;
+    int                         mScrubberMaxPendingIoRequests;
+
     ChunkManager();
     ~ChunkManager();
 
@@ -1039,6 +1075,7 @@ private:
 
     void CheckChunkDirs();
     void GetFsSpaceAvailable();
+    void RunScrubbers();
 
     string MakeChunkPathname(const string& chunkdir, kfsFileId_t fid,
         kfsChunkId_t chunkId, kfsSeq_t chunkVersion, const string& subDir);
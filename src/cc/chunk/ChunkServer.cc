@@ -50,7 +50,8 @@ ChunkServer::ChunkServer()
       mRemoteSyncers(),
       mMutex(0),
       mWatchdog(),
-      mNetManagerWatcher("main", globalNetManager())
+      mNetManagerWatcher("main", globalNetManager()),
+      mMetricsExporter(globalNetManager(), "qfs_chunk_")
 {
 }
 
@@ -60,7 +61,8 @@ ChunkServer::Init(
     bool                  ipV6OnlyFlag,
     const string&         serverIp,
     int                   threadCount,
-    int                   firstCpuIdx)
+    int                   firstCpuIdx,
+    const vector<int>&    numaNodes)
 {
     if (clientListener.port < 0) {
         KFS_LOG_STREAM_FATAL <<
@@ -100,7 +102,9 @@ ChunkServer::Init(
                 ipV6OnlyFlag,
                 threadCount,
                 firstCpuIdx,
-                mMutex) ||
+                mMutex,
+                (int)numaNodes.size(),
+                numaNodes.empty() ? 0 : &numaNodes[0]) ||
             gClientManager.GetPort() <= 0) {
         KFS_LOG_STREAM_FATAL <<
             "failed to bind acceptor to: " << clientListener <<
@@ -156,10 +160,12 @@ ChunkServer::MainLoop(
     assert(! mMutex || ! ClientThread::GetCurrentClientThreadPtr());
     SetParameters(props);
     if (! gChunkManager.Init(chunkDirs, props)) {
+        mMetricsExporter.Shutdown();
         gClientManager.Shutdown();
         return false;
     }
     if (gChunkManager.Restart() != 0 || ! gChunkManager.Start()) {
+        mMetricsExporter.Shutdown();
         gClientManager.Shutdown();
         return false;
     }
@@ -167,6 +173,7 @@ ChunkServer::MainLoop(
         KFS_LOG_STREAM_FATAL <<
             "failed to start acceptor on port: " << gClientManager.GetPort() <<
         KFS_LOG_EOM;
+        mMetricsExporter.Shutdown();
         gClientManager.Shutdown();
         return false;
     }
@@ -183,6 +190,7 @@ ChunkServer::MainLoop(
         mWatchdog.Stop();
         mWatchdog.Unregister(mNetManagerWatcher);
     }
+    mMetricsExporter.Shutdown();
     Replicator::CancelAll();
     gClientManager.Stop();
     mRemoteSyncers.ReleaseAllServers();
@@ -29,6 +29,7 @@
 
 #include "common/kfsdecls.h"
 #include "kfsio/NetManagerWatcher.h"
+#include "kfsio/MetricsExporter.h"
 #include "RemoteSyncSM.h"
 
 #include <vector>
@@ -50,7 +51,8 @@ public:
         bool                  ipV6OnlyFlag,
         const string&         serverIp,
         int                   threadCount,
-        int                   firstCpuIdx);
+        int                   firstCpuIdx,
+        const vector<int>&    numaNodes);
     bool MainLoop(
         const vector<string>& chunkDirs,
         const Properties&     props);
@@ -94,8 +96,12 @@ public:
     Watchdog& GetWatchdog() {
         return mWatchdog;
     }
+    const NetManagerWatcher& GetNetManagerWatcher() const {
+        return mNetManagerWatcher;
+    }
     void SetParameters(const Properties& props) {
         mWatchdog.SetParameters("chunkServer.watchdog.", props);
+        mMetricsExporter.SetParameters("chunkServer.metrics.", props);
     }
     const ServerLocation& GetConfigLocation() const {
         return mUpdateServerIpFlag ? mLocation : mConfigLocation;
@@ -111,6 +117,7 @@ private:
     QCMutex*           mMutex;
     Watchdog           mWatchdog;
     NetManagerWatcher  mNetManagerWatcher;
+    MetricsExporter    mMetricsExporter;
 
     ChunkServer();
     ~ChunkServer()
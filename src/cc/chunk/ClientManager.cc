@@ -35,6 +35,7 @@
 #include "kfsio/DelegationToken.h"
 #include "kfsio/Globals.h"
 
+#include "qcdio/QCThread.h"
 #include "qcdio/QCUtils.h"
 #include "qcdio/qcdebug.h"
 #include "qcdio/qcstutils.h"
@@ -185,9 +186,17 @@ ClientManager::ClientManager()
       mCurThreadIdx(0),
       mFirstClientThreadIndex(0),
       mThreadCount(0),
-      mThreadsPtr(0)
+      mThreadsPtr(0),
+      mNumaNodeCount(0)
 {
     mCounters.Clear();
+    for (int i = 0; i < kMaxNumaNodes; i++) {
+        mNumaNodes[i]        = -1;
+        mNumaCurThreadIdx[i] = 0;
+    }
+    for (int i = 0; i < kMaxNumaCpus; i++) {
+        mCpuNumaNodeIdx[i] = -1;
+    }
 }
 
 ClientManager::~ClientManager()
@@ -204,14 +213,49 @@ ClientManager::BindAcceptor(
     bool                  ipV6OnlyFlag,
     int                   inThreadCount,
     int                   inFirstCpuIdx,
-    QCMutex*&             outMutexPtr)
+    QCMutex*&             outMutexPtr,
+    int                   inNumaNodeCount,
+    const int*            inNumaNodesPtr)
 {
     Stop();
     delete mAcceptorPtr;
     delete [] mThreadsPtr;
-    mAcceptorPtr = 0;
-    mThreadsPtr  = 0;
-    mThreadCount = 0;
+    mAcceptorPtr   = 0;
+    mThreadsPtr    = 0;
+    mThreadCount   = 0;
+    mNumaNodeCount = 0;
+    for (int i = 0; i < kMaxNumaCpus; i++) {
+        mCpuNumaNodeIdx[i] = -1;
+    }
+    // The validated node list is also used by the disk io buffer pool, keep
+    // it regardless of the client thread count.
+    if (inNumaNodesPtr) {
+        for (int i = 0; i < inNumaNodeCount; i++) {
+            const int theNode = inNumaNodesPtr[i];
+            if (kMaxNumaNodes <= mNumaNodeCount) {
+                KFS_LOG_STREAM_ERROR <<
+                    "numa node: " << theNode <<
+                    " ignored, max number of nodes: " << kMaxNumaNodes <<
+                KFS_LOG_EOM;
+                continue;
+            }
+            const QCThread::CpuAffinity theCpus =
+                QCThread::GetNumaNodeCpus(theNode);
+            if (theCpus == QCThread::CpuAffinity::None()) {
+                KFS_LOG_STREAM_ERROR <<
+                    "numa node: " << theNode << " ignored, no cpus" <<
+                KFS_LOG_EOM;
+                continue;
+            }
+            for (int k = 0; k < kMaxNumaCpus; k++) {
+                if (theCpus.IsSet(k) && mCpuNumaNodeIdx[k] < 0) {
+                    mCpuNumaNodeIdx[k] = (signed char)mNumaNodeCount;
+                }
+            }
+            mNumaCurThreadIdx[mNumaNodeCount] = mNumaNodeCount;
+            mNumaNodes[mNumaNodeCount++]      = theNode;
+        }
+    }
     const bool kBindOnlyFlag = true;
     mAcceptorPtr = new Acceptor(
         globalNetManager(), clientListener, ipV6OnlyFlag, this, kBindOnlyFlag);
@@ -220,7 +264,8 @@ ClientManager::BindAcceptor(
         static QCMutex sOpsMutex;
         KfsOp::SetMutex(&sOpsMutex);
         mThreadsPtr  = ClientThread::CreateThreads(
-            inThreadCount, inFirstCpuIdx, outMutexPtr);
+            inThreadCount, inFirstCpuIdx, outMutexPtr,
+            mNumaNodeCount, mNumaNodes);
         mThreadCount = mThreadsPtr ? inThreadCount : 0;
     } else {
         outMutexPtr = 0;
@@ -263,7 +308,13 @@ ClientManager::CreateKfsCallbackObj(
     }
     mCounters.mAcceptCount++;
     mCounters.mClientCount++;
-    ClientThread* const theThreadPtr = GetNextClientThreadPtr();
+    ClientThread* theThreadPtr = 0;
+    if (0 < mNumaNodeCount && 0 < mThreadCount) {
+        theThreadPtr = GetNumaClientThreadPtr(*inConnPtr);
+    }
+    if (! theThreadPtr) {
+        theThreadPtr = GetNextClientThreadPtr();
+    }
     ClientSM*     const theClientPtr = new ClientSM(inConnPtr, theThreadPtr);
     if (! mAuth.Setup(*inConnPtr, *theClientPtr)) {
         delete theClientPtr;
@@ -359,6 +410,43 @@ ClientManager::GetNextClientThreadPtr()
     return theRetPtr;
 }
 
+    ClientThread*
+ClientManager::GetNumaClientThreadPtr(
+    const NetConnection& inConn)
+{
+    // Client thread i is bound to the node i % mNumaNodeCount, pick the next
+    // thread bound to the node where the connection's receive processing runs
+    // in order to keep the socket buffers, io buffers, and the thread on the
+    // same node.
+    const int theCpu     = inConn.GetIncomingCpu();
+    const int theNodeIdx = (0 <= theCpu && theCpu < kMaxNumaCpus) ?
+        mCpuNumaNodeIdx[theCpu] : -1;
+    if (theNodeIdx < 0 || mNumaNodeCount <= theNodeIdx) {
+        mCounters.mNumaUnknownAcceptCount++;
+        return 0;
+    }
+    const int theFirst = max(mFirstClientThreadIndex, 0);
+    int&      theIdx   = mNumaCurThreadIdx[theNodeIdx];
+    for (int i = 0; i < 2; i++) {
+        if (theIdx < theFirst) {
+            theIdx += ((theFirst - theIdx + mNumaNodeCount - 1) /
+                mNumaNodeCount) * mNumaNodeCount;
+        }
+        if (theIdx < mThreadCount) {
+            break;
+        }
+        theIdx = theNodeIdx;
+    }
+    if (theIdx < theFirst || mThreadCount <= theIdx) {
+        mCounters.mNumaUnknownAcceptCount++;
+        return 0;
+    }
+    mCounters.mNumaNodeAcceptCount[theNodeIdx]++;
+    ClientThread* const theRetPtr = mThreadsPtr + theIdx;
+    theIdx += mNumaNodeCount;
+    return theRetPtr;
+}
+
     ClientThread*
 ClientManager::GetClientThread(
     int inIdx)
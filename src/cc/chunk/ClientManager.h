@@ -44,6 +44,7 @@ class ClientThread;
 // Client connection listener.
 class ClientManager : public IAcceptorOwner {
 public:
+    enum { kMaxNumaNodes = 8 };
     struct Counters
     {
         typedef int64_t Counter;
@@ -72,6 +73,9 @@ public:
         Counter mWaitTimeExceededCount;
         Counter mDiscardedBytesCount;
         Counter mOverClientLimitCount;
+        Counter mCutThroughWriteCount;
+        Counter mNumaNodeAcceptCount[kMaxNumaNodes];
+        Counter mNumaUnknownAcceptCount;
 
         void Clear()
         {
@@ -99,6 +103,11 @@ public:
             mWaitTimeExceededCount      = 0;
             mDiscardedBytesCount        = 0;
             mOverClientLimitCount       = 0;
+            mCutThroughWriteCount       = 0;
+            for (int i = 0; i < kMaxNumaNodes; i++) {
+                mNumaNodeAcceptCount[i] = 0;
+            }
+            mNumaUnknownAcceptCount     = 0;
         }
     };
     bool BindAcceptor(
@@ -106,7 +115,9 @@ public:
         bool                  ipV6OnlyFlag,
         int                   inThreadCount,
         int                   inFirstCpuIdx,
-        QCMutex*&             outMutexPtr);
+        QCMutex*&             outMutexPtr,
+        int                   inNumaNodeCount = 0,
+        const int*            inNumaNodesPtr  = 0);
     bool StartListening();
     virtual KfsCallbackObj* CreateKfsCallbackObj(
         NetConnectionPtr& inConnPtr);
@@ -139,6 +150,8 @@ public:
         { mCounters.mIdleTimeoutCount++; }
     void WaitTimeExceeded()
         { mCounters.mWaitTimeExceededCount++; }
+    void CutThroughWriteStarted()
+        { mCounters.mCutThroughWriteCount++; }
     void RequestDone(
         int64_t      inRequestTimeMicroSecs,
         const KfsOp& inOp)
@@ -203,6 +216,14 @@ public:
     }
     int GetClientThreadCount() const
         { return mThreadCount; }
+    int GetNumaNodeCount() const
+        { return mNumaNodeCount; }
+    int GetNumaNode(
+        int inIdx) const
+        { return ((0 <= inIdx && inIdx < mNumaNodeCount) ?
+            mNumaNodes[inIdx] : -1); }
+    const int* GetNumaNodes() const
+        { return mNumaNodes; }
     const QCMutex* GetMutexPtr() const;
     ClientThread* GetCurrentClientThreadPtr();
     ClientThread* GetNextClientThreadPtr();
@@ -219,6 +240,7 @@ public:
         { return mMaxClientCount; }
 private:
     class Auth;
+    enum { kMaxNumaCpus = 64 };
 
     Acceptor*     mAcceptorPtr;
     int           mIoTimeoutSec;
@@ -230,6 +252,13 @@ private:
     int           mFirstClientThreadIndex;
     int           mThreadCount;
     ClientThread* mThreadsPtr;
+    int           mNumaNodeCount;
+    int           mNumaNodes[kMaxNumaNodes];
+    int           mNumaCurThreadIdx[kMaxNumaNodes];
+    signed char   mCpuNumaNodeIdx[kMaxNumaCpus];
+
+    ClientThread* GetNumaClientThreadPtr(
+        const NetConnection& inConn);
 
     ClientManager();
     ~ClientManager();
@@ -69,6 +69,7 @@ using std::list;
 
 // KFS client protocol state machine implementation.
 
+int      ClientSM::sCutThroughFwdSize        = 0;
 int      ClientSM::sMaxCmdHeaderReadAhead    = 1 << 10;
 bool     ClientSM::sTraceRequestResponseFlag = false;
 bool     ClientSM::sEnforceMaxWaitFlag       = true;
@@ -189,6 +190,12 @@ ClientSM::SetParameters(const Properties& prop)
     sMaxCmdHeaderReadAhead = prop.getValue(
         "chunkServer.clientSM.maxCmdHeaderReadAhead",
         sMaxCmdHeaderReadAhead);
+    const int cutThroughFwdSize = prop.getValue(
+        "chunkServer.clientSM.cutThroughForwardSize",
+        sCutThroughFwdSize);
+    sCutThroughFwdSize = cutThroughFwdSize <= 0 ? 0 : max(
+        (int)CHECKSUM_BLOCKSIZE,
+        cutThroughFwdSize - cutThroughFwdSize % (int)CHECKSUM_BLOCKSIZE);
 }
 
 ClientSM::ClientSM(
@@ -504,8 +511,12 @@ ClientSM::HandleRequest(int code, void* data)
                 PutAndResetDevBufferManager(*mCurOp, GetWaitingForByteCount());
                 CancelRequest();
             }
-            delete mCurOp;
-            mCurOp = 0;
+            if (mCurOp->op != CMD_WRITE_PREPARE ||
+                    ! static_cast<WritePrepareOp*>(
+                        mCurOp)->IsCutThroughInFlight()) {
+                delete mCurOp;
+                mCurOp = 0;
+            }
         }
         break;
 
@@ -543,6 +554,25 @@ ClientSM::HandleRequest(int code, void* data)
             // if there are any disk ops, wait for the ops to finish
             mNetConnection->SetOwningKfsCallbackObj(0);
             mHandleTerminateFlag = true;
+            if (mCurOp && mCurOp->op == CMD_WRITE_PREPARE &&
+                    static_cast<WritePrepareOp*>(
+                        mCurOp)->IsCutThroughInFlight()) {
+                // Partially forwarded write prepare: the forwarded op has to
+                // complete before the op can be deleted, therefore fail the
+                // op and wait for its completion in the terminate handler.
+                WritePrepareOp* const op =
+                    static_cast<WritePrepareOp*>(mCurOp);
+                mCurOp = 0;
+                op->clientSMFlag       = true;
+                op->clnt               = this;
+                op->bufferBytes.mCount = 0;
+                if (IsDependingOpType(*op)) {
+                    mOps.push_back(op);
+                }
+                mInFlightOpCount++;
+                gChunkServer.OpInserted();
+                op->CutThroughAbort();
+            }
             assert(0 <= mInFlightOpCount);
             if (mInFlightOpCount <= 0) {
                 mRecursionCnt--;
@@ -753,10 +783,16 @@ ClientSM::GetWriteOp(KfsOp& op, int align, int numBytes,
     }
     if (nAvail < numBytes) {
         mNetConnection->SetMaxReadAhead(numBytes - nAvail);
-        SetReceiveContent(numBytes, op.op == CMD_WRITE_PREPARE);
+        if (CutThroughForward(op, iobuf, nAvail, numBytes)) {
+            SetReceiveContentCutThrough(numBytes, sCutThroughFwdSize,
+                static_cast<const WritePrepareOp&>(op).cutThroughFwdBytes);
+        } else {
+            SetReceiveContent(numBytes, op.op == CMD_WRITE_PREPARE);
+        }
         // we couldn't process the command...so, wait
         return false;
     }
+    CutThroughForward(op, iobuf, nAvail, numBytes);
     ioOpBuf.Clear();
     if (nAvail != numBytes) {
         assert(nAvail > numBytes);
@@ -772,6 +808,47 @@ ClientSM::GetWriteOp(KfsOp& op, int align, int numBytes,
     return true;
 }
 
+///
+/// Forward write prepare data received so far to the next chunk server in
+/// the synchronous replication chain, instead of waiting for the remaining
+/// data to arrive. The data is forwarded in chunks of at least
+/// sCutThroughFwdSize bytes rounded down to the checksum block size, the
+/// remaining data is forwarded once all data is received.
+/// @retval true if cut through forwarding is in flight, or might be started
+/// once more data is received.
+///
+bool
+ClientSM::CutThroughForward(KfsOp& op, IOBuffer& iobuf, int nAvail,
+    int numBytes)
+{
+    if (op.op != CMD_WRITE_PREPARE || op.status < 0 ||
+            sCutThroughFwdSize <= 0 || numBytes <= sCutThroughFwdSize) {
+        return false;
+    }
+    WritePrepareOp& wop = static_cast<WritePrepareOp&>(op);
+    if (wop.cutThroughFwdBytes < 0) {
+        return false;
+    }
+    if (numBytes <= nAvail) {
+        return (wop.IsCutThroughInFlight() &&
+            wop.CutThroughForward(iobuf, numBytes));
+    }
+    if (wop.cutThroughFwdBytes + sCutThroughFwdSize <= nAvail) {
+        const bool startFlag = ! wop.IsCutThroughInFlight();
+        if (startFlag) {
+            // Peer lookup requires client state machine.
+            wop.clientSMFlag = true;
+            wop.clnt         = this;
+        }
+        if (wop.CutThroughForward(
+                    iobuf, nAvail - nAvail % (int)CHECKSUM_BLOCKSIZE) &&
+                startFlag) {
+            gClientManager.CutThroughWriteStarted();
+        }
+    }
+    return (0 <= wop.cutThroughFwdBytes);
+}
+
 bool
 ClientSM::FailIfExceedsWait(
     BufferManager&         bufMgr,
@@ -1416,6 +1493,12 @@ ClientSM::CheckAccess(KfsClientChunkOp& op)
     return true;
 }
 
+bool
+ClientSM::IsLocalPeer() const
+{
+    return (mNetConnection && mNetConnection->IsLocalPeer());
+}
+
 bool
 ClientSM::CheckAccess(ChunkAccessRequestOp& op)
 {
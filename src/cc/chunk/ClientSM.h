@@ -82,6 +82,9 @@ protected:
           mFirstChecksumBlockLen(CHECKSUM_BLOCKSIZE),
           mReceiveByteCount(-1),
           mReceivedHeaderLen(0),
+          mChecksumByteCount(0),
+          mCutThroughFwdSize(0),
+          mCutThroughFwdPos(0),
           mRpcFormat(kRpcFormatUndef),
           mGrantedFlag(false),
           mReceiveOpFlag(false),
@@ -96,6 +99,9 @@ protected:
         mFirstChecksumBlockLen = CHECKSUM_BLOCKSIZE;
         mReceiveByteCount      = -1;
         mReceivedHeaderLen     = 0;
+        mChecksumByteCount     = 0;
+        mCutThroughFwdSize     = 0;
+        mCutThroughFwdPos      = 0;
         mReceiveOpFlag         = false;
         mComputeChecksumFlag   = false;
         mReceivedOpPtr         = 0;
@@ -124,6 +130,27 @@ protected:
         mComputeChecksumFlag   =
             0 <= mReceiveByteCount && inComputeChecksumFlag;
     }
+    // Same as SetReceiveContent() with checksum computation, except that the
+    // client is also invoked every time when at least inFwdSize bytes past
+    // inFwdPos are received, in order to forward the data received so far.
+    // The checksums of the complete blocks received are computed
+    // incrementally, and preserved across invocations with the same length.
+    void SetReceiveContentCutThrough(
+        int inLength,
+        int inFwdSize,
+        int inFwdPos)
+    {
+        if (! mClientThreadPtr) {
+            return;
+        }
+        if (mReceiveByteCount != inLength || ! mComputeChecksumFlag ||
+                mCutThroughFwdSize <= 0) {
+            const bool kComputeChecksumFlag = true;
+            SetReceiveContent(inLength, kComputeChecksumFlag);
+        }
+        mCutThroughFwdSize = inFwdSize;
+        mCutThroughFwdPos  = inFwdPos;
+    }
     RpcFormat& GetRpcFormat()
         { return mRpcFormat; }
     KfsOp* GetReceivedOp() const
@@ -156,6 +183,9 @@ private:
     uint32_t               mFirstChecksumBlockLen;
     int                    mReceiveByteCount;
     int                    mReceivedHeaderLen;
+    int                    mChecksumByteCount;
+    int                    mCutThroughFwdSize;
+    int                    mCutThroughFwdPos;
     RpcFormat              mRpcFormat;
     bool                   mGrantedFlag:1;
     bool                   mReceiveOpFlag:1;
@@ -176,6 +206,10 @@ private:
     inline static const NetConnectionPtr& GetConnection(
         const ClientSM& inClient);
     inline ClientSM& GetClient();
+    void AppendChecksums(
+        const IOBuffer& inBuf,
+        int             inEndPos,
+        bool            inLastBlockFlag);
 private:
     ClientThreadListEntry(
         const ClientThreadListEntry& inEntry);
@@ -255,6 +289,7 @@ public:
     bool CheckAccess(KfsOp& op);
     bool CheckAccess(KfsClientChunkOp& op);
     bool CheckAccess(ChunkAccessRequestOp& op);
+    bool IsLocalPeer() const;
     const DelegationToken& GetDelegationToken() const
         { return mDelegationToken; }
     const string& GetSessionKey() const
@@ -388,6 +423,7 @@ private:
     string                     mSessionKey;
     bool                       mHandleTerminateFlag;
 
+    static int                 sCutThroughFwdSize;
     static int                 sMaxCmdHeaderReadAhead;
     static bool                sTraceRequestResponseFlag;
     static bool                sEnforceMaxWaitFlag;
@@ -415,6 +451,8 @@ private:
     bool Discard(IOBuffer& iobuf);
     bool GetWriteOp(KfsOp& op, int align, int numBytes, IOBuffer& iobuf,
         IOBuffer& ioOpBuf, bool forwardFlag);
+    bool CutThroughForward(KfsOp& op, IOBuffer& iobuf, int nAvail,
+        int numBytes);
     string GetPeerName();
     int HandleRequestSelf(int code, void* data);
     int HandleGranted();
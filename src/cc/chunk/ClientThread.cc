@@ -48,6 +48,7 @@
 namespace KFS
 {
 using std::ostringstream;
+using std::min;
 using libkfsio::globalNetManager;
 
     inline int
@@ -86,6 +87,32 @@ ClientThreadListEntry::GetClient()
     return *static_cast<ClientSM*>(this);
 }
 
+    void
+ClientThreadListEntry::AppendChecksums(
+    const IOBuffer& inBuf,
+    int             inEndPos,
+    bool            inLastBlockFlag)
+{
+    if (mChecksumByteCount <= 0) {
+        mChecksum = kKfsNullChecksum;
+        mBlocksChecksums.clear();
+    }
+    while (mChecksumByteCount < inEndPos) {
+        const int theBlockLen = mChecksumByteCount <= 0 ?
+            mFirstChecksumBlockLen : (int)CHECKSUM_BLOCKSIZE;
+        const int theLen      =
+            min(theBlockLen, inEndPos - mChecksumByteCount);
+        if (theLen < theBlockLen && ! inLastBlockFlag) {
+            break;
+        }
+        const uint32_t theChecksum = ComputeBlockChecksumAt(
+            &inBuf, mChecksumByteCount, theLen);
+        mBlocksChecksums.push_back(theChecksum);
+        mChecksum = ChecksumBlocksCombine(mChecksum, theChecksum, theLen);
+        mChecksumByteCount += theLen;
+    }
+}
+
     inline bool
 ClientThreadRemoteSyncListEntry::Enqueue(
     RemoteSyncSM& inSyncSM,
@@ -196,6 +223,9 @@ public:
           mResolverCacheExpiration(mNetManager.GetResolverCacheExpiration()),
           mUseOsResolverFlag(mNetManager.GetResolverOsFlag()),
           mResolverUpdateParamsFlag(false),
+          mEdgeTriggeredFlag(mNetManager.IsEdgeTriggered()),
+          mBusyPollUsec(mNetManager.GetBusyPollUsec()),
+          mNetUpdateParamsFlag(false),
           mWakeupCnt(0),
           mOuter(inOuter),
           mNetManagerWatcher("client", mNetManager)
@@ -250,7 +280,7 @@ public:
     bool IsStarted() const
         { return mThread.IsStarted(); }
     void Start(
-        int inCpuIndex)
+        QCThread::CpuAffinity inAffinity)
     {
         QCASSERT(GetMutex().IsOwned());
         if (! IsStarted()) {
@@ -261,9 +291,7 @@ public:
                 this,
                 kStackSize,
                 "ClientThread",
-                inCpuIndex < 0 ?
-                    QCThread::CpuAffinity::None() :
-                    QCThread::CpuAffinity(inCpuIndex)
+                inAffinity
             );
         }
     }
@@ -299,6 +327,11 @@ public:
                 mResolverCacheSize, mResolverCacheExpiration);
             mResolverUpdateParamsFlag = false;
         }
+        if (mNetUpdateParamsFlag) {
+            mNetManager.SetEdgeTriggered(mEdgeTriggeredFlag);
+            mNetManager.SetBusyPollUsec(mBusyPollUsec);
+            mNetUpdateParamsFlag = false;
+        }
         ClientThreadListEntry* theAddQueuePtr[kDispatchQueueCount];
         DispatchQueue::Init(theAddQueuePtr);
         DispatchQueue::PushBackList(theAddQueuePtr, mAddQueuePtr);
@@ -431,6 +464,23 @@ public:
                         mParseBuffer) != 0) {
                     theEntry.ReceiveClear();
                 }
+            } else if (0 < theEntry.mCutThroughFwdSize &&
+                    theEntry.mComputeChecksumFlag) {
+                // Compute checksums of the complete blocks received so far
+                // outside of the mutex, and invoke the client to forward
+                // the data to the next server in the replication chain.
+                const int theAvail = theBuf.BytesConsumable();
+                const bool kLastBlockFlag = true;
+                if (theAvail < theEntry.mReceiveByteCount) {
+                    theEntry.AppendChecksums(theBuf, theAvail, ! kLastBlockFlag);
+                    if (theAvail < theEntry.mCutThroughFwdPos +
+                            theEntry.mCutThroughFwdSize) {
+                        return 0;
+                    }
+                } else {
+                    theEntry.AppendChecksums(
+                        theBuf, theEntry.mReceiveByteCount, kLastBlockFlag);
+                }
             } else if (0 <= theEntry.mReceiveByteCount) {
                 if (theBuf.BytesConsumable() < theEntry.mReceiveByteCount) {
                     return 0;
@@ -532,6 +582,14 @@ public:
                 globalNetManager().GetResolverCacheExpiration();
             mResolverUpdateParamsFlag = true;
         }
+        if (mEdgeTriggeredFlag != globalNetManager().IsEdgeTriggered()) {
+            mEdgeTriggeredFlag = globalNetManager().IsEdgeTriggered();
+            mNetUpdateParamsFlag = true;
+        }
+        if (mBusyPollUsec != globalNetManager().GetBusyPollUsec()) {
+            mBusyPollUsec = globalNetManager().GetBusyPollUsec();
+            mNetUpdateParamsFlag = true;
+        }
     }
     static ClientThread* GetCurrentClientThreadPtr()
     {
@@ -566,6 +624,9 @@ private:
     int                    mResolverCacheExpiration;
     bool                   mUseOsResolverFlag;
     bool                   mResolverUpdateParamsFlag;
+    bool                   mEdgeTriggeredFlag;
+    int                    mBusyPollUsec;
+    bool                   mNetUpdateParamsFlag;
     volatile int           mWakeupCnt;
     ClientThread&          mOuter;
     NetManagerWatcher      mNetManagerWatcher;
@@ -894,9 +955,11 @@ ClientThread::GetCurrentClientThreadPtr()
 
     /* static */ ClientThread*
 ClientThread::CreateThreads(
-    int       inThreadCount,
-    int       inFirstCpuIdx,
-    QCMutex*& outMutexPtr)
+    int        inThreadCount,
+    int        inFirstCpuIdx,
+    QCMutex*&  outMutexPtr,
+    int        inNumaNodeCount,
+    const int* inNumaNodesPtr)
 {
     if (inThreadCount <= 0) {
         outMutexPtr = 0;
@@ -907,7 +970,13 @@ ClientThread::CreateThreads(
     ClientThread* const theThreadsPtr = new ClientThread[inThreadCount];
     for (int i = 0; i < inThreadCount; i++) {
         theThreadsPtr[i].mImpl.Start(
-            inFirstCpuIdx < 0 ? -1 : inFirstCpuIdx + i);
+            (0 < inNumaNodeCount && inNumaNodesPtr) ?
+                QCThread::GetNumaNodeCpus(
+                    inNumaNodesPtr[i % inNumaNodeCount]) :
+            inFirstCpuIdx < 0 ?
+                QCThread::CpuAffinity::None() :
+                QCThread::CpuAffinity(inFirstCpuIdx + i)
+        );
     }
     return theThreadsPtr;
 }
@@ -83,10 +83,15 @@ public:
     const QCThread& GetThread() const;
     static ClientThread* GetCurrentClientThreadPtr();
     static const QCMutex& GetMutex();
+    // If numa nodes are specified, then the threads are assigned to the
+    // nodes in round robin order, and the thread cpu affinity is set to the
+    // node's cpus.
     static ClientThread* CreateThreads(
-        int       inThreadCount,
-        int       inFirstCpuIdx,
-        QCMutex*& outMutexPtr);
+        int        inThreadCount,
+        int        inFirstCpuIdx,
+        QCMutex*&  outMutexPtr,
+        int        inNumaNodeCount = 0,
+        const int* inNumaNodesPtr  = 0);
     static void SetParameters(
         ClientThread*     inThreadsPtr,
         int               inThreadCount,
@@ -609,7 +609,9 @@ private:
             if (theSit != inSubDirNames.end()) {
                 continue;
             }
-            int64_t    theFsId = -1;
+            int64_t    theFsId                 = -1;
+            int64_t    theSampledFileCount     = 0;
+            int64_t    theSampledExtentCount   = 0;
             ChunkInfos theChunkInfos;
             string     theFsIdPathName;
             if (GetChunkFiles(
@@ -626,6 +628,8 @@ private:
                     inRandom,
                     theFsId,
                     theFsIdPathName,
+                    theSampledFileCount,
+                    theSampledExtentCount,
                     theChunkInfos) != 0) {
                 continue;
             }
@@ -723,6 +727,20 @@ private:
                         theSupportsSpaceReservatonFlag,
                         theFsId
                     )));
+            if (theDirRes.second) {
+                theDirRes.first->second.mSampledChunkFileCount   =
+                    theSampledFileCount;
+                theDirRes.first->second.mSampledChunkExtentCount =
+                    theSampledExtentCount;
+                if (0 < theSampledFileCount) {
+                    KFS_LOG_STREAM_INFO << theIt->first <<
+                        " sampled chunk files: " << theSampledFileCount <<
+                        " extents: "             << theSampledExtentCount <<
+                        " avg: "                 <<
+                            (double)theSampledExtentCount / theSampledFileCount <<
+                    KFS_LOG_EOM;
+                }
+            }
             if (! theChunkInfos.IsEmpty() && theDirRes.second) {
                 theChunkInfos.Swap(theDirRes.first->second.mChunkInfos);
             }
@@ -742,10 +760,14 @@ private:
         PrngIsaac64&       inRandom,
         int64_t&           outFileSystemId,
         string&            outFsIdPathName,
+        int64_t&           outSampledFileCount,
+        int64_t&           outSampledExtentCount,
         ChunkInfos&        outChunkInfos)
     {
         QCASSERT(! inDirName.empty() && *(inDirName.rbegin()) == '/');
-        outFileSystemId = -1;
+        outFileSystemId       = -1;
+        outSampledFileCount   = 0;
+        outSampledExtentCount = 0;
         int theErr = 0;
         DIR* const theDirStream = opendir(inDirName.c_str());
         if (! theDirStream) {
@@ -944,6 +966,7 @@ private:
             int64_t    theChunkFileFsId = -1;
             int        theIoTimeSec     = -1;
             bool       theReadFlag      = false;
+            int64_t    theExtentCount   = -1;
             const bool kForceReadFlag   = true;
             if (IsValidChunkFile(
                     inDirName,
@@ -959,7 +982,8 @@ private:
                     theChunkInfo.mChunkSize,
                     theChunkFileFsId,
                     theIoTimeSec,
-                    theReadFlag
+                    theReadFlag,
+                    &theExtentCount
                     )) {
                 if (0 < theChunkFileFsId) {
                     if (0 < outFileSystemId) {
@@ -983,6 +1007,10 @@ private:
                     theErr = -ETIMEDOUT;
                     break;
                 }
+                if (0 <= theExtentCount) {
+                    outSampledFileCount++;
+                    outSampledExtentCount += theExtentCount;
+                }
                 theReadCnt++;
             } else {
                 // Mark entry as invalid.
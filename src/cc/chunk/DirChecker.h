@@ -103,6 +103,8 @@ public:
               mBufferedIoFlag(inBufferedIoFlag),
               mSupportsSpaceReservatonFlag(inSupportsSpaceReservatonFlag),
               mFileSystemId(inFileSystemId),
+              mSampledChunkFileCount(0),
+              mSampledChunkExtentCount(0),
               mChunkInfos()
             {}
         DeviceId   mDeviceId;
@@ -110,6 +112,11 @@ public:
         bool       mBufferedIoFlag;
         bool       mSupportsSpaceReservatonFlag;
         int64_t    mFileSystemId;
+        // Fragmentation estimate: the total number of file system extents of
+        // the sampled chunk files. Both are 0 if the file system does not
+        // support extent mapping.
+        int64_t    mSampledChunkFileCount;
+        int64_t    mSampledChunkExtentCount;
         ChunkInfos mChunkInfos;
     };
     typedef map<string, DirInfo> DirsAvailable;
@@ -30,21 +30,25 @@
 #include "kfsio/IOBuffer.h"
 #include "kfsio/Globals.h"
 #include "kfsio/PrngIsaac64.h"
+#include "kfsio/LatencyHistogram.h"
 #include "common/Properties.h"
 #include "common/MsgLogger.h"
 #include "common/kfstypes.h"
+#include "common/time.h"
 
 #include "qcdio/QCDLList.h"
 #include "qcdio/QCMutex.h"
 #include "qcdio/qcstutils.h"
 #include "qcdio/QCUtils.h"
 #include "qcdio/QCIoBufferPool.h"
+#include "qcdio/QCThread.h"
 #include "qcdio/qcdebug.h"
 
 #include <cerrno>
 #include <algorithm>
 #include <limits>
 #include <set>
+#include <vector>
 #include <iomanip>
 
 namespace KFS
@@ -53,6 +57,7 @@ using std::max;
 using std::min;
 using std::string;
 using std::set;
+using std::vector;
 using std::numeric_limits;
 using std::setw;
 using std::setfill;
@@ -706,7 +711,9 @@ public:
     typedef DiskIo::Counters Counters;
 
     DiskIoQueues(
-            const Properties& inConfig)
+            const Properties& inConfig,
+            int               inNumaNodeCount,
+            const int*        inNumaNodesPtr)
         : ITimeout(),
           mDiskQueueThreadCount(inConfig.getValue(
             "chunkServer.diskQueue.threadCount", 2)),
@@ -714,6 +721,8 @@ public:
             "chunkServer.diskQueue.maxBuffersPerRequest", 1 << 8)),
           mDiskQueueMaxEnqueueWaitNanoSec(inConfig.getValue(
             "chunkServer.diskQueue.maxEnqueueWaitTimeMilliSec", 0) * 1000000),
+          mDiskQueueMaxWriteCoalesceCount(inConfig.getValue(
+            "chunkServer.diskQueue.maxWriteCoalesceRequests", 8)),
           mBufferPoolPartitionCount(inConfig.getValue(
             "chunkServer.ioBufferPool.partitionCount", 1)),
           mBufferPoolPartitionBufferCount(inConfig.getValue(
@@ -784,13 +793,18 @@ public:
           mNullBufferDataWrittenPtr(0),
           mCounters(),
           mDiskErrorSimulatorConfig(inConfig),
-          mCpuAffinity(inConfig.getValue(
-            "chunkServer.diskQueue.cpuAffinity", -1)),
+          mNumaNodes(inNumaNodesPtr, inNumaNodesPtr +
+            (inNumaNodesPtr ? max(0, inNumaNodeCount) : 0)),
+          mCpuAffinity(GetCpuAffinity(inConfig, mNumaNodes)),
           mDiskQueueTraceFlag(inConfig.getValue(
             "chunkServer.diskQueue.trace", 0) != 0),
-          mParameters(inConfig)
+          mParameters(inConfig),
+          mReadLatency("Latency Disk read usec"),
+          mWriteLatency("Latency Disk write usec")
     {
         mCounters.Clear();
+        globals().counterManager.AddHistogram(&mReadLatency);
+        globals().counterManager.AddHistogram(&mWriteLatency);
         IoQueue::Init(mIoInFlightQueuePtr);
         IoQueue::Init(mIoInFlightNoTimeoutQueuePtr);
         IoQueue::Init(mIoDoneQueuePtr);
@@ -802,6 +816,8 @@ public:
     {
         DiskIoQueues::Shutdown(0, false);
         globalNetManager().UnRegisterTimeoutHandler(this);
+        globals().counterManager.RemoveHistogram(&mReadLatency);
+        globals().counterManager.RemoveHistogram(&mWriteLatency);
         if (mDebugVerifyIoBuffersFlag) {
             SetIOBufferVerifier(0);
         }
@@ -815,7 +831,9 @@ public:
             mBufferPoolPartitionCount,
             mBufferPoolPartitionBufferCount,
             mBufferPoolBufferSize,
-            mBufferPoolLockMemoryFlag
+            mBufferPoolLockMemoryFlag,
+            (int)mNumaNodes.size(),
+            mNumaNodes.empty() ? 0 : &mNumaNodes[0]
         );
         if (theSysError) {
             if (inErrMessagePtr) {
@@ -1142,6 +1160,7 @@ public:
             }
             return false;
         }
+        theQueuePtr->SetMaxWriteCoalesceCount(mDiskQueueMaxWriteCoalesceCount);
         return true;
     }
     DiskQueue::Time GetMaxEnqueueWaitTimeNanoSec() const
@@ -1202,6 +1221,12 @@ public:
         QCASSERT(mWritePendingBytes >= 0 && mWriteReqCount >= 0);
         CheckIfOverloaded();
     }
+    void IoLatency(
+        bool    inReadFlag,
+        int64_t inLatencyUsec)
+    {
+        (inReadFlag ? mReadLatency : mWriteLatency).Update(inLatencyUsec);
+    }
     void SyncDone(
         int64_t inRetCode)
     {
@@ -1269,7 +1294,18 @@ public:
         { return mDiskQueueThreadCount; }
     void GetCounters(
         Counters& outCounters)
-        { outCounters = mCounters; }
+    {
+        outCounters = mCounters;
+        DiskQueueList::Iterator theIt(mDiskQueuesPtr);
+        DiskQueue* thePtr;
+        while ((thePtr = theIt.Next())) {
+            int64_t theReqCount   = 0;
+            int64_t theBlockCount = 0;
+            thePtr->GetCoalescedWriteCount(theReqCount, theBlockCount);
+            outCounters.mCoalescedWriteCount      += theReqCount;
+            outCounters.mCoalescedWriteBlockCount += theBlockCount;
+        }
+    }
     void SetInFlight(
         DiskIo* inIoPtr)
     {
@@ -1278,6 +1314,7 @@ public:
         }
         Pin(*inIoPtr);
         inIoPtr->mEnqueueTime = Now();
+        inIoPtr->mEnqueueUsec = microseconds();
         QCStMutexLocker theLocker(mMutex);
         AddInFlight(*inIoPtr);
     }
@@ -1331,11 +1368,15 @@ public:
         mValidateIoBuffersFlag = inProperties.getValue(
             "chunkServer.diskIo.debugValidateIoBuffers",
             mValidateIoBuffersFlag ? 1 : 0) != 0;
+        mDiskQueueMaxWriteCoalesceCount = inProperties.getValue(
+            "chunkServer.diskQueue.maxWriteCoalesceRequests",
+            mDiskQueueMaxWriteCoalesceCount);
         mParameters = inProperties;
         DiskQueue* thePtr;
         DiskQueueList::Iterator theIt(mDiskQueuesPtr);
         while ((thePtr = theIt.Next())) {
             thePtr->SetParameters(mParameters);
+            thePtr->SetMaxWriteCoalesceCount(mDiskQueueMaxWriteCoalesceCount);
         }
     }
     int GetMaxIoTimeSec() const
@@ -1521,6 +1562,7 @@ private:
     const int                      mDiskQueueThreadCount;
     const int                      mDiskQueueMaxBuffersPerRequest;
     const DiskQueue::Time          mDiskQueueMaxEnqueueWaitNanoSec;
+    int                            mDiskQueueMaxWriteCoalesceCount;
     const int                      mBufferPoolPartitionCount;
     const int                      mBufferPoolPartitionBufferCount;
     const int                      mBufferPoolBufferSize;
@@ -1562,13 +1604,45 @@ private:
     DiskQueue*                     mDiskQueuesPtr[1];
     Counters                       mCounters;
     DiskErrorSimulator::Config     mDiskErrorSimulatorConfig;
+    const vector<int>              mNumaNodes;
     const QCDiskQueue::CpuAffinity mCpuAffinity;
     const int                      mDiskQueueTraceFlag;
     Properties                     mParameters;
+    LatencyHistogram               mReadLatency;
+    LatencyHistogram               mWriteLatency;
 
     QCIoBufferPool& GetBufferPool()
         { return mBufferAllocator.GetBufferPool(); }
 
+    static QCDiskQueue::CpuAffinity GetCpuAffinity(
+        const Properties&  inConfig,
+        const vector<int>& inNumaNodes)
+    {
+        const int theCpuIdx = inConfig.getValue(
+            "chunkServer.diskQueue.cpuAffinity", -1);
+        if (0 <= theCpuIdx || inNumaNodes.empty()) {
+            return QCDiskQueue::CpuAffinity(theCpuIdx);
+        }
+        // Run disk queue threads on the cpus of the configured numa nodes.
+        QCDiskQueue::CpuAffinity theRet;
+        for (vector<int>::const_iterator theIt = inNumaNodes.begin();
+                theIt != inNumaNodes.end();
+                ++theIt) {
+            const QCThread::CpuAffinity theCpus =
+                QCThread::GetNumaNodeCpus(*theIt);
+            if (theCpus == QCThread::CpuAffinity::None()) {
+                continue;
+            }
+            for (int i = 0; i < 64; i++) {
+                if (theCpus.IsSet(i)) {
+                    theRet.Set(i);
+                }
+            }
+        }
+        return (theRet == QCDiskQueue::CpuAffinity() ?
+            QCDiskQueue::CpuAffinity::None() : theRet);
+    }
+
     DiskIo** GetInFlightQueue(
         const DiskIo& inIo)
     {
@@ -1717,13 +1791,16 @@ DiskQueue::WritePending(
     /* static */ bool
 DiskIo::Init(
     const Properties& inProperties,
-    string*           inErrMessagePtr /* = 0 */)
+    string*           inErrMessagePtr /* = 0 */,
+    int               inNumaNodeCount /* = 0 */,
+    const int*        inNumaNodesPtr  /* = 0 */)
 {
     if (sDiskIoQueuesPtr) {
         *inErrMessagePtr = "already initialized";
         return false;
     }
-    sDiskIoQueuesPtr = new DiskIoQueues(inProperties);
+    sDiskIoQueuesPtr = new DiskIoQueues(
+        inProperties, inNumaNodeCount, inNumaNodesPtr);
     if (! sDiskIoQueuesPtr->Start(inErrMessagePtr)) {
         delete sDiskIoQueuesPtr;
         sDiskIoQueuesPtr = 0;
@@ -2274,6 +2351,12 @@ DiskIo::File::GetMinWriteBlkSize() const
     return (mQueuePtr ? mQueuePtr->GetMinWriteBlkSize() : 0);
 }
 
+    int
+DiskIo::File::DupFd() const
+{
+    return ((mQueuePtr && IsOpen()) ? mQueuePtr->DupFd(mFileIdx) : -EBADF);
+}
+
     bool
 DiskIo::File::ReserveSpace(
     string* inErrMessagePtr)
@@ -2334,6 +2417,7 @@ DiskIo::DiskIo(
       mBlockIdx(0),
       mIoRetCode(0),
       mEnqueueTime(),
+      mEnqueueUsec(0),
       mWriteSyncFlag(false),
       mCachedFlag(false),
       mCompletionRequestId(QCDiskQueue::kRequestIdNone),
@@ -3074,8 +3158,10 @@ DiskIo::RunCompletion()
     } else if (mReadLength > 0) {
         theQueuePtr->ReadPending(
             -int64_t(mReadLength), mIoRetCode, mCachedFlag);
+        sDiskIoQueuesPtr->IoLatency(true, microseconds() - mEnqueueUsec);
         theOpNamePtr = "read";
     } else if (! mIoBuffers.empty()) {
+        sDiskIoQueuesPtr->IoLatency(false, microseconds() - mEnqueueUsec);
         theQueuePtr->WritePending(
             -int64_t(mIoBuffers.size() *
                 sDiskIoQueuesPtr->GetBufferAllocator().GetBufferSize()),
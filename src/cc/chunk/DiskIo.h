@@ -81,6 +81,8 @@ public:
         Counter mTimedOutErrorReadByteCount;
         Counter mTimedOutErrorWriteByteCount;
         Counter mOpenFilesCount;
+        Counter mCoalescedWriteCount;
+        Counter mCoalescedWriteBlockCount;
         void Clear()
         {
             mReadCount                     = 0;
@@ -106,14 +108,21 @@ public:
             mTimedOutErrorReadByteCount    = 0;
             mTimedOutErrorWriteByteCount   = 0;
             mOpenFilesCount                = 0;
+            mCoalescedWriteCount           = 0;
+            mCoalescedWriteBlockCount      = 0;
         }
     };
     typedef int64_t Offset;
     typedef int64_t DeviceId;
 
+    // If numa nodes are specified, then the io buffer pool partitions are
+    // allocated from the nodes, and the disk queue threads run on the
+    // nodes' cpus, unless chunkServer.diskQueue.cpuAffinity is set.
     static bool Init(
         const Properties& inProperties,
-        string*           inErrMessagePtr = 0);
+        string*           inErrMessagePtr = 0,
+        int               inNumaNodeCount = 0,
+        const int*        inNumaNodesPtr  = 0);
     static bool StartIoQueue(
         const char* inDirNamePtr,
         DeviceId    inDeviceId,
@@ -229,6 +238,9 @@ public:
             int64_t& outWriteBlockCount,
             int&     outBlockSize);
         int GetMinWriteBlkSize() const;
+        // Returns duplicate of the open file descriptor, or negative error
+        // code.
+        int DupFd() const;
         int GetError() const
             { return mError; }
     private:
@@ -297,6 +309,7 @@ private:
     int64_t                mBlockIdx;
     int64_t                mIoRetCode;
     time_t                 mEnqueueTime;
+    int64_t                mEnqueueUsec;
     bool                   mWriteSyncFlag;
     bool                   mCachedFlag;
     QCDiskQueue::RequestId mCompletionRequestId;
@@ -45,11 +45,14 @@
 #include "common/RequestParser.h"
 #include "common/kfserrno.h"
 #include "common/IntToString.h"
+#include "common/SlabAllocator.h"
 
 #include "kfsio/Globals.h"
 #include "kfsio/checksum.h"
 #include "kfsio/CryptoKeys.h"
 #include "kfsio/ChunkAccessToken.h"
+#include "kfsio/LatencyHistogram.h"
+#include "kfsio/TraceRing.h"
 
 #include "qcdio/qcstutils.h"
 #include "qcdio/QCUtils.h"
@@ -82,14 +85,41 @@ using namespace KFS::libkfsio;
 // Counters for the various ops
 struct OpCounters : private map<KfsOp_t, Counter *>
 {
-    static void Update(KfsOp_t opName, int64_t startTime)
+    static void Update(const KfsOp& op)
     {
-        Counter* const c = GetCounter(opName);
-        if (! c) {
+        if (! sInstance) {
+            return;
+        }
+        const int64_t now  = microseconds();
+        const int64_t time = now - op.startTime;
+        OpCounters::iterator const iter = sInstance->find(op.op);
+        if (iter != sInstance->end()) {
+            iter->second->Update(1);
+            iter->second->UpdateTime(time);
+            Histograms::const_iterator const it =
+                sInstance->mHistograms.find(op.op);
+            if (it != sInstance->mHistograms.end()) {
+                it->second->Update(time);
+            }
+        }
+        if (sInstance->mTraceRing.Sample()) {
+            TraceRing::Record rec;
+            rec.mTimeUsec = now;
+            rec.mSeq      = op.seq;
+            rec.mWaitUsec = -1;
+            rec.mExecUsec = time;
+            rec.mLogUsec  = -1;
+            rec.mOp       = op.op;
+            rec.mStatus   = op.status;
+            sInstance->mTraceRing.Put(rec);
+        }
+    }
+    static void SetParameters(const Properties& props)
+    {
+        if (! sInstance) {
             return;
         }
-        c->Update(1);
-        c->UpdateTime(microseconds() - startTime);
+        sInstance->mTraceRing.SetParameters("chunkServer.opTrace.", props);
     }
     static void WriteMaster()
     {
@@ -113,14 +143,20 @@ struct OpCounters : private map<KfsOp_t, Counter *>
         }
     }
 private:
-    Counter mWriteMaster;
-    Counter mWriteDuration;
+    typedef map<KfsOp_t, LatencyHistogram*> Histograms;
+
+    Counter    mWriteMaster;
+    Counter    mWriteDuration;
+    Histograms mHistograms;
+    TraceRing  mTraceRing;
     static OpCounters* sInstance;
 
     OpCounters()
         : map<KfsOp_t, Counter *>(),
           mWriteMaster("Write Master"),
-          mWriteDuration("Write Duration")
+          mWriteDuration("Write Duration"),
+          mHistograms(),
+          mTraceRing()
       {}
     ~OpCounters()
     {
@@ -130,6 +166,14 @@ private:
             }
             delete i->second;
         }
+        for (Histograms::iterator i = mHistograms.begin();
+                i != mHistograms.end();
+                ++i) {
+            if (sInstance == this) {
+                globals().counterManager.RemoveHistogram(i->second);
+            }
+            delete i->second;
+        }
         if (sInstance == this) {
             globals().counterManager.RemoveCounter(&mWriteMaster);
             globals().counterManager.RemoveCounter(&mWriteDuration);
@@ -144,17 +188,10 @@ private:
             return;
         }
         globals().counterManager.AddCounter(c);
-    }
-    static Counter* GetCounter(KfsOp_t opName)
-    {
-        if (! sInstance) {
-            return 0;
-        }
-        OpCounters::iterator iter = sInstance->find(opName);
-        if (iter == sInstance->end()) {
-            return 0;
-        }
-        return iter->second;
+        LatencyHistogram* const h = new LatencyHistogram(
+            (string("Latency ") + name + " usec").c_str());
+        mHistograms.insert(make_pair(opName, h));
+        globals().counterManager.AddHistogram(h);
     }
     static OpCounters* MakeInstance()
     {
@@ -608,6 +645,13 @@ public:
     }
 };
 
+/* static */ void
+KfsOp::SetParameters(const Properties& props)
+{
+    QCStMutexLocker theLocker(sMutex);
+    OpCounters::SetParameters(props);
+}
+
 /* static */ bool
 KfsOp::Init()
 {
@@ -672,6 +716,32 @@ int64_t  KfsOp::sOpsCount           = 0;
 KfsOp*   KfsOp::sOpsList[1]         = {0};
 bool     KfsOp::sExitDebugCheckFlag = false;
 
+static SlabAllocator&
+GetOpAllocator()
+{
+    // Never destroyed, as ops can be deleted by static destructors.
+    static SlabAllocator& sAllocator = *(new SlabAllocator("Op"));
+    return sAllocator;
+}
+
+/* static */ void*
+KfsOp::operator new(size_t size)
+{
+    return GetOpAllocator().Allocate(size);
+}
+
+/* static */ void
+KfsOp::operator delete(void* ptr, size_t size)
+{
+    GetOpAllocator().Deallocate(ptr, size);
+}
+
+/* static */ void
+KfsOp::ShowAllocatorStats(ostream& os)
+{
+    GetOpAllocator().Show(os);
+}
+
 KfsOp::KfsOp(KfsOp_t o)
     : KfsCallbackObj(),
       op(o),
@@ -707,7 +777,7 @@ KfsOp::~KfsOp()
         die("~KfsOp: invalid instance");
         return;
     }
-    OpCounters::Update(op, startTime);
+    OpCounters::Update(*this);
     sOpsCount--;
     OpsList::Remove(sOpsList, *this);
     clnt = 0;
@@ -1824,6 +1894,18 @@ HBAppendCounters(ostream* hbos)
     HBAppend(os, "Read-chksum-skip-bytes",    cm.mReadSkipDiskVerifyByteCount);
     HBAppend(os, "Read-chksum-skip-cs-bytes",
         cm.mReadSkipDiskVerifyChecksumByteCount);
+    HBAppend(os, "Scrub-chunks",              cm.mScrubChunkCount);
+    HBAppend(os, "Scrub-bytes",               cm.mScrubByteCount);
+    HBAppend(os, "Scrub-chksum-errors",       cm.mScrubChecksumErrorCount);
+    HBAppend(os, "Scrub-errors",              cm.mScrubErrorCount);
+    HBAppend(os, "Scrub-yield",               cm.mScrubYieldCount);
+    HBAppend(os, "Local-read-opens",          cm.mLocalReadOpenCount);
+    HBAppend(os, "Local-read-open-errors",    cm.mLocalReadOpenErrorCount);
+    int64_t localReadPassed  = 0;
+    int64_t localReadExpired = 0;
+    gChunkManager.GetLocalReadCounters(localReadPassed, localReadExpired);
+    HBAppend(os, "Local-read-fds-passed",     localReadPassed);
+    HBAppend(os, "Local-read-fds-expired",    localReadExpired);
 
     MetaServerSM::Counters mc;
     gMetaServerSM.GetCounters(mc);
@@ -1858,6 +1940,14 @@ HBAppendCounters(ostream* hbos)
     HBAppend(os, "Client-other-micro-sec",    cli.mOtherRequestTimeMicroSecs);
     HBAppend(os, "Client-other-errors",       cli.mOtherRequestErrors);
     HBAppend(os, "Client-over-limit",         cli.mOverClientLimitCount);
+    HBAppend(os, "Client-write-cut-through",  cli.mCutThroughWriteCount);
+    for (int i = 0; i < gClientManager.GetNumaNodeCount(); i++) {
+        HBAppend(os, "Client-numa-accept-node-", cli.mNumaNodeAcceptCount[i],
+            0, gClientManager.GetNumaNode(i));
+    }
+    if (0 < gClientManager.GetNumaNodeCount()) {
+        HBAppend(os, "Client-numa-accept-other", cli.mNumaUnknownAcceptCount);
+    }
     HBAppend(os, "Client-max-count",
         gClientManager.GetMaxClientCount());
 
@@ -1865,6 +1955,18 @@ HBAppendCounters(ostream* hbos)
         globalNetManager().GetTimerOverrunCount());
     HBAppend(os, "Timer-overrun-sec",
         globalNetManager().GetTimerOverrunSec());
+    NetManager::LoopStats nls;
+    gChunkServer.GetNetManagerWatcher().GetLoopStats(nls);
+    HBAppend(os, "Net-loop-wakeups",          nls.mWakeupCount);
+    HBAppend(os, "Net-loop-events",           nls.mEventCount);
+    HBAppend(os, "Net-loop-max-events",       nls.mMaxEventsPerWakeup);
+    HBAppend(os, "Net-loop-busy-polls",       nls.mBusyPollCount);
+    HBAppend(os, "Net-loop-edge-ready",       nls.mEdgeReadyCount);
+    HBAppend(os, "Net-loop-micro-sec",        nls.mLoopTimeUsec);
+    for (int i = 0; i < NetManager::LoopStats::kLatencyBucketCount; i++) {
+        HBAppend(os, "Net-loop-latency-", nls.mLatency[i], 0,
+            NetManager::LoopStats::kLatencyFirstBucketUsec << i);
+    }
 
     HBAppend(os, "Write-appenders",
         gAtomicRecordAppendManager.GetAppendersCount());
@@ -1964,6 +2066,9 @@ HBAppendCounters(ostream* hbos)
     HBAppend(os, "Disk-timedout-read-bytes",  dio.mTimedOutErrorReadByteCount);
     HBAppend(os, "Disk-timedout-write-bytes", dio.mTimedOutErrorWriteByteCount);
     HBAppend(os, "Disk-open-files",           dio.mOpenFilesCount);
+    HBAppend(os, "Disk-coalesced-writes",     dio.mCoalescedWriteCount);
+    HBAppend(os, "Disk-coalesced-write-blocks",
+        dio.mCoalescedWriteBlockCount);
 
     MsgLogger::Counters msgLogCntrs;
     MsgLogger::GetLogger()->GetCounters(msgLogCntrs);
@@ -1974,6 +2079,10 @@ HBAppendCounters(ostream* hbos)
     HBAppend(os, "Msg-log-write-errors",     msgLogCntrs.mWriteErrorCount);
     HBAppend(os, "Msg-log-wait",             msgLogCntrs.mAppendWaitCount);
     HBAppend(os, "Msg-log-waited-micro-sec", msgLogCntrs.mAppendWaitMicroSecs);
+    HBAppend(os, "Msg-log-thread-buf-appends",
+        msgLogCntrs.mThreadBufAppendCount);
+    HBAppend(os, "Msg-log-thread-buf-overflows",
+        msgLogCntrs.mThreadBufOverflowCount);
 
     Replicator::Counters replCntrs;
     Replicator::GetCounters(replCntrs);
@@ -2491,10 +2600,17 @@ WritePrepareOp::Execute()
     int            myPos         = -1;
     const bool     needToForward = needToForwardToPeer(shortRpcFormatFlag,
         servers, numServers, myPos, peerLoc, true, writeId);
+    // With cut through forwarding in flight the completion must wait for the
+    // forwarded op, therefore use Done() instead of Submit().
+    const bool     cutThroughFlag = IsCutThroughInFlight();
     if (myPos < 0) {
         statusMsg = "invalid or missing Servers: field";
         status = -EINVAL;
-        Submit();
+        if (cutThroughFlag) {
+            Done(EVENT_CMD_DONE, this);
+        } else {
+            Submit();
+        }
         return;
     }
     if (chunkAccessTokenValidFlag &&
@@ -2502,7 +2618,11 @@ WritePrepareOp::Execute()
             subjectId != writeId) {
         status    = -EPERM;
         statusMsg = "access token write access mismatch";
-        Submit();
+        if (cutThroughFlag) {
+            Done(EVENT_CMD_DONE, this);
+        } else {
+            Submit();
+        }
         return;
     }
 
@@ -2510,7 +2630,11 @@ WritePrepareOp::Execute()
     if (! gChunkManager.IsValidWriteId(writeId)) {
         statusMsg = "invalid write id";
         status = -EINVAL;
-        Submit();
+        if (cutThroughFlag) {
+            Done(EVENT_CMD_DONE, this);
+        } else {
+            Submit();
+        }
         return;
     }
 
@@ -2568,7 +2692,7 @@ WritePrepareOp::Execute()
         return;
     }
 
-    if (needToForward) {
+    if (needToForward && ! cutThroughFlag) {
         ForwardToPeer(peerLoc, writeMaster, allowCSClearTextFlag);
         if (status < 0) {
             // can't forward to peer...so fail the write
@@ -2628,6 +2752,85 @@ WritePrepareOp::ForwardToPeer(
     peer->Enqueue(writeFwdOp);
 }
 
+bool
+WritePrepareOp::CutThroughForward(const IOBuffer& buf, int numBytesAvail)
+{
+    if (cutThroughFwdBytes < 0 || status < 0) {
+        return false;
+    }
+    if (! writeFwdOp) {
+        // Validate the op the same way as Execute() does prior to forwarding.
+        // If validation fails, then fall back to forwarding after the op
+        // content is received, in order to let Execute() handle the error.
+        ServerLocation peerLoc;
+        int            myPos                = -1;
+        bool           allowCSClearTextFlag = chunkAccessTokenValidFlag &&
+            (chunkAccessFlags & ChunkAccessToken::kAllowClearTextFlag) != 0;
+        if (! needToForwardToPeer(shortRpcFormatFlag,
+                    servers, numServers, myPos, peerLoc, true, writeId) ||
+                myPos < 0 ||
+                (chunkAccessTokenValidFlag &&
+                    (chunkAccessFlags &
+                        ChunkAccessToken::kUsesWriteIdFlag) != 0 &&
+                    subjectId != writeId) ||
+                ! gChunkManager.IsValidWriteId(writeId) ||
+                ! gChunkManager.IsChunkMetadataLoaded(chunkId, chunkVersion) ||
+                (myPos == 0 && ! gLeaseClerk.IsLeaseValid(
+                    chunkId, chunkVersion,
+                    &syncReplicationAccess, &allowCSClearTextFlag))) {
+            cutThroughFwdBytes = -1;
+            return false;
+        }
+        RemoteSyncSMPtr const peer = FindPeer(
+            *this, peerLoc, myPos == 0, allowCSClearTextFlag);
+        if (! peer) {
+            // Let Execute() report the error.
+            status = 0;
+            statusMsg.clear();
+            cutThroughFwdBytes = -1;
+            return false;
+        }
+        KFS_LOG_STREAM_DEBUG <<
+            "cut through forwarding to: " << peerLoc <<
+            " " << Show() <<
+        KFS_LOG_EOM;
+        cutThroughPeer = peer;
+        writeFwdOp     = new WritePrepareFwdOp(*this, true);
+        writeFwdOp->clnt = this;
+        peer->Enqueue(writeFwdOp);
+    }
+    const int fwdBytes = min(numBytesAvail, (int)numBytes) - cutThroughFwdBytes;
+    if (fwdBytes <= 0) {
+        return true;
+    }
+    WritePrepareFwdDataOp* const dataOp =
+        new WritePrepareFwdDataOp(*this, offset + cutThroughFwdBytes);
+    dataOp->dataBuf.Copy(&buf, cutThroughFwdBytes + fwdBytes);
+    dataOp->dataBuf.Consume(cutThroughFwdBytes);
+    cutThroughFwdBytes += fwdBytes;
+    cutThroughPeer->Enqueue(dataOp);
+    return true;
+}
+
+void
+WritePrepareOp::CutThroughAbort()
+{
+    if (0 <= status) {
+        status    = -EHOSTUNREACH;
+        statusMsg = "cut through forwarding aborted";
+    }
+    // The remaining data will never be sent, therefore close the connection
+    // to the peer. This fails the forwarded op and the ops queued after the
+    // data, and releases the data queued for transmission. The peer discards
+    // partially received op when the connection closes.
+    RemoteSyncSMPtr const peer = cutThroughPeer;
+    cutThroughPeer.reset();
+    if (peer) {
+        peer->Finish();
+    }
+    Done(EVENT_CMD_DONE, this);
+}
+
 int
 WritePrepareOp::Done(int code, void* data)
 {
@@ -3077,6 +3280,19 @@ GetChunkMetadataOp::Execute()
             kAddObjectBlockMappingFlag));
 }
 
+bool
+GetChunkMetadataOp::CheckAccess(ClientSM& sm)
+{
+    if (! KfsClientChunkOp::CheckAccess(sm)) {
+        return false;
+    }
+    // Descriptor can only be passed to the client on the same host.
+    if (localReadFlag && ! sm.IsLocalPeer()) {
+        localReadFlag = false;
+    }
+    return true;
+}
+
 int
 GetChunkMetadataOp::HandleChunkMetaReadDone(int code, void* data)
 {
@@ -3103,6 +3319,12 @@ GetChunkMetadataOp::HandleChunkMetaReadDone(int code, void* data)
         status = -EBADF;
     }
 
+    if (0 <= status && localReadFlag && ! readVerifyFlag &&
+            gChunkManager.OpenChunkForLocalRead(chunkId, chunkVersion,
+                localReadHandle, localReadHeaderSize) != 0) {
+        // Not an error, the client falls back to reading over the network.
+        localReadHandle = -1;
+    }
     if (status < 0 || ! readVerifyFlag) {
         Submit();
         return 0;
@@ -3237,6 +3459,7 @@ StatsOp::Execute()
     os << "Num aios: " << 0 << "\r\n";
     os << "Num ops: " << gChunkServer.GetNumOps() << "\r\n";
     globals().counterManager.Show(os);
+    KfsOp::ShowAllocatorStats(os);
     stats = os.str();
     status = 0;
     Submit();
@@ -3317,7 +3540,22 @@ GetChunkMetadataOp::Response(ReqOstream& os)
     os <<
     (shortRpcFormatFlag ? "H:" : "Chunk-handle: ")  << chunkId      << "\r\n" <<
     (shortRpcFormatFlag ? "V:" : "Chunk-version: ") << chunkVersion << "\r\n" <<
-    (shortRpcFormatFlag ? "S:" : "Size: ")          << chunkSize    << "\r\n" <<
+    (shortRpcFormatFlag ? "S:" : "Size: ")          << chunkSize    << "\r\n";
+    // Return the socket path even if the descriptor was not opened, in order
+    // to let the client know that it is on the same host.
+    const string& localReadPath = gChunkManager.GetLocalReadSocketPath();
+    if (localReadFlag && ! localReadPath.empty()) {
+        os << (shortRpcFormatFlag ? "LP:" : "Local-read-path: ") <<
+            localReadPath << "\r\n";
+        if (0 < localReadHandle) {
+            os <<
+            (shortRpcFormatFlag ? "LH:" : "Local-read-handle: ") <<
+                localReadHandle << "\r\n" <<
+            (shortRpcFormatFlag ? "LZ:" : "Local-read-header-size: ") <<
+                localReadHeaderSize << "\r\n";
+        }
+    }
+    os <<
     (shortRpcFormatFlag ? "l:" : "Content-length: ") << numBytesIO  << "\r\n"
     "\r\n";
 }
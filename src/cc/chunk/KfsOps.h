@@ -103,6 +103,7 @@ enum KfsOp_t {
     CMD_WRITE_ID_ALLOC,
     CMD_WRITE_PREPARE,
     CMD_WRITE_PREPARE_FWD,
+    CMD_WRITE_PREPARE_FWD_DATA,
     CMD_WRITE_SYNC,
     CMD_SIZE,
     // RPCs support for record append: client reserves space and sends
@@ -391,6 +392,12 @@ struct KfsOp : public KfsCallbackObj
         { return (op ? Display(*op) : Display(GetNullOp())); }
     virtual bool CheckAccess(ClientSM& sm);
     static bool Init();
+    static void SetParameters(const Properties& props);
+    // Ops are allocated from the size class slab pools with per thread free
+    // lists, see common/SlabAllocator.h
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr, size_t size);
+    static void ShowAllocatorStats(ostream& os);
     static void SetExitDebugCheck(bool flag)
         { sExitDebugCheckFlag = flag; }
     static bool GetExitDebugCheckFlag()
@@ -1379,6 +1386,8 @@ struct WritePrepareOp : public ChunkAccessRequestOp {
     BufferManager*        devBufMgr;
     uint32_t              receivedChecksum;
     vector<uint32_t>      blocksChecksums;
+    RemoteSyncSMPtr       cutThroughPeer;     // peer receiving data as it arrives
+    int                   cutThroughFwdBytes; // data bytes forwarded so far
 
     WritePrepareOp()
         : ChunkAccessRequestOp(CMD_WRITE_PREPARE),
@@ -1397,7 +1406,9 @@ struct WritePrepareOp : public ChunkAccessRequestOp {
           numDone(0),
           devBufMgr(0),
           receivedChecksum(0),
-          blocksChecksums()
+          blocksChecksums(),
+          cutThroughPeer(),
+          cutThroughFwdBytes(0)
         { SET_HANDLER(this, &WritePrepareOp::Done); }
     ~WritePrepareOp();
 
@@ -1414,6 +1425,14 @@ struct WritePrepareOp : public ChunkAccessRequestOp {
         bool                  wrtieMasterFlag,
         bool                  allowCSClearTextFlag);
     int Done(int code, void* data);
+    // Cut through forwarding: stream the data received so far to the next
+    // server in the synchronous replication chain, before the whole op
+    // content is received. The first invocation sends the op header.
+    // Returns false if cut through cannot be used with this op.
+    bool CutThroughForward(const IOBuffer& buf, int numBytesAvail);
+    void CutThroughAbort();
+    bool IsCutThroughInFlight() const
+        { return (writeFwdOp && cutThroughPeer); }
     virtual BufferManager* GetDeviceBufferManager(
         bool findFlag, bool resetFlag)
     {
@@ -1448,10 +1467,14 @@ struct WritePrepareOp : public ChunkAccessRequestOp {
 
 struct WritePrepareFwdOp : public KfsOp {
     const WritePrepareOp& owner;
+    // Only the header is sent with the op, the data follows in
+    // WritePrepareFwdDataOp(s) as it arrives.
+    const bool            cutThroughFlag;
 
-    WritePrepareFwdOp(WritePrepareOp& o)
+    WritePrepareFwdOp(WritePrepareOp& o, bool ctFlag = false)
         : KfsOp(CMD_WRITE_PREPARE_FWD),
-          owner(o)
+          owner(o),
+          cutThroughFlag(ctFlag)
     {
         shortRpcFormatFlag        = o.shortRpcFormatFlag;
         initialShortRpcFormatFlag = o.initialShortRpcFormatFlag;
@@ -1466,11 +1489,49 @@ struct WritePrepareFwdOp : public KfsOp {
         return os <<
             "write-prepare-fwd: "
             "seq: " << seq <<
+            (cutThroughFlag ? " cut-through" : "") <<
             " " << owner.Show()
         ;
     }
 };
 
+// Cut through forwarding data piece. Must not reference the "owner" write
+// prepare, as the owner might complete and go away while the piece is still
+// queued for transmission.
+struct WritePrepareFwdDataOp : public KfsOp {
+    kfsChunkId_t chunkId;
+    int64_t      offset;
+    IOBuffer     dataBuf;
+
+    WritePrepareFwdDataOp(const WritePrepareOp& o, int64_t off)
+        : KfsOp(CMD_WRITE_PREPARE_FWD_DATA),
+          chunkId(o.chunkId),
+          offset(off),
+          dataBuf()
+    {
+        // Fire'n'forget: the op comes right back to be deleted after
+        // the data is queued for transmission.
+        clnt = this;
+        SET_HANDLER(this, &WritePrepareFwdDataOp::HandlePeerReply);
+    }
+    void Execute() {}
+    int HandlePeerReply(int /* code */, void* /* data */)
+    {
+        delete this;
+        return 0;
+    }
+    virtual ostream& ShowSelf(ostream& os) const
+    {
+        return os <<
+            "write-prepare-fwd-data:"
+            " seq: "      << seq <<
+            " chunk: "    << chunkId <<
+            " offset: "   << offset <<
+            " numBytes: " << dataBuf.BytesConsumable()
+        ;
+    }
+};
+
 struct WriteOp : public KfsOp {
     kfsChunkId_t     chunkId;
     int64_t          chunkVersion;
@@ -1939,7 +2000,10 @@ struct ChunkSpaceReleaseOp : public KfsClientChunkOp {
 
 struct GetChunkMetadataOp : public KfsClientChunkOp {
     bool         readVerifyFlag;
+    bool         localReadFlag;
     int64_t      chunkSize; // output
+    int64_t      localReadHandle; // output
+    int          localReadHeaderSize; // output
     IOBuffer     dataBuf; // buffer with the checksum info
     size_t       numBytesIO;
     ReadOp       readOp; // internally generated
@@ -1950,7 +2014,10 @@ struct GetChunkMetadataOp : public KfsClientChunkOp {
     GetChunkMetadataOp()
         : KfsClientChunkOp(CMD_GET_CHUNK_METADATA),
           readVerifyFlag(false),
+          localReadFlag(false),
           chunkSize(0),
+          localReadHandle(-1),
+          localReadHeaderSize(0),
           dataBuf(),
           numBytesIO(0),
           readOp(),
@@ -1960,6 +2027,7 @@ struct GetChunkMetadataOp : public KfsClientChunkOp {
     ~GetChunkMetadataOp()
         {}
     void Execute();
+    virtual bool CheckAccess(ClientSM& sm);
     // handler for reading in the chunk meta-data
     int HandleChunkMetaReadDone(int code, void* data);
 
@@ -2005,6 +2073,7 @@ struct GetChunkMetadataOp : public KfsClientChunkOp {
     {
         return KfsClientChunkOp::ParserDef(parser)
         .Def2("Read-verify",  "RV", &GetChunkMetadataOp::readVerifyFlag)
+        .Def2("Local-read",   "LR", &GetChunkMetadataOp::localReadFlag)
         ;
     }
 };
@@ -70,6 +70,7 @@ MakeClientRequestHandler(const T* typeArg = 0)
         static_cast<const DumpChunkMapOp*>(0))
     .MakeParser("STATS",
         static_cast<const StatsOp*>(0))
+    .MakeParsersDone()
     ;
 }
 
@@ -103,6 +104,7 @@ MakeMetaRequestHandler(const T* typeArg = 0)
         static_cast<const SetProperties*>(0))
     .MakeParser("RESTART_CHUNK_SERVER",
         static_cast<const RestartChunkServerOp*>(0))
+    .MakeParsersDone()
     ;
 }
 
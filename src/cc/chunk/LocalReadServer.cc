@@ -0,0 +1,486 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file LocalReadServer.cc
+// \brief Unix domain socket chunk file descriptor server.
+//
+// The protocol is intentionally trivial, as both ends are on the same host:
+// the client sends 8 bytes handle in host byte order, and the server responds
+// with 4 bytes status in host byte order. With status 0 the response carries
+// the descriptor in SCM_RIGHTS control message. The connection is closed
+// after the response.
+//
+//----------------------------------------------------------------------------
+
+#include "LocalReadServer.h"
+
+#include "common/MsgLogger.h"
+#include "common/Properties.h"
+#include "kfsio/CryptoKeys.h"
+#include "kfsio/DescriptorPassingFilter.h"
+#include "kfsio/NetManager.h"
+#include "kfsio/TcpSocket.h"
+#include "kfsio/IOBuffer.h"
+#include "kfsio/Globals.h"
+#include "qcdio/QCUtils.h"
+#include "qcdio/QCDLList.h"
+#include "qcdio/qcdebug.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <grp.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <ios>
+#include <utility>
+
+namespace KFS
+{
+using std::make_pair;
+using std::oct;
+using std::dec;
+using libkfsio::globalNetManager;
+
+class LocalReadServer::Connection : public KfsCallbackObj
+{
+public:
+    typedef QCDLList<Connection> List;
+
+    Connection(
+        LocalReadServer&        inServer,
+        const NetConnectionPtr& inConnPtr)
+        : KfsCallbackObj(),
+          mServer(inServer),
+          mConnPtr(inConnPtr),
+          mFilter(),
+          mChunkFd(-1),
+          mRespondedFlag(false)
+    {
+        List::Init(*this);
+        SET_HANDLER(this, &Connection::HandleEvent);
+        List::PushBack(mServer.mConnections, *this);
+        mServer.mConnectionCount++;
+        mConnPtr->SetOwningKfsCallbackObj(this);
+        mConnPtr->SetFilter(&mFilter, 0);
+        mConnPtr->SetMaxReadAhead((int)sizeof(int64_t));
+        mConnPtr->SetInactivityTimeout(mServer.mIoTimeoutSec);
+    }
+    ~Connection()
+    {
+        List::Remove(mServer.mConnections, *this);
+        mServer.mConnectionCount--;
+        mConnPtr->Close();
+        mConnPtr.reset();
+        if (0 <= mChunkFd) {
+            close(mChunkFd);
+        }
+    }
+    int HandleEvent(
+        int   inCode,
+        void* inDataPtr)
+    {
+        switch (inCode) {
+            case EVENT_NET_READ: {
+                QCASSERT(&mConnPtr->GetInBuffer() == inDataPtr);
+                IOBuffer& theBuf    = mConnPtr->GetInBuffer();
+                int64_t   theHandle = 0;
+                if (mRespondedFlag ||
+                        theBuf.BytesConsumable() < (int)sizeof(theHandle)) {
+                    return 0;
+                }
+                theBuf.CopyOut(reinterpret_cast<char*>(&theHandle),
+                    (int)sizeof(theHandle));
+                theBuf.Clear();
+                mConnPtr->SetMaxReadAhead(0);
+                mChunkFd = mServer.Remove(theHandle);
+                const int32_t theStatus = mChunkFd < 0 ? -ENOENT : 0;
+                mFilter.SetSendFd(mChunkFd);
+                mConnPtr->GetOutBuffer().CopyIn(
+                    reinterpret_cast<const char*>(&theStatus),
+                    (int)sizeof(theStatus));
+                mRespondedFlag = true;
+                // Write completion might delete this.
+                mConnPtr->StartFlush();
+                return 0;
+            }
+            case EVENT_NET_WROTE:
+                if (! mRespondedFlag || mConnPtr->IsWriteReady()) {
+                    return 0;
+                }
+                if (0 <= mChunkFd) {
+                    mServer.mPassedCount++;
+                }
+                break;
+            case EVENT_NET_ERROR:
+            case EVENT_INACTIVITY_TIMEOUT:
+                KFS_LOG_STREAM_DEBUG <<
+                    "local read connection: " <<
+                    (EVENT_NET_ERROR == inCode ?
+                        mConnPtr->GetErrorMsg() : string("timed out")) <<
+                KFS_LOG_EOM;
+                break;
+            default:
+                QCRTASSERT(! "unexpected event");
+                break;
+        }
+        delete this;
+        return 0;
+    }
+private:
+    LocalReadServer&        mServer;
+    NetConnectionPtr        mConnPtr;
+    DescriptorPassingFilter mFilter;
+    int                     mChunkFd;
+    bool                    mRespondedFlag;
+    Connection*             mPrevPtr[1];
+    Connection*             mNextPtr[1];
+
+    friend class QCDLListOp<Connection>;
+private:
+    Connection(
+        const Connection& inConnection);
+    Connection& operator=(
+        const Connection& inConnection);
+};
+
+LocalReadServer::LocalReadServer()
+    : KfsCallbackObj(),
+      ITimeout(),
+      mEntries(),
+      mListenerPtr(),
+      mSocketPath(),
+      mConfigSocketPath(),
+      mSocketGroup(),
+      mSocketMode(0660),
+      mHandleExpireSec(30),
+      mMaxHandles(4 << 10),
+      mMaxConnections(256),
+      mIoTimeoutSec(5),
+      mConnectionCount(0),
+      mStartedFlag(false),
+      mPassedCount(0),
+      mExpiredCount(0)
+{
+    Connection::List::Init(mConnections);
+    SET_HANDLER(this, &LocalReadServer::HandleEvent);
+    SetTimeoutInterval(1000);
+}
+
+LocalReadServer::~LocalReadServer()
+{
+    LocalReadServer::Stop();
+}
+
+void
+LocalReadServer::SetParameters(
+    const Properties& inProps)
+{
+    mHandleExpireSec = inProps.getValue(
+        "chunkServer.localRead.handleExpireSec", mHandleExpireSec);
+    mMaxHandles      = inProps.getValue(
+        "chunkServer.localRead.maxHandles", mMaxHandles);
+    mMaxConnections  = inProps.getValue(
+        "chunkServer.localRead.maxConnections", mMaxConnections);
+    mIoTimeoutSec    = inProps.getValue(
+        "chunkServer.localRead.ioTimeoutSec", mIoTimeoutSec);
+    const Properties::String* const theModePtr = inProps.getValue(
+        "chunkServer.localRead.socketMode");
+    if (theModePtr) {
+        char*      theEndPtr = 0;
+        const long theMode   = strtol(theModePtr->c_str(), &theEndPtr, 8);
+        if (theEndPtr && theModePtr->c_str() < theEndPtr &&
+                (*theEndPtr & 0xFF) <= ' ' && 0 <= theMode &&
+                theMode <= 0777) {
+            mSocketMode = (int)theMode;
+        } else {
+            KFS_LOG_STREAM_ERROR <<
+                "invalid local read socket mode: " << *theModePtr <<
+            KFS_LOG_EOM;
+        }
+    }
+    mSocketGroup = inProps.getValue(
+        "chunkServer.localRead.socketGroup", mSocketGroup);
+    const string thePrevPath = mConfigSocketPath;
+    mConfigSocketPath = inProps.getValue(
+        "chunkServer.localRead.socketPath", mConfigSocketPath);
+    if (thePrevPath != mConfigSocketPath && mStartedFlag) {
+        Stop();
+        Start();
+    }
+}
+
+int
+LocalReadServer::Start()
+{
+    if (mStartedFlag) {
+        return 0;
+    }
+    if (mConfigSocketPath.empty()) {
+        return 0;
+    }
+    mStartedFlag = true;
+    globalNetManager().RegisterTimeoutHandler(this);
+    return Listen();
+}
+
+void
+LocalReadServer::Stop()
+{
+    if (! mStartedFlag) {
+        return;
+    }
+    mStartedFlag = false;
+    globalNetManager().UnRegisterTimeoutHandler(this);
+    StopListening();
+    while (! Connection::List::IsEmpty(mConnections)) {
+        delete Connection::List::Front(mConnections);
+    }
+    Expire(true);
+}
+
+int
+LocalReadServer::Listen()
+{
+    struct sockaddr_un theAddr;
+    memset(&theAddr, 0, sizeof(theAddr));
+    if (sizeof(theAddr.sun_path) <= mConfigSocketPath.size()) {
+        KFS_LOG_STREAM_ERROR <<
+            "local read socket path is too long: " << mConfigSocketPath <<
+        KFS_LOG_EOM;
+        return -ENAMETOOLONG;
+    }
+    theAddr.sun_family = AF_UNIX;
+    memcpy(theAddr.sun_path, mConfigSocketPath.data(),
+        mConfigSocketPath.size());
+    const int theFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (theFd < 0) {
+        const int theErr = errno;
+        KFS_LOG_STREAM_ERROR <<
+            "local read socket: " << QCUtils::SysError(theErr) <<
+        KFS_LOG_EOM;
+        return (theErr > 0 ? -theErr : -EINVAL);
+    }
+    fcntl(theFd, F_SETFD, FD_CLOEXEC);
+    unlink(mConfigSocketPath.c_str());
+    int theErr = 0;
+    if (bind(theFd, reinterpret_cast<const struct sockaddr*>(&theAddr),
+                sizeof(theAddr)) ||
+            fcntl(theFd, F_SETFL, O_NONBLOCK)) {
+        theErr = errno;
+    } else if ((theErr = SetSocketPermissions(mConfigSocketPath)) == 0 &&
+            listen(theFd, 1024)) {
+        theErr = errno;
+    }
+    if (theErr) {
+        KFS_LOG_STREAM_ERROR <<
+            "local read socket: " << mConfigSocketPath <<
+            ": " << QCUtils::SysError(theErr) <<
+        KFS_LOG_EOM;
+        close(theFd);
+        unlink(mConfigSocketPath.c_str());
+        return (theErr > 0 ? -theErr : -EINVAL);
+    }
+    const bool kListenOnlyFlag = true;
+    mListenerPtr.reset(new NetConnection(
+        new TcpSocket(theFd, TcpSocket::kTypeUnix), this, kListenOnlyFlag));
+    mListenerPtr->EnableReadIfOverloaded();
+    globalNetManager().AddConnection(mListenerPtr);
+    mSocketPath = mConfigSocketPath;
+    KFS_LOG_STREAM_INFO <<
+        "local read server started: " << mSocketPath <<
+        " mode: "  << oct << mSocketMode << dec <<
+        " group: " << mSocketGroup <<
+    KFS_LOG_EOM;
+    return 0;
+}
+
+int
+LocalReadServer::SetSocketPermissions(
+    const string& inPath)
+{
+    // The socket is accessible by the chunk server's user and group, unless
+    // configured otherwise. The clients must also present a descriptor
+    // handle, which is given out only with chunk access check.
+    if (! mSocketGroup.empty()) {
+        char*       theEndPtr = 0;
+        const long  theId     = strtol(mSocketGroup.c_str(), &theEndPtr, 10);
+        gid_t       theGid;
+        if (theEndPtr && *theEndPtr == 0 && 0 <= theId) {
+            theGid = (gid_t)theId;
+        } else {
+            const struct group* const theGrPtr =
+                getgrnam(mSocketGroup.c_str());
+            if (! theGrPtr) {
+                KFS_LOG_STREAM_ERROR <<
+                    "local read socket group: " << mSocketGroup <<
+                    " not found" <<
+                KFS_LOG_EOM;
+                return EINVAL;
+            }
+            theGid = theGrPtr->gr_gid;
+        }
+        if (chown(inPath.c_str(), (uid_t)-1, theGid)) {
+            return errno;
+        }
+    }
+    if (chmod(inPath.c_str(), (mode_t)mSocketMode)) {
+        return errno;
+    }
+    return 0;
+}
+
+void
+LocalReadServer::StopListening()
+{
+    if (! mListenerPtr) {
+        return;
+    }
+    mListenerPtr->Close();
+    mListenerPtr.reset();
+    unlink(mSocketPath.c_str());
+    mSocketPath.clear();
+}
+
+int
+LocalReadServer::HandleEvent(
+    int   inCode,
+    void* inDataPtr)
+{
+    switch (inCode) {
+        case EVENT_NEW_CONNECTION: {
+            QCASSERT(inDataPtr);
+            NetConnectionPtr& theConnPtr =
+                *reinterpret_cast<NetConnectionPtr*>(inDataPtr);
+            if (! theConnPtr) {
+                break;
+            }
+            if (mMaxConnections <= mConnectionCount) {
+                KFS_LOG_STREAM_ERROR <<
+                    "local read server: connection limit: " <<
+                        mMaxConnections <<
+                    " exceeded, closing new connection" <<
+                KFS_LOG_EOM;
+                theConnPtr->Close();
+                break;
+            }
+            new Connection(*this, theConnPtr);
+            globalNetManager().AddConnection(theConnPtr);
+            break;
+        }
+        case EVENT_NET_ERROR:
+            KFS_LOG_STREAM_ERROR <<
+                "local read server: " << mSocketPath <<
+                " error: " << (mListenerPtr ?
+                    mListenerPtr->GetErrorMsg() : string()) <<
+                ", restarting" <<
+            KFS_LOG_EOM;
+            StopListening();
+            // Timeout() restarts the listener.
+            break;
+        case EVENT_INACTIVITY_TIMEOUT:
+            break;
+        default:
+            QCRTASSERT(! "unexpected event");
+            break;
+    }
+    return 0;
+}
+
+    /* virtual */ void
+LocalReadServer::Timeout()
+{
+    Expire(false);
+    if (mStartedFlag && ! mListenerPtr) {
+        Listen();
+    }
+}
+
+int64_t
+LocalReadServer::Add(
+    int inFd)
+{
+    if (inFd < 0) {
+        return -EINVAL;
+    }
+    if (! mListenerPtr) {
+        close(inFd);
+        return -ENOTSUP;
+    }
+    if (mMaxHandles <= (int)mEntries.size()) {
+        Expire(false);
+        if (mMaxHandles <= (int)mEntries.size()) {
+            close(inFd);
+            return -EAGAIN;
+        }
+    }
+    int64_t theHandle = 0;
+    for (int i = 0; i < 8; i++) {
+        CryptoKeys::PseudoRand(&theHandle, sizeof(theHandle));
+        theHandle &= ~(int64_t(1) << 63);
+        if (0 < theHandle &&
+                mEntries.insert(make_pair(theHandle,
+                    Entry(inFd, globalNetManager().Now() +
+                        mHandleExpireSec))).second) {
+            return theHandle;
+        }
+    }
+    close(inFd);
+    return -EAGAIN;
+}
+
+int
+LocalReadServer::Remove(
+    int64_t inHandle)
+{
+    Entries::iterator const theIt = mEntries.find(inHandle);
+    if (theIt == mEntries.end()) {
+        return -1;
+    }
+    const int theFd = theIt->second.mFd;
+    mEntries.erase(theIt);
+    return theFd;
+}
+
+void
+LocalReadServer::Expire(
+    bool inAllFlag)
+{
+    const int64_t theNow = globalNetManager().Now();
+    Entries::iterator theIt = mEntries.begin();
+    while (theIt != mEntries.end()) {
+        if (inAllFlag || theIt->second.mExpireTime < theNow) {
+            close(theIt->second.mFd);
+            mEntries.erase(theIt++);
+            mExpiredCount++;
+        } else {
+            ++theIt;
+        }
+    }
+}
+
+}
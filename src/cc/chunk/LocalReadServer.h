@@ -0,0 +1,129 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file LocalReadServer.h
+// \brief Passes read only chunk file descriptors to the clients running on
+// the same host over unix domain socket.
+//
+// The descriptor is opened by the chunk manager after the client's get chunk
+// meta data request passes the access check, and is registered under a
+// random handle, which is returned to the client in the response. The client
+// then connects to the unix domain socket, and exchanges the handle for the
+// descriptor. Handles that are not claimed within the configured time are
+// discarded. The socket connections are served by the main net manager.
+//
+//----------------------------------------------------------------------------
+
+#ifndef LOCAL_READ_SERVER_H
+#define LOCAL_READ_SERVER_H
+
+#include "kfsio/KfsCallbackObj.h"
+#include "kfsio/ITimeout.h"
+#include "kfsio/NetConnection.h"
+
+#include <string>
+#include <map>
+
+namespace KFS
+{
+using std::string;
+using std::map;
+
+class Properties;
+
+class LocalReadServer : public KfsCallbackObj, public ITimeout
+{
+public:
+    LocalReadServer();
+    virtual ~LocalReadServer();
+    void SetParameters(
+        const Properties& inProps);
+    int Start();
+    void Stop();
+    bool IsRunning() const
+        { return (mListenerPtr != 0); }
+    const string& GetSocketPath() const
+        { return mSocketPath; }
+    /// Takes ownership of the descriptor. Returns positive handle on success,
+    /// or negative error code, in which case the descriptor is closed.
+    int64_t Add(
+        int inFd);
+    void GetCounters(
+        int64_t& outPassedCount,
+        int64_t& outExpiredCount) const
+    {
+        outPassedCount  = mPassedCount;
+        outExpiredCount = mExpiredCount;
+    }
+    virtual void Timeout();
+private:
+    class Connection;
+    struct Entry
+    {
+        Entry(
+            int     inFd         = -1,
+            int64_t inExpireTime = 0)
+            : mFd(inFd),
+              mExpireTime(inExpireTime)
+            {}
+        int     mFd;
+        int64_t mExpireTime;
+    };
+    typedef map<int64_t, Entry> Entries;
+
+    Entries          mEntries;
+    NetConnectionPtr mListenerPtr;
+    Connection*      mConnections[1];
+    string           mSocketPath;
+    string           mConfigSocketPath;
+    string           mSocketGroup;
+    int              mSocketMode;
+    int              mHandleExpireSec;
+    int              mMaxHandles;
+    int              mMaxConnections;
+    int              mIoTimeoutSec;
+    int              mConnectionCount;
+    bool             mStartedFlag;
+    int64_t          mPassedCount;
+    int64_t          mExpiredCount;
+
+    int HandleEvent(
+        int   inCode,
+        void* inDataPtr);
+    int Listen();
+    void StopListening();
+    int SetSocketPermissions(
+        const string& inPath);
+    int Remove(
+        int64_t inHandle);
+    void Expire(
+        bool inAllFlag);
+    friend class Connection;
+private:
+    LocalReadServer(
+        const LocalReadServer& inServer);
+    LocalReadServer& operator=(
+        const LocalReadServer& inServer);
+};
+
+}
+
+#endif /* LOCAL_READ_SERVER_H */
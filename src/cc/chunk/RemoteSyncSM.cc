@@ -321,7 +321,9 @@ RemoteSyncSM::RemoteSyncSM(
       mFinishRecursionCount(0),
       mDeletedFlagPtr(0),
       mOpResponseTimeoutSec(sOpResponseTimeoutSec),
-      mTraceRequestResponseFlag(sTraceRequestResponseFlag)
+      mTraceRequestResponseFlag(sTraceRequestResponseFlag),
+      mCutThroughRemaining(0),
+      mCutThroughPendingOps()
 {
     QCASSERT(IsMutexOwner(GetMutexPtr()));
     SET_HANDLER(this, &RemoteSyncSM::HandleEvent);
@@ -339,6 +341,7 @@ RemoteSyncSM::~RemoteSyncSM()
             mFinishRecursionCount != 0 ||
             mNetConnection ||
             ! mDispatchedOps.empty() ||
+            ! mCutThroughPendingOps.empty() ||
             mList ||
             ! mDeleteFlag) {
         die("invalid remote sync destructor invocation");
@@ -428,6 +431,15 @@ RemoteSyncSM::EnqueueSelf(KfsOp* op)
         SubmitOpResponse(op);
         return false;
     }
+    if (op->op == CMD_WRITE_PREPARE_FWD_DATA) {
+        return EnqueueCutThroughData(op);
+    }
+    if (0 < mCutThroughRemaining) {
+        // Cut through write data is being sent, queue the op after it in
+        // order to maintain the request order.
+        mCutThroughPendingOps.push_back(op);
+        return true;
+    }
     if (mNetConnection && ! mNetConnection->IsGood()) {
         SYNC_SM_LOG_STREAM_INFO <<
             "lost connection to peer, failing ops" <<
@@ -508,8 +520,13 @@ RemoteSyncSM::EnqueueSelf(KfsOp* op)
         // send the data as well
         WritePrepareFwdOp* const wpfo = static_cast<WritePrepareFwdOp*>(op);
         op->status = 0;
-        mNetConnection->WriteCopy(&wpfo->owner.dataBuf,
-            wpfo->owner.dataBuf.BytesConsumable());
+        if (wpfo->cutThroughFlag) {
+            // The data follows as it arrives.
+            mCutThroughRemaining = (int)wpfo->owner.numBytes;
+        } else {
+            mNetConnection->WriteCopy(&wpfo->owner.dataBuf,
+                wpfo->owner.dataBuf.BytesConsumable());
+        }
         if (wpfo->owner.replyRequestedFlag) {
             if (! mDispatchedOps.insert(make_pair(op->seq, op)).second) {
                 die("duplicate seq. number");
@@ -546,6 +563,60 @@ RemoteSyncSM::EnqueueSelf(KfsOp* op)
         mNetConnection && mNetConnection->IsGood());
 }
 
+bool
+RemoteSyncSM::EnqueueCutThroughData(KfsOp* op)
+{
+    WritePrepareFwdDataOp& dataOp = *static_cast<WritePrepareFwdDataOp*>(op);
+    const int              len    = dataOp.dataBuf.BytesConsumable();
+    if (mCutThroughRemaining < len ||
+            ! mNetConnection || ! mNetConnection->IsGood()) {
+        // The header or the preceding data was not sent, or connection was
+        // lost. The forwarded op fails with the connection, and the next
+        // server discards the partially received op.
+        SYNC_SM_LOG_STREAM_DEBUG <<
+            "discarding cut through data:"
+            " remaining: " << mCutThroughRemaining <<
+            " " << op->Show() <<
+        KFS_LOG_EOM;
+        op->status    = -EHOSTUNREACH;
+        op->statusMsg = "cut through forwarding failed";
+        SubmitOpResponse(op);
+        return false;
+    }
+    mCutThroughRemaining -= len;
+    mNetConnection->Write(&dataOp.dataBuf, len);
+    op->status = 0;
+    // Fire'n'forget, the forwarded write prepare tracks the completion.
+    SubmitOpResponse(op);
+    if (mCutThroughRemaining <= 0 && ! RunCutThroughPending()) {
+        return false;
+    }
+    if (mRecursionCount <= 0 && mNetConnection && ! IsClientThread()) {
+        mNetConnection->StartFlush();
+    }
+    return (mNetConnection && mNetConnection->IsGood());
+}
+
+bool
+RemoteSyncSM::RunCutThroughPending()
+{
+    QCStDeleteNotifier const deleteNotifier(mDeletedFlagPtr);
+    PendingOps               ops;
+    ops.swap(mCutThroughPendingOps);
+    bool okFlag = true;
+    while (! ops.empty()) {
+        KfsOp* const op = ops.front();
+        ops.pop_front();
+        if (okFlag) {
+            okFlag = EnqueueSelf(op) && ! deleteNotifier.IsDeleted();
+        } else {
+            op->status = -EHOSTUNREACH;
+            SubmitOpResponse(op);
+        }
+    }
+    return okFlag;
+}
+
 int
 RemoteSyncSM::HandleEvent(int code, void *data)
 {
@@ -611,8 +682,9 @@ RemoteSyncSM::HandleEvent(int code, void *data)
             mNetConnection->Close();
             mNetConnection.reset();
         }
-        mReplyNumBytes = 0;
-        mReplySeqNum   = -1;
+        mReplyNumBytes       = 0;
+        mReplySeqNum         = -1;
+        mCutThroughRemaining = 0;
         break;
 
     default:
@@ -792,6 +864,18 @@ RemoteSyncSM::FailAllOps()
 {
     QCASSERT(IsMutexOwner(GetMutexPtr()));
 
+    // The remaining cut through data, if any, can no longer be sent.
+    mCutThroughRemaining = 0;
+    if (! mCutThroughPendingOps.empty()) {
+        PendingOps opsToFail;
+        mCutThroughPendingOps.swap(opsToFail);
+        while (! opsToFail.empty()) {
+            KfsOp* const op = opsToFail.front();
+            opsToFail.pop_front();
+            op->status = -EHOSTUNREACH;
+            SubmitOpResponse(op);
+        }
+    }
     if (mDispatchedOps.empty()) {
         return;
     }
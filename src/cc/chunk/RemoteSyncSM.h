@@ -183,6 +183,10 @@ private:
             std::pair<const kfsSeq_t, KfsOp*>
         >
     > DispatchedOps;
+    typedef list<
+        KfsOp*,
+        StdFastAllocator<KfsOp*>
+    > PendingOps;
     class Auth;
 
     NetConnectionPtr     mNetConnection;
@@ -213,6 +217,10 @@ private:
     bool*                mDeletedFlagPtr;
     const int            mOpResponseTimeoutSec;
     const bool           mTraceRequestResponseFlag;
+    /// Cut through forwarding: the number of data bytes of the current write
+    /// prepare op that are yet to be sent, and the ops queued after it.
+    int                  mCutThroughRemaining;
+    PendingOps           mCutThroughPendingOps;
 
     static bool          sTraceRequestResponseFlag;
     static int           sOpResponseTimeoutSec;
@@ -262,6 +270,8 @@ private:
     void ResetConnection();
     void FailAllOps();
     bool EnqueueSelf(KfsOp* op);
+    bool EnqueueCutThroughData(KfsOp* op);
+    bool RunCutThroughPending();
     void FinishSelf();
     void ScheduleDelete();
     inline void UpdateRecvTimeout();
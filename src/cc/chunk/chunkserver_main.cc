@@ -150,6 +150,7 @@ private:
     bool           mClientListenerIpV6OnlyFlag;
     int            mClientThreadCount;
     int            mFirstCpuIndex;
+    vector<int>    mNumaNodes;
     string         mChunkServerHostname;
     string         mClusterKey;
     string         mNodeId;
@@ -237,6 +238,21 @@ ChunkServerMain::LoadParams(const char* fileName)
     KFS_LOG_STREAM_INFO << "chunk server client thread count: " <<
         mClientThreadCount <<  " first cpu: " << mFirstCpuIndex <<
     KFS_LOG_EOM;
+    mNumaNodes.clear();
+    {
+        istringstream is(mProp.getValue("chunkServer.numaNodes", string()));
+        int node;
+        while ((is >> node)) {
+            if (0 <= node) {
+                mNumaNodes.push_back(node);
+            }
+        }
+    }
+    if (! mNumaNodes.empty()) {
+        KFS_LOG_STREAM_INFO << "chunk server numa nodes: " <<
+            mProp.getValue("chunkServer.numaNodes", string()) <<
+        KFS_LOG_EOM;
+    }
 
     mChunkServerHostname = mProp.getValue("chunkServer.hostname",
         mChunkServerHostname);
@@ -417,7 +433,8 @@ ChunkServerMain::Run(int argc, char **argv)
                 mClientListenerIpV6OnlyFlag,
                 mChunkServerHostname,
                 mClientThreadCount,
-                mFirstCpuIndex)) {
+                mFirstCpuIndex,
+                mNumaNodes)) {
         ret = gChunkServer.MainLoop(mChunkDirs, mProp) ? 0 : 1;
     }
     NetErrorSimulatorConfigure(globalNetManager());
@@ -32,10 +32,12 @@
 #include "qcdio/qcstutils.h"
 #include "qcdio/qcdebug.h"
 #include "qcdio/QCThread.h"
+#include "kfsatomic.h"
 
 #include <fcntl.h>
 #include <unistd.h>
 #include <poll.h>
+#include <pthread.h>
 #include <dirent.h>
 #include <stdio.h>
 #include <sys/types.h>
@@ -81,6 +83,8 @@ const char* const kBufferedLogWriter_LogLevels[] = {
 const int64_t kLogWriterMinLogFileSize               = 16 << 10;
 const int64_t kLogWriterMinOpenRetryIntervalMicroSec = 10000;
 const int     kLogWriterMinLogBufferSize             = 16 << 10;
+const int     kLogWriterMinThreadBufferSize          = 4 << 10;
+const size_t  kLogWriterThreadBufAvgMsgSize          = 256;
 const int64_t kLogWirterDefaultTimeToKeepSecs        = 60 * 60 * 24 * 30;
 const int     kLogWriterDefaulOpenFlags              =
     O_CREAT | O_APPEND | O_WRONLY /* | O_SYNC */;
@@ -157,7 +161,12 @@ public:
           mCpuAffinityIndex(-1),
           mMaxMsgStreamCount(256),
           mMsgStreamCount(0),
-          mMsgStreamHeadPtr(0)
+          mMsgStreamHeadPtr(0),
+          mThreadBufSize(0),
+          mThreadBufKeyValidFlag(false),
+          mThreadBufAppendCount(0),
+          mThreadBufOverflowCount(0),
+          mThreadBufsHeadPtr(0)
     {
         if (! mFileName.empty()) {
             mLogFileNamePrefixes.push_back(mFileName);
@@ -172,6 +181,8 @@ public:
         mLastLogTm       = mTimeTm;
         GetLogTimeStampPrefixPtr(theSec);
         mNextFlushTime = Seconds(theSec) + theMicroSec + mFlushInterval;
+        mThreadBufKeyValidFlag =
+            pthread_key_create(&mThreadBufKey, &ThreadBufExited) == 0;
     }
     static const char* GetLogLevelNamePtr(
         LogLevel inLogLevel)
@@ -187,6 +198,14 @@ public:
     virtual ~Impl()
     {
         Impl::Stop();
+        if (mThreadBufKeyValidFlag) {
+            pthread_key_delete(mThreadBufKey);
+        }
+        while (mThreadBufsHeadPtr) {
+            ThreadBuf* const thePtr = mThreadBufsHeadPtr;
+            mThreadBufsHeadPtr = thePtr->mNextPtr;
+            delete thePtr;
+        }
         delete [] mBuf0Ptr;
         while (mMsgStreamHeadPtr) {
             QCASSERT(mMsgStreamCount > 0);
@@ -237,6 +256,16 @@ public:
         mCpuAffinityIndex = inProps.getValue(
             inPropsPrefix + "cpuAffinityIndex",
             mCpuAffinityIndex);
+        const int theThreadBufSize = inProps.getValue(
+            inPropsPrefix + "threadBufferSize",
+            (int)mThreadBufSize);
+        // Round up to the record alignment, and limit by the write buffer
+        // size, in order to guarantee that any ring buffer record fits into
+        // the empty write buffer.
+        mThreadBufSize = theThreadBufSize <= 0 ? 0 :
+            (min(max(kLogWriterMinThreadBufferSize, theThreadBufSize),
+                mBufSize / 2) + ThreadBuf::kAlign - 1) /
+            ThreadBuf::kAlign * ThreadBuf::kAlign;
         string theLogFilePrefixes;
         for (LogFileNames::const_iterator theIt =
                 mLogFileNamePrefixes.begin();
@@ -303,6 +332,7 @@ public:
         if (! mRunFlag) {
             return;
         }
+        DrainThreadBufs();
         FlushSelf();
         mRunFlag = false;
         mWriteCond.Notify();
@@ -407,12 +437,13 @@ public:
     void Flush()
     {
         QCStMutexLocker theLocker(mMutex);
+        DrainThreadBufs();
         FlushSelf();
     }
     void Sync()
     {
         QCStMutexLocker theLocker(mMutex);
-        while (! FlushSelf() || mWritePtr) {
+        while (! DrainThreadBufs() || ! FlushSelf() || mWritePtr) {
             mBufWaitersCount++;
             mWriteDoneCond.Wait(mMutex);
             mBufWaitersCount--;
@@ -453,6 +484,13 @@ public:
         outCounters.mWriteErrorCount     = mWriteErrCount;
         outCounters.mAppendWaitCount     = mBufWaitedCount;
         outCounters.mAppendWaitMicroSecs = mTotalLogWaitedTime;
+        outCounters.mThreadBufAppendCount   = mThreadBufAppendCount;
+        for (const ThreadBuf* thePtr = mThreadBufsHeadPtr;
+                thePtr;
+                thePtr = thePtr->mNextPtr) {
+            outCounters.mThreadBufAppendCount += thePtr->GetAppendCount();
+        }
+        outCounters.mThreadBufOverflowCount = mThreadBufOverflowCount;
     }
     void PrepareToFork()
         { mMutex.Lock(); }
@@ -473,7 +511,24 @@ public:
         if (! mRunFlag) {
             return;
         }
+        const bool       theRingFlag = IsThreadBufLogLevel(inLogLevel);
+        ThreadBuf* const theBufPtr   = GetThreadBuf(theRingFlag);
+        if (theRingFlag && theBufPtr) {
+            const Time theTime   = Now();
+            size_t     theMaxLen = (size_t)max(0, inWriter.GetMsgLength()) + 1;
+            char* const thePtr   = theBufPtr->Reserve(theMaxLen);
+            if (thePtr) {
+                const int theLen = inWriter.Write(thePtr, (int)theMaxLen);
+                if (0 <= theLen && (size_t)theLen < theMaxLen) {
+                    Commit(*theBufPtr, inLogLevel, theTime, theLen);
+                    return;
+                }
+            }
+        }
         QCStMutexLocker theLocker(mMutex);
+        if (! PrepareToAppend(theBufPtr, theRingFlag)) {
+            return;
+        }
         static va_list theArgs; // dummy
         AppendSelf(inLogLevel, &inWriter, 0, "", theArgs);
     }
@@ -485,7 +540,28 @@ public:
         if (! mRunFlag) {
             return;
         }
+        const bool       theRingFlag = IsThreadBufLogLevel(inLogLevel);
+        ThreadBuf* const theBufPtr   = GetThreadBuf(theRingFlag);
+        if (theRingFlag && theBufPtr) {
+            const Time  theTime   = Now();
+            size_t      theMaxLen = kLogWriterThreadBufAvgMsgSize;
+            char* const thePtr    = theBufPtr->Reserve(theMaxLen);
+            if (thePtr) {
+                va_list theArgs;
+                va_copy(theArgs, inArgs);
+                const int theLen = ::vsnprintf(
+                    thePtr, theMaxLen, inFmtStrPtr, theArgs);
+                va_end(theArgs);
+                if (0 <= theLen && (size_t)theLen < theMaxLen) {
+                    Commit(*theBufPtr, inLogLevel, theTime, theLen);
+                    return;
+                }
+            }
+        }
         QCStMutexLocker theLocker(mMutex);
+        if (! PrepareToAppend(theBufPtr, theRingFlag)) {
+            return;
+        }
         AppendSelf(inLogLevel, 0, -1, inFmtStrPtr, inArgs);
     }
     void AppendSelf(
@@ -568,8 +644,13 @@ public:
                 0;
             if (inStrLen < 0) {
                 if (theMaxMsgLen > 0) {
+                    // Copy the arguments, as the message might need to be
+                    // formatted again after flush with more buffer space.
+                    va_list theArgs;
+                    va_copy(theArgs, inArgs);
                     theRet += ::vsnprintf(
-                        mCurPtr + theLen, theMaxMsgLen, inFmtStrPtr, inArgs);
+                        mCurPtr + theLen, theMaxMsgLen, inFmtStrPtr, theArgs);
+                    va_end(theArgs);
                 }
             } else {
                 theRet += inStrLen;
@@ -638,6 +719,7 @@ public:
                 if (mWritePtr) {
                     break;
                 }
+                DrainThreadBufs();
                 int64_t theSec      = 0;
                 int64_t theMicroSec = 0;
                 Now(theSec, theMicroSec);
@@ -810,6 +892,20 @@ public:
             return *(new MsgStream(
                 inLogLevel, inDiscardFlag, inTeeStreamPtr));
         }
+        ThreadBuf* const theBufPtr =
+            GetThreadBuf(IsThreadBufLogLevel(inLogLevel));
+        if (theBufPtr && ! theBufPtr->mStreamInUseFlag) {
+            // Use thread's own stream, unless this is nested message.
+            if (theBufPtr->mStreamPtr) {
+                theBufPtr->mStreamPtr->Clear(
+                    inLogLevel, inDiscardFlag, inTeeStreamPtr);
+            } else {
+                theBufPtr->mStreamPtr = new MsgStream(
+                    inLogLevel, inDiscardFlag, inTeeStreamPtr);
+            }
+            theBufPtr->mStreamInUseFlag = true;
+            return *theBufPtr->mStreamPtr;
+        }
         QCStMutexLocker theLocker(mMutex);
         MsgStream* theRetPtr = mMsgStreamHeadPtr;
         if (theRetPtr) {
@@ -827,24 +923,42 @@ public:
     void PutStream(
         ostream& inStream)
     {
-        MsgStream& theStream = static_cast<MsgStream&>(inStream);
+        MsgStream&       theStream  = static_cast<MsgStream&>(inStream);
+        ThreadBuf* const theBufPtr  = GetThreadBuf(false);
+        const bool       theOwnFlag =
+            theBufPtr && theBufPtr->mStreamPtr == &theStream;
         if (! mRunFlag) {
-            delete &theStream;
+            if (theOwnFlag) {
+                ReleaseThreadStream(*theBufPtr);
+            } else {
+                delete &theStream;
+            }
+            return;
+        }
+        const bool theRingFlag = theBufPtr &&
+            IsThreadBufLogLevel(theStream.GetLogLevel());
+        if (theStream.IsDiscard() || (theRingFlag && AppendToThreadBuf(
+                *theBufPtr,
+                theStream.GetLogLevel(),
+                theStream.GetMsgPtr(),
+                theStream.GetMsgLength()))) {
+            if (theOwnFlag) {
+                ReleaseThreadStream(*theBufPtr);
+                return;
+            }
+            QCStMutexLocker theLocker(mMutex);
+            PutStreamSelf(theStream);
             return;
         }
         QCStMutexLocker theLocker(mMutex);
-        if (! theStream.IsDiscard()) {
+        if (PrepareToAppend(theBufPtr, theRingFlag)) {
             AppendSelf(theStream.GetLogLevel(),
                 theStream.GetMsgPtr(), theStream.GetMsgLength());
         }
-        if (mMsgStreamCount < mMaxMsgStreamCount) {
-            theStream.ClearTeeStreamPtr();
-            theStream.tie(0);
-            theStream.Next() = mMsgStreamHeadPtr;
-            mMsgStreamHeadPtr = &theStream;
-            mMsgStreamCount++;
+        if (theOwnFlag) {
+            ReleaseThreadStream(*theBufPtr);
         } else {
-            delete &theStream;
+            PutStreamSelf(theStream);
         }
     }
     void SetUseNonBlockingIo(
@@ -955,6 +1069,142 @@ private:
         MsgStream& operator=(
             const MsgStream&);
     };
+    // Per thread single producer / single consumer ring buffer. The owning
+    // thread appends records without locking, the consumer removes records
+    // with the writer's mutex held. The head and tail are monotonically
+    // increasing byte positions, a record that does not fit at the end of the
+    // buffer is preceded by the "skip to the beginning" marker record.
+    class ThreadBuf
+    {
+    public:
+        typedef uint64_t Pos;
+        enum { kAlign = 16 };
+        struct Record
+        {
+            Time    mTime;
+            int32_t mLogLevel;
+            int32_t mLength;
+
+            const char* GetMsgPtr() const
+                { return reinterpret_cast<const char*>(this + 1); }
+        };
+
+        ThreadBuf(
+            int inSize)
+            : mNextPtr(0),
+              mStreamPtr(0),
+              mStreamInUseFlag(false),
+              mSize((size_t)inSize),
+              mMaxRecordSize(mSize / 4 / kAlign * kAlign),
+              mBufPtr(new char[mSize]),
+              mHead(0),
+              mTail(0),
+              mHeadSeen(0),
+              mSkip(0),
+              mAppendCount(0),
+              mExitedFlag(0)
+            {}
+        ~ThreadBuf()
+        {
+            delete mStreamPtr;
+            delete [] mBufPtr;
+        }
+        // Returns pointer to at least ioLen bytes of contiguous space for the
+        // message, or null if the buffer is full. On success ioLen is set to
+        // the available space.
+        char* Reserve(
+            size_t& ioLen)
+        {
+            if (mMaxRecordSize < ioLen + sizeof(Record)) {
+                return 0;
+            }
+            mHeadSeen = SyncLoadAcquire(mHead);
+            const size_t theFree  = mSize - (size_t)(mTail - mHeadSeen);
+            const size_t thePos   = (size_t)(mTail % mSize);
+            size_t       theAvail = mSize - thePos;
+            mSkip = 0;
+            if (theAvail < ioLen + sizeof(Record)) {
+                mSkip    = theAvail;
+                theAvail = mSize;
+            }
+            if (theFree < mSkip + ioLen + sizeof(Record)) {
+                return 0;
+            }
+            theAvail = min(min(theAvail, theFree - mSkip), mMaxRecordSize);
+            ioLen = theAvail - sizeof(Record);
+            return (mBufPtr + (0 < mSkip ? 0 : thePos) + sizeof(Record));
+        }
+        // Publishes the reserved record. Returns true if the buffer became
+        // half full.
+        bool Commit(
+            LogLevel inLogLevel,
+            Time     inTime,
+            int      inLength)
+        {
+            const size_t thePos = (size_t)(mTail % mSize);
+            if (0 < mSkip) {
+                reinterpret_cast<Record*>(mBufPtr + thePos)->mLength = -1;
+            }
+            Record& theRec =
+                *reinterpret_cast<Record*>(mBufPtr + (0 < mSkip ? 0 : thePos));
+            theRec.mTime     = inTime;
+            theRec.mLogLevel = (int32_t)inLogLevel;
+            theRec.mLength   = (int32_t)inLength;
+            const Pos theUsed = mTail - mHeadSeen;
+            const Pos theTail = mTail + mSkip + Align(sizeof(Record) + inLength);
+            mAppendCount++;
+            SyncSet(mTail, theTail);
+            return (theUsed < mSize / 2 && mSize / 2 <= theTail - mHeadSeen);
+        }
+        const Record* Front()
+        {
+            const Pos theTail = SyncLoadAcquire(mTail);
+            while (mHead != theTail) {
+                const size_t  thePos = (size_t)(mHead % mSize);
+                const Record& theRec =
+                    *reinterpret_cast<const Record*>(mBufPtr + thePos);
+                if (0 <= theRec.mLength) {
+                    return &theRec;
+                }
+                SyncSet(mHead, mHead + (mSize - thePos));
+            }
+            return 0;
+        }
+        void Pop(
+            const Record& inRec)
+            { SyncSet(mHead, mHead + Align(sizeof(Record) + inRec.mLength)); }
+        bool IsEmpty()
+            { return (SyncLoadAcquire(mHead) == SyncLoadAcquire(mTail)); }
+        bool IsExited()
+            { return (SyncLoadAcquire(mExitedFlag) != 0); }
+        void SetExited()
+            { SyncSet(mExitedFlag, 1); }
+        Count GetAppendCount() const
+            { return mAppendCount; }
+
+        ThreadBuf* mNextPtr;
+        MsgStream* mStreamPtr;
+        bool       mStreamInUseFlag;
+    private:
+        const size_t mSize;
+        const size_t mMaxRecordSize;
+        char* const  mBufPtr;
+        volatile Pos mHead;
+        volatile Pos mTail;
+        Pos          mHeadSeen;
+        size_t       mSkip;
+        Count        mAppendCount;
+        volatile int mExitedFlag;
+
+        static size_t Align(
+            size_t inSize)
+            { return ((inSize + kAlign - 1) / kAlign * kAlign); }
+    private:
+        ThreadBuf(
+            const ThreadBuf&);
+        ThreadBuf& operator=(
+            const ThreadBuf&);
+    };
 
     QCMutex      mMutex;
     QCCondVar    mWriteCond;
@@ -1011,6 +1261,12 @@ private:
     int          mMaxMsgStreamCount;
     int          mMsgStreamCount;
     MsgStream*   mMsgStreamHeadPtr;
+    volatile int mThreadBufSize;
+    bool         mThreadBufKeyValidFlag;
+    pthread_key_t mThreadBufKey;
+    Count        mThreadBufAppendCount;
+    Count        mThreadBufOverflowCount;
+    ThreadBuf*   mThreadBufsHeadPtr;
     char         mLogTimeStampPrefixStr[256];
 
     static inline Time Seconds(
@@ -1336,6 +1592,187 @@ private:
         mLogTimeStampSec = inSec;
         return mLogTimeStampPrefixStr;
     }
+    bool IsThreadBufLogLevel(
+        LogLevel inLogLevel) const
+        { return (kLogLevelNOTICE <= inLogLevel && 0 < mThreadBufSize); }
+    ThreadBuf* GetThreadBuf(
+        bool inCreateFlag)
+    {
+        if (! mThreadBufKeyValidFlag) {
+            return 0;
+        }
+        ThreadBuf* thePtr =
+            static_cast<ThreadBuf*>(pthread_getspecific(mThreadBufKey));
+        if (thePtr || ! inCreateFlag) {
+            return thePtr;
+        }
+        const int theSize = mThreadBufSize;
+        if (theSize <= 0) {
+            return 0;
+        }
+        thePtr = new ThreadBuf(theSize);
+        if (pthread_setspecific(mThreadBufKey, thePtr) != 0) {
+            delete thePtr;
+            return 0;
+        }
+        QCStMutexLocker theLocker(mMutex);
+        thePtr->mNextPtr   = mThreadBufsHeadPtr;
+        mThreadBufsHeadPtr = thePtr;
+        return thePtr;
+    }
+    static void ThreadBufExited(
+        void* inPtr)
+    {
+        // The writer thread deletes the buffer once it is drained.
+        static_cast<ThreadBuf*>(inPtr)->SetExited();
+    }
+    void Commit(
+        ThreadBuf& inBuf,
+        LogLevel   inLogLevel,
+        Time       inTime,
+        int        inLength)
+    {
+        if (inBuf.Commit(inLogLevel, inTime, inLength)) {
+            // The writer waits with timeout, therefore notify without mutex,
+            // lost wakeup only delays the ring buffers drain.
+            mWriteCond.Notify();
+        }
+    }
+    bool AppendToThreadBuf(
+        ThreadBuf&  inBuf,
+        LogLevel    inLogLevel,
+        const char* inMsgPtr,
+        int         inLength)
+    {
+        const Time  theTime = Now();
+        size_t      theLen  = (size_t)max(0, inLength);
+        char* const thePtr  = inBuf.Reserve(theLen);
+        if (! thePtr) {
+            return false;
+        }
+        memcpy(thePtr, inMsgPtr, (size_t)max(0, inLength));
+        Commit(inBuf, inLogLevel, theTime, max(0, inLength));
+        return true;
+    }
+    void ReleaseThreadStream(
+        ThreadBuf& inBuf)
+    {
+        inBuf.mStreamPtr->ClearTeeStreamPtr();
+        inBuf.mStreamPtr->tie(0);
+        inBuf.mStreamInUseFlag = false;
+    }
+    void PutStreamSelf(
+        MsgStream& inStream)
+    {
+        if (mMsgStreamCount < mMaxMsgStreamCount) {
+            inStream.ClearTeeStreamPtr();
+            inStream.tie(0);
+            inStream.Next() = mMsgStreamHeadPtr;
+            mMsgStreamHeadPtr = &inStream;
+            mMsgStreamCount++;
+        } else {
+            delete &inStream;
+        }
+    }
+    bool AppendRecord(
+        const ThreadBuf::Record& inRec)
+    {
+        const int64_t theSec      = inRec.mTime / 1000000;
+        const int64_t theMicroSec = inRec.mTime % 1000000;
+        for (int i = 0; ; i++) {
+            const size_t theLen = MsgPrefix(
+                theSec, theMicroSec, (LogLevel)inRec.mLogLevel);
+            if (0 < theLen && mCurPtr + theLen + inRec.mLength < mEndPtr) {
+                memcpy(mCurPtr + theLen, inRec.GetMsgPtr(), inRec.mLength);
+                mCurPtr += theLen + inRec.mLength;
+                *mCurPtr++ = '\n';
+                mMsgAppendCount++;
+                mDroppedCount    = 0;
+                mCurLogWatedTime = 0;
+                return true;
+            }
+            if (0 < i || ! FlushSelf()) {
+                return false;
+            }
+        }
+    }
+    // Moves the ring buffers records into the write buffer, in time stamp
+    // order. Returns false if the write buffers are full.
+    bool DrainThreadBufs()
+    {
+        QCASSERT(mMutex.IsOwned());
+        for (; ;) {
+            ThreadBuf*               theMinPtr    = 0;
+            const ThreadBuf::Record* theMinRecPtr = 0;
+            for (ThreadBuf* thePtr = mThreadBufsHeadPtr;
+                    thePtr;
+                    thePtr = thePtr->mNextPtr) {
+                const ThreadBuf::Record* const theRecPtr = thePtr->Front();
+                if (theRecPtr && (! theMinRecPtr ||
+                        theRecPtr->mTime < theMinRecPtr->mTime)) {
+                    theMinPtr    = thePtr;
+                    theMinRecPtr = theRecPtr;
+                }
+            }
+            if (! theMinPtr) {
+                break;
+            }
+            if (! AppendRecord(*theMinRecPtr)) {
+                return false;
+            }
+            theMinPtr->Pop(*theMinRecPtr);
+        }
+        ThreadBuf** thePtr = &mThreadBufsHeadPtr;
+        while (*thePtr) {
+            ThreadBuf* const theBufPtr = *thePtr;
+            if (theBufPtr->IsExited() && theBufPtr->IsEmpty()) {
+                *thePtr = theBufPtr->mNextPtr;
+                mThreadBufAppendCount += theBufPtr->GetAppendCount();
+                delete theBufPtr;
+            } else {
+                thePtr = &theBufPtr->mNextPtr;
+            }
+        }
+        return true;
+    }
+    // Invoked with the mutex held prior to appending message directly into the
+    // write buffer. Drains the ring buffers first, in order to preserve the
+    // calling thread's message order. Returns false if the message has to be
+    // dropped.
+    bool PrepareToAppend(
+        ThreadBuf* inBufPtr,
+        bool       inOverflowFlag)
+    {
+        if (inOverflowFlag) {
+            mThreadBufOverflowCount++;
+        }
+        if (! mThreadBufsHeadPtr) {
+            return true;
+        }
+        Time theStart = -1;
+        while (! DrainThreadBufs() && inBufPtr && ! inBufPtr->IsEmpty()) {
+            const Time theNow = Now();
+            if (theStart < 0) {
+                theStart = theNow;
+            }
+            const Time theWaited = theNow - theStart;
+            if (! mRunFlag || mMaxLogWaitTime <= theWaited) {
+                mMsgAppendCount++;
+                mDroppedCount++;
+                mTotalDroppedCount++;
+                if (0 < mBufWaitersCount) {
+                    mWriteDoneCond.Notify();
+                }
+                return false;
+            }
+            mBufWaitersCount++;
+            mWriteDoneCond.Wait(mMutex, NanoSec(mMaxLogWaitTime - theWaited));
+            mBufWaitersCount--;
+            mBufWaitedCount++;
+            mTotalLogWaitedTime += Now() - theNow;
+        }
+        return true;
+    }
 private:
     Impl(
         const Impl& inImpl);
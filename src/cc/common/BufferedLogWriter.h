@@ -46,6 +46,12 @@ class Properties;
 // need to prevent blocking on message log write with "bad" disks in the cases
 // where the disk becomes unavailable or just cannot keep up. Chunk and meta
 // servers message log writes are configured with 0 write wait time by default.
+// Optionally, with non 0 "threadBufferSize" parameter, NOTICE, INFO, and DEBUG
+// messages are appended without taking the writer's mutex into per thread
+// single producer / single consumer ring buffers, which the writer thread
+// drains into the write buffer, merging by message time stamp. The time stamp
+// and log level prefix formatting is deferred until then. Ring buffer overflow
+// falls back to the mutex protected append path.
 class BufferedLogWriter
 {
 public:
@@ -70,6 +76,8 @@ public:
         int64_t mWriteErrorCount;
         int64_t mAppendWaitCount;
         int64_t mAppendWaitMicroSecs;
+        int64_t mThreadBufAppendCount;
+        int64_t mThreadBufOverflowCount;
     };
     BufferedLogWriter(
         int         inFd                        = -1,
@@ -0,0 +1,723 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Concurrent variant of the sorted linear hash table (LinearHash).
+//
+// Lookups are lock free. Readers do not write any shared memory, except their
+// own per thread epoch record on entering and leaving the read section.
+// Inserts and erases lock one of the 2^Log2StripeCount stripe mutexes, picked
+// by the low bits of the key hash. The table grows and shrinks one bucket at a
+// time, like LinearHash: split or merge of a bucket is done right after insert
+// or erase with the resize mutex and the bucket stripe mutex held. The minimum
+// number of buckets is the number of stripes, therefore both buckets involved
+// in split or merge always belong to the same stripe. An entry always belongs
+// to the same stripe, and each stripe has its own allocator instance and
+// retired entries list, used with the stripe mutex held. The writers to
+// different stripes do not share any mutex, except for the infrequent epoch
+// reclamation scan. The allocator instances must not share state that is not
+// thread safe. Insert allocates the entry only if the key is not found.
+//
+// The bucket lists are kept sorted, and every list link always points to the
+// entry with greater key, therefore a reader racing with writers always
+// reaches the list end. Split and merge bump the resize sequence number before
+// and after moving the entries. The reader that has not found the key retries
+// the lookup if the sequence number was odd, or has changed.
+//
+// The erased entries are not freed until all readers that might still access
+// them leave their read sections (epoch based reclamation). The delete
+// observer is invoked synchronously by Erase() after the entry is unlinked,
+// while concurrent readers might still access the entry. The entry destructor
+// is invoked later, after the grace period.
+//
+// Find() must be invoked with ReadLock held by the calling thread, unless the
+// calling thread is the only one that erases entries, Get() acquires the lock
+// internally. The returned value pointer remains valid until the read lock is
+// released, or until the entry is erased by the calling thread.
+//
+// The iteration methods (First(), Next(), Iterator, Traverse()), Clear(),
+// and the destructor must not be invoked concurrently with inserts and erases.
+// Iteration is allowed concurrently with lookups. Same as LinearHash, erasing
+// the current cursor entry advances the cursor.
+//
+//----------------------------------------------------------------------------
+
+#ifndef CONCURRENT_LINEAR_HASH_H
+#define CONCURRENT_LINEAR_HASH_H
+
+#include "LinearHash.h"
+#include "kfsatomic.h"
+
+#include "qcdio/QCMutex.h"
+#include "qcdio/qcstutils.h"
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include <cstddef>
+#include <memory>
+#include <deque>
+
+namespace KFS
+{
+
+template<
+  typename KVPairT,
+  typename KeyIdT          = KeyCompare<typename KVPairT::Key>,
+  typename AllocT          = std::allocator<KVPairT>,
+  typename DeleteObserverT = DeleteObserver<KVPairT>,
+  int      Log2StripeCount = 6
+>
+class ConcurrentLinearHash
+{
+public:
+    typedef KVPairT      KVPair;
+    typedef typename KVPair::Key Key;
+    typedef typename KVPair::Val Val;
+    typedef std::size_t  size_t;
+    class Entry
+    {
+    public:
+        Entry(
+            const KVPair& inData,
+            Entry*        inNextPtr)
+            : mData(inData),
+              mNextPtr(inNextPtr)
+            {}
+        Entry(
+            const Entry& inEntry)
+            : mData(inEntry.mData),
+              mNextPtr(inEntry.mNextPtr)
+            {}
+        KVPair& GetData()
+            { return mData; }
+        const KVPair& GetData() const
+            { return mData; }
+    private:
+        KVPair          mData;
+        Entry* volatile mNextPtr;
+
+        friend class ConcurrentLinearHash;
+    private:
+        Entry& operator=(
+            const Entry& inEntry);
+    };
+    typedef typename AllocT::template rebind<Entry>::other Allocator;
+
+private:
+    class Reader;
+public:
+    // Read section guard, can be nested.
+    class ReadLock
+    {
+    public:
+        ReadLock(
+            const ConcurrentLinearHash& inHash)
+            : mReaderPtr(inHash.EnterRead())
+            {}
+        ~ReadLock()
+            { ConcurrentLinearHash::LeaveRead(mReaderPtr); }
+    private:
+        Reader* const mReaderPtr;
+    private:
+        ReadLock(
+            const ReadLock& inLock);
+        ReadLock& operator=(
+            const ReadLock& inLock);
+    };
+    friend class ReadLock;
+
+    static inline size_t MaxSize()
+        { return (size_t(kFirstSegmentSize) << (kMaxSegmentCount - 1)); }
+
+    ConcurrentLinearHash()
+        : mBucketCount(kStripeCount),
+          mSize(0),
+          mResizeSeq(0),
+          mEpoch(1),
+          mNextBucketIdx(0),
+          mNextEntryPtr(0),
+          mKeyId(),
+          mDelObserverPtr(0),
+          mReadersPtr(0),
+          mReaderKey(),
+          mReaderKeyValidFlag(false),
+          mResizeMutex(),
+          mReadersMutex()
+    {
+        for (int i = 0; i < kMaxSegmentCount; i++) {
+            mSegments[i] = 0;
+        }
+        AllocateSegment(0);
+        mReaderKeyValidFlag =
+            pthread_key_create(&mReaderKey, &ReaderExited) == 0;
+    }
+    ~ConcurrentLinearHash()
+    {
+        ConcurrentLinearHash::Clear();
+        if (mReaderKeyValidFlag) {
+            pthread_key_delete(mReaderKey);
+            mReaderKeyValidFlag = false;
+        }
+        while (mReadersPtr) {
+            Reader* const thePtr = mReadersPtr;
+            mReadersPtr = thePtr->mNextPtr;
+            delete thePtr;
+        }
+        for (int i = 0; i < kMaxSegmentCount; i++) {
+            delete [] const_cast<Entry**>(mSegments[i]);
+            mSegments[i] = 0;
+        }
+    }
+    template<typename FT>
+    void Traverse(
+        FT& inFunc) const
+    {
+        const size_t theSize = mBucketCount;
+        for (size_t i = 0; i < theSize; i++) {
+            const Entry* thePtr = BucketRef(i);
+            while (thePtr && inFunc.Traverse(thePtr->GetData())) {
+                thePtr = thePtr->mNextPtr;
+            }
+        }
+    }
+    void SetDeleteObserver(
+        DeleteObserverT* inObserverPtr)
+        { mDelObserverPtr = inObserverPtr; }
+    // Returns the first stripe allocator.
+    const Allocator& GetAllocator() const
+        { return mStripes[0].mAlloc; }
+    size_t GetSize() const
+        { return mSize; }
+    size_t IsEmpty() const
+        { return (mSize == 0); }
+    void Clear()
+    {
+        mNextBucketIdx = 0;
+        mNextEntryPtr  = 0;
+        const size_t theSize = mBucketCount;
+        for (size_t i = 0; i < theSize; i++) {
+            // The bucket index low bits are the same as the hash low bits.
+            Stripe&          theStripe    = mStripes[i & kStripeMask];
+            Entry* volatile& theBucketPtr = BucketRef(i);
+            Entry*           thePtr       = theBucketPtr;
+            theBucketPtr = 0;
+            while (thePtr) {
+                Entry* const theNextPtr = thePtr->mNextPtr;
+                Deleted(*thePtr);
+                Delete(theStripe, thePtr);
+                thePtr = theNextPtr;
+            }
+        }
+        mBucketCount = kStripeCount;
+        mSize        = 0;
+        for (int i = 0; i < kStripeCount; i++) {
+            Stripe&         theStripe = mStripes[i];
+            QCStMutexLocker theLocker(theStripe.mMutex);
+            while (! theStripe.mRetired.empty()) {
+                Delete(theStripe, theStripe.mRetired.front().first);
+                theStripe.mRetired.pop_front();
+            }
+        }
+    }
+    Val* Find(
+        const Key& inKey) const
+    {
+        const size_t theHash = mKeyId.Hash(inKey);
+        for (; ;) {
+            const uint64_t theSeq = SyncLoadAcquire(mResizeSeq);
+            const Entry*   thePtr = SyncLoadAcquire(
+                BucketRef(BucketIdx(SyncLoadAcquire(mBucketCount), theHash)));
+            while (thePtr) {
+                if (mKeyId.Equals(inKey, thePtr->GetData().GetKey())) {
+                    return const_cast<Val*>(&(thePtr->GetData().GetVal()));
+                }
+                thePtr = SyncLoadAcquire(thePtr->mNextPtr);
+            }
+            SyncFenceAcquire();
+            if ((theSeq & 1) == 0 && theSeq == SyncLoadAcquire(mResizeSeq)) {
+                break;
+            }
+        }
+        return 0;
+    }
+    bool Get(
+        const Key& inKey,
+        Val&       outVal) const
+    {
+        ReadLock   theLock(*this);
+        const Val* thePtr = Find(inKey);
+        if (! thePtr) {
+            return false;
+        }
+        outVal = *thePtr;
+        return true;
+    }
+    Val* Insert(
+        const Key& inKey,
+        const Val& inVal,
+        bool&      outInsertedFlag)
+    {
+        const size_t theHash   = mKeyId.Hash(inKey);
+        Stripe&      theStripe = GetStripe(theHash);
+        Entry*       theEntryPtr;
+        {
+            QCStMutexLocker theLocker(theStripe.mMutex);
+            Entry* volatile* thePrevPtr =
+                &BucketRef(BucketIdx(mBucketCount, theHash));
+            Entry*           thePtr     = *thePrevPtr;
+            while (thePtr && mKeyId.Less(thePtr->GetData().GetKey(), inKey)) {
+                thePrevPtr = &thePtr->mNextPtr;
+                thePtr     = *thePrevPtr;
+            }
+            if (thePtr && mKeyId.Equals(inKey, thePtr->GetData().GetKey())) {
+                outInsertedFlag = false;
+                return &(thePtr->GetData().GetVal());
+            }
+            theEntryPtr = New(theStripe, Entry(KVPair(inKey, inVal), thePtr));
+            SyncStoreRelease(*thePrevPtr, theEntryPtr);
+        }
+        if (mBucketCount < SyncAddAndFetch(mSize, size_t(1))) {
+            Split();
+        }
+        outInsertedFlag = true;
+        return &(theEntryPtr->GetData().GetVal());
+    }
+    size_t Erase(
+        const Key& inKey)
+    {
+        const size_t theHash   = mKeyId.Hash(inKey);
+        Stripe&      theStripe = GetStripe(theHash);
+        {
+            QCStMutexLocker theLocker(theStripe.mMutex);
+            Entry*          thePtr;
+            Entry* volatile* thePrevPtr =
+                &BucketRef(BucketIdx(mBucketCount, theHash));
+            // With good hash function the lists should be short enough.
+            while ((thePtr = *thePrevPtr) &&
+                    ! mKeyId.Equals(inKey, thePtr->GetData().GetKey())) {
+                thePrevPtr = &thePtr->mNextPtr;
+            }
+            if (! thePtr) {
+                return 0;
+            }
+            SyncStoreRelease(*thePrevPtr, static_cast<Entry*>(thePtr->mNextPtr));
+            Deleted(*thePtr);
+            Retire(theStripe, thePtr);
+        }
+        const size_t theSize = SyncAddAndFetch(mSize, ~size_t(0));
+        if (kStripeCount < mBucketCount && theSize < mBucketCount / 2) {
+            Merge();
+        }
+        return 1;
+    }
+    void First()
+    {
+        mNextEntryPtr  = 0;
+        mNextBucketIdx = 0;
+    }
+    const KVPair* Next()
+    {
+        return NextEntryT(mNextBucketIdx, mNextEntryPtr,
+            static_cast<const KVPair*>(0));
+    }
+    template <typename LHashT, typename EntryT, typename KeyValT>
+    class IteratorT
+    {
+    public:
+        IteratorT(
+                LHashT& inHashTable)
+            : mNextBucketIdx(0),
+              mNextEntryPtr(0),
+              mHashTable(inHashTable)
+            {}
+        KeyValT* Next()
+        {
+            return mHashTable.template NextEntryT(
+                mNextBucketIdx, mNextEntryPtr, static_cast<KeyValT*>(0));
+        }
+    private:
+        size_t  mNextBucketIdx;
+        EntryT* mNextEntryPtr;
+        LHashT& mHashTable;
+    };
+    friend class IteratorT<
+        ConcurrentLinearHash, Entry, const KVPair>;
+    friend class IteratorT<
+        const ConcurrentLinearHash, const Entry, const KVPair>;
+    typedef IteratorT<
+        ConcurrentLinearHash, Entry, const KVPair>             Iterator;
+    typedef IteratorT<
+        const ConcurrentLinearHash, const Entry, const KVPair> ConstIterator;
+
+private:
+    enum
+    {
+        kStripeCount          = 1 << Log2StripeCount,
+        kStripeMask           = kStripeCount - 1,
+        kLog2FirstSegmentSize = Log2StripeCount < 7 ? 7 : Log2StripeCount,
+        kFirstSegmentSize     = 1 << kLog2FirstSegmentSize,
+        kMaxSegmentCount      = (int)(sizeof(size_t) * 8) -
+            kLog2FirstSegmentSize,
+        kReclaimInterval      = 128
+    };
+    // Per thread epoch record, padded to avoid false sharing.
+    class Reader
+    {
+    public:
+        Reader()
+            : mEpoch(0),
+              mInUseFlag(1),
+              mNestingLevel(0),
+              mNextPtr(0)
+            {}
+        volatile uint64_t mEpoch;
+        volatile int      mInUseFlag;
+        int               mNestingLevel;
+        Reader*           mNextPtr;
+        char              mPad[64];
+    };
+    typedef std::deque<std::pair<Entry*, uint64_t> > Retired;
+    // Per stripe mutex, allocator, and retired entries, padded to avoid false
+    // sharing.
+    class Stripe
+    {
+    public:
+        Stripe()
+            : mMutex(),
+              mAlloc(),
+              mRetired()
+            {}
+        QCMutex   mMutex;
+        Allocator mAlloc;
+        Retired   mRetired;
+        char      mPad[64];
+    private:
+        Stripe(
+            const Stripe& inStripe);
+        Stripe& operator=(
+            const Stripe& inStripe);
+    };
+
+    // Buckets directory: the first segment has kFirstSegmentSize buckets, the
+    // size of every subsequent segment is doubled. The segments are only
+    // freed by the destructor, as the readers might access the buckets past
+    // the end after the merge.
+    Entry* volatile* volatile mSegments[kMaxSegmentCount];
+    volatile size_t           mBucketCount;
+    volatile size_t           mSize;
+    volatile uint64_t         mResizeSeq;
+    mutable volatile uint64_t mEpoch;
+    size_t                    mNextBucketIdx; // Cursor.
+    Entry*                    mNextEntryPtr;  // Cursor.
+    KeyIdT                    mKeyId;
+    DeleteObserverT*          mDelObserverPtr;
+    mutable Reader*           mReadersPtr;
+    pthread_key_t             mReaderKey;
+    bool                      mReaderKeyValidFlag;
+    QCMutex                   mResizeMutex;
+    mutable QCMutex           mReadersMutex;
+    Stripe                    mStripes[kStripeCount];
+
+    // New() and Delete() must be invoked with the stripe mutex held, or by
+    // the only thread that accesses the table.
+    static Entry* New(
+        Stripe&      inStripe,
+        const Entry& inEntry)
+    {
+        Entry* const thePtr = inStripe.mAlloc.allocate(1);
+        inStripe.mAlloc.construct(thePtr, inEntry);
+        return thePtr;
+    }
+    static void Delete(
+        Stripe& inStripe,
+        Entry*  inEntryPtr)
+    {
+        inStripe.mAlloc.destroy(inEntryPtr);
+        inStripe.mAlloc.deallocate(inEntryPtr, 1);
+    }
+    void Deleted(
+        Entry& inEntry)
+    {
+        if (&inEntry == mNextEntryPtr &&
+                ! (mNextEntryPtr = inEntry.mNextPtr)) {
+            mNextBucketIdx++;
+        }
+        if (mDelObserverPtr) {
+            (*mDelObserverPtr)(inEntry.GetData());
+        }
+    }
+    Reader* EnterRead() const
+    {
+        Reader* const thePtr = GetReader();
+        if (thePtr && thePtr->mNestingLevel++ <= 0) {
+            // Full barrier: the epoch must be visible to the writers before
+            // the table is accessed.
+            SyncSet(thePtr->mEpoch, SyncLoadAcquire(mEpoch));
+        }
+        return thePtr;
+    }
+    static void LeaveRead(
+        Reader* inReaderPtr)
+    {
+        if (inReaderPtr && --inReaderPtr->mNestingLevel <= 0) {
+            inReaderPtr->mNestingLevel = 0;
+            SyncStoreRelease(inReaderPtr->mEpoch, uint64_t(0));
+        }
+    }
+    static void ReaderExited(
+        void* inPtr)
+    {
+        Reader* const thePtr = reinterpret_cast<Reader*>(inPtr);
+        thePtr->mNestingLevel = 0;
+        SyncStoreRelease(thePtr->mEpoch, uint64_t(0));
+        SyncStoreRelease(thePtr->mInUseFlag, 0);
+    }
+    Reader* GetReader() const
+    {
+        if (! mReaderKeyValidFlag) {
+            return 0;
+        }
+        Reader* thePtr =
+            reinterpret_cast<Reader*>(pthread_getspecific(mReaderKey));
+        if (thePtr) {
+            return thePtr;
+        }
+        QCStMutexLocker theLocker(mReadersMutex);
+        // Re-use the record of the exited thread, if any.
+        for (thePtr = mReadersPtr; thePtr; thePtr = thePtr->mNextPtr) {
+            if (! SyncLoadAcquire(thePtr->mInUseFlag)) {
+                thePtr->mNestingLevel = 0;
+                SyncStoreRelease(thePtr->mInUseFlag, 1);
+                break;
+            }
+        }
+        if (! thePtr) {
+            thePtr = new Reader();
+            thePtr->mNextPtr = mReadersPtr;
+            mReadersPtr = thePtr;
+        }
+        if (pthread_setspecific(mReaderKey, thePtr) != 0) {
+            SyncStoreRelease(thePtr->mInUseFlag, 0);
+            return 0;
+        }
+        return thePtr;
+    }
+    // Must be invoked with the stripe mutex held.
+    void Retire(
+        Stripe& inStripe,
+        Entry*  inEntryPtr)
+    {
+        Retired& theRetired = inStripe.mRetired;
+        if (! mReaderKeyValidFlag) {
+            // Cannot track readers, free the entries on Clear() only.
+            theRetired.push_back(std::make_pair(inEntryPtr, uint64_t(0)));
+            return;
+        }
+        // Full barrier: the entry unlink must be visible before the epoch
+        // load.
+        theRetired.push_back(std::make_pair(
+            inEntryPtr, SyncAddAndFetch(mEpoch, uint64_t(0))));
+        if (theRetired.size() % kReclaimInterval != 0) {
+            return;
+        }
+        // Free the entries retired before the oldest epoch of the readers
+        // that are currently in the read sections.
+        const uint64_t theMinEpoch = AdvanceEpoch();
+        while (! theRetired.empty() &&
+                theRetired.front().second < theMinEpoch) {
+            Delete(inStripe, theRetired.front().first);
+            theRetired.pop_front();
+        }
+    }
+    // Advances the epoch, and returns the oldest epoch of the readers in the
+    // read sections, or the new epoch if there are no such readers.
+    uint64_t AdvanceEpoch() const
+    {
+        uint64_t        theMinEpoch = SyncAddAndFetch(mEpoch, uint64_t(1));
+        QCStMutexLocker theLocker(mReadersMutex);
+        for (const Reader* thePtr = mReadersPtr;
+                thePtr;
+                thePtr = thePtr->mNextPtr) {
+            const uint64_t theEpoch = SyncLoadAcquire(thePtr->mEpoch);
+            if (theEpoch != 0 && theEpoch < theMinEpoch) {
+                theMinEpoch = theEpoch;
+            }
+        }
+        return theMinEpoch;
+    }
+    Stripe& GetStripe(
+        size_t inHash)
+        { return mStripes[inHash & kStripeMask]; }
+    static int GetMsb(
+        size_t inValue)
+    {
+#if defined(__GNUC__)
+        return ((int)(sizeof(inValue) * 8) - 1 - __builtin_clzl(inValue));
+#else
+        int theRet = 0;
+        while (inValue >>= 1) {
+            theRet++;
+        }
+        return theRet;
+#endif
+    }
+    static size_t BucketIdx(
+        size_t inBucketCount,
+        size_t inHash)
+    {
+        // The bucket count is always greater or equal to the stripe count,
+        // therefore the low bits of the bucket index and the hash are the
+        // same, and both split buckets are in the same stripe.
+        const size_t theMaxSplitIdx = size_t(1) << GetMsb(inBucketCount);
+        const size_t theIdx         = inHash & (theMaxSplitIdx - 1);
+        return (theIdx < inBucketCount - theMaxSplitIdx ?
+            (inHash & (theMaxSplitIdx + theMaxSplitIdx - 1)) :
+            theIdx);
+    }
+    Entry* volatile& BucketRef(
+        size_t inIdx) const
+    {
+        const size_t theIdx = inIdx + kFirstSegmentSize;
+        const int    theMsb = GetMsb(theIdx);
+        return SyncLoadAcquire(mSegments[theMsb - kLog2FirstSegmentSize])[
+            theIdx - (size_t(1) << theMsb)];
+    }
+    bool AllocateSegment(
+        size_t inIdx)
+    {
+        const int theSegIdx = GetMsb(inIdx + kFirstSegmentSize) -
+            kLog2FirstSegmentSize;
+        if (kMaxSegmentCount <= theSegIdx) {
+            return false;
+        }
+        if (mSegments[theSegIdx]) {
+            return true;
+        }
+        const size_t theSize = size_t(kFirstSegmentSize) << theSegIdx;
+        Entry** const thePtr = new Entry*[theSize];
+        for (size_t i = 0; i < theSize; i++) {
+            thePtr[i] = 0;
+        }
+        SyncStoreRelease(mSegments[theSegIdx], (Entry* volatile*)thePtr);
+        return true;
+    }
+    void Split()
+    {
+        QCStMutexLocker theResizeLocker(mResizeMutex);
+        const size_t theCount = mBucketCount;
+        if (mSize <= theCount || MaxSize() <= theCount + 1 ||
+                ! AllocateSegment(theCount)) {
+            return;
+        }
+        const size_t theNewCount = theCount + 1;
+        const size_t thePrevIdx  = theCount - (size_t(1) << GetMsb(theCount));
+        QCStMutexLocker theLocker(mStripes[thePrevIdx & kStripeMask].mMutex);
+        SyncAddAndFetch(mResizeSeq, uint64_t(1));
+        // Split into prev and new buckets, preserving the order.
+        Entry* volatile* theTailPtr = &BucketRef(theCount);
+        Entry* volatile* thePrevPtr = &BucketRef(thePrevIdx);
+        Entry*           thePtr     = *thePrevPtr;
+        while (thePtr) {
+            Entry* const theNextPtr = thePtr->mNextPtr;
+            if (BucketIdx(theNewCount,
+                    mKeyId.Hash(thePtr->GetData().GetKey())) == thePrevIdx) {
+                thePrevPtr = &thePtr->mNextPtr;
+            } else {
+                // Move the entry into new bucket.
+                SyncStoreRelease(*thePrevPtr, theNextPtr);
+                SyncStoreRelease(thePtr->mNextPtr, static_cast<Entry*>(0));
+                SyncStoreRelease(*theTailPtr, thePtr);
+                theTailPtr = &thePtr->mNextPtr;
+            }
+            thePtr = theNextPtr;
+        }
+        SyncStoreRelease(mBucketCount, theNewCount);
+        SyncAddAndFetch(mResizeSeq, uint64_t(1));
+    }
+    void Merge()
+    {
+        QCStMutexLocker theResizeLocker(mResizeMutex);
+        const size_t theCount = mBucketCount;
+        if (theCount <= kStripeCount || theCount / 2 <= mSize) {
+            return;
+        }
+        const size_t theNewCount = theCount - 1;
+        const size_t theIdx      =
+            theNewCount - (size_t(1) << GetMsb(theNewCount));
+        QCStMutexLocker theLocker(mStripes[theIdx & kStripeMask].mMutex);
+        SyncAddAndFetch(mResizeSeq, uint64_t(1));
+        Entry* volatile& thePrevBucketPtr = BucketRef(theNewCount);
+        Entry*           thePtr           = thePrevBucketPtr;
+        SyncStoreRelease(thePrevBucketPtr, static_cast<Entry*>(0));
+        // Merge two sorted lists.
+        Entry* volatile* theInsertPrevPtr = &BucketRef(theIdx);
+        Entry*           theInsertPtr     = *theInsertPrevPtr;
+        while (thePtr) {
+            Entry* const theNextPtr = thePtr->mNextPtr;
+            while (theInsertPtr && mKeyId.Less(theInsertPtr->GetData().GetKey(),
+                    thePtr->GetData().GetKey())) {
+                theInsertPrevPtr = &theInsertPtr->mNextPtr;
+                theInsertPtr     = *theInsertPrevPtr;
+            }
+            if (! theInsertPtr) {
+                SyncStoreRelease(*theInsertPrevPtr, thePtr);
+                break;
+            }
+            SyncStoreRelease(thePtr->mNextPtr, theInsertPtr);
+            SyncStoreRelease(*theInsertPrevPtr, thePtr);
+            theInsertPrevPtr = &thePtr->mNextPtr;
+            thePtr           = theNextPtr;
+        }
+        SyncStoreRelease(mBucketCount, theNewCount);
+        SyncAddAndFetch(mResizeSeq, uint64_t(1));
+    }
+    template<typename ET, typename RT>
+    RT* NextEntryT(
+        size_t& ioNextBucketIdx,
+        ET*&    ioNextEntryPtr,
+        RT*     outRetTypePtr = 0) const
+    {
+        if (! ioNextEntryPtr) {
+            const size_t theSize = mBucketCount;
+            while (ioNextBucketIdx < theSize &&
+                    ! (ioNextEntryPtr = BucketRef(ioNextBucketIdx))) {
+                ioNextBucketIdx++;
+            }
+            if (! ioNextEntryPtr) {
+                return 0;
+            }
+        }
+        RT& theRet = ioNextEntryPtr->GetData();
+        if (! (ioNextEntryPtr = ioNextEntryPtr->mNextPtr)) {
+            ioNextBucketIdx++;
+        }
+        return &theRet;
+    }
+private:
+    ConcurrentLinearHash(
+        const ConcurrentLinearHash& inHash);
+    ConcurrentLinearHash& operator=(
+        const ConcurrentLinearHash& inHash);
+};
+
+} // namespace KFS
+
+#endif /* CONCURRENT_LINEAR_HASH_H */
@@ -42,6 +42,7 @@ namespace KFS
 {
 using std::string;
 using std::min;
+using std::max;
 using std::make_pair;
 using std::pair;
 using std::vector;
@@ -236,10 +237,12 @@ public:
         char* theEndPtr = 0;
         if ((inPtr[inLen - 1] & 0xFF) <= ' ') {
             ParseFloatSelf(inPtr, &theEndPtr, outValue);
-        } else {
-            StringBufT<64> theTmp(inPtr, inLen);
-            ParseFloatSelf(theTmp.GetPtr(), &theEndPtr, outValue);
+            return ((*theEndPtr & 0xFF) <= ' ');
         }
+        // The end pointer refers to the temporary buffer, and must be checked
+        // while the buffer is in scope.
+        StringBufT<64> theTmp(inPtr, inLen);
+        ParseFloatSelf(theTmp.GetPtr(), &theEndPtr, outValue);
         return ((*theEndPtr & 0xFF) <= ' ');
     }
     static void ParseFloatSelf(
@@ -474,6 +477,13 @@ private:
 
 typedef PropertiesTokenizerT<':', '\n'> PropertiesTokenizer;
 
+// The dictionary keys are kept in sorted vector. In addition to that, once
+// all keys are inserted, which normally happens only once at startup with
+// the request parser definitions, BuildPerfectHash() builds perfect hash table
+// by searching for the hash function seed that maps the known keys into
+// distinct table slots. The lookup then requires one hash and one key
+// comparison. The binary search is used if perfect hash can not be found, or
+// was not built yet. Insert discards the perfect hash table.
 template <typename TOKEN, typename VALUE, typename TOKEN2KEY>
 class RequestParserDictionaryT
 {
@@ -491,6 +501,7 @@ private:
             { return (inLhs.first < inRhs.first); }
     };
     typedef vector<Entry> Vector;
+    typedef vector<int>   HashTable;
 
 public:
     typedef typename Token2Key::ScratchBuf  ScratchBuf;
@@ -499,7 +510,10 @@ public:
     typedef typename Vector::iterator       iterator;
 
     RequestParserDictionaryT()
-        : mVector()
+        : mVector(),
+          mHashTable(),
+          mHashSeed(0),
+          mHashMask(0)
         {}
     ~RequestParserDictionaryT()
         {}
@@ -518,6 +532,12 @@ public:
             return end();
         }
         const Key theKey = Token2Key::ToKey(inToken);
+        if (! mHashTable.empty()) {
+            const int theIdx =
+                mHashTable[Hash(theKey, mHashSeed) & mHashMask];
+            return ((0 <= theIdx && mVector[theIdx].first == theKey) ?
+                begin() + theIdx : end());
+        }
         const_iterator const theIt = lower_bound(begin(), end(),
             make_pair(theKey, Value()), Less());
         return ((theIt == end() || theIt->first == theKey) ? theIt : end());
@@ -529,20 +549,97 @@ public:
             return make_pair(end(), false);
         }
         const Key theKey = Token2Key::ToKey(inKv.first);
-        iterator const theIt = lower_bound(begin(), end(),
+        iterator theIt = lower_bound(begin(), end(),
             make_pair(theKey, Value()), Less());
         if (theIt != mVector.end() && theIt->first == theKey) {
             return make_pair(theIt, false);
         }
-        return make_pair(mVector.insert(
-            theIt, make_pair(theKey, inKv.second)), true);
+        const size_t theIdx = theIt - begin();
+        mVector.insert(theIt, make_pair(theKey, inKv.second));
+        mHashTable.clear();
+        return make_pair(begin() + theIdx, true);
+    }
+    void BuildPerfectHash()
+    {
+        mHashTable.clear();
+        const size_t theCount = mVector.size();
+        size_t       theSize  = 1;
+        while (theSize < theCount * 2) {
+            theSize <<= 1;
+        }
+        const size_t theMaxSize = max(theSize, theCount * kMaxHashTableRatio);
+        for (; theSize <= theMaxSize; theSize <<= 1) {
+            for (unsigned int theSeed = 1;
+                    theSeed <= kMaxHashSeedTries;
+                    theSeed++) {
+                mHashTable.assign(theSize, -1);
+                size_t i;
+                for (i = 0; i < theCount; i++) {
+                    int& theSlot = mHashTable[
+                        Hash(mVector[i].first, theSeed) & (theSize - 1)];
+                    if (0 <= theSlot) {
+                        break;
+                    }
+                    theSlot = (int)i;
+                }
+                if (i == theCount) {
+                    mHashSeed = theSeed;
+                    mHashMask = theSize - 1;
+                    return;
+                }
+            }
+        }
+        mHashTable.clear();
     }
     static Token GetName(
             Key        inKey,
             ScratchBuf inBuf)
         { return Token2Key::ToName(inKey, inBuf); }
+    bool HasPerfectHash() const
+        { return (! mHashTable.empty()); }
 private:
-    Vector mVector;
+    enum { kMaxHashSeedTries  = 64 };
+    enum { kMaxHashTableRatio = 64 };
+
+    Vector       mVector;
+    HashTable    mHashTable;
+    unsigned int mHashSeed;
+    size_t       mHashMask;
+
+    static size_t Mix(
+        unsigned int inHash)
+    {
+        unsigned int theHash = inHash;
+        theHash ^= theHash >> 16;
+        theHash *= 0x85EBCA6BU;
+        theHash ^= theHash >> 13;
+        return theHash;
+    }
+    static size_t Hash(
+        unsigned int inKey,
+        unsigned int inSeed)
+        { return Mix((inKey ^ (inSeed * 0x9E3779B9U)) * 0xCC9E2D51U); }
+    static size_t Hash(
+        int          inKey,
+        unsigned int inSeed)
+        { return Hash((unsigned int)inKey, inSeed); }
+    template<typename T>
+    static size_t Hash(
+        const T&     inKey,
+        unsigned int inSeed)
+    {
+        // FNV-1a
+        const unsigned char*       thePtr    =
+            reinterpret_cast<const unsigned char*>(inKey.mPtr);
+        const unsigned char* const theEndPtr = thePtr + inKey.mLen;
+        unsigned int               theHash   =
+            2166136261U ^ (inSeed * 16777619U);
+        while (thePtr < theEndPtr) {
+            theHash ^= *thePtr++;
+            theHash *= 16777619U;
+        }
+        return Mix(theHash);
+    }
 };
 
 template<typename TOKEN>
@@ -713,7 +810,10 @@ public:
     }
     ObjectParser& DefDone()
     {
-        mDefDoneFlag = true;
+        if (! mDefDoneFlag) {
+            mFields.BuildPerfectHash();
+            mDefDoneFlag = true;
+        }
         return *this;
     }
     bool IsDefined() const
@@ -1158,6 +1258,14 @@ public:
         const char* inNamePtr,
         const OBJ*  inNullPtr = 0)
         { return MakeParser(inNamePtr, -1, inNullPtr); }
+    // Must be invoked after the last MakeParser() to build the request name
+    // and id lookup tables.
+    RequestHandler& MakeParsersDone()
+    {
+        mParsers.BuildPerfectHash();
+        mWriters.BuildPerfectHash();
+        return *this;
+    }
 private:
     typedef TOKEN Name;
     typedef FIELDS_MAP<
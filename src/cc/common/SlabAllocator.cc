@@ -0,0 +1,418 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Thread safe slab allocator with per thread free lists.
+//
+//----------------------------------------------------------------------------
+
+#include "SlabAllocator.h"
+#include "kfsatomic.h"
+
+#include "qcdio/QCMutex.h"
+#include "qcdio/qcstutils.h"
+#include "qcdio/qcdebug.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <new>
+#include <string>
+
+namespace KFS
+{
+using std::max;
+using std::min;
+using std::string;
+
+class SlabAllocator::Impl
+{
+public:
+    enum { kGranularity = 16 };
+
+    Impl(
+        const char* inNamePtr,
+        size_t      inMaxItemSize,
+        int         inThreadCacheSize,
+        size_t      inMinSlabSize,
+        size_t      inMaxSlabSize)
+        : mName(inNamePtr ? inNamePtr : ""),
+          mClassCount((max(size_t(kGranularity), inMaxItemSize) +
+            kGranularity - 1) / kGranularity),
+          mThreadCacheSize(max(2, inThreadCacheSize)),
+          mBatchSize(max(1, mThreadCacheSize / 2)),
+          mMaxSlabSize(max(inMinSlabSize, inMaxSlabSize)),
+          mClasses(new SizeClass[mClassCount]),
+          mThreadCachesPtr(0),
+          mStorageListPtr(0),
+          mStorageSize(0),
+          mLargeInUseCount(0),
+          mMutex(),
+          mThreadCacheKey(),
+          mThreadCacheKeyValidFlag(false)
+    {
+        for (size_t i = 0; i < mClassCount; i++) {
+            SizeClass& theClass = mClasses[i];
+            theClass.mItemSize = (i + 1) * kGranularity;
+            theClass.mSlabSize = max(inMinSlabSize, theClass.mItemSize);
+        }
+        mThreadCacheKeyValidFlag =
+            pthread_key_create(&mThreadCacheKey, &ThreadExited) == 0;
+    }
+    ~Impl()
+    {
+        if (mThreadCacheKeyValidFlag) {
+            pthread_key_delete(mThreadCacheKey);
+            mThreadCacheKeyValidFlag = false;
+        }
+        int64_t theInUseCount = mLargeInUseCount;
+        QCStMutexLocker theLocker(mMutex);
+        while (mThreadCachesPtr) {
+            ThreadCache* const thePtr = mThreadCachesPtr;
+            mThreadCachesPtr = thePtr->mNextPtr;
+            ReleaseSelf(*thePtr);
+            delete thePtr;
+        }
+        for (size_t i = 0; i < mClassCount; i++) {
+            theInUseCount +=
+                mClasses[i].mItemCount - mClasses[i].mFreeList.mCount;
+        }
+        theLocker.Unlock();
+        if (0 < theInUseCount) {
+            return; // Memory leak, the same as PoolAllocator.
+        }
+        while (mStorageListPtr) {
+            char* const thePtr = mStorageListPtr;
+            mStorageListPtr = *reinterpret_cast<char**>(thePtr);
+            delete [] thePtr;
+        }
+        delete [] mClasses;
+    }
+    void* Allocate(
+        size_t inSize)
+    {
+        const size_t theIdx = GetClassIdx(inSize);
+        if (mClassCount <= theIdx) {
+            SyncAddAndFetch(mLargeInUseCount, int64_t(1));
+            return ::operator new(inSize);
+        }
+        ThreadCache* const theCachePtr = GetThreadCache();
+        if (! theCachePtr) {
+            QCStMutexLocker theLocker(mMutex);
+            FreeList theList;
+            Get(theIdx, 1, theList);
+            return theList.Pop();
+        }
+        FreeList& theList = theCachePtr->mLists[theIdx];
+        if (! theList.mHeadPtr) {
+            QCStMutexLocker theLocker(mMutex);
+            Get(theIdx, mBatchSize, theList);
+        }
+        return theList.Pop();
+    }
+    void Deallocate(
+        void*  inPtr,
+        size_t inSize)
+    {
+        if (! inPtr) {
+            return;
+        }
+        const size_t theIdx = GetClassIdx(inSize);
+        if (mClassCount <= theIdx) {
+            SyncAddAndFetch(mLargeInUseCount, int64_t(-1));
+            ::operator delete(inPtr);
+            return;
+        }
+        ThreadCache* const theCachePtr = GetThreadCache();
+        if (! theCachePtr) {
+            QCStMutexLocker theLocker(mMutex);
+            mClasses[theIdx].mFreeList.Push(inPtr);
+            return;
+        }
+        FreeList& theList = theCachePtr->mLists[theIdx];
+        theList.Push(inPtr);
+        if (mThreadCacheSize < theList.mCount) {
+            QCStMutexLocker theLocker(mMutex);
+            Put(theIdx, mBatchSize, theList);
+        }
+    }
+    void Show(
+        ostream& inStream) const
+    {
+        int64_t theTotalInUse = 0;
+        int64_t theTotalFree  = 0;
+        QCStMutexLocker theLocker(mMutex);
+        for (size_t i = 0; i < mClassCount; i++) {
+            const SizeClass& theClass = mClasses[i];
+            if (theClass.mItemCount <= 0) {
+                continue;
+            }
+            int64_t theFree = theClass.mFreeList.mCount;
+            for (const ThreadCache* thePtr = mThreadCachesPtr;
+                    thePtr;
+                    thePtr = thePtr->mNextPtr) {
+                theFree += thePtr->mLists[i].mCount;
+            }
+            const int64_t theInUse = theClass.mItemCount - theFree;
+            inStream << mName << " pool " << theClass.mItemSize << ": " <<
+                theInUse << "," << theFree << "\r\n";
+            theTotalInUse += theInUse;
+            theTotalFree  += theFree;
+        }
+        inStream << mName << " pool total: " <<
+            theTotalInUse    << "," <<
+            theTotalFree     << "," <<
+            mStorageSize     << "," <<
+            mLargeInUseCount << "\r\n";
+    }
+private:
+    // The free list link is stored in the first bytes of the free item.
+    struct FreeList
+    {
+        FreeList()
+            : mHeadPtr(0),
+              mCount(0)
+            {}
+        void Push(
+            void* inPtr)
+        {
+            *reinterpret_cast<char**>(inPtr) = mHeadPtr;
+            mHeadPtr = reinterpret_cast<char*>(inPtr);
+            mCount++;
+        }
+        char* Pop()
+        {
+            char* const theRetPtr = mHeadPtr;
+            mHeadPtr = *reinterpret_cast<char**>(theRetPtr);
+            mCount--;
+            return theRetPtr;
+        }
+        char*        mHeadPtr;
+        volatile int mCount;
+    };
+    struct SizeClass
+    {
+        SizeClass()
+            : mFreeList(),
+              mFreeStoragePtr(0),
+              mFreeStorageEndPtr(0),
+              mItemSize(0),
+              mSlabSize(0),
+              mItemCount(0)
+            {}
+        FreeList mFreeList;
+        char*    mFreeStoragePtr;
+        char*    mFreeStorageEndPtr;
+        size_t   mItemSize;
+        size_t   mSlabSize;
+        int64_t  mItemCount;
+    };
+    struct ThreadCache
+    {
+        ThreadCache(
+            Impl&  inImpl,
+            size_t inClassCount)
+            : mImpl(inImpl),
+              mNextPtr(0),
+              mLists(new FreeList[inClassCount])
+            {}
+        ~ThreadCache()
+            { delete [] mLists; }
+        Impl&        mImpl;
+        ThreadCache* mNextPtr;
+        FreeList*    mLists;
+    private:
+        ThreadCache(
+            const ThreadCache& inCache);
+        ThreadCache& operator=(
+            const ThreadCache& inCache);
+    };
+
+    const string     mName;
+    const size_t     mClassCount;
+    const int        mThreadCacheSize;
+    const int        mBatchSize;
+    const size_t     mMaxSlabSize;
+    SizeClass*       mClasses;
+    ThreadCache*     mThreadCachesPtr;
+    char*            mStorageListPtr;
+    int64_t          mStorageSize;
+    volatile int64_t mLargeInUseCount;
+    mutable QCMutex  mMutex;
+    pthread_key_t    mThreadCacheKey;
+    bool             mThreadCacheKeyValidFlag;
+
+    static size_t GetClassIdx(
+        size_t inSize)
+        { return (inSize <= 0 ? size_t(0) : (inSize - 1) / kGranularity); }
+    ThreadCache* GetThreadCache()
+    {
+        if (! mThreadCacheKeyValidFlag) {
+            return 0;
+        }
+        ThreadCache* thePtr =
+            static_cast<ThreadCache*>(pthread_getspecific(mThreadCacheKey));
+        if (thePtr) {
+            return thePtr;
+        }
+        thePtr = new ThreadCache(*this, mClassCount);
+        if (pthread_setspecific(mThreadCacheKey, thePtr) != 0) {
+            delete thePtr;
+            return 0;
+        }
+        QCStMutexLocker theLocker(mMutex);
+        thePtr->mNextPtr = mThreadCachesPtr;
+        mThreadCachesPtr = thePtr;
+        return thePtr;
+    }
+    // Moves up to the specified number of items into the list, from the
+    // shared free list first, then from the slab.
+    void Get(
+        size_t    inIdx,
+        int       inCount,
+        FreeList& inList)
+    {
+        SizeClass& theClass = mClasses[inIdx];
+        int        theCount = inCount;
+        while (0 < theCount && theClass.mFreeList.mHeadPtr) {
+            inList.Push(theClass.mFreeList.Pop());
+            theCount--;
+        }
+        if (inList.mHeadPtr) {
+            return;
+        }
+        // Only take items from the slab if the list is empty, in order to
+        // touch the new memory only when it is really needed.
+        if (theClass.mFreeStorageEndPtr <
+                theClass.mFreeStoragePtr + theClass.mItemSize) {
+            AllocateSlab(theClass);
+        }
+        while (0 < theCount && theClass.mFreeStoragePtr + theClass.mItemSize <=
+                theClass.mFreeStorageEndPtr) {
+            inList.Push(theClass.mFreeStoragePtr);
+            theClass.mFreeStoragePtr += theClass.mItemSize;
+            theClass.mItemCount++;
+            theCount--;
+        }
+    }
+    void Put(
+        size_t    inIdx,
+        int       inCount,
+        FreeList& inList)
+    {
+        FreeList& theList = mClasses[inIdx].mFreeList;
+        for (int i = 0; i < inCount && inList.mHeadPtr; i++) {
+            theList.Push(inList.Pop());
+        }
+    }
+    void AllocateSlab(
+        SizeClass& inClass)
+    {
+        // Maintain kGranularity alignment, the first pointer links all slabs.
+        const size_t theHdrSize = kGranularity;
+        const size_t theSize    = theHdrSize + inClass.mSlabSize;
+        char* const  thePtr     = new char[theSize];
+        *reinterpret_cast<char**>(thePtr) = mStorageListPtr;
+        mStorageListPtr            = thePtr;
+        mStorageSize              += theSize;
+        inClass.mFreeStoragePtr    = thePtr + theHdrSize;
+        inClass.mFreeStorageEndPtr = thePtr + theSize;
+        inClass.mSlabSize          = min(mMaxSlabSize, inClass.mSlabSize << 1);
+    }
+    void ReleaseSelf(
+        ThreadCache& inCache)
+    {
+        for (size_t i = 0; i < mClassCount; i++) {
+            FreeList& theList = inCache.mLists[i];
+            Put(i, theList.mCount, theList);
+        }
+    }
+    void Release(
+        ThreadCache* inCachePtr)
+    {
+        QCStMutexLocker theLocker(mMutex);
+        ReleaseSelf(*inCachePtr);
+        ThreadCache** thePtr = &mThreadCachesPtr;
+        while (*thePtr && *thePtr != inCachePtr) {
+            thePtr = &(*thePtr)->mNextPtr;
+        }
+        QCASSERT(*thePtr);
+        if (*thePtr) {
+            *thePtr = inCachePtr->mNextPtr;
+        }
+        theLocker.Unlock();
+        delete inCachePtr;
+    }
+    static void ThreadExited(
+        void* inPtr)
+    {
+        if (! inPtr) {
+            return;
+        }
+        ThreadCache* const theCachePtr = static_cast<ThreadCache*>(inPtr);
+        theCachePtr->mImpl.Release(theCachePtr);
+    }
+private:
+    Impl(
+        const Impl& inImpl);
+    Impl& operator=(
+        const Impl& inImpl);
+};
+
+SlabAllocator::SlabAllocator(
+    const char* inNamePtr,
+    size_t      inMaxItemSize,
+    int         inThreadCacheSize,
+    size_t      inMinSlabSize,
+    size_t      inMaxSlabSize)
+    : mImpl(*(new Impl(inNamePtr, inMaxItemSize, inThreadCacheSize,
+        inMinSlabSize, inMaxSlabSize)))
+{}
+
+SlabAllocator::~SlabAllocator()
+{
+    delete &mImpl;
+}
+
+    void*
+SlabAllocator::Allocate(
+    size_t inSize)
+{
+    return mImpl.Allocate(inSize);
+}
+
+    void
+SlabAllocator::Deallocate(
+    void*  inPtr,
+    size_t inSize)
+{
+    mImpl.Deallocate(inPtr, inSize);
+}
+
+    void
+SlabAllocator::Show(
+    ostream& inStream) const
+{
+    mImpl.Show(inStream);
+}
+
+} // namespace KFS
@@ -0,0 +1,88 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Thread safe slab allocator with per thread free lists, intended to be used
+// by class specific operator new and delete of the frequently allocated
+// polymorphic objects, like RPC requests. The sizes are rounded up to the
+// 16 bytes size class granularity. Each size class is a memory pool similar
+// to PoolAllocator: the slabs are allocated with the size doubling on every
+// allocation, up to the max slab size, and are never released back.
+// Every thread has its own LIFO free list per size class. Allocation and
+// deallocation are lock free, unless the thread's free list is empty or
+// exceeds the thread cache size, in which case half of the thread cache size
+// items are moved from or to the shared free list with the mutex held.
+// The items can be freed by a thread different from the one that allocated
+// them, in which case the item is put onto the freeing thread's free list,
+// and reaches the shared free list only when that list exceeds the thread
+// cache size. Thread's free lists are returned to the shared free lists on
+// thread exit. Sizes larger than the max item size are allocated with global
+// operator new.
+//
+//----------------------------------------------------------------------------
+
+#ifndef KFS_COMMON_SLAB_ALLOCATOR_H
+#define KFS_COMMON_SLAB_ALLOCATOR_H
+
+#include <stddef.h>
+
+#include <ostream>
+
+namespace KFS
+{
+using std::ostream;
+
+class SlabAllocator
+{
+public:
+    SlabAllocator(
+        const char* inNamePtr,
+        size_t      inMaxItemSize     = 4 << 10,
+        int         inThreadCacheSize = 128,
+        size_t      inMinSlabSize     = 16 << 10,
+        size_t      inMaxSlabSize     = 1 << 20);
+    ~SlabAllocator();
+    void* Allocate(
+        size_t inSize);
+    // The size must be the same as the one passed to Allocate().
+    void Deallocate(
+        void*  inPtr,
+        size_t inSize);
+    // Emits one line per non empty size class in the counter manager format:
+    // <name> pool <size>: in use,free
+    // followed by the total line:
+    // <name> pool total: in use,free,storage bytes,large in use
+    // The thread free list sizes are read without synchronization, therefore
+    // the in use and free counts are approximate.
+    void Show(
+        ostream& inStream) const;
+private:
+    class Impl;
+    Impl& mImpl;
+private:
+    SlabAllocator(
+        const SlabAllocator& inAllocator);
+    SlabAllocator& operator=(
+        const SlabAllocator& inAllocator);
+};
+
+} // namespace KFS
+
+#endif /* KFS_COMMON_SLAB_ALLOCATOR_H */
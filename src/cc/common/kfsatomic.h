@@ -54,6 +54,32 @@ template<typename T> T SyncAddAndFetch(volatile T& val, T inc)
     return ret;
 }
 
+template<typename T> void SyncSet(volatile T& val, T newVal)
+{
+    atomicmpl::AtomicLock();
+    val = newVal;
+    atomicmpl::AtomicUnlock();
+}
+
+template<typename T> T SyncLoadAcquire(volatile T& val)
+{
+    atomicmpl::AtomicLock();
+    const T ret = val;
+    atomicmpl::AtomicUnlock();
+    return ret;
+}
+
+template<typename T> void SyncStoreRelease(volatile T& val, T newVal)
+{
+    SyncSet(val, newVal);
+}
+
+inline void SyncFenceAcquire()
+{
+    atomicmpl::AtomicLock();
+    atomicmpl::AtomicUnlock();
+}
+
 #else
 
 template<typename T> T SyncAddAndFetch(volatile T& val, T inc)
@@ -61,6 +87,59 @@ template<typename T> T SyncAddAndFetch(volatile T& val, T inc)
     return __sync_add_and_fetch(&val, inc);
 }
 
+// Full barrier store, for pointers and integers published without holding a
+// mutex, where the store must not be reordered with the subsequent loads.
+template<typename T> void SyncSet(volatile T& val, T newVal)
+{
+    T prev = val;
+    T cur;
+    while ((cur = __sync_val_compare_and_swap(&val, prev, newVal)) != prev) {
+        prev = cur;
+    }
+}
+
+// Acquire load, release store, and acquire fence, for the lock free readers
+// hot path. Unlike a compare and swap, the load does not write the shared cache
+// line.
+#if defined(__ATOMIC_ACQUIRE)
+
+template<typename T> T SyncLoadAcquire(volatile T& val)
+{
+    return __atomic_load_n(&val, __ATOMIC_ACQUIRE);
+}
+
+template<typename T> void SyncStoreRelease(volatile T& val, T newVal)
+{
+    __atomic_store_n(&val, newVal, __ATOMIC_RELEASE);
+}
+
+inline void SyncFenceAcquire()
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+}
+
+#else
+
+template<typename T> T SyncLoadAcquire(volatile T& val)
+{
+    const T ret = val;
+    __sync_synchronize();
+    return ret;
+}
+
+template<typename T> void SyncStoreRelease(volatile T& val, T newVal)
+{
+    __sync_synchronize();
+    val = newVal;
+}
+
+inline void SyncFenceAcquire()
+{
+    __sync_synchronize();
+}
+
+#endif
+
 #endif /* _KFS_ATOMIC_USE_MUTEX */
 }
 
@@ -0,0 +1,277 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Client block cache unit test: partial and last chunk blocks, LRU-2
+// eviction order, chunk version and file invalidation, and size accounting.
+//
+//----------------------------------------------------------------------------
+
+#include "libclient/BlockCache.h"
+#include "kfsio/IOBuffer.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+
+using namespace std;
+using KFS::IOBuffer;
+using KFS::client::BlockCache;
+
+static void
+TestFailed(
+    const char* msg)
+{
+    cerr << "test failed: " << msg << "\n";
+    abort();
+}
+
+const int     kBlockSize     = 16;
+const int64_t kChunkSize     = 1000;
+const int64_t kChunkVersion  = 1;
+// Size of one block with the cache per block overhead.
+const int64_t kBlockCost     = kBlockSize + 160;
+const int     kMaxBlockCount = 4;
+
+static char
+DataByte(
+    int64_t fileId,
+    int64_t chunkId,
+    int64_t pos)
+{
+    return (char)(fileId * 31 + chunkId * 7 + pos);
+}
+
+static void
+Put(
+    BlockCache& cache,
+    int64_t     fileId,
+    int64_t     chunkId,
+    int64_t     version,
+    int64_t     offset,
+    int         size,
+    int64_t     chunkSize = kChunkSize)
+{
+    char buf[256];
+    if ((int)sizeof(buf) < size) {
+        TestFailed("put size");
+    }
+    for (int i = 0; i < size; i++) {
+        buf[i] = DataByte(fileId, chunkId, offset + i);
+    }
+    IOBuffer iobuf;
+    iobuf.CopyIn(buf, size);
+    cache.Put(fileId, chunkId, version, offset, iobuf, chunkSize);
+}
+
+static bool
+Get(
+    BlockCache& cache,
+    int64_t     fileId,
+    int64_t     chunkId,
+    int64_t     version,
+    int64_t     offset,
+    int         size,
+    int64_t     chunkSize = kChunkSize)
+{
+    IOBuffer iobuf;
+    if (! cache.Get(fileId, chunkId, version, offset, size, chunkSize,
+            iobuf)) {
+        if (! iobuf.IsEmpty()) {
+            TestFailed("miss returned data");
+        }
+        return false;
+    }
+    char buf[256];
+    if ((int)sizeof(buf) < size || iobuf.BytesConsumable() != size ||
+            iobuf.CopyOut(buf, size) != size) {
+        TestFailed("hit returned invalid size");
+    }
+    for (int i = 0; i < size; i++) {
+        if (buf[i] != DataByte(fileId, chunkId, offset + i)) {
+            TestFailed("hit returned invalid data");
+        }
+    }
+    return true;
+}
+
+static BlockCache::Stats
+GetStats(
+    BlockCache& cache)
+{
+    BlockCache::Stats stats;
+    cache.GetStats(stats);
+    return stats;
+}
+
+static void
+TestPutGet()
+{
+    BlockCache cache(kMaxBlockCount * kBlockCost, kBlockSize);
+    // Only the fully covered blocks are inserted: [16, 32), [32, 48).
+    Put(cache, 1, 10, kChunkVersion, 3, 50);
+    if (GetStats(cache).mBlockCount != 2) {
+        TestFailed("partial blocks inserted");
+    }
+    if (! Get(cache, 1, 10, kChunkVersion, 20, 20)) {
+        TestFailed("covered range miss");
+    }
+    if (Get(cache, 1, 10, kChunkVersion, 10, 20) ||
+            Get(cache, 1, 10, kChunkVersion, 40, 10)) {
+        TestFailed("partial block hit");
+    }
+    if (Get(cache, 1, 10, kChunkVersion + 1, 20, 4) ||
+            Get(cache, 1, 11, kChunkVersion, 20, 4) ||
+            Get(cache, 2, 10, kChunkVersion, 20, 4)) {
+        TestFailed("different chunk version, chunk, or file hit");
+    }
+    // The last chunk block is shorter than the block size.
+    const int64_t chunkSize = 70;
+    Put(cache, 1, 12, kChunkVersion, 64, 6, chunkSize);
+    if (! Get(cache, 1, 12, kChunkVersion, 64, 6, chunkSize) ||
+            ! Get(cache, 1, 12, kChunkVersion, 66, 2, chunkSize)) {
+        TestFailed("last block miss");
+    }
+    if (Get(cache, 1, 12, kChunkVersion, 64, 6, chunkSize + 1)) {
+        TestFailed("last block hit with different chunk size");
+    }
+    const BlockCache::Stats stats = GetStats(cache);
+    if (stats.mHitCount != 3 || stats.mInsertCount != 3 ||
+            stats.mSize != 2 * kBlockCost + 6 + kBlockCost - kBlockSize) {
+        TestFailed("put get stats");
+    }
+    BlockCache disabled(0, kBlockSize);
+    Put(disabled, 1, 10, kChunkVersion, 0, 64);
+    if (GetStats(disabled).mBlockCount != 0) {
+        TestFailed("disabled cache insert");
+    }
+}
+
+static void
+TestLru2()
+{
+    BlockCache cache(kMaxBlockCount * kBlockCost, kBlockSize);
+    // Blocks 0 .. 3 of chunk 10, blocks 0 and 1 are referenced twice.
+    for (int i = 0; i < kMaxBlockCount; i++) {
+        Put(cache, 1, 10, kChunkVersion, i * kBlockSize, kBlockSize);
+    }
+    if (! Get(cache, 1, 10, kChunkVersion, 0, kBlockSize) ||
+            ! Get(cache, 1, 10, kChunkVersion, kBlockSize, kBlockSize)) {
+        TestFailed("lru2 initial miss");
+    }
+    // The blocks referenced once are evicted first, in lru order: 2, then 3.
+    Put(cache, 1, 10, kChunkVersion, 4 * kBlockSize, kBlockSize);
+    if (Get(cache, 1, 10, kChunkVersion, 2 * kBlockSize, kBlockSize)) {
+        TestFailed("lru2 first once referenced block is not evicted");
+    }
+    if (! Get(cache, 1, 10, kChunkVersion, 3 * kBlockSize, kBlockSize)) {
+        TestFailed("lru2 second once referenced block is evicted");
+    }
+    // Block 3 now referenced twice, block 4 is the only once referenced.
+    Put(cache, 1, 10, kChunkVersion, 5 * kBlockSize, kBlockSize);
+    if (Get(cache, 1, 10, kChunkVersion, 4 * kBlockSize, kBlockSize)) {
+        TestFailed("lru2 once referenced block is not evicted");
+    }
+    for (int i = 0; i < 2; i++) {
+        if (! Get(cache, 1, 10, kChunkVersion, i * kBlockSize, kBlockSize)) {
+            TestFailed("lru2 twice referenced block is evicted");
+        }
+    }
+    // With all other blocks referenced twice, the new block is evicted
+    // first, and no hot block is displaced.
+    if (! Get(cache, 1, 10, kChunkVersion, 5 * kBlockSize, kBlockSize)) {
+        TestFailed("lru2 new block miss");
+    }
+    Put(cache, 1, 10, kChunkVersion, 6 * kBlockSize, kBlockSize);
+    if (Get(cache, 1, 10, kChunkVersion, 6 * kBlockSize, kBlockSize)) {
+        TestFailed("lru2 new block displaced hot block");
+    }
+    const BlockCache::Stats stats = GetStats(cache);
+    if (stats.mBlockCount != kMaxBlockCount || stats.mEvictCount != 3 ||
+            stats.mSize != kMaxBlockCount * kBlockCost) {
+        TestFailed("lru2 eviction stats");
+    }
+}
+
+static void
+TestInvalidate()
+{
+    BlockCache cache(16 * kBlockCost, kBlockSize);
+    Put(cache, 1, 10, kChunkVersion,     0, 2 * kBlockSize);
+    Put(cache, 1, 10, kChunkVersion + 1, 0, 2 * kBlockSize);
+    Put(cache, 1, 11, kChunkVersion,     0, 2 * kBlockSize);
+    Put(cache, 2, 10, kChunkVersion,     0, 2 * kBlockSize);
+    // Reference the blocks twice, invalidation must remove the blocks from
+    // both the lru and history lists.
+    if (! Get(cache, 1, 10, kChunkVersion, 0, kBlockSize) ||
+            ! Get(cache, 2, 10, kChunkVersion, 0, 2 * kBlockSize)) {
+        TestFailed("invalidate initial miss");
+    }
+    // Chunk version change drops the blocks with the other versions only.
+    cache.Invalidate(1, 10, kChunkVersion + 1);
+    if (Get(cache, 1, 10, kChunkVersion, 0, kBlockSize) ||
+            Get(cache, 1, 10, kChunkVersion, kBlockSize, kBlockSize)) {
+        TestFailed("stale chunk version hit");
+    }
+    if (! Get(cache, 1, 10, kChunkVersion + 1, 0, 2 * kBlockSize) ||
+            ! Get(cache, 1, 11, kChunkVersion, 0, 2 * kBlockSize)) {
+        TestFailed("current chunk version or other chunk miss");
+    }
+    if (GetStats(cache).mInvalidateCount != 2) {
+        TestFailed("chunk invalidate count");
+    }
+    // File invalidation drops all file's chunks, and only the file's chunks.
+    cache.Invalidate(1);
+    if (Get(cache, 1, 10, kChunkVersion + 1, 0, kBlockSize) ||
+            Get(cache, 1, 11, kChunkVersion, 0, kBlockSize)) {
+        TestFailed("invalidated file hit");
+    }
+    if (! Get(cache, 2, 10, kChunkVersion, 0, 2 * kBlockSize)) {
+        TestFailed("other file miss");
+    }
+    BlockCache::Stats stats = GetStats(cache);
+    if (stats.mInvalidateCount != 6 || stats.mBlockCount != 2) {
+        TestFailed("file invalidate stats");
+    }
+    cache.Invalidate(2);
+    stats = GetStats(cache);
+    if (stats.mBlockCount != 0 || stats.mSize != 0) {
+        TestFailed("empty cache size");
+    }
+    // The cache remains usable after invalidation.
+    Put(cache, 1, 10, kChunkVersion, 0, kBlockSize);
+    if (! Get(cache, 1, 10, kChunkVersion, 0, kBlockSize)) {
+        TestFailed("insert after invalidate miss");
+    }
+}
+
+    int
+main(
+    int    /* argc */,
+    char** /* argv */)
+{
+    TestPutGet();
+    TestLru2();
+    TestInvalidate();
+    cout << "block cache test passed\n";
+    return 0;
+}
@@ -0,0 +1,475 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Concurrent sorted linear hash table unit, stress, and performance
+// tests. The performance test is comparable to sortedhash, and additionally
+// runs lookups from multiple threads with and without concurrent writer, and
+// inserts and erases from multiple concurrent writer threads.
+//
+// Usage: concurrenthash [key count] [reader thread count]
+//
+//----------------------------------------------------------------------------
+
+#include "common/ConcurrentLinearHash.h"
+#include "common/LinearHash.h"
+#include "common/kfsatomic.h"
+#include "common/time.h"
+
+#include "qcdio/QCThread.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <iostream>
+#include <set>
+#include <vector>
+
+typedef int64_t MyKey;
+struct MyKVPair
+{
+    typedef MyKey Key;
+    typedef MyKey Val;
+
+    MyKey key;
+
+    MyKVPair(const Key& key, const Val& /* val */)
+        : key(key)
+        {}
+    Key& GetKey()             { return key; }
+    const Key& GetKey() const { return key; }
+    Val& GetVal()             { return key; }
+    const Val& GetVal() const { return key; }
+};
+
+struct MyDeleteObserver
+{
+    MyDeleteObserver()
+        : count(0)
+        {}
+    void operator()(MyKVPair& /* kv */)
+        { KFS::SyncAddAndFetch(count, int64_t(1)); }
+    volatile int64_t count;
+};
+
+typedef KFS::ConcurrentLinearHash<
+    MyKVPair,
+    KFS::KeyCompare<MyKey>,
+    std::allocator<MyKVPair>,
+    MyDeleteObserver
+> MyCLH;
+
+typedef KFS::LinearHash<MyKVPair> MySLH;
+
+using namespace std;
+typedef set<MyKey> MySet;
+
+static void
+TestFailed()
+{
+    abort();
+}
+
+static void
+Verify(const MySet& set, MyCLH& ht)
+{
+    if (set.size() != ht.GetSize()) {
+        TestFailed();
+    }
+    for (MySet::const_iterator it = set.begin(); it != set.end(); ++it) {
+        MyCLH::ReadLock lock(ht);
+        const MyKey* const p = ht.Find(*it);
+        if (! p || *p != *it) {
+            TestFailed();
+        }
+    }
+    size_t cnt = 0;
+    ht.First();
+    for (const MyKVPair* p; (p = ht.Next()); cnt++) {
+        if (set.find(p->GetKey()) == set.end()) {
+            TestFailed();
+        }
+    }
+    if (cnt != set.size()) {
+        TestFailed();
+    }
+}
+
+static double
+Elapsed(int64_t start)
+{
+    return (double)(KFS::microseconds() - start) * 1e-6;
+}
+
+// Stable keys are even, and are never erased while the readers run.
+// Transient keys are odd, and are inserted and erased by the writer.
+class Reader : public QCRunnable
+{
+public:
+    Reader()
+        : ht(0),
+          slh(0),
+          start(0),
+          count(0),
+          step(1),
+          passes(1),
+          found(0),
+          stopFlag(0),
+          thread()
+        {}
+    void Start()
+        { thread.Start(this, 256 << 10, "reader"); }
+    virtual void Run()
+    {
+        int64_t k = 0;
+        for (int n = 0; n < passes || (passes <= 0 && ! stopFlag); n++) {
+            MyKey i = start;
+            for (int64_t c = 0; c < count; c++, i += step) {
+                if (slh) {
+                    const MyKey* const p = slh->Find(i);
+                    if (p) {
+                        k++;
+                    }
+                    continue;
+                }
+                MyCLH::ReadLock lock(*ht);
+                const MyKey* const p = ht->Find(i);
+                if (p) {
+                    if (*p != i) {
+                        TestFailed();
+                    }
+                    k++;
+                } else if ((i & 1) == 0) {
+                    TestFailed();
+                }
+            }
+        }
+        found = k;
+    }
+    MyCLH*           ht;
+    const MySLH*     slh;
+    MyKey            start;
+    int64_t          count;
+    MyKey            step;
+    int              passes;
+    int64_t          found;
+    volatile int     stopFlag;
+    QCThread         thread;
+};
+
+typedef vector<Reader*> Readers;
+
+// Inserts and erases its own transient keys, the writers' key sets do not
+// intersect.
+class Writer : public QCRunnable
+{
+public:
+    Writer()
+        : ht(0),
+          start(0),
+          count(0),
+          step(1),
+          passes(1),
+          writes(0),
+          thread()
+        {}
+    void Start()
+        { thread.Start(this, 256 << 10, "writer"); }
+    virtual void Run()
+    {
+        int64_t w = 0;
+        bool    inserted = false;
+        for (int n = 0; n < passes; n++) {
+            MyKey i = start;
+            for (int64_t c = 0; c < count; c++, i += step) {
+                if (! ht->Insert(i, i, inserted) || ! inserted) {
+                    TestFailed();
+                }
+                w++;
+            }
+            // Insert of the existing key must not allocate or modify.
+            if (0 < count && (*ht->Insert(start, start, inserted) != start ||
+                    inserted)) {
+                TestFailed();
+            }
+            i = start;
+            for (int64_t c = 0; c < count; c++, i += step) {
+                if (ht->Erase(i) != 1) {
+                    TestFailed();
+                }
+                w++;
+            }
+        }
+        writes = w;
+    }
+    MyCLH*   ht;
+    MyKey    start;
+    int64_t  count;
+    MyKey    step;
+    int      passes;
+    int64_t  writes;
+    QCThread thread;
+};
+
+static double
+RunReaders(Readers& readers, int passes)
+{
+    const int64_t s = KFS::microseconds();
+    for (size_t i = 0; i < readers.size(); i++) {
+        readers[i]->passes = passes;
+        readers[i]->Start();
+    }
+    for (size_t i = 0; i < readers.size(); i++) {
+        readers[i]->thread.Join();
+    }
+    return Elapsed(s);
+}
+
+int
+main(int argc, char** argv)
+{
+    MyDeleteObserver observer;
+    MyCLH ht;
+    ht.SetDeleteObserver(&observer);
+    bool inserted = false;
+    // Unit test.
+    if (! ht.Insert(500, 500, inserted) || ! inserted) {
+        TestFailed();
+    }
+    if (! ht.Insert(100, 100, inserted) || ! inserted) {
+        TestFailed();
+    }
+    if (! ht.Insert(100, 100, inserted) || inserted) {
+        TestFailed();
+    }
+    MyKey val = 0;
+    if (ht.Get(3, val) || ! ht.Get(500, val) || val != 500) {
+        TestFailed();
+    }
+    ht.Clear();
+    if (observer.count != 2 || ! ht.IsEmpty()) {
+        TestFailed();
+    }
+    observer.count = 0;
+
+    MySet myset;
+    const int kRandTestSize = 100 * 1000;
+    const unsigned int kSeed = 10;
+    srandom(kSeed);
+    for (int i = 0; i < kRandTestSize; i++) {
+        const MyKey r = (MyKey)random();
+        inserted = 0;
+        if (*(ht.Insert(r, r, inserted)) != r) {
+            TestFailed();
+        }
+        if (myset.insert(r).second != inserted) {
+            TestFailed();
+        }
+    }
+    Verify(myset, ht);
+    cout << "inserted: " << ht.GetSize() << " of " << kRandTestSize << "\n";
+
+    srandom(kSeed);
+    int64_t erased = 0;
+    for (int i = 0; i < kRandTestSize; i++) {
+        const MyKey r = (MyKey)random();
+        if (i % 3 != 0) {
+            continue;
+        }
+        const size_t rht  = ht.Erase(r);
+        if (! rht) {
+            MyCLH::ReadLock lock(ht);
+            if (ht.Find(r)) {
+                TestFailed();
+            }
+        }
+        const size_t rset = myset.erase(r);
+        if (rht != rset) {
+            TestFailed();
+        }
+        erased += rht;
+    }
+    Verify(myset, ht);
+    if (observer.count != erased) {
+        TestFailed();
+    }
+    cout << "removed: size: " << ht.GetSize() <<
+        " of " << kRandTestSize << "\n";
+
+    srandom(kSeed);
+    for (int i = 0; i < kRandTestSize; i++) {
+        const MyKey r = (MyKey)random();
+        MyKey v = -1;
+        const bool res = ht.Get(r, v);
+        if (res && v != r) {
+            TestFailed();
+        }
+        if ((myset.find(r) != myset.end()) != res) {
+            TestFailed();
+        }
+    }
+    ht.Clear();
+    observer.count = 0;
+
+    // Stress and performance test.
+    const int64_t nk = argc > 1 ? (int64_t)atof(argv[1]) : (1 << 22);
+    const int     nt = argc > 2 ? atoi(argv[2]) : 4;
+    const MyKey   kStart = 1000 * 1000 + 346;
+    const MyKey   kStep  = 34;
+    int64_t s = KFS::microseconds();
+    int64_t k = 0;
+    for (MyKey i = kStart; k < nk; i += kStep, k++) {
+        if (! ht.Insert(i, i, inserted) || ! inserted) {
+            abort();
+        }
+    }
+    cout << "insert: " << k << " " << Elapsed(s) << "\n";
+
+    Readers readers;
+    for (int i = 0; i < (nt > 0 ? nt : 1); i++) {
+        readers.push_back(new Reader());
+        readers[i]->ht    = &ht;
+        readers[i]->start = kStart;
+        readers[i]->count = nk;
+        readers[i]->step  = kStep;
+    }
+    double e = RunReaders(readers, 1);
+    cout << "find: threads: " << readers.size() << " " <<
+        readers.size() * nk << " " << e << "\n";
+
+    // Find with concurrent writer, that inserts and erases odd keys, causing
+    // splits and merges. The readers also look up odd keys, and validate that
+    // even keys are always found.
+    for (size_t i = 0; i < readers.size(); i++) {
+        readers[i]->step     = kStep / 2;
+        readers[i]->count    = nk * 2;
+        readers[i]->stopFlag = 0;
+    }
+    s = KFS::microseconds();
+    for (size_t i = 0; i < readers.size(); i++) {
+        readers[i]->passes = 0;
+        readers[i]->Start();
+    }
+    int64_t wk = 0;
+    for (int pass = 0; pass < 4; pass++) {
+        k = 0;
+        for (MyKey i = kStart + kStep / 2; k < nk; i += kStep, k++) {
+            if (! ht.Insert(i, i, inserted) || ! inserted) {
+                TestFailed();
+            }
+        }
+        wk += k;
+        if (ht.GetSize() != (size_t)(2 * nk)) {
+            TestFailed();
+        }
+        k = 0;
+        for (MyKey i = kStart + kStep / 2; k < nk; i += kStep, k++) {
+            if (ht.Erase(i) != 1) {
+                TestFailed();
+            }
+        }
+        wk += k;
+    }
+    e = Elapsed(s);
+    for (size_t i = 0; i < readers.size(); i++) {
+        KFS::SyncSet(readers[i]->stopFlag, 1);
+    }
+    int64_t rk = 0;
+    for (size_t i = 0; i < readers.size(); i++) {
+        readers[i]->thread.Join();
+        rk += readers[i]->found;
+    }
+    cout << "find with writer: threads: " << readers.size() <<
+        " found: " << rk << " writes: " << wk << " " << e << "\n";
+    if (observer.count != 4 * nk || ht.GetSize() != (size_t)nk) {
+        TestFailed();
+    }
+
+    // Concurrent writers, each inserts and erases its own odd keys, in the
+    // same key range as the single writer above.
+    const int kMaxWriters = kStep / 2;
+    const int nw          = nt <= 0 ? 1 : (nt < kMaxWriters ? nt : kMaxWriters);
+    vector<Writer*> writers;
+    for (int i = 0; i < nw; i++) {
+        writers.push_back(new Writer());
+        writers[i]->ht     = &ht;
+        writers[i]->start  = kStart + 2 * i + 1;
+        writers[i]->count  = nk / nw;
+        writers[i]->step   = kStep;
+        writers[i]->passes = 4;
+    }
+    s = KFS::microseconds();
+    for (int i = 0; i < nw; i++) {
+        writers[i]->Start();
+    }
+    wk = 0;
+    for (int i = 0; i < nw; i++) {
+        writers[i]->thread.Join();
+        wk += writers[i]->writes;
+        delete writers[i];
+    }
+    e = Elapsed(s);
+    cout << "concurrent writers: threads: " << nw <<
+        " writes: " << wk << " " << e << "\n";
+    if (observer.count != 4 * nk + wk / 2 || ht.GetSize() != (size_t)nk) {
+        TestFailed();
+    }
+
+    s = KFS::microseconds();
+    k = 0;
+    ht.First();
+    int64_t t = 0;
+    for (const MyKVPair* p; (p = ht.Next()); k++) {
+        t += p->GetKey();
+    }
+    cout << "iterate: " << k << " " << Elapsed(s) << " " << t << "\n";
+
+    // Single threaded LinearHash lookups for comparison.
+    MySLH slh;
+    k = 0;
+    for (MyKey i = kStart; k < nk; i += kStep, k++) {
+        slh.Insert(i, i, inserted);
+    }
+    Readers slhReaders(1, new Reader());
+    slhReaders[0]->slh   = &slh;
+    slhReaders[0]->start = kStart;
+    slhReaders[0]->count = nk;
+    slhReaders[0]->step  = kStep;
+    e = RunReaders(slhReaders, 1);
+    delete slhReaders[0];
+    cout << "LinearHash find: " << nk << " " << e << "\n";
+
+    s = KFS::microseconds();
+    k = 0;
+    for (MyKey i = kStart; k < nk; i += kStep, k++) {
+        if (ht.Erase(i) != 1) {
+            abort();
+        }
+    }
+    cout << "erase: " << k << " " << Elapsed(s) << "\n";
+    for (size_t i = 0; i < readers.size(); i++) {
+        delete readers[i];
+    }
+    if (! ht.IsEmpty()) {
+        abort();
+    }
+    return 0;
+}
@@ -0,0 +1,248 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Message log writer per thread ring buffers test. Several producer
+// threads log messages of varying length into minimum size rings, in order to
+// make the records wrap around with the skip marker, and the rings fill up
+// and fall back to the mutex path. The test verifies that every message is
+// written once, intact, and in the producer's order.
+//
+// Usage: logwritertest [messages per thread] [thread count]
+//
+//----------------------------------------------------------------------------
+
+#include "common/BufferedLogWriter.h"
+#include "common/Properties.h"
+
+#include "qcdio/QCThread.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using KFS::BufferedLogWriter;
+using KFS::Properties;
+
+static void
+TestFailed(
+    const char* msg,
+    int         thread = -1,
+    int         seq    = -1)
+{
+    cerr << "test failed: " << msg <<
+        " thread: " << thread << " seq: " << seq << "\n";
+    abort();
+}
+
+// Longer than the ring buffer average message size, and shorter than the
+// maximum ring record size of the minimum size ring.
+const int kMaxPadLen = 700;
+
+static int
+PadLength(
+    int thread,
+    int seq)
+{
+    return ((seq * 37 + thread * 11) % kMaxPadLen);
+}
+
+static char
+PadChar(
+    int thread,
+    int seq,
+    int pos)
+{
+    return (char)('a' + (thread + seq + pos) % 26);
+}
+
+class Producer : public QCRunnable
+{
+public:
+    Producer()
+        : writer(0),
+          index(0),
+          count(0),
+          thread()
+        {}
+    void Start()
+        { thread.Start(this, 256 << 10, "producer"); }
+    virtual void Run()
+    {
+        char pad[kMaxPadLen + 1];
+        for (int i = 0; i < count; i++) {
+            const int len = PadLength(index, i);
+            for (int k = 0; k < len; k++) {
+                pad[k] = PadChar(index, i, k);
+            }
+            pad[len] = 0;
+            writer->Append(BufferedLogWriter::kLogLevelINFO,
+                "lwt %d %d %s", index, i, pad);
+        }
+    }
+    BufferedLogWriter* writer;
+    int                index;
+    int                count;
+    QCThread           thread;
+};
+
+static void
+Verify(
+    const string& log,
+    int           threadCount,
+    int           msgCount)
+{
+    vector<int> next(threadCount, 0);
+    size_t      pos = 0;
+    while (pos < log.size()) {
+        size_t end = log.find('\n', pos);
+        if (end == string::npos) {
+            end = log.size();
+        }
+        const char* const kMsgPrefix = "lwt ";
+        const char* const line       = log.c_str() + pos;
+        const char* const msgPtr     = search(line, log.c_str() + end,
+            kMsgPrefix, kMsgPrefix + strlen(kMsgPrefix));
+        const size_t      msg        = pos + (msgPtr - line);
+        if (msg < end) {
+            // Parse the line copy, as sscanf() might scan the entire string.
+            const string msgStr(log, msg, end - msg);
+            int          thread = -1;
+            int          seq    = -1;
+            int          off    = 0;
+            if (sscanf(msgStr.c_str(), "lwt %d %d%n",
+                    &thread, &seq, &off) != 2 || off <= 0 ||
+                    msgStr.size() <= (size_t)off || msgStr[off] != ' ') {
+                TestFailed("invalid message");
+            }
+            off++;
+            if (thread < 0 || threadCount <= thread) {
+                TestFailed("invalid thread index", thread, seq);
+            }
+            if (seq != next[thread]) {
+                TestFailed("out of order, missing, or duplicate message",
+                    thread, seq);
+            }
+            next[thread]++;
+            const char* const pad = msgStr.c_str() + off;
+            const int         len = PadLength(thread, seq);
+            if (msgStr.size() - off != (size_t)len) {
+                TestFailed("invalid message length", thread, seq);
+            }
+            for (int k = 0; k < len; k++) {
+                if (pad[k] != PadChar(thread, seq, k)) {
+                    TestFailed("corrupted message", thread, seq);
+                }
+            }
+        }
+        pos = end + 1;
+    }
+    for (int i = 0; i < threadCount; i++) {
+        if (next[i] != msgCount) {
+            TestFailed("missing messages", i, next[i]);
+        }
+    }
+}
+
+    int
+main(
+    int    argc,
+    char** argv)
+{
+    const int msgCount    = argc > 1 ? (int)atof(argv[1]) : 20000;
+    const int threadCount = argc > 2 ? atoi(argv[2]) : 4;
+    if (msgCount <= 0 || threadCount <= 0) {
+        cerr << "invalid arguments\n";
+        return 1;
+    }
+    char name[] = "/tmp/logwritertest.XXXXXX";
+    const int fd = mkstemp(name);
+    if (fd < 0) {
+        perror(name);
+        return 1;
+    }
+    unlink(name);
+    BufferedLogWriter writer(dup(fd), 0, 1 << 20);
+    Properties props;
+    // Minimum size rings, and wait instead of dropping the messages when the
+    // write buffers are full.
+    props.setValue("logWriter.logLevel",         "INFO");
+    props.setValue("logWriter.threadBufferSize", "4096");
+    props.setValue("logWriter.waitMicroSec",     "60000000");
+    writer.SetParameters(props, "logWriter.");
+
+    vector<Producer*> producers;
+    for (int i = 0; i < threadCount; i++) {
+        producers.push_back(new Producer());
+        producers[i]->writer = &writer;
+        producers[i]->index  = i;
+        producers[i]->count  = msgCount;
+    }
+    for (int i = 0; i < threadCount; i++) {
+        producers[i]->Start();
+    }
+    for (int i = 0; i < threadCount; i++) {
+        producers[i]->thread.Join();
+        delete producers[i];
+    }
+    writer.Stop();
+    BufferedLogWriter::Counters counters;
+    writer.GetCounters(counters);
+
+    string log;
+    char   buf[64 << 10];
+    ssize_t nrd;
+    if (lseek(fd, 0, SEEK_SET) != 0) {
+        perror(name);
+        return 1;
+    }
+    while (0 < (nrd = read(fd, buf, sizeof(buf)))) {
+        log.append(buf, (size_t)nrd);
+    }
+    close(fd);
+    Verify(log, threadCount, msgCount);
+    cout <<
+        "messages: "           << (int64_t)threadCount * msgCount <<
+        " ring appends: "      << counters.mThreadBufAppendCount <<
+        " ring overflows: "    << counters.mThreadBufOverflowCount <<
+        " dropped: "           << counters.mDroppedCount <<
+    "\n";
+    if (counters.mDroppedCount != 0) {
+        TestFailed("dropped messages");
+    }
+    // Both the ring and the mutex paths must be exercised: the messages
+    // longer than the ring average message size that do not fit into the
+    // remaining ring space, and the messages appended while the ring is full,
+    // take the mutex path.
+    if (counters.mThreadBufAppendCount <= 0 ||
+            counters.mThreadBufOverflowCount <= 0) {
+        TestFailed("ring or mutex path not exercised");
+    }
+    cout << "log writer test passed\n";
+    return 0;
+}
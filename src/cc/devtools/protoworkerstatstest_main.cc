@@ -0,0 +1,275 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Client protocol worker stats test with two worker threads. A fake
+// meta server responds to the chunk allocation lookups with "no entry" after
+// a fixed delay, in order to read holes of the files assigned to both worker
+// threads with one meta server op per read with known latency. The test
+// verifies that the meta server op counters are summed, and the latency
+// percentiles are computed from the merged worker threads latency histograms.
+//
+//----------------------------------------------------------------------------
+
+#include "libclient/KfsProtocolWorker.h"
+#include "common/Properties.h"
+#include "common/kfstypes.h"
+
+#include "qcdio/QCThread.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using KFS::client::KfsProtocolWorker;
+using KFS::Properties;
+using KFS::KFS_STRIPED_FILE_TYPE_NONE;
+
+static void
+TestFailed(
+    const char* msg)
+{
+    cerr << "test failed: " << msg << "\n";
+    abort();
+}
+
+const int kResponseDelayMs = 200;
+const int kFileCount       = 8;
+
+class MetaConnection : public QCRunnable
+{
+public:
+    MetaConnection(
+        int fd)
+        : mFd(fd),
+          mThread()
+        { mThread.Start(this, 256 << 10, "metaconn"); }
+    ~MetaConnection()
+    {
+        mThread.Join();
+        close(mFd);
+    }
+    virtual void Run()
+    {
+        string buf;
+        char   rbuf[4 << 10];
+        ssize_t nrd;
+        while (0 < (nrd = read(mFd, rbuf, sizeof(rbuf)))) {
+            buf.append(rbuf, (size_t)nrd);
+            size_t end;
+            while ((end = buf.find("\r\n\r\n")) != string::npos) {
+                const string req(buf, 0, end + 2);
+                buf.erase(0, end + 4);
+                if (! Respond(req)) {
+                    return;
+                }
+            }
+        }
+    }
+private:
+    int      mFd;
+    QCThread mThread;
+
+    bool Respond(
+        const string& req)
+    {
+        const char* const kSeq = "\r\nCseq: ";
+        const size_t      pos  = req.find(kSeq);
+        if (pos == string::npos) {
+            TestFailed("no request sequence number");
+        }
+        const long long seq = atoll(req.c_str() + pos + strlen(kSeq));
+        // Respond to the connection hello lookup immediately, and to all
+        // other requests with "no entry" after the delay.
+        const bool lookupFlag = req.compare(0, 8, "LOOKUP\r\n") == 0;
+        if (! lookupFlag) {
+            usleep(kResponseDelayMs * 1000);
+        }
+        char resp[128];
+        const int len = snprintf(resp, sizeof(resp),
+            "OK\r\nCseq: %lld\r\nStatus: %d\r\n\r\n",
+            seq, lookupFlag ? 0 : -ENOENT);
+        return (write(mFd, resp, len) == len);
+    }
+    MetaConnection(
+        const MetaConnection&);
+    MetaConnection& operator=(
+        const MetaConnection&);
+};
+
+class MetaServer : public QCRunnable
+{
+public:
+    MetaServer()
+        : mFd(socket(AF_INET, SOCK_STREAM, 0)),
+          mPort(-1),
+          mConnections(),
+          mThread()
+    {
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (mFd < 0 ||
+                bind(mFd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+                listen(mFd, 16) != 0 ||
+                getsockname(mFd, (struct sockaddr*)&addr, &len) != 0) {
+            perror("meta server socket");
+            TestFailed("meta server socket");
+        }
+        mPort = ntohs(addr.sin_port);
+        mThread.Start(this, 256 << 10, "metaserver");
+    }
+    ~MetaServer()
+    {
+        // Shutdown wakes up accept().
+        shutdown(mFd, SHUT_RDWR);
+        mThread.Join();
+        close(mFd);
+        for (size_t i = 0; i < mConnections.size(); i++) {
+            delete mConnections[i];
+        }
+    }
+    virtual void Run()
+    {
+        int fd;
+        while (0 <= (fd = accept(mFd, 0, 0))) {
+            mConnections.push_back(new MetaConnection(fd));
+        }
+    }
+    int GetPort() const
+        { return mPort; }
+private:
+    int                     mFd;
+    int                     mPort;
+    vector<MetaConnection*> mConnections;
+    QCThread                mThread;
+
+    MetaServer(
+        const MetaServer&);
+    MetaServer& operator=(
+        const MetaServer&);
+};
+
+static int64_t
+GetStat(
+    const Properties& stats,
+    const char*       name)
+{
+    const int64_t ret = stats.getValue(name, int64_t(-1));
+    if (ret < 0) {
+        cerr << name << ": no value\n";
+        TestFailed("missing stats counter");
+    }
+    return ret;
+}
+
+    int
+main(
+    int    /* argc */,
+    char** /* argv */)
+{
+    MetaServer metaServer;
+    KfsProtocolWorker::Parameters params;
+    params.mMetaMaxRetryCount = 0;
+    params.mMaxRetryCount     = 0;
+    params.mWorkerThreadCount = 2;
+    {
+        KfsProtocolWorker worker("127.0.0.1", metaServer.GetPort(), &params);
+        worker.Start();
+        // Consecutive file ids are assigned to both worker threads.
+        for (int i = 1; i <= kFileCount; i++) {
+            const KfsProtocolWorker::Request::Params openParams(
+                "/protoworkerstatstest",
+                int64_t(1) << 20,
+                KFS_STRIPED_FILE_TYPE_NONE
+            );
+            char buf[4 << 10];
+            const int64_t status = worker.Execute(
+                KfsProtocolWorker::kRequestTypeRead,
+                1,
+                i,
+                &openParams,
+                buf,
+                (int)sizeof(buf),
+                0,
+                0
+            );
+            if (status != (int64_t)sizeof(buf)) {
+                cerr << "read status: " << status << "\n";
+                TestFailed("unexpected read status");
+            }
+            worker.Execute(KfsProtocolWorker::kRequestTypeReadShutdown, 1, i);
+        }
+        const Properties stats    = worker.GetStats();
+        const int64_t    connects = GetStat(stats, "MetaServer.Connect");
+        const int64_t    count    = GetStat(stats, "MetaServer.OpLatencyCount");
+        const int64_t    p50      = GetStat(stats, "MetaServer.OpLatencyP50");
+        const int64_t    p90      = GetStat(stats, "MetaServer.OpLatencyP90");
+        const int64_t    p99      = GetStat(stats, "MetaServer.OpLatencyP99");
+        const int64_t    p999     = GetStat(stats, "MetaServer.OpLatencyP999");
+        const int64_t    maxVal   = GetStat(stats, "MetaServer.OpLatencyMax");
+        cout <<
+            "meta server connects: " << connects <<
+            " ops: "                 << count <<
+            " latency usec p50: "    << p50 <<
+            " p90: "                 << p90 <<
+            " p99: "                 << p99 <<
+            " p99.9: "               << p999 <<
+            " max: "                 << maxVal <<
+        "\n";
+        worker.Stop();
+        // Each worker thread has its own meta server connection, the counters
+        // must be summed.
+        if (connects != 2) {
+            TestFailed("both worker threads must connect to meta server");
+        }
+        if (count != kFileCount) {
+            TestFailed("meta server op count");
+        }
+        // The percentiles and max must be computed from the merged
+        // histograms, not summed: summed values would be at least twice the
+        // response delay.
+        const int64_t kDelayUsec = int64_t(kResponseDelayMs) * 1000;
+        if (p50 > p90 || p90 > p99 || p99 > p999 || p999 > maxVal) {
+            TestFailed("latency percentiles are not monotonic");
+        }
+        if (maxVal < kDelayUsec || 2 * kDelayUsec <= maxVal) {
+            TestFailed("max latency is not within the response delay range");
+        }
+        if (p50 < kDelayUsec / 2) {
+            TestFailed("p50 latency is less than the response delay");
+        }
+    }
+    cout << "protocol worker stats test passed\n";
+    return 0;
+}
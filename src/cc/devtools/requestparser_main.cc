@@ -26,9 +26,11 @@
 #include "common/BufferInputStream.h"
 #include "common/RequestParser.h"
 #include "common/Properties.h"
+#include "common/time.h"
 
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 #include <iostream>
@@ -206,6 +208,8 @@ Max-appenders: 640000000\r
 /*
     To benchmark:
     ../src/test-scripts/allocatesend.pl 1e6 | ( time src/cc/devtools/requestparser_test q )
+    or, without the input generation and io overhead:
+    src/cc/devtools/requestparser b 1e6
 */
 
 typedef RequestHandler<AbstractTest> ReqHandler;
@@ -215,16 +219,72 @@ static const ReqHandler& MakeRequestHandler()
     return sHandler
         .MakeParser<Test>("ALLOCATE")
         .MakeParser<Test>("xALLOCATE")
+        .MakeParsersDone()
     ;
 }
 static const ReqHandler& sReqHandler = MakeRequestHandler();
 
+static int
+Benchmark(
+    int64_t inCount,
+    bool    inUsePropertiesFlag)
+{
+    const char* const theReqPtr =
+        "ALLOCATE\r\n"
+        "Cseq: 1234567\r\n"
+        "Version: KFS/1.0\r\n"
+        "Client-Protocol-Version: 100\r\n"
+        "Client-host: somehostname\r\n"
+        "Pathname: /sort/job/1/fanout/27/file.27\r\n"
+        "File-handle: 98765432\r\n"
+        "Chunk-offset: 0\r\n"
+        "Chunk-append: 1\r\n"
+        "Space-reserve: 0\r\n"
+        "Max-appenders: 640000000\r\n"
+        "\r\n"
+    ;
+    const size_t      theLen   = strlen(theReqPtr);
+    BufferInputStream theStream;
+    int64_t           theSum   = 0;
+    const int64_t     theStart = microseconds();
+    for (int64_t i = 0; i < inCount; i++) {
+        AbstractTest* const theTestPtr = inUsePropertiesFlag ?
+            Test::Load(theStream.Set(theReqPtr, theLen)) :
+            sReqHandler.Handle(theReqPtr, theLen);
+        if (! theTestPtr) {
+            std::cerr << "parse failure\n";
+            return 1;
+        }
+        theSum += theTestPtr->seq;
+        delete theTestPtr;
+    }
+    const int64_t theTime = microseconds() - theStart;
+    std::cout <<
+        (inUsePropertiesFlag ? "properties" : "request parser") <<
+        " requests: " << inCount <<
+        " usec: "     << theTime <<
+        " ns/op: "    << (inCount <= 0 ? 0. : theTime * 1e3 / inCount) <<
+        " check: "    << (theSum == inCount * 1234567) <<
+    "\n";
+    return 0;
+}
+
 int
 main(int argc, char** argv)
 {
     if (argc <= 1 || (!strcmp(argv[1], "-h") || !strcmp(argv[1], "--help"))) {
+        std::cout << "Usage: " << (argc > 0 ? argv[0] : "requestparser") <<
+            " {q|n|a|p}... < requests\n"
+            " q -- quiet, n -- no parse, a -- allocate only,"
+            " p -- use properties\n"
+            "or: " << (argc > 0 ? argv[0] : "requestparser") <<
+            " b[p] [count] -- report parse ns/op\n";
         return 0;
     }
+    if (strchr(argv[1], 'b')) {
+        return Benchmark(argc > 2 ? (int64_t)atof(argv[2]) : int64_t(1000000),
+            strchr(argv[1], 'p') != 0);
+    }
 
     static char buf[1 << 20];
     char* ptr = buf;
@@ -0,0 +1,195 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Reed-Solomon file write throughput test. Writes the same RS file
+// with the default write path, and with the write behind mode enabled by
+// client.rsWriteBehindSize, and reports the throughput of each.
+//
+//----------------------------------------------------------------------------
+
+#include "libclient/KfsClient.h"
+#include "common/Properties.h"
+#include "common/time.h"
+
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+
+using std::cout;
+using std::cerr;
+using std::string;
+
+using namespace KFS;
+
+static int
+WriteFile(
+    const string& inHost,
+    int           inPort,
+    const char*   inPathPtr,
+    int           inWriteBehindSize,
+    int64_t       inFileSize,
+    int           inWriteSize,
+    int           inSyncInterval,
+    int           inStripeCount,
+    int           inRecoveryStripeCount,
+    int           inStripeSize,
+    const char*   inBufPtr)
+{
+    Properties theProps;
+    char       theVal[32];
+    snprintf(theVal, sizeof(theVal), "%d", inWriteBehindSize);
+    theProps.setValue(string("client.rsWriteBehindSize"), string(theVal));
+    KfsClient* const theClientPtr = Connect(inHost, inPort, &theProps);
+    if (! theClientPtr) {
+        cerr << "failed to connect to: " << inHost << ":" << inPort << "\n";
+        return 1;
+    }
+    const int theFd = theClientPtr->Create(
+        inPathPtr,
+        1,     // replicas
+        false, // exclusive
+        inStripeCount,
+        inRecoveryStripeCount,
+        inStripeSize,
+        KFS_STRIPED_FILE_TYPE_RS
+    );
+    if (theFd < 0) {
+        cerr << inPathPtr << ": " << ErrorCodeToStr(theFd) << "\n";
+        delete theClientPtr;
+        return 1;
+    }
+    const int64_t theStart = microseconds();
+    int64_t       theRem   = inFileSize;
+    int           theCnt   = 0;
+    int           theRet   = 0;
+    while (0 < theRem) {
+        const int     theSize = (int)(theRem < inWriteSize ?
+            theRem : (int64_t)inWriteSize);
+        const ssize_t theRes  = theClientPtr->Write(theFd, inBufPtr, theSize);
+        if (theRes != theSize) {
+            cerr << inPathPtr << ": write: " <<
+                ErrorCodeToStr((int)(theRes < 0 ? theRes : -EIO)) << "\n";
+            theRet = 1;
+            break;
+        }
+        theRem -= theSize;
+        if (0 < inSyncInterval && ++theCnt % inSyncInterval == 0) {
+            const int theStatus = theClientPtr->Sync(theFd);
+            if (theStatus != 0) {
+                cerr << inPathPtr << ": sync: " <<
+                    ErrorCodeToStr(theStatus) << "\n";
+                theRet = 1;
+                break;
+            }
+        }
+    }
+    const int theStatus = theClientPtr->Close(theFd);
+    if (theStatus != 0 && theRet == 0) {
+        cerr << inPathPtr << ": close: " << ErrorCodeToStr(theStatus) << "\n";
+        theRet = 1;
+    }
+    const int64_t theTime = microseconds() - theStart;
+    if (theRet == 0) {
+        cout <<
+            "write behind: " << inWriteBehindSize <<
+            " bytes: "       << inFileSize <<
+            " write size: "  << inWriteSize <<
+            " sec: "         << theTime * 1e-6 <<
+            " MB/sec: "      << (theTime <= 0 ? 0. :
+                inFileSize * 1e6 / ((double)theTime * (1 << 20))) <<
+        "\n";
+    }
+    theClientPtr->Remove(inPathPtr);
+    delete theClientPtr;
+    return theRet;
+}
+
+int
+main(int argc, char** argv)
+{
+    string      theHost;
+    int         thePort                = -1;
+    const char* thePathPtr             = "/rswritebench.dat";
+    int64_t     theFileSize            = int64_t(1) << 30;
+    int         theWriteSize           = 1 << 20;
+    int         theWriteBehindSize     = 8 << 20;
+    int         theSyncInterval        = 0;
+    int         theStripeCount         = 6;
+    int         theRecoveryStripeCount = 3;
+    int         theStripeSize          = 64 << 10;
+    bool        theHelpFlag            = false;
+    int         theOpt;
+
+    while ((theOpt = getopt(argc, argv, "s:p:f:n:w:b:y:k:m:S:h")) != -1) {
+        switch (theOpt) {
+            case 's': theHost                = optarg;                break;
+            case 'p': thePort                = atoi(optarg);          break;
+            case 'f': thePathPtr             = optarg;                break;
+            case 'n': theFileSize            = (int64_t)atof(optarg); break;
+            case 'w': theWriteSize           = (int)atof(optarg);     break;
+            case 'b': theWriteBehindSize     = (int)atof(optarg);     break;
+            case 'y': theSyncInterval        = atoi(optarg);          break;
+            case 'k': theStripeCount         = atoi(optarg);          break;
+            case 'm': theRecoveryStripeCount = atoi(optarg);          break;
+            case 'S': theStripeSize          = atoi(optarg);          break;
+            default:  theHelpFlag            = true;                  break;
+        }
+    }
+    if (theHelpFlag || theHost.empty() || thePort <= 0 ||
+            theWriteSize <= 0 || theFileSize <= 0 ||
+            theWriteBehindSize <= 0) {
+        cout << "Usage: " << argv[0] << "\n"
+            " -s <meta server host>\n"
+            " -p <meta server port>\n"
+            " [-f <file path>, default: " << thePathPtr << "]\n"
+            " [-n <file size>, default: " << theFileSize << "]\n"
+            " [-w <write size>, default: " << theWriteSize << "]\n"
+            " [-b <write behind size>, default: " <<
+                theWriteBehindSize << "]\n"
+            " [-y <sync every n writes>, default: 0 -- no sync]\n"
+            " [-k <data stripes>, default: " << theStripeCount << "]\n"
+            " [-m <recovery stripes>, default: " <<
+                theRecoveryStripeCount << "]\n"
+            " [-S <stripe size>, default: " << theStripeSize << "]\n"
+            "Writes RS file with the default write path, then with the write"
+            " behind enabled.\n"
+        ;
+        return (theHelpFlag ? 0 : 1);
+    }
+    char* const theBufPtr = new char[theWriteSize];
+    for (int i = 0; i < theWriteSize; i++) {
+        theBufPtr[i] = (char)(i * 131 + 7);
+    }
+    int theRet = WriteFile(theHost, thePort, thePathPtr, 0,
+        theFileSize, theWriteSize, theSyncInterval,
+        theStripeCount, theRecoveryStripeCount, theStripeSize, theBufPtr);
+    if (theRet == 0) {
+        theRet = WriteFile(theHost, thePort, thePathPtr, theWriteBehindSize,
+            theFileSize, theWriteSize, theSyncInterval,
+            theStripeCount, theRecoveryStripeCount, theStripeSize, theBufPtr);
+    }
+    delete [] theBufPtr;
+    return theRet;
+}
@@ -0,0 +1,286 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Slab allocator unit test: multi threaded allocation and
+// deallocation, deallocation by a thread different from the one that
+// allocated, thread exit free list release, and large size fallback.
+//
+//----------------------------------------------------------------------------
+
+#include "common/SlabAllocator.h"
+
+#include "qcdio/QCThread.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using KFS::SlabAllocator;
+
+static void
+TestFailed(
+    const char* msg)
+{
+    cerr << "test failed: " << msg << "\n";
+    abort();
+}
+
+struct Totals
+{
+    int64_t inUse;
+    int64_t free;
+    int64_t storage;
+    int64_t large;
+};
+
+static Totals
+GetTotals(
+    const SlabAllocator& alloc)
+{
+    ostringstream os;
+    alloc.Show(os);
+    const string str = os.str();
+    const char* const kTotal = "pool total: ";
+    const size_t pos = str.find(kTotal);
+    Totals ret;
+    if (pos == string::npos || sscanf(str.c_str() + pos + strlen(kTotal),
+            "%lld,%lld,%lld,%lld",
+            (long long*)&ret.inUse, (long long*)&ret.free,
+            (long long*)&ret.storage, (long long*)&ret.large) != 4) {
+        TestFailed("show total line");
+    }
+    return ret;
+}
+
+static size_t
+ItemSize(
+    int i)
+{
+    return (size_t)(8 + (i * 37) % 1000);
+}
+
+static void
+Fill(
+    void*  ptr,
+    size_t size,
+    int    val)
+{
+    memset(ptr, val & 0xFF, size);
+}
+
+static void
+Check(
+    const void* ptr,
+    size_t      size,
+    int         val)
+{
+    const unsigned char* const p = static_cast<const unsigned char*>(ptr);
+    for (size_t i = 0; i < size; i++) {
+        if (p[i] != (unsigned char)(val & 0xFF)) {
+            TestFailed("item content overwritten");
+        }
+    }
+}
+
+typedef vector<void*> Items;
+
+// Allocates, verifies, and frees items of different sizes. With passes
+// greater than 0 the allocations and deallocations are interleaved, otherwise
+// all items are allocated first, and then freed.
+class Worker : public QCRunnable
+{
+public:
+    Worker()
+        : alloc(0),
+          id(0),
+          count(0),
+          passes(8),
+          thread()
+        {}
+    virtual void Run()
+    {
+        Items items(count, (void*)0);
+        for (int i = 0; passes <= 0 && i < count; i++) {
+            items[i] = alloc->Allocate(ItemSize(i));
+            Fill(items[i], ItemSize(i), id + i);
+        }
+        for (int pass = 0; pass < passes; pass++) {
+            for (int i = 0; i < count; i++) {
+                if (items[i]) {
+                    Check(items[i], ItemSize(i), id + i);
+                    alloc->Deallocate(items[i], ItemSize(i));
+                    items[i] = 0;
+                }
+                if ((i + pass) % 3 != 0) {
+                    items[i] = alloc->Allocate(ItemSize(i));
+                    Fill(items[i], ItemSize(i), id + i);
+                }
+            }
+        }
+        for (int i = 0; i < count; i++) {
+            if (items[i]) {
+                Check(items[i], ItemSize(i), id + i);
+                alloc->Deallocate(items[i], ItemSize(i));
+            }
+        }
+    }
+    SlabAllocator* alloc;
+    int            id;
+    int            count;
+    int            passes;
+    QCThread       thread;
+};
+
+// Frees the items allocated by a different thread.
+class Freer : public QCRunnable
+{
+public:
+    Freer()
+        : alloc(0),
+          items(0),
+          thread()
+        {}
+    virtual void Run()
+    {
+        for (size_t i = 0; i < items->size(); i++) {
+            Check((*items)[i], ItemSize((int)i), (int)i);
+            alloc->Deallocate((*items)[i], ItemSize((int)i));
+        }
+        items->clear();
+    }
+    SlabAllocator* alloc;
+    Items*         items;
+    QCThread       thread;
+};
+
+static void
+RunWorkers(
+    SlabAllocator& alloc,
+    int            threadCount,
+    int            itemCount,
+    int            passes)
+{
+    vector<Worker*> workers;
+    for (int i = 0; i < threadCount; i++) {
+        Worker* const w = new Worker();
+        w->alloc  = &alloc;
+        w->id     = i;
+        w->count  = itemCount;
+        w->passes = passes;
+        workers.push_back(w);
+        w->thread.Start(w, 256 << 10, "worker");
+    }
+    for (int i = 0; i < threadCount; i++) {
+        workers[i]->thread.Join();
+        delete workers[i];
+    }
+}
+
+// Allocates the same items as the exited thread, with the minimal thread
+// cache size every allocation takes one item from the shared free list, if
+// it is not empty, therefore no free items must remain after the allocation,
+// and no new slabs must be allocated.
+static void
+CheckReuse(
+    SlabAllocator& alloc,
+    Items&         items,
+    int            itemCount,
+    const char*    msg)
+{
+    const Totals t = GetTotals(alloc);
+    if (t.inUse != 0 || t.free != itemCount) {
+        TestFailed(msg);
+    }
+    for (int i = 0; i < itemCount; i++) {
+        items.push_back(alloc.Allocate(ItemSize(i)));
+        Fill(items.back(), ItemSize(i), i);
+    }
+    const Totals t2 = GetTotals(alloc);
+    if (t2.inUse != itemCount || t2.free != 0 || t2.storage != t.storage) {
+        TestFailed(msg);
+    }
+}
+
+int
+main(
+    int    argc,
+    char** argv)
+{
+    const int threadCount = argc > 1 ? atoi(argv[1]) : 8;
+    const int itemCount   = argc > 2 ? atoi(argv[2]) : 20000;
+
+    // Multi threaded allocation and deallocation.
+    SlabAllocator alloc("Test", 1 << 10, 128, 4 << 10, 64 << 10);
+    RunWorkers(alloc, threadCount, itemCount, 8);
+    Totals t = GetTotals(alloc);
+    if (t.inUse != 0 || t.free <= 0 || t.large != 0) {
+        TestFailed("multi threaded alloc free");
+    }
+    cout << "threads: " << threadCount << " items: " << itemCount <<
+        " storage: " << t.storage << " free: " << t.free << "\n";
+
+    // Thread exit: the exited thread's free lists must be returned to the
+    // shared free lists.
+    SlabAllocator exitAlloc("Exit", 1 << 10, 2, 4 << 10, 64 << 10);
+    RunWorkers(exitAlloc, 1, itemCount, 0);
+    Items items;
+    CheckReuse(exitAlloc, items, itemCount, "thread exit free list release");
+
+    // Deallocation by a different thread.
+    Freer freer;
+    freer.alloc = &exitAlloc;
+    freer.items = &items;
+    freer.thread.Start(&freer, 256 << 10, "freer");
+    freer.thread.Join();
+    CheckReuse(exitAlloc, items, itemCount, "cross thread free");
+    for (int i = 0; i < itemCount; i++) {
+        Check(items[i], ItemSize(i), i);
+        exitAlloc.Deallocate(items[i], ItemSize(i));
+    }
+    items.clear();
+    if (GetTotals(exitAlloc).inUse != 0) {
+        TestFailed("in use count");
+    }
+
+    // Large size fallback.
+    const size_t kLargeSize = (1 << 10) + 1;
+    void* const large = alloc.Allocate(kLargeSize);
+    Fill(large, kLargeSize, 7);
+    t = GetTotals(alloc);
+    if (t.large != 1 || t.inUse != 0) {
+        TestFailed("large allocation");
+    }
+    Check(large, kLargeSize, 7);
+    alloc.Deallocate(large, kLargeSize);
+    if (GetTotals(alloc).large != 0) {
+        TestFailed("large deallocation");
+    }
+    alloc.Deallocate(0, 16);
+    cout << "passed\n";
+    return 0;
+}
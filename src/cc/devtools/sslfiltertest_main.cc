@@ -40,7 +40,10 @@
 #include <stdio.h>
 #include <fcntl.h>
 
+#include <openssl/ssl.h>
+
 #include <iostream>
+#include <fstream>
 #include <string>
 #include <sstream>
 
@@ -51,6 +54,7 @@ using std::cerr;
 using std::cout;
 using std::string;
 using std::istringstream;
+using std::ifstream;
 
 class SslFilterTest :
     private IAcceptorOwner,
@@ -102,6 +106,7 @@ private:
     int             mMaxReadAhead;
     int             mMaxWriteBehind;
     bool            mUseFilterFlag;
+    bool            mKtlsCheckFlag;
 
     static SslFilterTest* sInstancePtr;
 
@@ -262,6 +267,7 @@ private:
             int                   inMaxWriteBehind,
             bool                  inShutdownFlag,
             bool                  inUserFilterFlag,
+            bool                  inWaitForEchoFlag,
             NetManager&           inNetManager)
             : mConnectionPtr(),
               mSslFilter(
@@ -284,6 +290,8 @@ private:
               mMaxWriteBehind(inMaxWriteBehind),
               mShutdownFlag(inShutdownFlag),
               mUseFilterFlag(inUserFilterFlag),
+              mWaitForEchoFlag(inWaitForEchoFlag),
+              mPendingEchoCount(0),
               mNetManager(inNetManager),
               mInputCB(),
               mOutputCB(),
@@ -366,6 +374,9 @@ private:
                 case EVENT_NET_READ: {
                     IOBuffer& theIoBuf = mInputConnectionPtr->GetInBuffer();
                     QCASSERT(&theIoBuf == inEventDataPtr);
+                    if (mWaitForEchoFlag) {
+                        mPendingEchoCount += theIoBuf.BytesConsumable();
+                    }
                     mConnectionPtr->Write(&theIoBuf);
                     break;
                 }
@@ -384,12 +395,7 @@ private:
                     mCloseConnectionFlag = true;
                     mInputConnectionPtr->Close();
                     mInputConnectionPtr->GetInBuffer().Clear();
-                    if (! mConnectionPtr->IsWriteReady()) {
-                        mConnectionPtr->Close();
-                    }
-                    if (! mOutputConnectionPtr->IsWriteReady()) {
-                        mOutputConnectionPtr->Close();
-                    }
+                    CloseIfDone();
                     break;
 
                 default:
@@ -407,9 +413,8 @@ private:
 
             switch (inEventCode) {
                 case EVENT_NET_WROTE:
-                    if (mCloseConnectionFlag &&
-                            ! mOutputConnectionPtr->IsWriteReady()) {
-                        mOutputConnectionPtr->Close();
+                    if (mCloseConnectionFlag) {
+                        CloseIfDone();
                     }
                     break;
 
@@ -442,7 +447,13 @@ private:
                 case EVENT_NET_READ: {
                     IOBuffer& theIoBuf = mConnectionPtr->GetInBuffer();
                     QCASSERT(&theIoBuf == inEventDataPtr);
+                    if (mWaitForEchoFlag) {
+                        mPendingEchoCount -= theIoBuf.BytesConsumable();
+                    }
                     mOutputConnectionPtr->Write(&theIoBuf);
+                    if (mCloseConnectionFlag) {
+                        CloseIfDone();
+                    }
                     break;
                 }
                 case EVENT_NET_WROTE:
@@ -463,9 +474,8 @@ private:
                             break;
                         }
                     }
-                    if (mCloseConnectionFlag &&
-                            ! mConnectionPtr->IsWriteReady()) {
-                        mConnectionPtr->Close();
+                    if (mCloseConnectionFlag) {
+                        CloseIfDone();
                     }
                     break;
 
@@ -503,6 +513,8 @@ private:
         const int            mMaxWriteBehind;
         const bool           mShutdownFlag;
         const bool           mUseFilterFlag;
+        const bool           mWaitForEchoFlag;
+        int64_t              mPendingEchoCount;
         NetManager&          mNetManager;
         KfsCallbackObj       mInputCB;
         KfsCallbackObj       mOutputCB;
@@ -517,6 +529,21 @@ private:
         {
             return (mConnectionPtr->GetNumBytesToWrite() > mMaxWriteBehind);
         }
+        void CloseIfDone()
+        {
+            // With wait for echo, keep the connections open until all data
+            // sent to the server comes back, and is written to the output.
+            if (0 < mPendingEchoCount || (mWaitForEchoFlag &&
+                    mOutputConnectionPtr->IsWriteReady())) {
+                return;
+            }
+            if (! mConnectionPtr->IsWriteReady()) {
+                mConnectionPtr->Close();
+            }
+            if (! mOutputConnectionPtr->IsWriteReady()) {
+                mOutputConnectionPtr->Close();
+            }
+        }
         int FlowControl()
         {
             if (mRecursionCount > 1) {
@@ -537,7 +564,7 @@ private:
                         mConnectionPtr->SetMaxReadAhead(0);
                     }
                 } else {
-                    if (! mCloseConnectionFlag &&
+                    if ((! mCloseConnectionFlag || 0 < mPendingEchoCount) &&
                             ! IsOverWriteBehindLimit()) {
                         // Set read back again.
                         mConnectionPtr->SetMaxReadAhead(mMaxReadAhead);
@@ -581,7 +608,8 @@ private:
           mPskKey("test"),
           mMaxReadAhead((8 << 10) - 1),
           mMaxWriteBehind((8 << 10) - 1),
-          mUseFilterFlag(true)
+          mUseFilterFlag(true),
+          mKtlsCheckFlag(false)
         {}
     virtual ~SslFilterTest()
     {
@@ -646,6 +674,19 @@ private:
             "sslFilterTest.maxWriteBehind", mMaxWriteBehind);
         mUseFilterFlag = mProperties.getValue(
             "sslFilterTest.useFilter", mUseFilterFlag ? 0 : 1) != 0;
+        mKtlsCheckFlag = mProperties.getValue(
+            "sslFilterTest.ktlsCheck", mKtlsCheckFlag ? 1 : 0) != 0;
+        if (mKtlsCheckFlag) {
+            // Loop stdin back to stdout through the kernel tls connection,
+            // and exit on stdin EOF.
+            if (! IsKtlsAvailable()) {
+                cout << "kernel tls is not available, ktls check skipped\n";
+                MsgLogger::Stop();
+                return 0;
+            }
+            mProperties.setValue(string("sslFilterTest.ktls"), string("1"));
+            mUseFilterFlag = true;
+        }
         int theRet = 0;
         if (0 <= theAcceptPort) {
             const bool kServerFlag  = true;
@@ -705,8 +746,10 @@ private:
                         theServerLocation,
                         mMaxReadAhead,
                         mMaxWriteBehind,
-                        ! mAcceptorPtr, // Shutdown if no acceptor.
+                        // Shutdown if no acceptor.
+                        ! mAcceptorPtr || mKtlsCheckFlag,
                         mUseFilterFlag,
+                        mKtlsCheckFlag, // Wait for echo.
                         mNetManager
                     );
                     if (! theClientPtr->Connect(&theErrMsg)) {
@@ -724,9 +767,59 @@ private:
             sInstancePtr = this;
             mNetManager.MainLoop();
             sInstancePtr = 0;
+            if (mKtlsCheckFlag) {
+                theRet = CheckKtls();
+            }
         }
         SslFilter::FreeCtx(theSslCtxPtr);
         MsgLogger::Stop();
+        return (mKtlsCheckFlag ? theRet : 0);
+    }
+    static bool IsKtlsAvailable()
+    {
+#if defined(SSL_OP_ENABLE_KTLS) && ! defined(OPENSSL_NO_KTLS)
+        // The tls upper layer protocol is listed once the kernel module is
+        // loaded.
+        ifstream theStream("/proc/sys/net/ipv4/tcp_available_ulp");
+        string   theName;
+        while ((theStream >> theName)) {
+            if (theName == "tls") {
+                return true;
+            }
+        }
+#endif
+        return false;
+    }
+    static int CheckKtls()
+    {
+        const libkfsio::Globals_t& theGlobals = libkfsio::globals();
+        if (theGlobals.ctrSslKtlsSend.GetValue() <= 0) {
+            if (0 < theGlobals.ctrSslKtlsFallback.GetValue()) {
+                // Stdout is used for the data, log the message.
+                KFS_LOG_STREAM_NOTICE <<
+                    "kernel tls was not negotiated, ktls check skipped" <<
+                KFS_LOG_EOM;
+                return 0;
+            }
+            KFS_LOG_STREAM_ERROR << "ktls check: no ssl connections" <<
+            KFS_LOG_EOM;
+            return 1;
+        }
+        // Every byte read from stdin and from the ssl connections is written
+        // once to the ssl connections or to stdout.
+        const int64_t theReadCount  = theGlobals.ctrNetBytesRead.GetValue();
+        const int64_t theWriteCount = theGlobals.ctrNetBytesWritten.GetValue();
+        if (theReadCount <= 0 || theReadCount != theWriteCount) {
+            KFS_LOG_STREAM_ERROR << "ktls check:"
+                " bytes read: "    << theReadCount <<
+                " bytes written: " << theWriteCount <<
+            KFS_LOG_EOM;
+            return 1;
+        }
+        KFS_LOG_STREAM_NOTICE << "ktls check:"
+            " connections: " << theGlobals.ctrSslKtlsSend.GetValue() <<
+            " bytes: "       << theWriteCount <<
+        KFS_LOG_EOM;
         return 0;
     }
     void ShutdownSelf()
@@ -738,6 +831,8 @@ private:
             "Usage " << (inNamePtr ? inNamePtr : "") << ":\n"
             " -c <config file name>\n"
             " -D config-key=config-value\n"
+            " -D sslFilterTest.ktlsCheck=1 -- loop stdin through kernel tls"
+            " connection\n"
         ;
     }
     virtual KfsCallbackObj* CreateKfsCallbackObj(
@@ -320,6 +320,25 @@ public:
             KFS_LOG_EOM;
             return -EINVAL;
         }
+        if (theAllowCSClearTextFlag) {
+            // Kernel tls cannot be removed from the socket after the ssl
+            // shutdown, fail here instead of failing the connections.
+            const char* const kCtxNames[] = { "psk.", "X509.", 0 };
+            for (const char* const* thePtr = kCtxNames; *thePtr; ++thePtr) {
+                theParamName.Truncate(thePrefLen).Append(*thePtr).Append(
+                    "ktls");
+                if (theParams.getValue(theParamName, 0) == 0) {
+                    continue;
+                }
+                const Properties::String theKtlsParamName(theParamName);
+                KFS_LOG_STREAM_ERROR <<
+                    theKtlsParamName << " is on, conflicts with " <<
+                        theParamName.Truncate(thePrefLen).Append(
+                            "allowChunkServerClearText") <<
+                KFS_LOG_EOM;
+                return -EINVAL;
+            }
+        }
         mMaxAuthRetryCount = max(1, theParams.getValue(
             theParamName.Truncate(thePrefLen).Append("maxAuthRetries"),
             mMaxAuthRetryCount));
@@ -37,6 +37,7 @@
 #include <map>
 
 #include "common/kfsatomic.h"
+#include "LatencyHistogram.h"
 
 namespace KFS
 {
@@ -114,10 +115,12 @@ public:
 /// manager can be queried for statistics.
 ///
 class CounterManager {
-    typedef map<string, Counter*> CounterMap;
+    typedef map<string, Counter*>          CounterMap;
+    typedef map<string, LatencyHistogram*> HistogramMap;
 public:
     CounterManager()
-        : mCounters()
+        : mCounters(),
+          mHistograms()
         {}
     ~CounterManager()
         {}
@@ -137,6 +140,20 @@ public:
         }
     }
 
+    /// Add latency histogram. The histograms are shown after the counters,
+    /// the empty histograms are omitted.
+    void AddHistogram(LatencyHistogram *histogram) {
+        mHistograms[histogram->GetName()] = histogram;
+    }
+
+    void RemoveHistogram(LatencyHistogram *histogram) {
+        HistogramMap::iterator const it =
+            mHistograms.find(histogram->GetName());
+        if (it != mHistograms.end() && it->second == histogram) {
+            mHistograms.erase(it);
+        }
+    }
+
     /// Given a counter's name, retrieve the associated counter
     /// object.
     /// @param[in] name   Name of the counter to be retrieved
@@ -151,16 +168,39 @@ public:
     /// line is terminated with a "\r\n".  If there are no counters,
     /// then we print "\r\n".
     void Show(ostream &os) {
-        if (mCounters.empty()) {
+        if (mCounters.empty() && mHistograms.empty()) {
             os << "\r\n";
             return;
         }
         for_each(mCounters.begin(), mCounters.end(), ShowCounter(os));
+        for (HistogramMap::const_iterator it = mHistograms.begin();
+                it != mHistograms.end();
+                ++it) {
+            if (0 < it->second->GetTotalCount()) {
+                it->second->Show(os);
+            }
+        }
+    }
+
+    /// Invoke the functor with each counter, then with each histogram.
+    template<typename T>
+    void Enumerate(T& functor) const {
+        for (CounterMap::const_iterator it = mCounters.begin();
+                it != mCounters.end();
+                ++it) {
+            functor(*it->second);
+        }
+        for (HistogramMap::const_iterator it = mHistograms.begin();
+                it != mHistograms.end();
+                ++it) {
+            functor(*it->second);
+        }
     }
 
 private:
     /// Map that tracks all the counters in the system
-    CounterMap  mCounters;
+    CounterMap   mCounters;
+    HistogramMap mHistograms;
 };
 
 } // namespace KFS
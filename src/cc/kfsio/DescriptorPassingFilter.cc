@@ -0,0 +1,221 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Unix domain socket descriptor passing net connection filter.
+//
+//----------------------------------------------------------------------------
+
+#include "DescriptorPassingFilter.h"
+#include "TcpSocket.h"
+#include "IOBuffer.h"
+#include "Globals.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+
+namespace KFS
+{
+using libkfsio::globals;
+
+class DescriptorPassingFilter::Receiver : public IOBuffer::Reader
+{
+public:
+    Receiver(
+        DescriptorPassingFilter& inFilter)
+        : IOBuffer::Reader(),
+          mFilter(inFilter)
+        {}
+    virtual int Read(
+        int              inFd,
+        void*            inBufPtr,
+        IOBuffer::BufPos inNumRead)
+    {
+        struct iovec  theIov;
+        struct msghdr theMsg;
+        char          theCtl[CMSG_SPACE(sizeof(int))];
+        memset(&theMsg, 0, sizeof(theMsg));
+        theIov.iov_base       = inBufPtr;
+        theIov.iov_len        = (size_t)inNumRead;
+        theMsg.msg_iov        = &theIov;
+        theMsg.msg_iovlen     = 1;
+        theMsg.msg_control    = theCtl;
+        theMsg.msg_controllen = sizeof(theCtl);
+        const ssize_t theRet = recvmsg(inFd, &theMsg, 0);
+        if (theRet < 0) {
+            const int theErr = errno;
+            return (0 < theErr ? -theErr : -EIO);
+        }
+        for (struct cmsghdr* thePtr = CMSG_FIRSTHDR(&theMsg);
+                thePtr;
+                thePtr = CMSG_NXTHDR(&theMsg, thePtr)) {
+            if (thePtr->cmsg_level != SOL_SOCKET ||
+                    thePtr->cmsg_type != SCM_RIGHTS ||
+                    thePtr->cmsg_len < CMSG_LEN(sizeof(int))) {
+                continue;
+            }
+            const int theCnt = (int)((thePtr->cmsg_len - CMSG_LEN(0)) /
+                sizeof(int));
+            for (int i = 0; i < theCnt; i++) {
+                int theFd;
+                memcpy(&theFd, CMSG_DATA(thePtr) + i * sizeof(int),
+                    sizeof(theFd));
+                mFilter.SetReceivedFd(theFd);
+            }
+        }
+        return (int)theRet;
+    }
+private:
+    DescriptorPassingFilter& mFilter;
+private:
+    Receiver(
+        const Receiver& inReceiver);
+    Receiver& operator=(
+        const Receiver& inReceiver);
+};
+
+DescriptorPassingFilter::DescriptorPassingFilter()
+    : NetConnection::Filter(),
+      mSendFd(-1),
+      mReceivedFd(-1)
+{}
+
+DescriptorPassingFilter::~DescriptorPassingFilter()
+{
+    SetReceivedFd(-1);
+}
+
+void
+DescriptorPassingFilter::SetReceivedFd(
+    int inFd)
+{
+    // Only one descriptor is expected, close the previous one, if any.
+    if (0 <= mReceivedFd) {
+        close(mReceivedFd);
+    }
+    mReceivedFd = inFd;
+    if (0 <= mReceivedFd) {
+        fcntl(mReceivedFd, F_SETFD, FD_CLOEXEC);
+    }
+}
+
+    /* virtual */ bool
+DescriptorPassingFilter::WantRead(
+    const NetConnection& inConnection) const
+{
+    return inConnection.IsReadReady();
+}
+
+    /* virtual */ bool
+DescriptorPassingFilter::WantWrite(
+    const NetConnection& inConnection) const
+{
+    return inConnection.IsWriteReady();
+}
+
+    /* virtual */ int
+DescriptorPassingFilter::Read(
+    NetConnection& /* inConnection */,
+    TcpSocket&     inSocket,
+    IOBuffer&      inIoBuffer,
+    int            inMaxRead)
+{
+    Receiver theReceiver(*this);
+    return inIoBuffer.Read(inSocket.GetFd(), inMaxRead, &theReceiver);
+}
+
+    /* virtual */ int
+DescriptorPassingFilter::Write(
+    NetConnection& /* inConnection */,
+    TcpSocket&     inSocket,
+    IOBuffer&      inIoBuffer,
+    bool&          outForceInvokeErrHandlerFlag)
+{
+    outForceInvokeErrHandlerFlag = false;
+    const int     kMaxIov = 16;
+    struct iovec  theIov[kMaxIov];
+    int           theIovCnt = 0;
+    for (IOBuffer::iterator theIt = inIoBuffer.begin();
+            theIt != inIoBuffer.end() && theIovCnt < kMaxIov;
+            ++theIt) {
+        const int theLen = theIt->BytesConsumable();
+        if (theLen <= 0) {
+            continue;
+        }
+        theIov[theIovCnt].iov_base = const_cast<char*>(theIt->Consumer());
+        theIov[theIovCnt].iov_len  = (size_t)theLen;
+        theIovCnt++;
+    }
+    if (theIovCnt <= 0) {
+        return 0;
+    }
+    struct msghdr theMsg;
+    char          theCtl[CMSG_SPACE(sizeof(int))];
+    memset(&theMsg, 0, sizeof(theMsg));
+    theMsg.msg_iov    = theIov;
+    theMsg.msg_iovlen = theIovCnt;
+    if (0 <= mSendFd) {
+        memset(theCtl, 0, sizeof(theCtl));
+        theMsg.msg_control    = theCtl;
+        theMsg.msg_controllen = sizeof(theCtl);
+        struct cmsghdr* const theCmsgPtr = CMSG_FIRSTHDR(&theMsg);
+        theCmsgPtr->cmsg_level = SOL_SOCKET;
+        theCmsgPtr->cmsg_type  = SCM_RIGHTS;
+        theCmsgPtr->cmsg_len   = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(theCmsgPtr), &mSendFd, sizeof(mSendFd));
+    }
+    const ssize_t theRet = sendmsg(inSocket.GetFd(), &theMsg, 0);
+    if (theRet < 0) {
+        const int theErr = errno;
+        return (0 < theErr ? -theErr : -EIO);
+    }
+    if (0 < theRet) {
+        // The control message is sent with the first byte.
+        mSendFd = -1;
+        inIoBuffer.Consume((int)theRet);
+        globals().ctrNetBytesWritten.Update(theRet);
+    }
+    return (int)theRet;
+}
+
+    /* virtual */ void
+DescriptorPassingFilter::Close(
+    NetConnection& inConnection,
+    TcpSocket*     /* inSocketPtr */)
+{
+    mSendFd = -1;
+    inConnection.SetFilter(0, 0);
+    inConnection.Close();
+}
+
+    /* virtual */ int
+DescriptorPassingFilter::Shutdown(
+    NetConnection& /* inConnection */,
+    TcpSocket&     inSocket)
+{
+    return inSocket.Shutdown(false, true);
+}
+
+}
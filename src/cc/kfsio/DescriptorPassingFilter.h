@@ -0,0 +1,93 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Unix domain socket net connection filter that sends and receives
+// file descriptors in SCM_RIGHTS control messages along with the data.
+//
+//----------------------------------------------------------------------------
+
+#ifndef KFS_IO_DESCRIPTOR_PASSING_FILTER_H
+#define KFS_IO_DESCRIPTOR_PASSING_FILTER_H
+
+#include "NetConnection.h"
+
+namespace KFS
+{
+
+class DescriptorPassingFilter : public NetConnection::Filter
+{
+public:
+    DescriptorPassingFilter();
+    virtual ~DescriptorPassingFilter();
+    /// Attach the descriptor to the next write. The descriptor is not owned
+    /// by the filter, and must remain open until IsSendFdPending() returns
+    /// false.
+    void SetSendFd(
+        int inFd)
+        { mSendFd = inFd; }
+    bool IsSendFdPending() const
+        { return (0 <= mSendFd); }
+    /// Returns the last received descriptor, or -1, and passes the
+    /// descriptor ownership to the caller.
+    int DetachReceivedFd()
+    {
+        const int theFd = mReceivedFd;
+        mReceivedFd = -1;
+        return theFd;
+    }
+    virtual bool WantRead(
+        const NetConnection& inConnection) const;
+    virtual bool WantWrite(
+        const NetConnection& inConnection) const;
+    virtual int Read(
+        NetConnection& inConnection,
+        TcpSocket&     inSocket,
+        IOBuffer&      inIoBuffer,
+        int            inMaxRead);
+    virtual int Write(
+        NetConnection& inConnection,
+        TcpSocket&     inSocket,
+        IOBuffer&      inIoBuffer,
+        bool&          outForceInvokeErrHandlerFlag);
+    virtual void Close(
+        NetConnection& inConnection,
+        TcpSocket*     inSocketPtr);
+    virtual int Shutdown(
+        NetConnection& inConnection,
+        TcpSocket&     inSocket);
+private:
+    class Receiver;
+
+    int mSendFd;
+    int mReceivedFd;
+
+    void SetReceivedFd(
+        int inFd);
+private:
+    DescriptorPassingFilter(
+        const DescriptorPassingFilter& inFilter);
+    DescriptorPassingFilter& operator=(
+        const DescriptorPassingFilter& inFilter);
+};
+
+}
+
+#endif /* KFS_IO_DESCRIPTOR_PASSING_FILTER_H */
@@ -45,6 +45,13 @@ Globals_t::Globals_t()
       ctrDiskIOErrors     ("Disk I/O errors"),
       ctrNetDnsResolvedCtr("Network names resolved"),
       ctrNetDnsErrors     ("Network name resolution errors"),
+      ctrNetDnsCacheHits  ("Network name resolver cache hits"),
+      ctrNetDnsNegativeCacheHits("Network name resolver negative cache hits"),
+      ctrNetDnsCacheRefreshes("Network name resolver cache refreshes"),
+      dnsResolveLatency   ("Latency DNS resolve usec"),
+      ctrSslKtlsSend      ("Ssl connections with kernel tls send"),
+      ctrSslKtlsRecv      ("Ssl connections with kernel tls receive"),
+      ctrSslKtlsFallback  ("Ssl connections without kernel tls"),
       mInitedFlag(false),
       mDestructedFlag(false),
       mForGdbToFindNetManager(0)
@@ -58,6 +65,13 @@ Globals_t::Globals_t()
     counterManager.AddCounter(&ctrDiskIOErrors);
     counterManager.AddCounter(&ctrNetDnsResolvedCtr);
     counterManager.AddCounter(&ctrNetDnsErrors);
+    counterManager.AddCounter(&ctrNetDnsCacheHits);
+    counterManager.AddCounter(&ctrNetDnsNegativeCacheHits);
+    counterManager.AddCounter(&ctrNetDnsCacheRefreshes);
+    counterManager.AddHistogram(&dnsResolveLatency);
+    counterManager.AddCounter(&ctrSslKtlsSend);
+    counterManager.AddCounter(&ctrSslKtlsRecv);
+    counterManager.AddCounter(&ctrSslKtlsFallback);
     sForGdbToFindInstance = this;
 }
 
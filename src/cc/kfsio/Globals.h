@@ -50,6 +50,16 @@ struct Globals_t
     Counter ctrDiskIOErrors;
     Counter ctrNetDnsResolvedCtr;
     Counter ctrNetDnsErrors;
+    Counter ctrNetDnsCacheHits;
+    Counter ctrNetDnsNegativeCacheHits;
+    Counter ctrNetDnsCacheRefreshes;
+    // Name resolution latency, excluding cache hits. Updated by the resolver
+    // instances with the resolver's shared mutex held.
+    LatencyHistogram dnsResolveLatency;
+    // Ssl connections with kernel tls requested.
+    Counter ctrSslKtlsSend;
+    Counter ctrSslKtlsRecv;
+    Counter ctrSslKtlsFallback;
     void Init();
     static NetManager& getNetManager();
     static void Destroy();
@@ -0,0 +1,205 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Log linear latency histogram, similar to HDR histogram. Every power
+// of two range is split into 8 equal buckets, therefore the values reported
+// are within 12.5% of the recorded values. The range is [0, 2^40) micro
+// seconds, larger values are recorded in the last bucket.
+// The histogram is not thread safe, the caller must serialize updates.
+// Concurrent reads return approximate values.
+//
+//----------------------------------------------------------------------------
+
+#ifndef LIBKFSIO_LATENCY_HISTOGRAM_H
+#define LIBKFSIO_LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+#include <ostream>
+
+namespace KFS
+{
+using std::ostream;
+using std::string;
+
+class LatencyHistogram
+{
+public:
+    typedef int64_t Counter;
+    enum
+    {
+        kSubBucketBits  = 3,
+        kSubBucketCount = 1 << kSubBucketBits,
+        kMaxValueBits   = 40,
+        kBucketCount    = (kMaxValueBits - kSubBucketBits + 1) * kSubBucketCount
+    };
+
+    LatencyHistogram(
+        const char* inNamePtr = "")
+        : mName(inNamePtr ? inNamePtr : ""),
+          mTotalCount(0),
+          mTotalValue(0),
+          mMaxValue(0)
+        { memset(mBuckets, 0, sizeof(mBuckets)); }
+    void SetName(
+        const char* inNamePtr)
+        { mName = inNamePtr ? inNamePtr : ""; }
+    const string& GetName() const
+        { return mName; }
+    void Clear()
+    {
+        memset(mBuckets, 0, sizeof(mBuckets));
+        mTotalCount = 0;
+        mTotalValue = 0;
+        mMaxValue   = 0;
+    }
+    void Update(
+        int64_t inValue)
+    {
+        const int64_t theValue = inValue < 0 ? int64_t(0) : inValue;
+        mBuckets[GetBucketIdx(theValue)]++;
+        mTotalCount++;
+        mTotalValue += theValue;
+        if (mMaxValue < theValue) {
+            mMaxValue = theValue;
+        }
+    }
+    LatencyHistogram& Add(
+        const LatencyHistogram& inHistogram)
+    {
+        for (int i = 0; i < kBucketCount; i++) {
+            mBuckets[i] += inHistogram.mBuckets[i];
+        }
+        mTotalCount += inHistogram.mTotalCount;
+        mTotalValue += inHistogram.mTotalValue;
+        if (mMaxValue < inHistogram.mMaxValue) {
+            mMaxValue = inHistogram.mMaxValue;
+        }
+        return *this;
+    }
+    Counter GetTotalCount() const
+        { return mTotalCount; }
+    Counter GetTotalValue() const
+        { return mTotalValue; }
+    Counter GetMaxValue() const
+        { return mMaxValue; }
+    Counter GetBucketCount(
+        int inIdx) const
+        { return ((inIdx < 0 || kBucketCount <= inIdx) ? 0 : mBuckets[inIdx]); }
+    // Returns the upper bound of the bucket that contains the value at the
+    // given percentile, or 0 if the histogram is empty.
+    int64_t GetPercentile(
+        double inPercentile) const
+    {
+        if (mTotalCount <= 0) {
+            return 0;
+        }
+        const double  theTarget = (double)mTotalCount *
+            (inPercentile < 0 ? 0. : (100. < inPercentile ? 100. :
+                inPercentile)) / 100.;
+        const Counter theCount  = theTarget <= 1 ? Counter(1) :
+            (Counter)theTarget + ((double)(Counter)theTarget < theTarget ?
+                1 : 0);
+        Counter       theSum    = 0;
+        for (int i = 0; i < kBucketCount; i++) {
+            theSum += mBuckets[i];
+            if (theCount <= theSum) {
+                const int64_t theRet = GetBucketUpperBound(i);
+                return (mMaxValue < theRet ? mMaxValue : theRet);
+            }
+        }
+        return mMaxValue;
+    }
+    // Emits a single line in the same "name: values" format as Counter:
+    // count,p50,p90,p99,p99.9,max
+    void Show(
+        ostream& inStream) const
+    {
+        inStream << mName << ": " <<
+            mTotalCount              << "," <<
+            GetPercentile(50)        << "," <<
+            GetPercentile(90)        << "," <<
+            GetPercentile(99)        << "," <<
+            GetPercentile(99.9)      << "," <<
+            mMaxValue                << "\r\n";
+    }
+    template<typename T>
+    void Enumerate(
+        T& inFunctor) const
+    {
+        inFunctor("Count", mTotalCount);
+        inFunctor("P50",   GetPercentile(50));
+        inFunctor("P90",   GetPercentile(90));
+        inFunctor("P99",   GetPercentile(99));
+        inFunctor("P999",  GetPercentile(99.9));
+        inFunctor("Max",   mMaxValue);
+    }
+    static int GetBucketIdx(
+        int64_t inValue)
+    {
+        if (inValue < kSubBucketCount) {
+            return (inValue < 0 ? 0 : (int)inValue);
+        }
+        const int theMsb = GetMsb((uint64_t)inValue);
+        if (kMaxValueBits <= theMsb) {
+            return (kBucketCount - 1);
+        }
+        const int theShift = theMsb - kSubBucketBits;
+        return ((theShift + 1) * kSubBucketCount +
+            (int)((inValue >> theShift) - kSubBucketCount));
+    }
+    static int64_t GetBucketUpperBound(
+        int inIdx)
+    {
+        if (inIdx < kSubBucketCount) {
+            return inIdx;
+        }
+        const int theShift = inIdx / kSubBucketCount - 1;
+        return ((((int64_t)(inIdx % kSubBucketCount + kSubBucketCount + 1)) <<
+            theShift) - 1);
+    }
+private:
+    string  mName;
+    Counter mTotalCount;
+    Counter mTotalValue;
+    Counter mMaxValue;
+    Counter mBuckets[kBucketCount];
+
+    static int GetMsb(
+        uint64_t inValue)
+    {
+#if defined(__GNUC__)
+        return (63 - __builtin_clzll(inValue));
+#else
+        int theRet = 0;
+        while (inValue >>= 1) {
+            theRet++;
+        }
+        return theRet;
+#endif
+    }
+};
+
+} // namespace KFS
+
+#endif // LIBKFSIO_LATENCY_HISTOGRAM_H
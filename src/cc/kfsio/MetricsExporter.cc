@@ -0,0 +1,638 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief OpenMetrics text exporter of the counter manager counters and
+// latency histograms.
+//
+//----------------------------------------------------------------------------
+
+#include "MetricsExporter.h"
+#include "Counter.h"
+#include "Globals.h"
+#include "ITimeout.h"
+#include "NetManager.h"
+#include "TcpSocket.h"
+
+#include "common/MsgLogger.h"
+#include "common/Properties.h"
+#include "common/IntToString.h"
+#include "common/kfsatomic.h"
+#include "common/kfsdecls.h"
+#include "common/time.h"
+
+#include "qcdio/QCThread.h"
+#include "qcdio/QCMutex.h"
+#include "qcdio/qcstutils.h"
+#include "qcdio/QCUtils.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+namespace KFS
+{
+using std::string;
+using std::vector;
+using std::swap;
+using libkfsio::globals;
+
+class MetricsExporter::Impl :
+    public QCRunnable,
+    public ITimeout
+{
+public:
+    Impl(
+        NetManager& inNetManager,
+        const char* inMetricPrefixPtr)
+        : QCRunnable(),
+          ITimeout(),
+          mNetManager(inNetManager),
+          mMetricPrefix(inMetricPrefixPtr ? inMetricPrefixPtr : ""),
+          mLocation(),
+          mSnapshotTimeoutMs(5000),
+          mIoTimeoutMs(10000),
+          mRunFlag(false),
+          mSnapshotDoneFlag(false),
+          mSnapshotRequestCount(0),
+          mListener(),
+          mThread(),
+          mMutex(),
+          mCondVar(),
+          mSnapshot(),
+          mOutSnapshot(),
+          mBuf(),
+          mName()
+    {
+        mWakeupFd[0] = -1;
+        mWakeupFd[1] = -1;
+    }
+    virtual ~Impl()
+        { Impl::Shutdown(); }
+    int SetParameters(
+        const char*       inPrefixPtr,
+        const Properties& inParameters)
+    {
+        Properties::String theName(inPrefixPtr ? inPrefixPtr : "");
+        const size_t       thePrefixLen = theName.length();
+        ServerLocation     theLocation(
+            inParameters.getValue(
+                theName.Truncate(thePrefixLen).Append("bindAddress"),
+                mLocation.hostname),
+            inParameters.getValue(
+                theName.Truncate(thePrefixLen).Append("port"),
+                mLocation.port)
+        );
+        QCStMutexLocker theLock(mMutex);
+        mSnapshotTimeoutMs = inParameters.getValue(
+            theName.Truncate(thePrefixLen).Append("snapshotTimeoutMs"),
+            mSnapshotTimeoutMs);
+        mIoTimeoutMs = inParameters.getValue(
+            theName.Truncate(thePrefixLen).Append("ioTimeoutMs"),
+            mIoTimeoutMs);
+        const bool theRunFlag = mRunFlag;
+        theLock.Unlock();
+        if (theLocation.hostname == mLocation.hostname &&
+                theLocation.port == mLocation.port &&
+                (theRunFlag || theLocation.port < 0)) {
+            return 0;
+        }
+        Shutdown();
+        mLocation = theLocation;
+        if (mLocation.port < 0) {
+            return 0;
+        }
+        return Start();
+    }
+    void Shutdown()
+    {
+        QCStMutexLocker theLock(mMutex);
+        if (! mRunFlag) {
+            return;
+        }
+        mRunFlag = false;
+        mCondVar.NotifyAll();
+        theLock.Unlock();
+        const char theByte = 0;
+        if (write(mWakeupFd[1], &theByte, 1) < 0) {
+            QCUtils::SetLastIgnoredError(errno);
+        }
+        mThread.Join();
+        mNetManager.UnRegisterTimeoutHandler(this);
+        close(mWakeupFd[0]);
+        close(mWakeupFd[1]);
+        mWakeupFd[0] = -1;
+        mWakeupFd[1] = -1;
+        mListener.Close();
+    }
+    virtual void Timeout()
+    {
+        if (0 == SyncAddAndFetch(mSnapshotRequestCount, 0)) {
+            return;
+        }
+        QCStMutexLocker theLock(mMutex);
+        mSnapshotRequestCount = 0;
+        mSnapshot.Clear();
+        globals().counterManager.Enumerate(mSnapshot);
+        mSnapshotDoneFlag = true;
+        mCondVar.Notify();
+    }
+    virtual void Run()
+    {
+        struct pollfd thePoll[2];
+        for (; ;) {
+            thePoll[0].fd      = mListener.GetFd();
+            thePoll[0].events  = POLLIN;
+            thePoll[0].revents = 0;
+            thePoll[1].fd      = mWakeupFd[0];
+            thePoll[1].events  = POLLIN;
+            thePoll[1].revents = 0;
+            const int theRet = poll(thePoll, 2, -1);
+            if (theRet < 0 && EINTR != errno) {
+                KFS_LOG_STREAM_ERROR <<
+                    "metrics exporter: poll: " <<
+                    QCUtils::SysError(errno) <<
+                KFS_LOG_EOM;
+                break;
+            }
+            if (0 != thePoll[1].revents) {
+                break;
+            }
+            if (0 != (thePoll[0].revents & (POLLERR | POLLNVAL))) {
+                KFS_LOG_STREAM_ERROR <<
+                    "metrics exporter: listen socket error" <<
+                KFS_LOG_EOM;
+                break;
+            }
+            if (0 == (thePoll[0].revents & POLLIN)) {
+                continue;
+            }
+            int              theStatus = 0;
+            TcpSocket* const theSockPtr = mListener.Accept(&theStatus);
+            if (! theSockPtr) {
+                continue;
+            }
+            ProcessRequest(theSockPtr->GetFd());
+            theSockPtr->Close();
+            delete theSockPtr;
+        }
+    }
+    int Start()
+    {
+        int theRet = mListener.Bind(
+            mLocation,
+            TcpSocket::kTypeIpV4,
+            false // inIpV6OnlyFlag
+        );
+        const bool kNonBlockingAcceptFlag = true;
+        const int  kMaxListenQueue        = 64;
+        if (0 == theRet) {
+            theRet = mListener.StartListening(
+                kNonBlockingAcceptFlag, kMaxListenQueue);
+        }
+        if (0 == theRet && pipe(mWakeupFd)) {
+            theRet = -errno;
+            mWakeupFd[0] = -1;
+            mWakeupFd[1] = -1;
+        }
+        if (0 != theRet) {
+            KFS_LOG_STREAM_ERROR <<
+                "metrics exporter: " << mLocation <<
+                " error: " <<
+                    QCUtils::SysError(theRet < 0 ? -theRet : theRet) <<
+            KFS_LOG_EOM;
+            mListener.Close();
+            return (theRet < 0 ? theRet : -EINVAL);
+        }
+        fcntl(mWakeupFd[0], F_SETFD, FD_CLOEXEC);
+        fcntl(mWakeupFd[1], F_SETFD, FD_CLOEXEC);
+        mRunFlag = true;
+        mNetManager.RegisterTimeoutHandler(this);
+        const int kStackSize = 64 << 10;
+        mThread.Start(this, kStackSize, "MetricsExporter");
+        KFS_LOG_STREAM_INFO <<
+            "metrics exporter: listening on: " << mLocation <<
+        KFS_LOG_EOM;
+        return 0;
+    }
+private:
+    class Snapshot
+    {
+    public:
+        struct CounterValue
+        {
+            CounterValue()
+                : mName(),
+                  mValue(0),
+                  mTimeSpent(0)
+                {}
+            string  mName;
+            int64_t mValue;
+            int64_t mTimeSpent;
+        };
+        typedef vector<CounterValue>     Counters;
+        typedef vector<LatencyHistogram> Histograms;
+
+        Snapshot()
+            : mCounters(),
+              mHistograms(),
+              mCounterCount(0),
+              mHistogramCount(0)
+            {}
+        void Clear()
+        {
+            mCounterCount   = 0;
+            mHistogramCount = 0;
+        }
+        void operator()(
+            const Counter& inCounter)
+        {
+            if (mCounters.size() <= mCounterCount) {
+                mCounters.push_back(CounterValue());
+            }
+            CounterValue& theVal = mCounters[mCounterCount++];
+            theVal.mName      = inCounter.GetName();
+            theVal.mValue     = inCounter.GetValue();
+            theVal.mTimeSpent = inCounter.GetTimeSpent();
+        }
+        void operator()(
+            const LatencyHistogram& inHistogram)
+        {
+            if (inHistogram.GetTotalCount() <= 0) {
+                return;
+            }
+            if (mHistograms.size() <= mHistogramCount) {
+                mHistograms.push_back(inHistogram);
+                mHistogramCount++;
+            } else {
+                mHistograms[mHistogramCount++] = inHistogram;
+            }
+        }
+        void Swap(
+            Snapshot& inSnapshot)
+        {
+            mCounters.swap(inSnapshot.mCounters);
+            mHistograms.swap(inSnapshot.mHistograms);
+            swap(mCounterCount,   inSnapshot.mCounterCount);
+            swap(mHistogramCount, inSnapshot.mHistogramCount);
+        }
+        Counters   mCounters;
+        Histograms mHistograms;
+        size_t     mCounterCount;
+        size_t     mHistogramCount;
+    };
+    enum
+    {
+        kMaxRequestHeaderSize = 8 << 10,
+        kSendBufferSize       = 64 << 10,
+        kHistogramBucketStep  = 2  // Power of 4 bucket boundaries.
+    };
+
+    NetManager&    mNetManager;
+    string const   mMetricPrefix;
+    ServerLocation mLocation;
+    int            mSnapshotTimeoutMs;
+    int            mIoTimeoutMs;
+    bool           mRunFlag;
+    bool           mSnapshotDoneFlag;
+    volatile int   mSnapshotRequestCount;
+    TcpSocket      mListener;
+    QCThread       mThread;
+    QCMutex        mMutex;
+    QCCondVar      mCondVar;
+    Snapshot       mSnapshot;
+    Snapshot       mOutSnapshot;
+    string         mBuf;
+    string         mName;
+    int            mWakeupFd[2];
+
+    bool GetSnapshot()
+    {
+        QCStMutexLocker theLock(mMutex);
+        const int64_t theEnd = microseconds() +
+            int64_t(mSnapshotTimeoutMs) * 1000;
+        mSnapshotDoneFlag = false;
+        SyncAddAndFetch(mSnapshotRequestCount, 1);
+        mNetManager.Wakeup();
+        while (mRunFlag && ! mSnapshotDoneFlag) {
+            const int64_t theWait = theEnd - microseconds();
+            if (theWait <= 0) {
+                break;
+            }
+            mCondVar.Wait(mMutex, QCCondVar::Time(theWait) * 1000);
+        }
+        if (! mSnapshotDoneFlag) {
+            return false;
+        }
+        mOutSnapshot.Swap(mSnapshot);
+        return true;
+    }
+    int GetIoTimeoutMs()
+    {
+        QCStMutexLocker theLock(mMutex);
+        return mIoTimeoutMs;
+    }
+    static bool WaitIo(
+        int     inFd,
+        short   inEvents,
+        int64_t inEndTimeUsec)
+    {
+        for (; ;) {
+            const int64_t theWait = inEndTimeUsec - microseconds();
+            if (theWait <= 0) {
+                return false;
+            }
+            struct pollfd thePoll;
+            thePoll.fd      = inFd;
+            thePoll.events  = inEvents;
+            thePoll.revents = 0;
+            const int theRet = poll(&thePoll, 1, (int)((theWait + 999) / 1000));
+            if (0 < theRet) {
+                return true;
+            }
+            if (theRet < 0 && EINTR != errno) {
+                return false;
+            }
+        }
+    }
+    bool Send(
+        int         inFd,
+        const char* inPtr,
+        size_t      inLen,
+        int64_t     inEndTimeUsec)
+    {
+        while (0 < inLen) {
+#ifdef MSG_NOSIGNAL
+            const ssize_t theRet = send(inFd, inPtr, inLen, MSG_NOSIGNAL);
+#else
+            const ssize_t theRet = send(inFd, inPtr, inLen, 0);
+#endif
+            if (0 < theRet) {
+                inPtr += theRet;
+                inLen -= theRet;
+                continue;
+            }
+            if (theRet < 0 && EINTR == errno) {
+                continue;
+            }
+            if (theRet < 0 && (EAGAIN == errno || EWOULDBLOCK == errno) &&
+                    WaitIo(inFd, POLLOUT, inEndTimeUsec)) {
+                continue;
+            }
+            return false;
+        }
+        return true;
+    }
+    bool Flush(
+        int     inFd,
+        int64_t inEndTimeUsec,
+        size_t  inMinSize)
+    {
+        if (mBuf.size() < inMinSize) {
+            return true;
+        }
+        const bool theRet =
+            Send(inFd, mBuf.data(), mBuf.size(), inEndTimeUsec);
+        mBuf.clear();
+        return theRet;
+    }
+    void ProcessRequest(
+        int inFd)
+    {
+        const int64_t theEnd = microseconds() +
+            int64_t(GetIoTimeoutMs()) * 1000;
+        char   theHeader[kMaxRequestHeaderSize + 1];
+        size_t theLen = 0;
+        for (; ;) {
+            if (kMaxRequestHeaderSize <= theLen) {
+                SendStatus(inFd, "431 Request Header Fields Too Large", theEnd);
+                return;
+            }
+            const ssize_t theRet = recv(
+                inFd, theHeader + theLen, kMaxRequestHeaderSize - theLen, 0);
+            if (0 < theRet) {
+                theLen += theRet;
+                theHeader[theLen] = 0;
+                if (strstr(theHeader, "\r\n\r\n") ||
+                        strstr(theHeader, "\n\n")) {
+                    break;
+                }
+                continue;
+            }
+            if (theRet < 0 && EINTR == errno) {
+                continue;
+            }
+            if (theRet < 0 && (EAGAIN == errno || EWOULDBLOCK == errno) &&
+                    WaitIo(inFd, POLLIN, theEnd)) {
+                continue;
+            }
+            return;
+        }
+        const char* const kGet        = "GET ";
+        const size_t      kGetLen     = 4;
+        const char* const kMetrics    = "/metrics";
+        const size_t      kMetricsLen = 8;
+        if (theLen < kGetLen || 0 != memcmp(theHeader, kGet, kGetLen)) {
+            SendStatus(inFd, "405 Method Not Allowed", theEnd);
+            return;
+        }
+        const char* const thePathPtr = theHeader + kGetLen;
+        if (0 != strncmp(thePathPtr, kMetrics, kMetricsLen) ||
+                (' ' != thePathPtr[kMetricsLen] &&
+                    '?' != thePathPtr[kMetricsLen])) {
+            SendStatus(inFd, "404 Not Found", theEnd);
+            return;
+        }
+        if (! GetSnapshot()) {
+            SendStatus(inFd, "503 Service Unavailable", theEnd);
+            return;
+        }
+        mBuf.clear();
+        mBuf +=
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: application/openmetrics-text;"
+                " version=1.0.0; charset=utf-8\r\n"
+            "Connection: close\r\n"
+            "\r\n";
+        const Snapshot& theSnapshot = mOutSnapshot;
+        for (size_t i = 0; i < theSnapshot.mCounterCount; i++) {
+            const Snapshot::CounterValue& theVal = theSnapshot.mCounters[i];
+            if (! SetName(theVal.mName)) {
+                continue;
+            }
+            AppendType("unknown");
+            AppendSample("", theVal.mValue);
+            if (0 != theVal.mTimeSpent) {
+                mName += "_time_usec";
+                AppendType("unknown");
+                AppendSample("", theVal.mTimeSpent);
+            }
+            if (! Flush(inFd, theEnd, kSendBufferSize)) {
+                return;
+            }
+        }
+        for (size_t i = 0; i < theSnapshot.mHistogramCount; i++) {
+            const LatencyHistogram& theHist = theSnapshot.mHistograms[i];
+            if (! SetName(theHist.GetName())) {
+                continue;
+            }
+            AppendType("histogram");
+            AppendHistogram(theHist);
+            if (! Flush(inFd, theEnd, kSendBufferSize)) {
+                return;
+            }
+        }
+        mBuf += "# EOF\n";
+        Flush(inFd, theEnd, 0);
+    }
+    void SendStatus(
+        int         inFd,
+        const char* inStatusPtr,
+        int64_t     inEndTimeUsec)
+    {
+        mBuf.clear();
+        mBuf += "HTTP/1.1 ";
+        mBuf += inStatusPtr;
+        mBuf += "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        Flush(inFd, inEndTimeUsec, 0);
+    }
+    // Converts counter name into metric name: lower case, all characters
+    // except letters and digits replaced with single underscore.
+    bool SetName(
+        const string& inName)
+    {
+        mName = mMetricPrefix;
+        const size_t thePrefixLen = mName.size();
+        bool         theSepFlag   = false;
+        for (const char* thePtr = inName.c_str(); *thePtr; ++thePtr) {
+            const int theSym = *thePtr & 0xFF;
+            if (('a' <= theSym && theSym <= 'z') ||
+                    ('0' <= theSym && theSym <= '9')) {
+                mName += (char)theSym;
+                theSepFlag = false;
+            } else if ('A' <= theSym && theSym <= 'Z') {
+                mName += (char)(theSym - 'A' + 'a');
+                theSepFlag = false;
+            } else if (! theSepFlag && thePrefixLen < mName.size()) {
+                mName += '_';
+                theSepFlag = true;
+            }
+        }
+        if (theSepFlag) {
+            mName.erase(mName.size() - 1);
+        }
+        if (mName.size() <= thePrefixLen) {
+            return false;
+        }
+        if (0 == thePrefixLen && '0' <= mName[0] && mName[0] <= '9') {
+            mName.insert(0, 1, '_');
+        }
+        return true;
+    }
+    void AppendType(
+        const char* inTypePtr)
+    {
+        mBuf += "# TYPE ";
+        mBuf += mName;
+        mBuf += ' ';
+        mBuf += inTypePtr;
+        mBuf += '\n';
+    }
+    void AppendSample(
+        const char* inSuffixPtr,
+        int64_t     inValue)
+    {
+        mBuf += mName;
+        mBuf += inSuffixPtr;
+        mBuf += ' ';
+        AppendDecIntToString(mBuf, inValue);
+        mBuf += '\n';
+    }
+    // Emits cumulative counts at power of 4 boundaries, in order to keep the
+    // output size and the bucket set the same between scrapes, regardless of
+    // the values recorded.
+    void AppendHistogram(
+        const LatencyHistogram& inHistogram)
+    {
+        LatencyHistogram::Counter theCount = 0;
+        int                       theIdx   = 0;
+        for (int theBits = kHistogramBucketStep;
+                theBits <= LatencyHistogram::kMaxValueBits;
+                theBits += kHistogramBucketStep) {
+            const int64_t theBound = (int64_t(1) << theBits) - 1;
+            const int     theLast  = LatencyHistogram::GetBucketIdx(theBound);
+            while (theIdx <= theLast) {
+                theCount += inHistogram.GetBucketCount(theIdx++);
+            }
+            mBuf += mName;
+            mBuf += "_bucket{le=\"";
+            AppendDecIntToString(mBuf, theBound);
+            mBuf += "\"} ";
+            AppendDecIntToString(mBuf, theCount);
+            mBuf += '\n';
+        }
+        mBuf += mName;
+        mBuf += "_bucket{le=\"+Inf\"} ";
+        AppendDecIntToString(mBuf, inHistogram.GetTotalCount());
+        mBuf += '\n';
+        AppendSample("_count", inHistogram.GetTotalCount());
+        AppendSample("_sum",   inHistogram.GetTotalValue());
+    }
+private:
+    Impl(
+        const Impl& inImpl);
+    Impl& operator=(
+        const Impl& inImpl);
+};
+
+MetricsExporter::MetricsExporter(
+    NetManager& inNetManager,
+    const char* inMetricPrefixPtr)
+    : mImpl(*(new Impl(inNetManager, inMetricPrefixPtr)))
+    {}
+
+MetricsExporter::~MetricsExporter()
+{
+    delete &mImpl;
+}
+
+    int
+MetricsExporter::SetParameters(
+    const char*       inPrefixPtr,
+    const Properties& inParameters)
+{
+    return mImpl.SetParameters(inPrefixPtr, inParameters);
+}
+
+    void
+MetricsExporter::Shutdown()
+{
+    mImpl.Shutdown();
+}
+
+}
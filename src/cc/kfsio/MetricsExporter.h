@@ -0,0 +1,75 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief OpenMetrics text exporter of the counter manager counters and
+// latency histograms.
+// The exporter runs its own thread with minimal HTTP/1.1 server, that serves
+// "GET /metrics" requests. On each request the exporter thread asks the net
+// manager thread to copy the counters and histograms values, then formats and
+// sends the response. The net manager thread only copies the values, all
+// formatting and network io is done by the exporter thread. The requests are
+// processed sequentially, one connection at a time.
+//
+//----------------------------------------------------------------------------
+
+#ifndef KFSIO_METRICS_EXPORTER_H
+#define KFSIO_METRICS_EXPORTER_H
+
+namespace KFS
+{
+
+class NetManager;
+class Properties;
+
+class MetricsExporter
+{
+public:
+    // The metric prefix is prepended to all metric names, for example
+    // "qfs_meta_".
+    MetricsExporter(
+        NetManager& inNetManager,
+        const char* inMetricPrefixPtr);
+    ~MetricsExporter();
+    // Parameters:
+    // <prefix>port -- listen port, negative value turns the exporter off.
+    // <prefix>bindAddress -- listen address, empty means any.
+    // <prefix>snapshotTimeoutMs -- max time to wait for the counters copy.
+    // <prefix>ioTimeoutMs -- max time to receive request and send response.
+    // The exporter is started or restarted if the port or address changes.
+    // Returns 0 on success, or negative error code if the listen socket cannot
+    // be created, in which case the exporter is turned off.
+    int SetParameters(
+        const char*       inPrefixPtr,
+        const Properties& inParameters);
+    void Shutdown();
+private:
+    class Impl;
+    Impl& mImpl;
+private:
+    MetricsExporter(
+        const MetricsExporter& inExporter);
+    MetricsExporter& operator=(
+        const MetricsExporter& inExporter);
+};
+
+}
+
+#endif /* KFSIO_METRICS_EXPORTER_H */
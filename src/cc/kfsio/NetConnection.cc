@@ -171,6 +171,9 @@ NetConnection::HandleReadEvent(int maxAcceptsPerRead /* = 1 */)
                     conn->Update();
                 }
             } else {
+                if (err == EAGAIN || err == EWOULDBLOCK) {
+                    mNetManagerEntry.ClearReadReady();
+                }
                 if (i == 0 || IsFatalError(err)) {
                     NET_CONNECTION_LOG_STREAM_DEBUG <<
                         " accept failure: " << QCUtils::SysError(err) <<
@@ -187,6 +190,9 @@ NetConnection::HandleReadEvent(int maxAcceptsPerRead /* = 1 */)
         const int nread = mFilter ?
             mFilter->Read(*this, *mSock, mInBuffer, mMaxReadAhead) :
             mInBuffer.Read(mSock->GetFd(), mMaxReadAhead);
+        if (nread <= 0 && nread != -EINTR) {
+            mNetManagerEntry.ClearReadReady();
+        }
         if (nread <= 0 && IsFatalError(-nread)) {
             if (nread != 0) {
                 GetErrorMsg();
@@ -224,6 +230,10 @@ NetConnection::HandleWriteEvent()
                 forceInvokeErrHandlerFlag) :
             mOutBuffer.Write(mSock->GetFd())
         ) : 0;
+        if (nwrote < 0 ? nwrote != -EINTR : (0 < nwrote && WantWrite())) {
+            // Would block, or partial write: the socket buffer is full.
+            mNetManagerEntry.ClearWriteReady();
+        }
         if (nwrote < 0 && IsFatalError(-nwrote)) {
             GetErrorMsg();
             IsAuthFailure();
@@ -282,6 +282,10 @@ public:
         return (IsConnected() ? mSock->GetSockLocation(loc) : -ENOTCONN);
     }
 
+    bool IsLocalPeer() const {
+        return (IsConnected() && mSock->IsLocalPeer());
+    }
+
     /// Enqueue data to be sent out.
     void Write(const IOBufferData &ioBufData, bool resetTimerFlag = true) {
         if (! ioBufData.IsEmpty()) {
@@ -352,6 +356,10 @@ public:
         return (mSock ? mSock->GetSocketError() : 0);
     }
 
+    int GetIncomingCpu() const {
+        return (mSock ? mSock->GetIncomingCpu() : -1);
+    }
+
     /// Close the connection.
     void Close(bool clearOutBufferFlag = true) {
         if (mFilter) {
@@ -468,6 +476,9 @@ public:
               mPendingCloseFlag(false),
               mPendingResetTimerFlag(false),
               mPendingNameResolutionFlag(false),
+              mEdgeFlag(false),
+              mEdgeReadReadyFlag(false),
+              mEdgeWriteReadyFlag(false),
               mFd(-1),
               mWriteByteCount(0),
               mTimerWheelSlot(-1),
@@ -486,6 +497,11 @@ public:
         bool IsPendingClose() const       { return mPendingCloseFlag; }
         bool IsNameResolutionPending() const
             { return mPendingNameResolutionFlag; }
+        bool IsEdgeTriggered() const      { return mEdgeFlag; }
+        /// With edge triggered poll the socket remains "ready" until
+        /// read or write reports that it would block.
+        void ClearReadReady()             { mEdgeReadReadyFlag  = false; }
+        void ClearWriteReady()            { mEdgeWriteReadyFlag = false; }
         time_t TimeNow() const;
 
     private:
@@ -500,6 +516,9 @@ public:
         bool             mPendingCloseFlag:1;
         bool             mPendingResetTimerFlag:1;
         bool             mPendingNameResolutionFlag:1;
+        bool             mEdgeFlag:1;
+        bool             mEdgeReadReadyFlag:1;
+        bool             mEdgeWriteReadyFlag:1;
         int              mFd;
         int              mWriteByteCount;
         int              mTimerWheelSlot;
@@ -513,10 +532,13 @@ public:
         {
             if (con.mSock) {
                 con.mSock->Close();
-                mAdded = false;
-                mIn    = false;
-                mOut   = false;
-                mFd    = -1;
+                mAdded              = false;
+                mIn                 = false;
+                mOut                = false;
+                mEdgeFlag           = false;
+                mEdgeReadReadyFlag  = false;
+                mEdgeWriteReadyFlag = false;
+                mFd                 = -1;
             } 
         }
         void SetPendingClose(const NetConnection& conn)
@@ -124,6 +124,10 @@ NetManager::NetManager(int timeoutMs)
       mResolverCacheSize(8 << 10),
       mResolverCacheExpiration(-1),
       mResolverOsFlag(false),
+      mEdgeTriggeredFlag(false),
+      mBusyPollUsec(0),
+      mLastEventUsec(0),
+      mLoopStats(),
       mPoll(*(new QCFdPoll(true))), // Wakeable
       mPollEventHook(0),
       mResolver(0),
@@ -247,6 +251,13 @@ NetManager::SetResolverParameters(bool useOsResolverFlag,
     }
 }
 
+void
+NetManager::SetEdgeTriggered(bool flag)
+{
+    // The connections are switched on the next update.
+    mEdgeTriggeredFlag = flag && QCFdPoll::IsEdgeTriggeredSupported();
+}
+
 void
 NetManager::RegisterTimeoutHandler(ITimeout* handler)
 {
@@ -436,7 +447,36 @@ NetManager::UpdateSelf(NetConnection::NetManagerEntry& entry, int fd,
         conn.WantRead();
     const bool out = (entry.mConnectPending &&
         ! entry.mPendingNameResolutionFlag) || conn.WantWrite();
-    if (in != entry.mIn || out != entry.mOut) {
+    if (mEdgeTriggeredFlag && ! conn.GetFilter()) {
+        // Register once for both read and write, the first time the
+        // connection wants io, then only the readiness state changes.
+        if (fd != entry.mFd && entry.mFd >= 0) {
+            PollRemove(entry.mFd);
+            entry.mFd = -1;
+        }
+        if ((entry.mFd < 0 || ! entry.mEdgeFlag) && (in || out)) {
+            assert(fd >= 0);
+            const int op = QCFdPoll::kOpTypeIn + QCFdPoll::kOpTypeOut +
+                QCFdPoll::kOpTypeEdgeTriggered;
+            if (CheckFatalPollSysError(entry.mFd < 0 ?
+                        mPoll.Add(fd, op, &conn) : mPoll.Set(fd, op, &conn),
+                    "failed to add fd to poll set") != 0) {
+                UpdateSelf(entry, fd, false, true);
+                return; // Tail recursion
+            }
+            // Add and modify report the current state.
+            entry.mFd                 = fd;
+            entry.mEdgeFlag           = true;
+            entry.mEdgeReadReadyFlag  = false;
+            entry.mEdgeWriteReadyFlag = false;
+        } else if (entry.mFd >= 0 && ! entry.mEdgeFlag) {
+            // Level triggered registration with no io interest.
+            PollRemove(entry.mFd);
+            entry.mFd = -1;
+        }
+        entry.mIn  = in  && entry.mFd >= 0;
+        entry.mOut = out && entry.mFd >= 0;
+    } else if (in != entry.mIn || out != entry.mOut || entry.mEdgeFlag) {
         assert(fd >= 0);
         const int op =
             (in ? QCFdPoll::kOpTypeIn : 0) + (out ? QCFdPoll::kOpTypeOut : 0);
@@ -464,10 +504,13 @@ NetManager::UpdateSelf(NetConnection::NetManagerEntry& entry, int fd,
                 return; // Tail recursion
             }
         }
-        entry.mIn  = in  && entry.mFd >= 0;
-        entry.mOut = out && entry.mFd >= 0;
+        entry.mIn       = in  && entry.mFd >= 0;
+        entry.mOut      = out && entry.mFd >= 0;
+        entry.mEdgeFlag = false;
     }
-    if (conn.IsReadPending()) {
+    if (conn.IsReadPending() || (entry.mEdgeFlag && (
+            (entry.mIn  && entry.mEdgeReadReadyFlag) ||
+            (entry.mOut && entry.mEdgeWriteReadyFlag)))) {
         PendingReadList::Insert(
             entry, PendingReadList::GetPrev(mPendingReadList));
     } else {
@@ -550,8 +593,13 @@ NetManager::MainLoop(
         if (dispatcher) {
             dispatcher->DispatchEnd();
         }
-        const int timeout = PendingReadList::IsInList(mPendingReadList) ?
+        int timeout = PendingReadList::IsInList(mPendingReadList) ?
             0 : mTimeoutMs;
+        if (0 < timeout && 0 < mBusyPollUsec &&
+                mNowUsec < mLastEventUsec + mBusyPollUsec) {
+            timeout = 0;
+            mLoopStats.mBusyPollCount++;
+        }
         const int fdCount = mConnectionsCount + 1;
         assert(mPendingUpdate.empty());
         mPollFlag = true;
@@ -571,6 +619,15 @@ NetManager::MainLoop(
         sec *= 1000;
         const int64_t nowMs = sec + usec / 1000;
         mNowUsec = sec * 1000 + usec;
+        const int64_t loopStartUsec = mNowUsec;
+        mLoopStats.mWakeupCount++;
+        if (0 < ret) {
+            mLastEventUsec = mNowUsec;
+            mLoopStats.mEventCount += ret;
+            if (mLoopStats.mMaxEventsPerWakeup < ret) {
+                mLoopStats.mMaxEventsPerWakeup = ret;
+            }
+        }
         for (PendingUpdate::const_iterator it = mPendingUpdate.begin();
                 it != mPendingUpdate.end();
                 ++it) {
@@ -612,7 +669,21 @@ NetManager::MainLoop(
             if (mPollEventHook) {
                 mPollEventHook->Event(*this, conn, op);
             }
+            NetManagerEntry& entry = *conn.GetNetManagerEntry();
+            if (entry.mEdgeFlag) {
+                if ((op & (QCFdPoll::kOpTypeIn | QCFdPoll::kOpTypeHup |
+                        QCFdPoll::kOpTypeError)) != 0) {
+                    entry.mEdgeReadReadyFlag = true;
+                }
+                if ((op & (QCFdPoll::kOpTypeOut | QCFdPoll::kOpTypeHup |
+                        QCFdPoll::kOpTypeError)) != 0) {
+                    entry.mEdgeWriteReadyFlag = true;
+                }
+            }
+            // With edge triggered poll hang up is reported regardless of the
+            // io interest, let read report end of file once read resumes.
             const bool hupError = op == QCFdPoll::kOpTypeHup &&
+                ! entry.mEdgeFlag &&
                 ! conn.WantRead() && ! conn.WantWrite();
             if (((op & (QCFdPoll::kOpTypeIn | QCFdPoll::kOpTypeHup)) != 0 ||
                     PendingReadList::IsInList(*conn.GetNetManagerEntry())) &&
@@ -634,12 +705,23 @@ NetManager::MainLoop(
             mCurConnection = 0;
             conn.Update();
         }
-        // Process connections with pending read (inside filter).
+        // Process connections with pending read (inside filter), and edge
+        // triggered connections with the socket still ready for io.
         while (PendingReadList::IsInList(pendingRead)) {
             NetManagerEntry& cur = PendingReadList::GetNext(pendingRead);
             PendingReadList::Remove(cur);
             NetConnection& conn = **cur.mListIt;
-            conn.HandleReadEvent(mMaxAcceptsPerRead);
+            if (! cur.mEdgeFlag) {
+                conn.HandleReadEvent(mMaxAcceptsPerRead);
+                continue;
+            }
+            mLoopStats.mEdgeReadyCount++;
+            if ((cur.mIn && cur.mEdgeReadReadyFlag) || conn.IsReadPending()) {
+                conn.HandleReadEvent(mMaxAcceptsPerRead);
+            }
+            if (cur.mEdgeWriteReadyFlag && conn.IsGood() && conn.WantWrite()) {
+                conn.HandleWriteEvent();
+            }
         }
         while (! mEpollError.empty()) {
             assert(mEpollError.front());
@@ -690,6 +772,7 @@ NetManager::MainLoop(
         mTimerRunningFlag = false;
         mLastTimerTime = mNow;
         mTimerWheelBucketItr = mRemove.end();
+        mLoopStats.UpdateLatency(microseconds() - loopStartUsec);
         if (runOnceFlag) {
             break;
         }
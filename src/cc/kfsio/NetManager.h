@@ -76,6 +76,47 @@ public:
             {}
     };
     typedef NetConnection::NetManagerEntry NetManagerEntry;
+    /// Event loop instrumentation.
+    struct LoopStats
+    {
+        typedef int64_t Counter;
+        enum { kLatencyBucketCount = 16 };
+        enum { kLatencyFirstBucketUsec = 16 };
+
+        LoopStats()
+            : mWakeupCount(0),
+              mEventCount(0),
+              mMaxEventsPerWakeup(0),
+              mBusyPollCount(0),
+              mEdgeReadyCount(0),
+              mLoopTimeUsec(0)
+        {
+            for (int i = 0; i < kLatencyBucketCount; i++) {
+                mLatency[i] = 0;
+            }
+        }
+        void UpdateLatency(int64_t usec)
+        {
+            mLoopTimeUsec += usec;
+            int i = 0;
+            for (int64_t lim = kLatencyFirstBucketUsec;
+                    lim <= usec && i < kLatencyBucketCount - 1;
+                    lim <<= 1) {
+                i++;
+            }
+            mLatency[i]++;
+        }
+        Counter mWakeupCount;
+        Counter mEventCount;
+        Counter mMaxEventsPerWakeup;
+        Counter mBusyPollCount;
+        Counter mEdgeReadyCount;
+        Counter mLoopTimeUsec;
+        /// Loop processing time histogram. The bucket i counts the loop
+        /// iterations that took less than kLatencyFirstBucketUsec << i
+        /// microseconds, the last bucket counts the remaining iterations.
+        Counter mLatency[kLatencyBucketCount];
+    };
 
     NetManager(int timeoutMs = 1000);
     ~NetManager();
@@ -135,6 +176,22 @@ public:
     void SetTimeNow(time_t now) { mNow = now; }
     int GetConnectionCount() const
         { return mConnectionsCount; }
+    /// Edge triggered mode registers each socket in the poll set once, and
+    /// tracks socket readiness, instead of changing the poll set on every
+    /// read / write interest change. The connections with filters, i.e.
+    /// ssl, remain level triggered. Has no effect if the os poll
+    /// implementation has no edge triggered mode.
+    void SetEdgeTriggered(bool flag);
+    bool IsEdgeTriggered() const
+        { return mEdgeTriggeredFlag; }
+    /// Poll with no wait for the specified time after the last io event,
+    /// in order to reduce latency at the expense of cpu use.
+    void SetBusyPollUsec(int usec)
+        { mBusyPollUsec = usec < 0 ? 0 : usec; }
+    int GetBusyPollUsec() const
+        { return mBusyPollUsec; }
+    const LoopStats& GetLoopStats() const
+        { return mLoopStats; }
 
     // Primarily for debugging, to simulate network failures.
     class PollEventHook
@@ -266,6 +323,10 @@ private:
     int             mResolverCacheSize;
     int             mResolverCacheExpiration;
     bool            mResolverOsFlag;
+    bool            mEdgeTriggeredFlag;
+    int             mBusyPollUsec;
+    int64_t         mLastEventUsec;
+    LoopStats       mLoopStats;
     QCFdPoll&       mPoll;
     PollEventHook*  mPollEventHook;
     Resolver*       mResolver;
@@ -46,6 +46,11 @@ public:
         {}
     virtual uint64_t Poll() const
         { return (uint64_t)mNetManager.NowUsec(); }
+    // The counters are updated by the net manager thread without
+    // synchronization, and intended only for monitoring.
+    void GetLoopStats(
+        NetManager::LoopStats& outStats) const
+        { outStats = mNetManager.GetLoopStats(); }
 private:
     const NetManager& mNetManager;
 private:
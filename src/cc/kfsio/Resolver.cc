@@ -27,6 +27,7 @@
 #include "Globals.h"
 
 #include "common/MsgLogger.h"
+#include "common/Properties.h"
 #include "common/SingleLinkedQueue.h"
 #include "common/kfsatomic.h"
 
@@ -57,6 +58,7 @@ namespace KFS
 {
 using KFS::libkfsio::globals;
 using std::max;
+using std::min;
 using std::pair;
 
 class Resolver::Impl
@@ -67,9 +69,8 @@ public:
         : mNetManager(inNetManager),
           mRunFlag(false),
           mPendingRequests(),
+          mRefreshRequests(),
           mCache(),
-          mExpirationList(),
-          mSearchEntry(),
           mMaxCacheSize(8 << 10),
           mExpirationTimeSec(-1)
     {
@@ -80,7 +81,14 @@ public:
         mAddrInfoHints.ai_protocol = 0;           // Any protocol
     }
     virtual ~Impl()
-        {}
+    {
+        // Refresh requests can only remain here if the resolver was shut
+        // down while the requests were in flight.
+        // The request destructor removes the request from the set.
+        while (! mRefreshRequests.empty()) {
+            delete *mRefreshRequests.begin();
+        }
+    }
     virtual int Start() = 0;
     virtual void Shutdown() = 0;
     int Enqueue(
@@ -91,7 +99,7 @@ public:
         if (! mRunFlag) {
             return -EINVAL;
         }
-        if (Find(inRequest)) {
+        if (Find(inRequest, inTimeout)) {
             return 0;
         }
         if (AddToPending(inRequest)) {
@@ -105,8 +113,28 @@ public:
     {
         mMaxCacheSize      = inMaxCacheSize;
         mExpirationTimeSec = inTimeoutSec;
-        if (mMaxCacheSize <= 0 || mExpirationTimeSec <= 0) {
-            mCache.clear();
+        if (! IsCacheEnabled()) {
+            mCache.Clear();
+        }
+    }
+    static void SetParameters(
+        const char*       inPrefixPtr,
+        const Properties& inParameters)
+    {
+        Properties::String theName(inPrefixPtr ? inPrefixPtr : "");
+        const size_t       thePrefixLen = theName.GetSize();
+        QCStMutexLocker    theLock(sSharedMutex);
+        sNegativeExpirationSec = inParameters.getValue(
+            theName.Truncate(thePrefixLen).Append("NegativeCacheExpiration"),
+            sNegativeExpirationSec);
+        sRefreshTimeSec = inParameters.getValue(
+            theName.Truncate(thePrefixLen).Append("CacheRefreshTime"),
+            sRefreshTimeSec);
+        sMaxSharedCacheSize = inParameters.getValue(
+            theName.Truncate(thePrefixLen).Append("SharedCacheSize"),
+            sMaxSharedCacheSize);
+        if (sMaxSharedCacheSize <= 0) {
+            sSharedCache.Clear();
         }
     }
 protected:
@@ -120,48 +148,22 @@ protected:
         Request& inRequest,
         bool     inExpireFlag = true)
     {
-        if (0 < mExpirationTimeSec && 0 < mMaxCacheSize) {
+        if (IsCacheEnabled()) {
+            const time_t theNow = mNetManager.Now();
             if (inExpireFlag) {
-                const time_t theExpTime =
-                    mNetManager.Now() - mExpirationTimeSec;
-                Entry*       thePtr;
-                while ((thePtr = &Entry::List::GetNext(mExpirationList)) !=
-                        &mExpirationList && thePtr->mTime < theExpTime) {
-                    KFS_LOG_STREAM_DEBUG <<
-                        "cached expired: " << thePtr->mHostName <<
-                    KFS_LOG_EOM;
-                    mCache.erase(*thePtr);
-                }
-            }
-            if (0 == inRequest.mStatus) {
-                Entry* thePtr;
-                while (mMaxCacheSize < mCache.size() &&
-                        (thePtr = &Entry::List::GetNext(mExpirationList)) !=
-                            &mExpirationList) {
-                    KFS_LOG_STREAM_DEBUG <<
-                        " cache size: " << mCache.size() <<
-                        " max: "        << mMaxCacheSize <<
-                        " evicting: "   << thePtr->mHostName <<
-                    KFS_LOG_EOM;
-                    mCache.erase(*thePtr);
-                }
-                Entry theEntry(inRequest.mHostName);
-                theEntry.mTime        = mNetManager.Now();
-                theEntry.mIpAddresses = inRequest.mIpAddresses;
-                theEntry.mMaxResults  = inRequest.mMaxResults;
-                pair<Cache::iterator, bool> const
-                    theRes = mCache.insert(theEntry);
-                Entry& theInserted = const_cast<Entry&>(*theRes.first);
-                if (! theRes.second) {
-                    theInserted = theEntry;
-                }
-                Entry::List::Insert(
-                    theInserted, Entry::List::GetPrev(mExpirationList));
+                mCache.Expire(theNow);
             }
+            UpdateCache(inRequest, theNow);
         }
         if (1 != mPendingRequests.erase(PendingReqEntry(inRequest))) {
             QCRTASSERT(! "invalid request completion -- no pending entry");
         }
+        if (-ECANCELED != inRequest.mStatus) {
+            const int64_t   theTime = mNetManager.NowUsec() -
+                inRequest.mStartUsec;
+            QCStMutexLocker theLock(sSharedMutex);
+            globals().dnsResolveLatency.Update(theTime);
+        }
         Request* thePtr = &inRequest;
         do {
             Request& theCur = *thePtr;
@@ -180,7 +182,7 @@ protected:
     {
         const int64_t theTime    = mNetManager.NowUsec() - inRequest.mStartUsec;
         Counter&      theCounter = 0 == inRequest.mStatus ?
-            globals().ctrNetDnsErrors : globals().ctrNetDnsErrors;
+            globals().ctrNetDnsResolvedCtr : globals().ctrNetDnsErrors;
         theCounter.Update(1);
         theCounter.UpdateTime(theTime);
         inRequest.Done();
@@ -197,24 +199,68 @@ private:
         Entry(
             const string& inHostName = string())
             : mMaxResults(),
+              mStatus(0),
+              mRefreshFlag(false),
               mTime(),
+              mExpirationTime(),
               mHostName(inHostName),
+              mStatusMsg(),
               mIpAddresses()
             { List::Init(*this); }
+        Entry(
+            const Entry& inEntry)
+            : mMaxResults(inEntry.mMaxResults),
+              mStatus(inEntry.mStatus),
+              mRefreshFlag(inEntry.mRefreshFlag),
+              mTime(inEntry.mTime),
+              mExpirationTime(inEntry.mExpirationTime),
+              mHostName(inEntry.mHostName),
+              mStatusMsg(inEntry.mStatusMsg),
+              mIpAddresses(inEntry.mIpAddresses)
+            { List::Init(*this); }
         ~Entry()
             { List::Remove(*this); }
+        // Assignment does not change the expiration list membership.
+        Entry& operator=(
+            const Entry& inEntry)
+        {
+            mMaxResults     = inEntry.mMaxResults;
+            mStatus         = inEntry.mStatus;
+            mRefreshFlag    = inEntry.mRefreshFlag;
+            mTime           = inEntry.mTime;
+            mExpirationTime = inEntry.mExpirationTime;
+            mHostName       = inEntry.mHostName;
+            mStatusMsg      = inEntry.mStatusMsg;
+            mIpAddresses    = inEntry.mIpAddresses;
+            return *this;
+        }
         bool operator<(
             const Entry& inRhs) const
             { return (mHostName < inRhs.mHostName); }
         bool operator==(
             const Entry& inRhs) const
             { return (mHostName == inRhs.mHostName); }
+        bool IsExpired(
+            time_t inNow) const
+            { return (mExpirationTime < inNow); }
+        bool CanBeUsedFor(
+            const Request& inRequest) const
+        {
+            return (0 != mStatus || ! (0 < mMaxResults &&
+                (inRequest.mMaxResults <= 0 ||
+                    mMaxResults < inRequest.mMaxResults) &&
+                (size_t)mMaxResults < mIpAddresses.size()));
+        }
     private:
         typedef QCDLListOp<Entry, 0> List;
 
         int         mMaxResults;
+        int         mStatus;
+        bool        mRefreshFlag;
         time_t      mTime;
+        time_t      mExpirationTime;
         string      mHostName;
+        string      mStatusMsg;
         IpAddresses mIpAddresses;
         Entry*      mPrevPtr[1];
         Entry*      mNextPtr[1];
@@ -222,11 +268,83 @@ private:
         friend class QCDLListOp<Entry, 0>;
         friend class Impl;
     };
-    typedef std::set<
-        Entry,
-        std::less<Entry>,
-        StdFastAllocator< Entry>
-    > Cache;
+    // Name to entry map with insertion order list, used for both the per
+    // instance and process wide shared caches.
+    class Cache
+    {
+    public:
+        Cache()
+            : mEntries(),
+              mExpirationList(),
+              mSearchEntry()
+            {}
+        Entry* Find(
+            const string& inHostName)
+        {
+            mSearchEntry.mHostName = inHostName;
+            const Entries::iterator theIt = mEntries.find(mSearchEntry);
+            mSearchEntry.mHostName = string();
+            return (mEntries.end() == theIt ? 0 :
+                &const_cast<Entry&>(*theIt));
+        }
+        void Erase(
+            const Entry& inEntry)
+            { mEntries.erase(inEntry); }
+        void Expire(
+            time_t inNow)
+        {
+            // The list is in the insertion order, the negative entries might
+            // expire sooner, and are removed on lookup or eviction.
+            Entry* thePtr;
+            while ((thePtr = &Entry::List::GetNext(mExpirationList)) !=
+                    &mExpirationList && thePtr->IsExpired(inNow)) {
+                KFS_LOG_STREAM_DEBUG <<
+                    "cached expired: " << thePtr->mHostName <<
+                KFS_LOG_EOM;
+                mEntries.erase(*thePtr);
+            }
+        }
+        Entry& Insert(
+            const Entry& inEntry,
+            size_t       inMaxSize)
+        {
+            Entry* thePtr = Find(inEntry.mHostName);
+            if (thePtr) {
+                *thePtr = inEntry;
+            } else {
+                while (0 < inMaxSize && inMaxSize <= mEntries.size() &&
+                        (thePtr = &Entry::List::GetNext(mExpirationList)) !=
+                            &mExpirationList) {
+                    KFS_LOG_STREAM_DEBUG <<
+                        " cache size: " << mEntries.size() <<
+                        " max: "        << inMaxSize <<
+                        " evicting: "   << thePtr->mHostName <<
+                    KFS_LOG_EOM;
+                    mEntries.erase(*thePtr);
+                }
+                thePtr = &const_cast<Entry&>(*mEntries.insert(inEntry).first);
+            }
+            Entry::List::Insert(*thePtr, Entry::List::GetPrev(mExpirationList));
+            return *thePtr;
+        }
+        void Clear()
+            { mEntries.clear(); }
+    private:
+        typedef std::set<
+            Entry,
+            std::less<Entry>,
+            StdFastAllocator<Entry>
+        > Entries;
+
+        Entries mEntries;
+        Entry   mExpirationList;
+        Entry   mSearchEntry;
+    private:
+        Cache(
+            const Cache& inCache);
+        Cache& operator=(
+            const Cache& inCache);
+    };
     class PendingReqEntry
     {
     public:
@@ -261,44 +379,177 @@ private:
         std::less<PendingReqEntry>,
         StdFastAllocator< PendingReqEntry>
     > PendingRequests;
+    // Background refresh of the cache entry, issued on cache hit shortly
+    // before the entry expiration. The result updates the cache the same way
+    // as any other request, then the request deletes itself.
+    class RefreshRequest : public Request
+    {
+    public:
+        RefreshRequest(
+            Impl&         inImpl,
+            const string& inHostName,
+            int           inMaxResults)
+            : Request(inHostName, inMaxResults),
+              mImpl(inImpl)
+            { mImpl.mRefreshRequests.insert(this); }
+        virtual ~RefreshRequest()
+            { mImpl.mRefreshRequests.erase(this); }
+        virtual void Done()
+            { delete this; }
+    private:
+        Impl& mImpl;
+    private:
+        RefreshRequest(
+            const RefreshRequest& inRequest);
+        RefreshRequest& operator=(
+            const RefreshRequest& inRequest);
+    };
+    friend class RefreshRequest;
+    typedef std::set<
+        RefreshRequest*,
+        std::less<RefreshRequest*>,
+        StdFastAllocator<RefreshRequest*>
+    > RefreshRequests;
 
     PendingRequests mPendingRequests;
+    RefreshRequests mRefreshRequests;
     Cache           mCache;
-    Entry           mExpirationList;
-    Entry           mSearchEntry;
     size_t          mMaxCacheSize;
     int             mExpirationTimeSec;
 
+    static QCMutex       sSharedMutex;
+    static Cache         sSharedCache;
+    static volatile int  sNegativeExpirationSec;
+    static volatile int  sRefreshTimeSec;
+    static volatile int  sMaxSharedCacheSize;
+
+    bool IsCacheEnabled() const
+        { return (0 < mExpirationTimeSec && 0 < mMaxCacheSize); }
     bool Find(
-        Request& inRequest)
+        Request& inRequest,
+        int      inTimeout)
     {
-        if (mExpirationTimeSec <= 0 || mMaxCacheSize <= 0) {
+        if (! IsCacheEnabled()) {
             return false;
         }
-        mSearchEntry.mHostName = inRequest.mHostName;
-        const Cache::iterator theIt = mCache.find(mSearchEntry);
-        mSearchEntry.mHostName = string();
-        if (mCache.end() == theIt) {
-            return false;
+        const time_t theNow   = mNetManager.Now();
+        Entry*       theEntry = mCache.Find(inRequest.mHostName);
+        if (theEntry && theEntry->IsExpired(theNow)) {
+            mCache.Erase(*theEntry);
+            theEntry = 0;
         }
-        if (theIt->mTime + mExpirationTimeSec < mNetManager.Now()) {
-            mCache.erase(theIt);
-            return false;
+        if (! theEntry) {
+            theEntry = FindShared(inRequest, theNow);
         }
-        if (0 < theIt->mMaxResults &&
-                (inRequest.mMaxResults <= 0 ||
-                theIt->mMaxResults < inRequest.mMaxResults) &&
-                (size_t)theIt->mMaxResults <
-                    theIt->mIpAddresses.size()) {
+        if (! theEntry || ! theEntry->CanBeUsedFor(inRequest)) {
             return false;
         }
-        inRequest.mIpAddresses = theIt->mIpAddresses;
-        inRequest.mStatus      = 0;
-        inRequest.mStatusMsg.clear();
+        inRequest.mIpAddresses = theEntry->mIpAddresses;
+        inRequest.mStatus      = theEntry->mStatus;
+        inRequest.mStatusMsg   = theEntry->mStatusMsg;
+        if (0 == theEntry->mStatus) {
+            globals().ctrNetDnsCacheHits.Update(1);
+            const int theRefreshTimeSec = sRefreshTimeSec;
+            if (0 < theRefreshTimeSec && ! theEntry->mRefreshFlag &&
+                    theEntry->mExpirationTime <= theNow + theRefreshTimeSec) {
+                // Mark the entry first, as the refresh might complete, and
+                // replace the entry, before the enqueue returns.
+                theEntry->mRefreshFlag = true;
+                Refresh(theEntry->mHostName, theEntry->mMaxResults,
+                    inTimeout);
+            }
+        } else {
+            globals().ctrNetDnsNegativeCacheHits.Update(1);
+        }
         DoneSelf(inRequest);
         return true;
     }
-
+    Entry* FindShared(
+        const Request& inRequest,
+        time_t         inNow)
+    {
+        if (sMaxSharedCacheSize <= 0) {
+            return 0;
+        }
+        QCStMutexLocker theLock(sSharedMutex);
+        Entry* const    thePtr = sSharedCache.Find(inRequest.mHostName);
+        if (! thePtr) {
+            return 0;
+        }
+        if (thePtr->IsExpired(inNow)) {
+            sSharedCache.Erase(*thePtr);
+            return 0;
+        }
+        if (! thePtr->CanBeUsedFor(inRequest)) {
+            return 0;
+        }
+        Entry& theEntry = mCache.Insert(*thePtr, mMaxCacheSize);
+        theLock.Unlock();
+        // Do not keep the entry longer than this instance's expiration.
+        theEntry.mExpirationTime = min(theEntry.mExpirationTime,
+            theEntry.mTime + (time_t)mExpirationTimeSec);
+        theEntry.mRefreshFlag = false;
+        return &theEntry;
+    }
+    void Refresh(
+        const string& inHostName,
+        int           inMaxResults,
+        int           inTimeout)
+    {
+        globals().ctrNetDnsCacheRefreshes.Update(1);
+        Request& theRequest = *(new RefreshRequest(
+            *this, inHostName, inMaxResults));
+        theRequest.mStartUsec = mNetManager.NowUsec();
+        if (AddToPending(theRequest)) {
+            return;
+        }
+        const int theStatus = EnqueueSelf(theRequest, inTimeout);
+        if (0 != theStatus) {
+            mPendingRequests.erase(PendingReqEntry(theRequest));
+            delete &theRequest;
+        }
+    }
+    void UpdateCache(
+        const Request& inRequest,
+        time_t         inNow)
+    {
+        Entry* const theCurPtr = mCache.Find(inRequest.mHostName);
+        if (0 != inRequest.mStatus) {
+            const int theNegativeExpirationSec = sNegativeExpirationSec;
+            if (theCurPtr && 0 == theCurPtr->mStatus &&
+                    ! theCurPtr->IsExpired(inNow)) {
+                // Keep using the last good result until it expires, and allow
+                // the subsequent lookups to refresh it again.
+                theCurPtr->mRefreshFlag = false;
+                return;
+            }
+            if (-ECANCELED == inRequest.mStatus ||
+                    theNegativeExpirationSec <= 0) {
+                if (theCurPtr) {
+                    mCache.Erase(*theCurPtr);
+                }
+                return;
+            }
+        }
+        Entry theEntry(inRequest.mHostName);
+        theEntry.mTime           = inNow;
+        theEntry.mExpirationTime = inNow + min(mExpirationTimeSec,
+            0 == inRequest.mStatus ? mExpirationTimeSec :
+                (int)sNegativeExpirationSec);
+        theEntry.mStatus         = inRequest.mStatus;
+        theEntry.mStatusMsg      = inRequest.mStatusMsg;
+        theEntry.mIpAddresses    = inRequest.mIpAddresses;
+        theEntry.mMaxResults     = inRequest.mMaxResults;
+        mCache.Insert(theEntry, mMaxCacheSize);
+        if (sMaxSharedCacheSize <= 0) {
+            return;
+        }
+        QCStMutexLocker theLock(sSharedMutex);
+        if (0 < sMaxSharedCacheSize) {
+            sSharedCache.Expire(inNow);
+            sSharedCache.Insert(theEntry, (size_t)sMaxSharedCacheSize);
+        }
+    }
     bool AddToPending(
         Request& inRequest)
     {
@@ -318,6 +569,11 @@ protected:
     Impl& operator=(
         const Impl& inImpl);
 };
+QCMutex               Resolver::Impl::sSharedMutex;
+Resolver::Impl::Cache Resolver::Impl::sSharedCache;
+volatile int          Resolver::Impl::sNegativeExpirationSec = 1;
+volatile int          Resolver::Impl::sRefreshTimeSec        = -1;
+volatile int          Resolver::Impl::sMaxSharedCacheSize    = 0;
 
 class Resolver::OsImpl :
     public Resolver::Impl,
@@ -1018,6 +1274,14 @@ Resolver::SetCacheSizeAndTimeout(
     return mImpl.SetCacheSizeAndTimeout(inMaxCacheSize, inTimeoutSec);
 }
 
+    /* static */ void
+Resolver::SetParameters(
+    const char*       inPrefixPtr,
+    const Properties& inParameters)
+{
+    Resolver::Impl::SetParameters(inPrefixPtr, inParameters);
+}
+
     void
 Resolver::ChildAtFork()
 {
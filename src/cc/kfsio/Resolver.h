@@ -37,6 +37,7 @@ using std::string;
 using std::vector;
 
 class NetManager;
+class Properties;
 
 class Resolver
 {
@@ -105,6 +106,19 @@ public:
     void SetCacheSizeAndTimeout(
         size_t inMaxCacheSize,
         int    inTimeoutSec);
+    // Process wide parameters, common to all resolver instances:
+    // <prefix>NegativeCacheExpiration -- failed lookup cache time in seconds,
+    // capped by the instance cache expiration time; 0 turns negative caching
+    // off.
+    // <prefix>CacheRefreshTime -- refresh cache entry in the background on
+    // lookup if the entry expires in less than the specified number of
+    // seconds; 0 or negative turns refresh off.
+    // <prefix>SharedCacheSize -- max size of the cache shared by all resolver
+    // instances, used as the second level cache by instances with cache
+    // enabled; 0 turns the shared cache off.
+    static void SetParameters(
+        const char*       inPrefixPtr,
+        const Properties& inParameters);
     void ChildAtFork();
     static int Initialize();
     static void Cleanup();
@@ -257,6 +257,16 @@ public:
 #   endif
 #endif
         ));
+#ifdef SSL_OP_ENABLE_KTLS
+        // Let openssl install kernel tls on the socket after the handshake
+        // completes, if the kernel and the negotiated cipher support it.
+        // Kernel tls cannot be removed from the socket, therefore it is not
+        // compatible with clear text communication after the ssl shutdown.
+        if (inParams.getValue(
+                theParamName.Truncate(thePrefLen).Append("ktls"), 0) != 0) {
+            SSL_CTX_set_options(theRetPtr, SSL_OP_ENABLE_KTLS);
+        }
+#endif
         SSL_CTX_set_timeout(
                 theRetPtr,
                 inParams.getValue(
@@ -449,7 +459,10 @@ public:
           mSslErrorFlag(false),
           mShutdownCompleteFlag(false),
           mVerifyOrGetPskInvokedFlag(false),
-          mRenegotiationPendingFlag(false)
+          mRenegotiationPendingFlag(false),
+          mKtlsCheckedFlag(false),
+          mKtlsSendFlag(false),
+          mKtlsRecvFlag(false)
     {
         if (! mSslPtr) {
             return;
@@ -575,6 +588,12 @@ public:
         if (inIoBuffer.IsEmpty()) {
             return 0;
         }
+        if (mKtlsSendFlag && ! SSL_want_write(mSslPtr)) {
+            // The kernel encrypts the data, write the buffers directly.
+            // IOBuffer::Write() accounts the bytes written the same way as
+            // the SSL_write() path below: the application bytes.
+            return inIoBuffer.Write(inSocket.GetFd());
+        }
         ERR_clear_error();
         int theWrCnt = 0;
         for (IOBuffer::iterator theIt = inIoBuffer.begin();
@@ -635,6 +654,14 @@ public:
             }
             return -EINVAL;
         }
+        if (mKtlsSendFlag || mKtlsRecvFlag) {
+            // Kernel tls state belongs to the socket it was installed on.
+            if (outErrMsgPtr) {
+                *outErrMsgPtr = "kernel tls session cannot be moved to"
+                    " another socket";
+            }
+            return -EINVAL;
+        }
         errno = 0;
         int theRet = 0;
         if (! SSL_set_fd(mSslPtr, inSocketPtr->GetFd())) {
@@ -745,7 +772,8 @@ public:
     }
     virtual bool RenewSession()
     {
-        if (! mSslPtr || mError != 0) {
+        if (! mSslPtr || mError != 0 || mKtlsSendFlag || mKtlsRecvFlag) {
+            // Openssl does not support renegotiation with kernel tls.
             return false;
         }
         mRenegotiationPendingFlag =
@@ -834,6 +862,9 @@ private:
     bool              mShutdownCompleteFlag:1;
     bool              mVerifyOrGetPskInvokedFlag:1;
     bool              mRenegotiationPendingFlag:1;
+    bool              mKtlsCheckedFlag:1;
+    bool              mKtlsSendFlag:1;
+    bool              mKtlsRecvFlag:1;
 
     struct OpenSslInit
     {
@@ -1107,6 +1138,7 @@ private:
             if (! mServerFlag && ! mSessionStoredFlag) {
                 StoreClientSession();
             }
+            UpdateKtlsState();
             return 0;
         }
         if (mRenegotiationPendingFlag) {
@@ -1121,6 +1153,7 @@ private:
             }
             // Try to update in case of renegotiation.
             StoreClientSession();
+            UpdateKtlsState();
             return 0;
         }
         const int theErr = SslRetToErr(theRet);
@@ -1273,6 +1306,32 @@ private:
 #endif
         }
     }
+    void UpdateKtlsState()
+    {
+        if (mKtlsCheckedFlag) {
+            return;
+        }
+        mKtlsCheckedFlag = true;
+#ifdef SSL_OP_ENABLE_KTLS
+        if ((SSL_get_options(mSslPtr) & SSL_OP_ENABLE_KTLS) == 0) {
+            return;
+        }
+        // Openssl enables kernel tls when the keys are changed, if the kernel
+        // tls module is loaded and the cipher is supported, otherwise it
+        // continues to use user space encryption.
+        mKtlsSendFlag = BIO_get_ktls_send(SSL_get_wbio(mSslPtr)) != 0;
+        mKtlsRecvFlag = BIO_get_ktls_recv(SSL_get_rbio(mSslPtr)) != 0;
+        if (mKtlsSendFlag) {
+            globals().ctrSslKtlsSend.Update(1);
+        }
+        if (mKtlsRecvFlag) {
+            globals().ctrSslKtlsRecv.Update(1);
+        }
+        if (! mKtlsSendFlag && ! mKtlsRecvFlag) {
+            globals().ctrSslKtlsFallback.Update(1);
+        }
+#endif
+    }
     int ShutdownSelf(
         NetConnection& inConnection,
         SslFilter&     inOuter)
@@ -1290,6 +1349,10 @@ private:
             // Wait for handshake to complete, then issue shutdown.
             return 0;
         }
+        if (mKtlsSendFlag || mKtlsRecvFlag) {
+            // Clear text communication is not possible with kernel tls.
+            return -EINVAL;
+        }
         ERR_clear_error();
         int theRet = SSL_shutdown(mSslPtr);
         if (theRet == 0) {
@@ -403,7 +403,9 @@ TcpSocket::Accept(int* status /* = 0 */)
     TcpSocket* accSock;
     socklen_t  cliAddrLen = cliAddr.Size();
 
-    if ((fd = accept(mSockFd, cliAddr.Ptr(), &cliAddrLen)) < 0) {
+    const bool unixFlag = kTypeUnix == mType;
+    if ((fd = accept(mSockFd, unixFlag ? 0 : cliAddr.Ptr(),
+            unixFlag ? 0 : &cliAddrLen)) < 0) {
         const int err = errno;
         if (err != EAGAIN && err != EWOULDBLOCK) {
             Perror("accept", err);
@@ -515,7 +517,8 @@ TcpSocket::SetupSocket()
     }
 #endif
     // turn off NAGLE
-    if (SetSockOpt(mSockFd, IPPROTO_TCP, TCP_NODELAY, flag)) {
+    if (kTypeUnix != mType &&
+            SetSockOpt(mSockFd, IPPROTO_TCP, TCP_NODELAY, flag)) {
         Perror("setsockopt TCP_NODELAY");
     }
 
@@ -534,6 +537,9 @@ TcpSocket::GetPeerName(TcpSocket::Address& peerAddr) const
 string
 TcpSocket::GetPeerName() const
 {
+    if (kTypeUnix == mType) {
+        return "unix";
+    }
     Address saddr(mType);
     if (GetPeerName(saddr) < 0) {
         return "unknown";
@@ -544,6 +550,9 @@ TcpSocket::GetPeerName() const
 string
 TcpSocket::GetSockName() const
 {
+    if (kTypeUnix == mType) {
+        return "unix";
+    }
     Address   saddr(mType);
     socklen_t len = saddr.Size();
     if (getsockname(mSockFd, saddr.Ptr(), &len)) {
@@ -558,6 +567,9 @@ TcpSocket::GetPeerLocation(ServerLocation& location) const
     if (mSockFd < 0) {
         return -EBADF;
     }
+    if (kTypeUnix == mType) {
+        return -EAFNOSUPPORT;
+    }
     Address addr(mType);
     const int ret = GetPeerName(addr);
     return (ret < 0 ? ret : addr.GetLocation(location));
@@ -569,6 +581,9 @@ TcpSocket::GetSockLocation(ServerLocation& location) const
     if (mSockFd < 0) {
         return -EBADF;
     }
+    if (kTypeUnix == mType) {
+        return -EAFNOSUPPORT;
+    }
     Address   addr(mType);
     socklen_t len = addr.Size();
     if (getsockname(mSockFd, addr.Ptr(), &len)) {
@@ -577,6 +592,55 @@ TcpSocket::GetSockLocation(ServerLocation& location) const
     return addr.GetLocation(location);
 }
 
+// Convert socket address into IPv6 address, with IPv4 address mapped into
+// ::ffff:0:0/96.
+static bool
+GetIpV6Address(const struct sockaddr_storage& saddr, struct in6_addr& addr)
+{
+    if (saddr.ss_family == AF_INET6) {
+        addr = reinterpret_cast<const struct sockaddr_in6&>(saddr).sin6_addr;
+        return true;
+    }
+    if (saddr.ss_family == AF_INET) {
+        memset(&addr, 0, sizeof(addr));
+        addr.s6_addr[10] = 0xff;
+        addr.s6_addr[11] = 0xff;
+        memcpy(addr.s6_addr + 12,
+            &reinterpret_cast<const struct sockaddr_in&>(saddr).sin_addr, 4);
+        return true;
+    }
+    return false;
+}
+
+bool
+TcpSocket::IsLocalPeer() const
+{
+    if (mSockFd < 0) {
+        return false;
+    }
+    if (kTypeUnix == mType) {
+        return true;
+    }
+    struct sockaddr_storage saddr;
+    socklen_t               len = sizeof(saddr);
+    struct in6_addr         peer;
+    struct in6_addr         self;
+    if (getpeername(mSockFd, reinterpret_cast<struct sockaddr*>(&saddr),
+                &len) || ! GetIpV6Address(saddr, peer)) {
+        return false;
+    }
+    if (IN6_IS_ADDR_LOOPBACK(&peer) ||
+            (IN6_IS_ADDR_V4MAPPED(&peer) && peer.s6_addr[12] == 127)) {
+        return true;
+    }
+    len = sizeof(saddr);
+    if (getsockname(mSockFd, reinterpret_cast<struct sockaddr*>(&saddr),
+                &len) || ! GetIpV6Address(saddr, self)) {
+        return false;
+    }
+    return (memcmp(&peer, &self, sizeof(peer)) == 0);
+}
+
 int
 TcpSocket::Send(const char *buf, int bufLen)
 {
@@ -652,6 +716,24 @@ TcpSocket::GetSocketError() const
     return err;
 }
 
+int
+TcpSocket::GetIncomingCpu() const
+{
+#ifdef SO_INCOMING_CPU
+    if (mSockFd < 0) {
+        return -1;
+    }
+    int       cpu = -1;
+    socklen_t len = sizeof(cpu);
+    if (getsockopt(mSockFd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len)) {
+        return -1;
+    }
+    return cpu;
+#else
+    return -1;
+#endif
+}
+
 string
 TcpSocket::ToString(const Address& saddr)
 {
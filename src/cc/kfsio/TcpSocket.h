@@ -44,7 +44,10 @@ public:
     {
         kTypeNone = 0x0,
         kTypeIpV4 = 0x1,
-        kTypeIpV6 = 0x2
+        kTypeIpV6 = 0x2,
+        // Unix domain stream socket, created and bound by the caller, and
+        // wrapped with TcpSocket(fd, kTypeUnix).
+        kTypeUnix = 0x4
     };
     enum { kFakeValidFd = ~(1 << (sizeof(int) * 8 - 1)) };
     TcpSocket(
@@ -116,6 +119,10 @@ public:
     string GetSockName() const;
     int GetPeerLocation(ServerLocation& location) const;
     int GetSockLocation(ServerLocation& location) const;
+    /// Return true if the peer is on the same host: the peer address is
+    /// loopback, or the same as the socket's local address. IPv4 mapped IPv6
+    /// addresses are compared as IPv4 addresses.
+    bool IsLocalPeer() const;
 
     /// Sends at-most the specified # of bytes.
     /// @retval Returns the result of calling send().
@@ -132,6 +139,9 @@ public:
     int Shutdown() { return Shutdown(true, true); }
     /// Get and clear pending socket error: getsockopt(SO_ERROR)
     int GetSocketError() const;
+    /// Return the cpu that processed the most recent incoming packets:
+    /// getsockopt(SO_INCOMING_CPU), or -1 if not available.
+    int GetIncomingCpu() const;
     Type GetType() const { return mType; }
     static int Validate(const string& address);
     static bool IsValidConnectToAddress(const ServerLocation& location);
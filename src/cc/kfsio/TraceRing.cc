@@ -0,0 +1,146 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Sampled request trace records binary ring file.
+//
+//----------------------------------------------------------------------------
+
+#include "TraceRing.h"
+
+#include "common/Properties.h"
+#include "common/MsgLogger.h"
+#include "common/time.h"
+#include "qcdio/QCUtils.h"
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+namespace KFS
+{
+
+TraceRing::TraceRing()
+    : mFileName(),
+      mFileSize(64 << 20),
+      mSampleInterval(100),
+      mSampleCount(0),
+      mMapSize(0),
+      mHeaderPtr(0),
+      mRecordsPtr(0)
+{}
+
+TraceRing::~TraceRing()
+{
+    TraceRing::Close();
+}
+
+    int
+TraceRing::SetParameters(
+    const char*       inPrefixPtr,
+    const Properties& inProps)
+{
+    Properties::String theName(inPrefixPtr ? inPrefixPtr : "");
+    const size_t       theLen         = theName.GetSize();
+    const string       thePrevName    = mFileName;
+    const int64_t      thePrevSize    = mFileSize;
+    mFileName = inProps.getValue(
+        theName.Truncate(theLen).Append("fileName"), mFileName);
+    mFileSize = inProps.getValue(
+        theName.Truncate(theLen).Append("fileSize"), mFileSize);
+    mSampleInterval = inProps.getValue(
+        theName.Truncate(theLen).Append("sampleInterval"), mSampleInterval);
+    if (mFileName.empty() || mSampleInterval < 1) {
+        Close();
+        return 0;
+    }
+    if (mHeaderPtr && thePrevName == mFileName && thePrevSize == mFileSize) {
+        return 0;
+    }
+    Close();
+    return Open();
+}
+
+    int
+TraceRing::Open()
+{
+    const int64_t theCapacity = (mFileSize - (int64_t)sizeof(Header)) /
+        (int64_t)sizeof(Record);
+    if (theCapacity <= 0) {
+        KFS_LOG_STREAM_ERROR <<
+            "trace ring: " << mFileName <<
+            " invalid file size: " << mFileSize <<
+        KFS_LOG_EOM;
+        return -EINVAL;
+    }
+    const size_t theSize = sizeof(Header) + theCapacity * sizeof(Record);
+    const int    theFd   = open(mFileName.c_str(), O_RDWR | O_CREAT, 0644);
+    int          theErr  = 0;
+    void*        thePtr  = MAP_FAILED;
+    if (theFd < 0 || ftruncate(theFd, (off_t)theSize) ||
+            MAP_FAILED == (thePtr = mmap(0, theSize,
+                PROT_READ | PROT_WRITE, MAP_SHARED, theFd, 0))) {
+        theErr = errno;
+    }
+    if (0 <= theFd) {
+        close(theFd);
+    }
+    if (MAP_FAILED == thePtr) {
+        KFS_LOG_STREAM_ERROR <<
+            "trace ring: " << mFileName << ": " <<
+            QCUtils::SysError(theErr) <<
+        KFS_LOG_EOM;
+        return (0 < theErr ? -theErr : -EFAULT);
+    }
+    mMapSize    = theSize;
+    mHeaderPtr  = reinterpret_cast<Header*>(thePtr);
+    mRecordsPtr = reinterpret_cast<Record*>(mHeaderPtr + 1);
+    memset(mHeaderPtr, 0, sizeof(*mHeaderPtr));
+    memcpy(mHeaderPtr->mMagic, "QFSTRACE", sizeof(mHeaderPtr->mMagic));
+    mHeaderPtr->mVersion       = kVersion;
+    mHeaderPtr->mRecordSize    = (int32_t)sizeof(Record);
+    mHeaderPtr->mCapacity      = theCapacity;
+    mHeaderPtr->mWriteCount    = 0;
+    mHeaderPtr->mStartTimeUsec = microseconds();
+    mSampleCount = 0;
+    KFS_LOG_STREAM_INFO <<
+        "trace ring: " << mFileName <<
+        " records: "   << theCapacity <<
+        " sample: 1/"  << mSampleInterval <<
+    KFS_LOG_EOM;
+    return 0;
+}
+
+    void
+TraceRing::Close()
+{
+    if (! mHeaderPtr) {
+        return;
+    }
+    munmap(mHeaderPtr, mMapSize);
+    mHeaderPtr  = 0;
+    mRecordsPtr = 0;
+    mMapSize    = 0;
+}
+
+} // namespace KFS
@@ -0,0 +1,124 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Sampled request trace records binary ring file.
+// The file is memory mapped, therefore appending a record does not involve
+// system calls, and the records survive process crash. The file consists of
+// the header followed by fixed size records. All fields are in host byte
+// order. The header's write count is incremented after each record write,
+// the oldest record index is write count modulo record capacity, once the
+// write count exceeds the capacity.
+// The trace ring is not thread safe, the caller must serialize access.
+//
+//----------------------------------------------------------------------------
+
+#ifndef LIBKFSIO_TRACE_RING_H
+#define LIBKFSIO_TRACE_RING_H
+
+#include <stdint.h>
+
+#include <string>
+
+namespace KFS
+{
+using std::string;
+
+class Properties;
+
+class TraceRing
+{
+public:
+    struct Header
+    {
+        char    mMagic[8];     // "QFSTRACE"
+        int32_t mVersion;
+        int32_t mRecordSize;
+        int64_t mCapacity;     // Number of records.
+        int64_t mWriteCount;   // Total number of records written.
+        int64_t mStartTimeUsec;
+        char    mReserved[24];
+    };
+    struct Record
+    {
+        int64_t mTimeUsec;     // Request completion time.
+        int64_t mSeq;
+        int64_t mWaitUsec;     // Queue wait, or -1 if not available.
+        int64_t mExecUsec;     // Execution time.
+        int64_t mLogUsec;      // Log commit time, or -1 if not applicable.
+        int32_t mOp;
+        int32_t mStatus;
+    };
+    enum { kVersion = 1 };
+
+    TraceRing();
+    ~TraceRing();
+    // Parameters: <prefix>fileName, <prefix>fileSize, <prefix>sampleInterval.
+    // Empty file name or sample interval less than 1 turns tracing off.
+    // Returns 0 on success, or negative error code if the file cannot be
+    // created or mapped, in which case tracing is turned off.
+    int SetParameters(
+        const char*       inPrefixPtr,
+        const Properties& inProps);
+    bool IsEnabled() const
+        { return (0 != mHeaderPtr); }
+    // Returns true every sample interval invocations.
+    bool Sample()
+    {
+        if (! mHeaderPtr) {
+            return false;
+        }
+        if (++mSampleCount < mSampleInterval) {
+            return false;
+        }
+        mSampleCount = 0;
+        return true;
+    }
+    void Put(
+        const Record& inRecord)
+    {
+        if (! mHeaderPtr) {
+            return;
+        }
+        mRecordsPtr[mHeaderPtr->mWriteCount % mHeaderPtr->mCapacity] =
+            inRecord;
+        mHeaderPtr->mWriteCount++;
+    }
+    void Close();
+private:
+    string  mFileName;
+    int64_t mFileSize;
+    int64_t mSampleInterval;
+    int64_t mSampleCount;
+    size_t  mMapSize;
+    Header* mHeaderPtr;
+    Record* mRecordsPtr;
+
+    int Open();
+private:
+    TraceRing(
+        const TraceRing& inRing);
+    TraceRing& operator=(
+        const TraceRing& inRing);
+};
+
+} // namespace KFS
+
+#endif // LIBKFSIO_TRACE_RING_H
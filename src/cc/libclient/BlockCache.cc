@@ -0,0 +1,319 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Client side chunk block cache.
+//
+//----------------------------------------------------------------------------
+
+#include "BlockCache.h"
+
+#include "kfsio/IOBuffer.h"
+#include "qcdio/qcstutils.h"
+#include "qcdio/qcdebug.h"
+#include "qcdio/QCUtils.h"
+
+#include <algorithm>
+#include <limits>
+#include <string.h>
+
+namespace KFS
+{
+namespace client
+{
+using std::max;
+using std::min;
+using std::make_pair;
+using std::numeric_limits;
+
+class BlockCache::Entry
+{
+public:
+    Entry(
+        const Key& inKey,
+        int        inSize)
+        : mKey(inKey),
+          mDataPtr(new char[inSize]),
+          mSize(inSize),
+          mLastAccess(0),
+          mPrevAccess(0)
+        { Lru::Init(*this); }
+    ~Entry()
+        { delete [] mDataPtr; }
+
+    const Key   mKey;
+    char* const mDataPtr;
+    const int   mSize;
+    uint64_t    mLastAccess;
+    uint64_t    mPrevAccess;
+private:
+    Entry* mPrevPtr[1];
+    Entry* mNextPtr[1];
+
+    friend class QCDLListOp<Entry, 0>;
+private:
+    Entry(
+        const Entry& inEntry);
+    Entry& operator=(
+        const Entry& inEntry);
+};
+
+// Approximate per block memory overhead: the entry and the map nodes.
+const int64_t kEntryOverhead = 160;
+
+BlockCache::BlockCache(
+    int64_t inMaxSize,
+    int     inBlockSize)
+    : mMaxSize(max(int64_t(0), inMaxSize)),
+      mBlockSize(max(1, inBlockSize)),
+      mMutex(),
+      mEntries(),
+      mHistory(),
+      mAccessSeq(0),
+      mStats()
+{
+    Lru::Init(mLruPtr);
+}
+
+BlockCache::~BlockCache()
+{
+    while (! mEntries.empty()) {
+        Erase(mEntries.begin());
+    }
+}
+
+bool
+BlockCache::Get(
+    kfsFileId_t  inFileId,
+    kfsChunkId_t inChunkId,
+    int64_t      inChunkVersion,
+    int64_t      inOffset,
+    int          inSize,
+    int64_t      inChunkSize,
+    IOBuffer&    outBuffer)
+{
+    if (inOffset < 0 || inSize <= 0 || inChunkSize < inOffset + inSize) {
+        return false;
+    }
+    QCStMutexLocker theLock(mMutex);
+    const int64_t theEnd   = inOffset + inSize;
+    const int64_t theStart = inOffset - inOffset % mBlockSize;
+    // Verify that all blocks are present first, in order to count and touch
+    // the blocks only on hit.
+    Entries::iterator const theFirstIt = mEntries.find(
+        Key(inFileId, inChunkId, inChunkVersion, theStart));
+    Entries::iterator       theIt      = theFirstIt;
+    for (int64_t thePos = theStart; thePos < theEnd; thePos += mBlockSize) {
+        if (theIt == mEntries.end() ||
+                theIt->first.mChunkId != inChunkId ||
+                theIt->first.mChunkVersion != inChunkVersion ||
+                theIt->first.mOffset != thePos ||
+                theIt->second->mSize !=
+                    (int)min(int64_t(mBlockSize), inChunkSize - thePos)) {
+            mStats.mMissCount++;
+            return false;
+        }
+        ++theIt;
+    }
+    theIt = theFirstIt;
+    for (int64_t thePos = theStart; thePos < theEnd; thePos += mBlockSize) {
+        Entry&        theEntry = *theIt->second;
+        const int64_t theBeg   = max(thePos, inOffset);
+        const int     theLen   = (int)(min(thePos + theEntry.mSize, theEnd) -
+            theBeg);
+        outBuffer.CopyIn(theEntry.mDataPtr + (theBeg - thePos), theLen);
+        Touch(theEntry);
+        ++theIt;
+    }
+    mStats.mHitCount++;
+    mStats.mHitByteCount += inSize;
+    return true;
+}
+
+void
+BlockCache::Put(
+    kfsFileId_t     inFileId,
+    kfsChunkId_t    inChunkId,
+    int64_t         inChunkVersion,
+    int64_t         inOffset,
+    const IOBuffer& inBuffer,
+    int64_t         inChunkSize)
+{
+    const int64_t theEnd = inOffset + inBuffer.BytesConsumable();
+    if (mMaxSize <= 0 || inOffset < 0 || inChunkSize < theEnd) {
+        return;
+    }
+    IOBuffer::iterator theBufIt  = inBuffer.begin();
+    int                theBufPos = 0;
+    int64_t            theCurPos = inOffset;
+    int64_t            thePos    =
+        (inOffset + mBlockSize - 1) / mBlockSize * mBlockSize;
+    QCStMutexLocker theLock(mMutex);
+    for (; thePos < theEnd; thePos += mBlockSize) {
+        const int theSize =
+            (int)min(int64_t(mBlockSize), inChunkSize - thePos);
+        if (theEnd < thePos + theSize) {
+            break;
+        }
+        const Key theKey(inFileId, inChunkId, inChunkVersion, thePos);
+        Entries::iterator const theIt = mEntries.find(theKey);
+        Entry*                  theEntryPtr = 0;
+        if (theIt == mEntries.end()) {
+            theEntryPtr = new Entry(theKey, theSize);
+        }
+        // Advance the buffer iterator to the block start, and copy the block
+        // out if it is not already in the cache.
+        char* theDstPtr = theEntryPtr ? theEntryPtr->mDataPtr : 0;
+        int64_t theSkip = thePos - theCurPos;
+        int     theRem  = theSize;
+        while (theBufIt != inBuffer.end() && (0 < theSkip || 0 < theRem)) {
+            const int theAvail = theBufIt->BytesConsumable() - theBufPos;
+            if (0 < theSkip) {
+                const int theNSkip = (int)min(int64_t(theAvail), theSkip);
+                theSkip   -= theNSkip;
+                theBufPos += theNSkip;
+                theCurPos += theNSkip;
+            } else {
+                const int theNCopy = min(theAvail, theRem);
+                if (theDstPtr) {
+                    memcpy(theDstPtr, theBufIt->Consumer() + theBufPos,
+                        (size_t)theNCopy);
+                    theDstPtr += theNCopy;
+                }
+                theRem    -= theNCopy;
+                theBufPos += theNCopy;
+                theCurPos += theNCopy;
+            }
+            if (theBufIt->BytesConsumable() <= theBufPos) {
+                ++theBufIt;
+                theBufPos = 0;
+            }
+        }
+        if (! theEntryPtr) {
+            continue;
+        }
+        QCRTASSERT(theRem == 0);
+        mEntries.insert(make_pair(theKey, theEntryPtr));
+        mStats.mSize += theSize + kEntryOverhead;
+        mStats.mBlockCount++;
+        mStats.mInsertCount++;
+        Touch(*theEntryPtr);
+    }
+    Evict();
+}
+
+void
+BlockCache::Invalidate(
+    kfsFileId_t inFileId)
+{
+    QCStMutexLocker theLock(mMutex);
+    Entries::iterator theIt = mEntries.lower_bound(Key(inFileId,
+        numeric_limits<kfsChunkId_t>::min(),
+        numeric_limits<int64_t>::min(),
+        numeric_limits<int64_t>::min()));
+    while (theIt != mEntries.end() && theIt->first.mFileId == inFileId) {
+        Erase(theIt++);
+        mStats.mInvalidateCount++;
+    }
+}
+
+void
+BlockCache::Invalidate(
+    kfsFileId_t  inFileId,
+    kfsChunkId_t inChunkId,
+    int64_t      inChunkVersion)
+{
+    QCStMutexLocker theLock(mMutex);
+    Entries::iterator theIt = mEntries.lower_bound(Key(inFileId, inChunkId,
+        numeric_limits<int64_t>::min(),
+        numeric_limits<int64_t>::min()));
+    while (theIt != mEntries.end() &&
+            theIt->first.mFileId == inFileId &&
+            theIt->first.mChunkId == inChunkId) {
+        if (theIt->first.mChunkVersion == inChunkVersion) {
+            ++theIt;
+        } else {
+            Erase(theIt++);
+            mStats.mInvalidateCount++;
+        }
+    }
+}
+
+void
+BlockCache::GetStats(
+    BlockCache::Stats& outStats)
+{
+    QCStMutexLocker theLock(mMutex);
+    outStats = mStats;
+}
+
+void
+BlockCache::Touch(
+    BlockCache::Entry& inEntry)
+{
+    const uint64_t theSeq = ++mAccessSeq;
+    if (0 < inEntry.mPrevAccess) {
+        mHistory.erase(inEntry.mPrevAccess);
+    } else if (0 < inEntry.mLastAccess) {
+        Lru::Remove(mLruPtr, inEntry);
+    }
+    inEntry.mPrevAccess = inEntry.mLastAccess;
+    inEntry.mLastAccess = theSeq;
+    if (0 < inEntry.mPrevAccess) {
+        mHistory.insert(make_pair(inEntry.mPrevAccess, &inEntry));
+    } else {
+        Lru::PushBack(mLruPtr, inEntry);
+    }
+}
+
+void
+BlockCache::Erase(
+    BlockCache::Entries::iterator inIt)
+{
+    Entry* const theEntryPtr = inIt->second;
+    if (0 < theEntryPtr->mPrevAccess) {
+        mHistory.erase(theEntryPtr->mPrevAccess);
+    } else {
+        Lru::Remove(mLruPtr, *theEntryPtr);
+    }
+    mStats.mSize -= theEntryPtr->mSize + kEntryOverhead;
+    mStats.mBlockCount--;
+    mEntries.erase(inIt);
+    delete theEntryPtr;
+}
+
+void
+BlockCache::Evict()
+{
+    QCASSERT(mMutex.IsOwned());
+    while (mMaxSize < mStats.mSize) {
+        Entry* theEntryPtr = Lru::Front(mLruPtr);
+        if (! theEntryPtr) {
+            if (mHistory.empty()) {
+                break;
+            }
+            theEntryPtr = mHistory.begin()->second;
+        }
+        Erase(mEntries.find(theEntryPtr->mKey));
+        mStats.mEvictCount++;
+    }
+}
+
+}} /* namespace client KFS */
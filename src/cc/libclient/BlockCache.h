@@ -0,0 +1,184 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Client side chunk block cache, shared by all readers of all protocol worker
+// threads. The blocks are keyed by file id, chunk id, chunk version, and
+// checksum block aligned chunk offset. The readers use the cache at the chunk
+// level, therefore striped files are cached by stripe chunk, and the entries
+// of a chunk become unreachable once the chunk version changes.
+// The eviction policy is LRU-2: the blocks that were accessed only once are
+// evicted first, in least recently used order, then the blocks with the
+// oldest second to last access.
+//
+//----------------------------------------------------------------------------
+
+#ifndef KFS_LIBCLIENT_BLOCKCACHE_H
+#define KFS_LIBCLIENT_BLOCKCACHE_H
+
+#include "common/kfstypes.h"
+#include "kfsio/checksum.h"
+#include "qcdio/QCMutex.h"
+#include "qcdio/QCDLList.h"
+
+#include <map>
+
+namespace KFS
+{
+class IOBuffer;
+
+namespace client
+{
+using std::map;
+
+class BlockCache
+{
+public:
+    struct Stats
+    {
+        typedef int64_t Counter;
+        Stats()
+            : mHitCount(0),
+              mMissCount(0),
+              mHitByteCount(0),
+              mInsertCount(0),
+              mEvictCount(0),
+              mInvalidateCount(0),
+              mSize(0),
+              mBlockCount(0)
+            {}
+        template<typename T>
+        void Enumerate(
+            T& inFunctor) const
+        {
+            inFunctor("Hits",        mHitCount);
+            inFunctor("Misses",      mMissCount);
+            inFunctor("HitBytes",    mHitByteCount);
+            inFunctor("Inserts",     mInsertCount);
+            inFunctor("Evictions",   mEvictCount);
+            inFunctor("Invalidated", mInvalidateCount);
+            inFunctor("Size",        mSize);
+            inFunctor("Blocks",      mBlockCount);
+        }
+        Counter mHitCount;
+        Counter mMissCount;
+        Counter mHitByteCount;
+        Counter mInsertCount;
+        Counter mEvictCount;
+        Counter mInvalidateCount;
+        Counter mSize;
+        Counter mBlockCount;
+    };
+    BlockCache(
+        int64_t inMaxSize,
+        int     inBlockSize = (int)CHECKSUM_BLOCKSIZE);
+    ~BlockCache();
+    // Appends [inOffset, inOffset + inSize) of the chunk to outBuffer, only if
+    // all blocks that the range covers are in the cache. The chunk size is
+    // used to validate the length of the chunk's last block.
+    bool Get(
+        kfsFileId_t  inFileId,
+        kfsChunkId_t inChunkId,
+        int64_t      inChunkVersion,
+        int64_t      inOffset,
+        int          inSize,
+        int64_t      inChunkSize,
+        IOBuffer&    outBuffer);
+    // Inserts the blocks that inBuffer fully covers, starting from chunk
+    // position inOffset. The chunk's last block is inserted if it is shorter
+    // than the block size, and the buffer ends at the end of the chunk.
+    void Put(
+        kfsFileId_t     inFileId,
+        kfsChunkId_t    inChunkId,
+        int64_t         inChunkVersion,
+        int64_t         inOffset,
+        const IOBuffer& inBuffer,
+        int64_t         inChunkSize);
+    // Removes all blocks of the file.
+    void Invalidate(
+        kfsFileId_t inFileId);
+    // Removes the blocks of the chunk with version other than the one given.
+    void Invalidate(
+        kfsFileId_t  inFileId,
+        kfsChunkId_t inChunkId,
+        int64_t      inChunkVersion);
+    void GetStats(
+        Stats& outStats);
+    int64_t GetMaxSize() const
+        { return mMaxSize; }
+private:
+    class Key
+    {
+    public:
+        Key(
+            kfsFileId_t  inFileId       = -1,
+            kfsChunkId_t inChunkId      = -1,
+            int64_t      inChunkVersion = -1,
+            int64_t      inOffset       = -1)
+            : mFileId(inFileId),
+              mChunkId(inChunkId),
+              mChunkVersion(inChunkVersion),
+              mOffset(inOffset)
+            {}
+        bool operator<(
+            const Key& inRhs) const
+        {
+            return (
+                mFileId < inRhs.mFileId || (mFileId == inRhs.mFileId && (
+                mChunkId < inRhs.mChunkId || (mChunkId == inRhs.mChunkId && (
+                mChunkVersion < inRhs.mChunkVersion ||
+                (mChunkVersion == inRhs.mChunkVersion &&
+                mOffset < inRhs.mOffset)))))
+            );
+        }
+        kfsFileId_t  mFileId;
+        kfsChunkId_t mChunkId;
+        int64_t      mChunkVersion;
+        int64_t      mOffset;
+    };
+    class Entry;
+    typedef map<Key, Entry*>      Entries;
+    typedef map<uint64_t, Entry*> History;
+    typedef QCDLList<Entry, 0>    Lru;
+
+    const int64_t mMaxSize;
+    const int     mBlockSize;
+    QCMutex       mMutex;
+    Entries       mEntries;
+    History       mHistory;
+    uint64_t      mAccessSeq;
+    Stats         mStats;
+    Entry*        mLruPtr[1];
+
+    void Touch(
+        Entry& inEntry);
+    void Erase(
+        Entries::iterator inIt);
+    void Evict();
+private:
+    BlockCache(
+        const BlockCache& inCache);
+    BlockCache& operator=(
+        const BlockCache& inCache);
+};
+
+}} /* namespace client KFS */
+
+#endif /* KFS_LIBCLIENT_BLOCKCACHE_H */
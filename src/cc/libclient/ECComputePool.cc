@@ -0,0 +1,292 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Erasure code compute thread pool.
+//
+//----------------------------------------------------------------------------
+
+#include "ECComputePool.h"
+
+#include "common/kfstypes.h"
+#include "common/MsgLogger.h"
+#include "qcdio/qcstutils.h"
+#include "qcdio/qcdebug.h"
+
+#include <algorithm>
+#include <cerrno>
+
+namespace KFS
+{
+namespace client
+{
+using std::max;
+using std::min;
+using std::find;
+
+class ECComputePool::Job
+{
+public:
+    Job(
+        ECMethod::Encoder* inEncoderPtr,
+        ECMethod::Decoder* inDecoderPtr,
+        int                inStripeCount,
+        int                inRecoveryStripeCount,
+        int                inLength,
+        int                inPieceSize,
+        void**             inBuffersPtr,
+        int const*         inMissingStripesIdxPtr)
+        : mEncoderPtr(inEncoderPtr),
+          mDecoderPtr(inDecoderPtr),
+          mStripeCount(inStripeCount),
+          mRecoveryStripeCount(inRecoveryStripeCount),
+          mLength(inLength),
+          mPieceSize(inPieceSize),
+          mPieceCount((inLength + inPieceSize - 1) / inPieceSize),
+          mBuffersPtr(inBuffersPtr),
+          mMissingStripesIdxPtr(inMissingStripesIdxPtr),
+          mNextPiece(0),
+          mPendingCount(mPieceCount),
+          mStatus(0),
+          mDoneCond()
+        {}
+    // Returns false if the piece index is past the end.
+    bool Run(
+        int  inPieceIdx,
+        int& outStatus) const
+    {
+        if (mPieceCount <= inPieceIdx) {
+            return false;
+        }
+        const int theOffset = inPieceIdx * mPieceSize;
+        const int theLength = min(mPieceSize, mLength - theOffset);
+        const int theCount  = mStripeCount + mRecoveryStripeCount;
+        void*     theBufs[KFS_MAX_DATA_STRIPE_COUNT +
+            KFS_MAX_RECOVERY_STRIPE_COUNT];
+        for (int i = 0; i < theCount; i++) {
+            theBufs[i] = static_cast<char*>(mBuffersPtr[i]) + theOffset;
+        }
+        outStatus = mEncoderPtr ?
+            mEncoderPtr->Encode(
+                mStripeCount, mRecoveryStripeCount, theLength, theBufs) :
+            mDecoderPtr->Decode(
+                mStripeCount, mRecoveryStripeCount, theLength, theBufs,
+                mMissingStripesIdxPtr);
+        return true;
+    }
+
+    ECMethod::Encoder* const mEncoderPtr;
+    ECMethod::Decoder* const mDecoderPtr;
+    const int                mStripeCount;
+    const int                mRecoveryStripeCount;
+    const int                mLength;
+    const int                mPieceSize;
+    const int                mPieceCount;
+    void** const             mBuffersPtr;
+    int const* const         mMissingStripesIdxPtr;
+    int                      mNextPiece;
+    int                      mPendingCount;
+    int                      mStatus;
+    QCCondVar                mDoneCond;
+private:
+    Job(
+        const Job& inJob);
+    Job& operator=(
+        const Job& inJob);
+};
+
+ECComputePool::ECComputePool(
+    int inThreadCount,
+    int inMinPieceSize,
+    int inAlign)
+    : QCRunnable(),
+      mThreadCount(max(0, inThreadCount)),
+      mMinPieceSize(max(1, inMinPieceSize)),
+      mAlign(max(1, inAlign)),
+      mThreadsPtr(0),
+      mMutex(),
+      mWorkCond(),
+      mJobs(),
+      mStopFlag(false)
+{}
+
+ECComputePool::~ECComputePool()
+{
+    ECComputePool::Stop();
+}
+
+int
+ECComputePool::Start()
+{
+    if (mThreadsPtr || mThreadCount <= 0) {
+        return 0;
+    }
+    mStopFlag   = false;
+    mThreadsPtr = new QCThread[mThreadCount];
+    const int kStackSize = 256 << 10;
+    for (int i = 0; i < mThreadCount; i++) {
+        const int theErr = mThreadsPtr[i].TryToStart(
+            this, kStackSize, "ECCompute");
+        if (theErr) {
+            KFS_LOG_STREAM_ERROR <<
+                "failed to start erasure code compute thread: " <<
+                QCThread::GetErrorMsg(theErr) <<
+            KFS_LOG_EOM;
+            Stop();
+            return (theErr > 0 ? -theErr : -EINVAL);
+        }
+    }
+    return 0;
+}
+
+void
+ECComputePool::Stop()
+{
+    if (! mThreadsPtr) {
+        return;
+    }
+    {
+        QCStMutexLocker theLock(mMutex);
+        mStopFlag = true;
+        mWorkCond.NotifyAll();
+    }
+    for (int i = 0; i < mThreadCount; i++) {
+        if (mThreadsPtr[i].IsStarted()) {
+            mThreadsPtr[i].Join();
+        }
+    }
+    delete [] mThreadsPtr;
+    mThreadsPtr = 0;
+}
+
+int
+ECComputePool::Encode(
+    ECMethod::Encoder& inEncoder,
+    int                inStripeCount,
+    int                inRecoveryStripeCount,
+    int                inLength,
+    void**             inBuffersPtr)
+{
+    const int thePieceSize = GetPieceSize(inLength);
+    if (inLength <= thePieceSize) {
+        return inEncoder.Encode(
+            inStripeCount, inRecoveryStripeCount, inLength, inBuffersPtr);
+    }
+    Job theJob(&inEncoder, 0, inStripeCount, inRecoveryStripeCount,
+        inLength, thePieceSize, inBuffersPtr, 0);
+    return Execute(theJob);
+}
+
+int
+ECComputePool::Decode(
+    ECMethod::Decoder& inDecoder,
+    int                inStripeCount,
+    int                inRecoveryStripeCount,
+    int                inLength,
+    void**             inBuffersPtr,
+    int const*         inMissingStripesIdxPtr)
+{
+    const int thePieceSize = GetPieceSize(inLength);
+    if (inLength <= thePieceSize) {
+        return inDecoder.Decode(inStripeCount, inRecoveryStripeCount,
+            inLength, inBuffersPtr, inMissingStripesIdxPtr);
+    }
+    Job theJob(0, &inDecoder, inStripeCount, inRecoveryStripeCount,
+        inLength, thePieceSize, inBuffersPtr, inMissingStripesIdxPtr);
+    return Execute(theJob);
+}
+
+int
+ECComputePool::GetPieceSize(
+    int inLength) const
+{
+    if (! mThreadsPtr || inLength <= mMinPieceSize) {
+        return inLength;
+    }
+    // One piece per thread, including the caller's thread.
+    const int theSize = (inLength + mThreadCount) / (mThreadCount + 1);
+    return ((max(theSize, mMinPieceSize) + mAlign - 1) / mAlign * mAlign);
+}
+
+int
+ECComputePool::Execute(
+    ECComputePool::Job& inJob)
+{
+    QCStMutexLocker theLock(mMutex);
+    mJobs.push_back(&inJob);
+    if (inJob.mPieceCount <= 2) {
+        mWorkCond.Notify();
+    } else {
+        mWorkCond.NotifyAll();
+    }
+    while (RunPiece(inJob))
+        {}
+    while (0 < inJob.mPendingCount) {
+        inJob.mDoneCond.Wait(mMutex);
+    }
+    return inJob.mStatus;
+}
+
+bool
+ECComputePool::RunPiece(
+    ECComputePool::Job& inJob)
+{
+    QCASSERT(mMutex.IsOwned());
+    const int theIdx = inJob.mNextPiece;
+    if (inJob.mPieceCount <= theIdx) {
+        return false;
+    }
+    if (++inJob.mNextPiece == inJob.mPieceCount) {
+        Jobs::iterator const theIt =
+            find(mJobs.begin(), mJobs.end(), &inJob);
+        if (theIt != mJobs.end()) {
+            mJobs.erase(theIt);
+        }
+    }
+    int theStatus = 0;
+    {
+        QCStMutexUnlocker theUnlock(mMutex);
+        inJob.Run(theIdx, theStatus);
+    }
+    if (theStatus < 0 && inJob.mStatus == 0) {
+        inJob.mStatus = theStatus;
+    }
+    if (--inJob.mPendingCount <= 0) {
+        inJob.mDoneCond.Notify();
+    }
+    return true;
+}
+
+void
+ECComputePool::Run()
+{
+    QCStMutexLocker theLock(mMutex);
+    for (; ;) {
+        while (! mStopFlag && mJobs.empty()) {
+            mWorkCond.Wait(mMutex);
+        }
+        if (mStopFlag) {
+            break;
+        }
+        RunPiece(*mJobs.front());
+    }
+}
+
+}} /* namespace client KFS */
@@ -0,0 +1,101 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Erasure code compute thread pool. The striper state machine runs in the
+// protocol worker thread, therefore the pool parallelizes a single encode or
+// decode call: the buffers are split into aligned pieces, which are processed
+// by the pool threads and by the calling thread, and the call returns once all
+// pieces are done. The encoders and decoders are stateless byte wise
+// transforms, thus processing of the pieces is independent.
+//
+//----------------------------------------------------------------------------
+
+#ifndef KFS_LIBCLIENT_ECCOMPUTEPOOL_H
+#define KFS_LIBCLIENT_ECCOMPUTEPOOL_H
+
+#include "ECMethod.h"
+
+#include "qcdio/QCThread.h"
+#include "qcdio/QCMutex.h"
+
+#include <deque>
+
+namespace KFS
+{
+namespace client
+{
+using std::deque;
+
+class ECComputePool : private QCRunnable
+{
+public:
+    ECComputePool(
+        int inThreadCount,
+        int inMinPieceSize = 64 << 10,
+        int inAlign        = 16);
+    virtual ~ECComputePool();
+    int Start();
+    void Stop();
+    int GetThreadCount() const
+        { return mThreadCount; }
+    int Encode(
+        ECMethod::Encoder& inEncoder,
+        int                inStripeCount,
+        int                inRecoveryStripeCount,
+        int                inLength,
+        void**             inBuffersPtr);
+    int Decode(
+        ECMethod::Decoder& inDecoder,
+        int                inStripeCount,
+        int                inRecoveryStripeCount,
+        int                inLength,
+        void**             inBuffersPtr,
+        int const*         inMissingStripesIdxPtr);
+private:
+    class Job;
+    typedef deque<Job*> Jobs;
+
+    const int  mThreadCount;
+    const int  mMinPieceSize;
+    const int  mAlign;
+    QCThread*  mThreadsPtr;
+    QCMutex    mMutex;
+    QCCondVar  mWorkCond;
+    Jobs       mJobs;
+    bool       mStopFlag;
+
+    virtual void Run();
+    int Execute(
+        Job& inJob);
+    int GetPieceSize(
+        int inLength) const;
+    bool RunPiece(
+        Job& inJob);
+private:
+    ECComputePool(
+        const ECComputePool& inPool);
+    ECComputePool& operator=(
+        const ECComputePool& inPool);
+};
+
+}} /* namespace client KFS */
+
+#endif /* KFS_LIBCLIENT_ECCOMPUTEPOOL_H */
@@ -0,0 +1,427 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Asynchronous positional read and write requests, and completion queue.
+// The requests are passed to the protocol worker as is, without going through
+// the file position, read ahead, and write behind logic, therefore any number
+// of requests can be in flight for the same file.
+//
+//----------------------------------------------------------------------------
+
+#include "KfsClientInt.h"
+#include "KfsProtocolWorker.h"
+#include "common/MsgLogger.h"
+#include "common/time.h"
+#include "qcdio/qcstutils.h"
+#include "qcdio/qcdebug.h"
+#include "qcdio/QCUtils.h"
+
+#include <cerrno>
+#include <deque>
+#include <limits>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace KFS
+{
+using std::deque;
+using std::min;
+using std::numeric_limits;
+
+class KfsClient::AsyncIoQueue::Impl
+{
+public:
+    Impl()
+        : mMutex(),
+          mCond(),
+          mQueue()
+    {
+        mPipe[0] = -1;
+        mPipe[1] = -1;
+        if (pipe(mPipe) == 0) {
+            for (int i = 0; i < 2; i++) {
+                fcntl(mPipe[i], F_SETFL, O_NONBLOCK);
+                fcntl(mPipe[i], F_SETFD, FD_CLOEXEC);
+            }
+        } else {
+            KFS_LOG_STREAM_ERROR <<
+                "async io queue: pipe: " << QCUtils::SysError(errno) <<
+            KFS_LOG_EOM;
+            mPipe[0] = -1;
+            mPipe[1] = -1;
+        }
+    }
+    ~Impl()
+    {
+        for (int i = 0; i < 2; i++) {
+            if (0 <= mPipe[i]) {
+                close(mPipe[i]);
+            }
+        }
+    }
+    void Done(
+        KfsClient::AsyncIo& inIo)
+    {
+        QCStMutexLocker theLock(mMutex);
+        const bool theWasEmptyFlag = mQueue.empty();
+        mQueue.push_back(&inIo);
+        if (theWasEmptyFlag) {
+            if (0 <= mPipe[1]) {
+                const char theByte = 0;
+                while (write(mPipe[1], &theByte, 1) < 0 && errno == EINTR)
+                    {}
+            }
+            mCond.Notify();
+        }
+    }
+    int GetFd() const
+        { return mPipe[0]; }
+    int Get(
+        KfsClient::AsyncIo** inIosPtr,
+        int                  inMaxCount,
+        int                  inTimeoutMs)
+    {
+        if (! inIosPtr || inMaxCount <= 0) {
+            return 0;
+        }
+        QCStMutexLocker theLock(mMutex);
+        if (mQueue.empty() && inTimeoutMs != 0) {
+            const int64_t theEnd = inTimeoutMs < 0 ? int64_t(-1) :
+                microseconds() + int64_t(inTimeoutMs) * 1000;
+            while (mQueue.empty()) {
+                if (theEnd < 0) {
+                    mCond.Wait(mMutex);
+                    continue;
+                }
+                const int64_t theWait = theEnd - microseconds();
+                if (theWait <= 0) {
+                    break;
+                }
+                mCond.Wait(mMutex, QCMutex::Time(theWait) * 1000);
+            }
+        }
+        int theCount = 0;
+        while (theCount < inMaxCount && ! mQueue.empty()) {
+            inIosPtr[theCount++] = mQueue.front();
+            mQueue.pop_front();
+        }
+        if (0 < theCount) {
+            if (mQueue.empty()) {
+                DrainPipe();
+            } else {
+                // Let the next waiter proceed.
+                mCond.Notify();
+            }
+        }
+        return theCount;
+    }
+private:
+    typedef deque<KfsClient::AsyncIo*> Queue;
+
+    QCMutex   mMutex;
+    QCCondVar mCond;
+    Queue     mQueue;
+    int       mPipe[2];
+
+    void DrainPipe()
+    {
+        if (mPipe[0] < 0) {
+            return;
+        }
+        char theBuf[64];
+        for (; ;) {
+            const ssize_t theNRd = read(mPipe[0], theBuf, sizeof(theBuf));
+            if (theNRd < 0 && errno == EINTR) {
+                continue;
+            }
+            if (theNRd <= 0) {
+                break;
+            }
+        }
+    }
+private:
+    Impl(
+        const Impl& inImpl);
+    Impl& operator=(
+        const Impl& inImpl);
+};
+
+KfsClient::AsyncIoQueue::AsyncIoQueue()
+    : AsyncIoCompletion(),
+      mImpl(*(new Impl()))
+{}
+
+KfsClient::AsyncIoQueue::~AsyncIoQueue()
+{
+    delete &mImpl;
+}
+
+void
+KfsClient::AsyncIoQueue::Done(
+    KfsClient::AsyncIo& io)
+{
+    mImpl.Done(io);
+}
+
+int
+KfsClient::AsyncIoQueue::GetFd() const
+{
+    return mImpl.GetFd();
+}
+
+int
+KfsClient::AsyncIoQueue::Get(
+    KfsClient::AsyncIo** ios,
+    int                  maxCount,
+    int                  timeoutMs)
+{
+    return mImpl.Get(ios, maxCount, timeoutMs);
+}
+
+namespace client
+{
+
+// Protocol worker request with completion callback. The request deletes itself
+// on completion.
+class AsyncIoRequest : public KfsProtocolWorker::Request
+{
+public:
+    typedef KfsProtocolWorker::Request::Params Params;
+
+    AsyncIoRequest(
+        KfsClient::AsyncIo&           inIo,
+        KfsClient::AsyncIoCompletion& inCompletion,
+        AsyncWriteEnd*                inWriteEndPtr = 0)
+        : Request(),
+          mOpenParams(),
+          mIo(inIo),
+          mCompletion(inCompletion),
+          mWriteEndPtr(inWriteEndPtr)
+    {
+        if (mWriteEndPtr) {
+            mWriteEndPtr->Ref();
+        }
+    }
+    Params& GetOpenParams()
+        { return mOpenParams; }
+    virtual void Done(
+        int64_t inStatus)
+    {
+        KfsClient::AsyncIo&           theIo         = mIo;
+        KfsClient::AsyncIoCompletion& theCompletion = mCompletion;
+        // The write request completion status is 0 on success, as the request
+        // completes when the writer releases the buffer. Report the request
+        // size instead, the same as the read reports the bytes read.
+        theIo.status = inStatus < 0 ? (ssize_t)inStatus :
+            (theIo.type == KfsClient::AsyncIo::kTypeWrite ?
+                (ssize_t)GetSize() : (ssize_t)inStatus);
+        if (mWriteEndPtr && 0 <= inStatus) {
+            mWriteEndPtr->Update(theIo.pos + (chunkOff_t)GetSize());
+        }
+        delete this;
+        theCompletion.Done(theIo);
+    }
+private:
+    Params                        mOpenParams;
+    KfsClient::AsyncIo&           mIo;
+    KfsClient::AsyncIoCompletion& mCompletion;
+    AsyncWriteEnd* const          mWriteEndPtr;
+
+    virtual ~AsyncIoRequest()
+    {
+        if (mWriteEndPtr) {
+            mWriteEndPtr->Unref();
+        }
+    }
+private:
+    AsyncIoRequest(
+        const AsyncIoRequest& inReq);
+    AsyncIoRequest& operator=(
+        const AsyncIoRequest& inReq);
+};
+
+int
+KfsClientImpl::AsyncIoSubmit(
+    KfsClient::AsyncIo* const*    ios,
+    int                           count,
+    KfsClient::AsyncIoCompletion& completion)
+{
+    if (! IsInitialized()) {
+        return -ENOTCONN;
+    }
+    if (count <= 0) {
+        return 0;
+    }
+    if (! ios) {
+        return -EINVAL;
+    }
+    for (int i = 0; i < count; i++) {
+        KfsClient::AsyncIo& io = *ios[i];
+        io.status = 0;
+        const int status = io.type == KfsClient::AsyncIo::kTypeRead ?
+            AsyncRead(io, completion) : (
+            io.type == KfsClient::AsyncIo::kTypeWrite ?
+            AsyncWrite(io, completion) : -EINVAL);
+        if (status < 0) {
+            io.status = status;
+            completion.Done(io);
+        }
+    }
+    return count;
+}
+
+int
+KfsClientImpl::AsyncRead(
+    KfsClient::AsyncIo&           io,
+    KfsClient::AsyncIoCompletion& completion)
+{
+    if (! io.buf || io.pos < 0) {
+        return -EINVAL;
+    }
+    if ((size_t)numeric_limits<int>::max() < io.size) {
+        return -EFBIG;
+    }
+    QCMutex* const  fdMutex = GetFdMutex(io.fd);
+    QCStMutexLocker lock(fdMutex);
+
+    FileTableEntry* const entryPtr = GetFdEntry(io.fd);
+    if (! entryPtr) {
+        return -EBADF;
+    }
+    FileTableEntry& entry = *entryPtr;
+    if (entry.openMode == O_WRONLY || entry.cachedAttrFlag) {
+        return -EINVAL;
+    }
+    if (entry.fattr.isDirectory) {
+        return -EISDIR;
+    }
+    entry.UpdateAsyncWriteFileSize();
+    const int64_t eof = entry.eofMark < 0 ?
+        entry.fattr.fileSize : min(entry.eofMark, entry.fattr.fileSize);
+    const int size = (int)min(int64_t(io.size), eof - io.pos);
+    if (size <= 0) {
+        lock.Unlock();
+        io.status = 0;
+        completion.Done(io);
+        return 0;
+    }
+    EnsureProtocolWorker();
+    AsyncIoRequest& req = *(new AsyncIoRequest(io, completion));
+    req.Reset(
+        KfsProtocolWorker::kRequestTypeReadAsync,
+        entry.instance + 1, // reader's instance always +1
+        entry.fattr.fileId,
+        &req.GetOpenParams(),
+        io.buf,
+        size,
+        0, // inMaxPending,
+        io.pos
+    );
+    AsyncIoRequest::Params& openParams = req.GetOpenParams();
+    openParams.mPathName            = entry.pathname;
+    openParams.mFileSize            = entry.fattr.fileSize;
+    openParams.mStriperType         = entry.fattr.striperType;
+    openParams.mStripeSize          = entry.fattr.stripeSize;
+    openParams.mStripeCount         = entry.fattr.numStripes;
+    openParams.mRecoveryStripeCount = entry.fattr.numRecoveryStripes;
+    openParams.mReplicaCount        = entry.fattr.numReplicas;
+    openParams.mSkipHolesFlag       = entry.skipHoles;
+    openParams.mFailShortReadsFlag  = entry.failShortReadsFlag;
+    openParams.mMsgLogId            = io.fd;
+    entry.readUsedProtocolWorkerFlag = true;
+    lock.Unlock();
+
+    mProtocolWorker->Enqueue(req);
+    return 0;
+}
+
+int
+KfsClientImpl::AsyncWrite(
+    KfsClient::AsyncIo&           io,
+    KfsClient::AsyncIoCompletion& completion)
+{
+    if (! io.buf || io.pos < 0) {
+        return -EINVAL;
+    }
+    if ((size_t)numeric_limits<int>::max() < io.size) {
+        return -EFBIG;
+    }
+    if (io.pos + (chunkOff_t)io.size < 0) {
+        return -EFBIG;
+    }
+    QCMutex* const  fdMutex = GetFdMutex(io.fd);
+    QCStMutexLocker lock(fdMutex);
+
+    FileTableEntry* const entryPtr = GetFdEntry(io.fd);
+    if (! entryPtr) {
+        return -EBADF;
+    }
+    FileTableEntry& entry = *entryPtr;
+    if (entry.openMode == O_RDONLY || (entry.openMode & O_APPEND) != 0) {
+        return -EINVAL;
+    }
+    if (entry.fattr.fileId <= 0) {
+        return -EBADF;
+    }
+    if (entry.fattr.isDirectory) {
+        return -EISDIR;
+    }
+    if (! entry.usedProtocolWorkerFlag &&
+            0 == entry.fattr.numReplicas && 0 != entry.fattr.fileSize) {
+        // Overwrite and append are not supported with object store files.
+        return -ESPIPE;
+    }
+    if (io.size <= 0) {
+        lock.Unlock();
+        io.status = 0;
+        completion.Done(io);
+        return 0;
+    }
+    EnsureProtocolWorker();
+    if (! entry.asyncWriteEnd) {
+        entry.asyncWriteEnd = new AsyncWriteEnd();
+    }
+    AsyncIoRequest& req = *(new AsyncIoRequest(
+        io, completion, entry.asyncWriteEnd));
+    if (! entry.usedProtocolWorkerFlag) {
+        InitWriteOpenParams(io.fd, entry, req.GetOpenParams());
+    }
+    req.Reset(
+        KfsProtocolWorker::kRequestTypeWriteAsyncNoCopy,
+        entry.instance,
+        entry.fattr.fileId,
+        entry.usedProtocolWorkerFlag ? 0 : &req.GetOpenParams(),
+        io.buf,
+        (int)io.size,
+        entry.ioBufferSize >= 0 ? entry.ioBufferSize : -1,
+        io.pos
+    );
+    entry.usedProtocolWorkerFlag = true;
+    // Make Sync() and Close() flush the writes and report errors.
+    entry.pending += io.size;
+    mProtocolWorker->InvalidateBlockCache(entry.fattr.fileId);
+    lock.Unlock();
+
+    mProtocolWorker->Enqueue(req);
+    return 0;
+}
+
+}} /* namespace client KFS */
@@ -706,6 +706,19 @@ KfsClient::PWrite(int fd, chunkOff_t pos, const char *buf, size_t numBytes)
     return mImpl->Write(fd, buf, numBytes, &cpos);
 }
 
+ssize_t
+KfsClient::PReadV(int fd, KfsClient::ReadRange* ranges, int count)
+{
+    return mImpl->ReadV(fd, ranges, count);
+}
+
+int
+KfsClient::AsyncIoSubmit(KfsClient::AsyncIo* const* ios, int count,
+    KfsClient::AsyncIoCompletion& completion)
+{
+    return mImpl->AsyncIoSubmit(ios, count, completion);
+}
+
 ssize_t
 KfsClient::Read(int fd, char *buf, size_t numBytes)
 {
@@ -1476,6 +1489,7 @@ KfsClientImpl::Validate(
     if (fa && (
             ! FAttrLru::IsInList(mFAttrLru, *fa) ||
             fa != fa->fidNameIt->second ||
+            fa != fa->fidIt->second ||
             (fa->nameIt != mPathCacheNone && fa != fa->nameIt->second))) {
         KFS_LOG_STREAM_FATAL << "invalid FAttr:" <<
             " "               << (const void*)fa <<
@@ -1519,6 +1533,7 @@ KfsClientImpl::KfsClientImpl(
       mCwd("/"),
       mFileTable(),
       mFidNameToFAttrMap(),
+      mFidToFAttrMap(),
       mPathCache(),
       mPathCacheNone(mPathCache.insert(
         make_pair(string(), static_cast<KfsClientImpl::FAttr*>(0))).first),
@@ -1576,6 +1591,13 @@ KfsClientImpl::KfsClientImpl(
       mAuthCtx(),
       mProtocolWorkerAuthCtx(),
       mTargetDiskIoSize(1 << 20),
+      mReadVCoalesceGap((int)CHECKSUM_BLOCKSIZE),
+      mReadVMaxCoalesceSize(4 << 20),
+      mReadAheadMaxSize(0),
+      mReadAheadCounters(),
+      mMetaCacheLeaseFlag(false),
+      mMetaCacheSeq(-1),
+      mMetaCacheLeaseSec(0),
       mConfig(),
       mMetaServer(metaServer),
       mCommonRpcHdrs(),
@@ -1721,6 +1743,17 @@ int KfsClientImpl::Init(const string& metaServerHost, int metaServerPort,
                 (int)CHECKSUM_BLOCKSIZE - 1) / (int)CHECKSUM_BLOCKSIZE *
                 (int)CHECKSUM_BLOCKSIZE;
         }
+        mReadVCoalesceGap = max(0, properties->getValue(
+            "client.readVCoalesceGap", mReadVCoalesceGap));
+        mReadVMaxCoalesceSize = max((int)CHECKSUM_BLOCKSIZE,
+            properties->getValue(
+                "client.readVMaxCoalesceSize", mReadVMaxCoalesceSize));
+        mReadAheadMaxSize = max(0, properties->getValue(
+            "client.adaptiveReadAheadMaxSize", mReadAheadMaxSize));
+        mReadAheadMaxSize = mReadAheadMaxSize / (int)CHECKSUM_BLOCKSIZE *
+            (int)CHECKSUM_BLOCKSIZE;
+        mMetaCacheLeaseFlag = properties->getValue(
+            "client.metaCacheLease", mMetaCacheLeaseFlag ? 1 : 0) != 0;
         const int defaultIoBufferSize = properties->getValue(
             "client.defaultIoBufferSize", -1);
         if ((int)CHECKSUM_BLOCKSIZE <= defaultIoBufferSize) {
@@ -1765,6 +1798,7 @@ int KfsClientImpl::Init(const string& metaServerHost, int metaServerPort,
             properties->getValue("client.resolverCacheExpiration",
                 mNetManager.GetResolverCacheExpiration())
         );
+        Resolver::SetParameters("client.resolver", *properties);
         properties->copyWithPrefix("client.", mConfig);
         string nodeId = properties->getValue("client.nodeId", mNodeId);
         const char* const kFilePrefix    = "FILE:";
@@ -2295,6 +2329,77 @@ KfsClientImpl::InvalidateAllCachedAttrs()
     mFAttrCacheGeneration++;
 }
 
+void
+KfsClientImpl::InvalidateCachedAttrs(const string& fids, bool hexFlag)
+{
+    vector<kfsFileId_t> ids;
+    const char*         ptr = fids.c_str();
+    for (; ;) {
+        char*           end = 0;
+        const long long id  = strtoll(ptr, &end, hexFlag ? 16 : 10);
+        if (end == ptr) {
+            break;
+        }
+        ids.push_back((kfsFileId_t)id);
+        ptr = end;
+        if (*ptr != ',') {
+            break;
+        }
+        ptr++;
+    }
+    // Mark the entries stale instead of deleting, as the caller might hold
+    // attribute pointers. The stale entries are purged by the cache
+    // validation scan the same way as after invalidating all attributes.
+    // The id can be either the directory id, in which case the directory
+    // entries must be invalidated, or the file or directory attribute id.
+    const unsigned int staleGeneration = mFAttrCacheGeneration - 1;
+    for (vector<kfsFileId_t>::const_iterator id = ids.begin();
+            id != ids.end();
+            ++id) {
+        for (FidNameToFAttrMap::const_iterator it =
+                    mFidNameToFAttrMap.lower_bound(make_pair(*id, string()));
+                it != mFidNameToFAttrMap.end() && it->first.first == *id;
+                ++it) {
+            MarkStale(*it->second, staleGeneration);
+        }
+        pair<FidToFAttrMap::const_iterator, FidToFAttrMap::const_iterator>
+            const range = mFidToFAttrMap.equal_range(*id);
+        for (FidToFAttrMap::const_iterator it = range.first;
+                it != range.second;
+                ++it) {
+            MarkStale(*it->second, staleGeneration);
+        }
+    }
+}
+
+void
+KfsClientImpl::SetFAttr(KfsClientImpl::FAttr& fa, const FileAttr& fattr)
+{
+    if (fa.fileId != fattr.fileId) {
+        mFidToFAttrMap.erase(fa.fidIt);
+        fa.fidIt = mFidToFAttrMap.insert(make_pair(fattr.fileId, &fa));
+    }
+    fa = fattr;
+}
+
+void
+KfsClientImpl::UpdateMetaCache(const KfsOp& op, const MetaCacheSync& sync)
+{
+    if (sync.seq < 0) {
+        // Meta server does not support, or has not enabled the leases.
+        mMetaCacheSeq      = -1;
+        mMetaCacheLeaseSec = 0;
+        return;
+    }
+    if (sync.invalidateAllFlag) {
+        InvalidateAllCachedAttrs();
+    } else if (! sync.invalidate.empty()) {
+        InvalidateCachedAttrs(sync.invalidate, op.shortRpcFormatFlag);
+    }
+    mMetaCacheSeq      = sync.seq;
+    mMetaCacheLeaseSec = max(0, sync.leaseSec);
+}
+
 int
 KfsClientImpl::RmdirsSelf(
     const string&                path,
@@ -3340,6 +3445,7 @@ KfsClientImpl::Lstat(const char *pathname, KfsFileAttr& kfsattr, bool computeFil
 int
 KfsClientImpl::Stat(int fd, KfsFileAttr& kfsattr)
 {
+    QCStMutexLocker fdLock(GetFdMutex(fd));
     QCStMutexLocker l(mMutex);
 
     if (! valid_fd(fd)) {
@@ -3809,7 +3915,7 @@ KfsClientImpl::UpdateFattr(
     fa->validatedTime      = now;
     fa->generation         = mFAttrCacheGeneration;
     fa->staleSubCountsFlag = false;
-    *fa                    = fattr;
+    SetFAttr(*fa, fattr);
     return 0;
 }
 
@@ -3963,7 +4069,7 @@ KfsClientImpl::OpenDirectory(const char *pathname)
     entry.dirEntries = new vector<KfsFileAttr>();
     const int res = ReaddirPlus(path, entry.fattr.fileId, *entry.dirEntries);
     if (res < 0) {
-        Close(fd);
+        ReleaseFileTableEntry(fd);
         return res;
     }
     return fd;
@@ -4325,6 +4431,7 @@ KfsClientImpl::Close(int fd)
     bool                            writeCloseFlag;
     int                             status = 0;
     {
+        QCStMutexLocker fdLock(GetFdMutex(fd));
         QCStMutexLocker l(mMutex);
 
         if (! valid_fd(fd)) {
@@ -4363,6 +4470,9 @@ KfsClientImpl::Close(int fd)
         if (status == 0) {
             status = ret;
         }
+        // Drop the blocks that might have been cached while the writes were
+        // in flight.
+        mProtocolWorker->InvalidateBlockCache(fileId);
     }
     if (readCloseFlag) {
         const int ret = (int)mProtocolWorker->Execute(
@@ -4389,6 +4499,7 @@ KfsClientImpl::Close(int fd)
 void
 KfsClientImpl::SkipHolesInFile(int fd)
 {
+    QCStMutexLocker fdLock(GetFdMutex(fd));
     QCStMutexLocker l(mMutex);
 
     if (! valid_fd(fd)) {
@@ -4402,6 +4513,7 @@ KfsClientImpl::SkipHolesInFile(int fd)
 int
 KfsClientImpl::Sync(int fd)
 {
+    QCStMutexLocker fdLock(GetFdMutex(fd));
     QCStMutexLocker l(mMutex);
 
     if (! valid_fd(fd)) {
@@ -4420,9 +4532,11 @@ KfsClientImpl::Sync(int fd)
             " bufsz: "   << entry.ioBufferSize <<
         KFS_LOG_EOM;
         entry.pending = 0;
+        const bool appendFlag = (entry.openMode & O_APPEND) != 0;
         l.Unlock();
+        fdLock.Unlock();
         return (int)mProtocolWorker->Execute(
-            (entry.openMode & O_APPEND) != 0 ?
+            appendFlag ?
                 KfsProtocolWorker::kRequestTypeWriteAppend :
                 KfsProtocolWorker::kRequestTypeWrite,
             fileInstance,
@@ -4442,6 +4556,7 @@ KfsClientImpl::Truncate(int fd, chunkOff_t offset)
     if (syncRes < 0) {
         return syncRes;
     }
+    QCStMutexLocker fdLock(GetFdMutex(fd));
     QCStMutexLocker l(mMutex);
     return TruncateSelf(fd, offset);
 }
@@ -4464,6 +4579,9 @@ KfsClientImpl::Truncate(const char* pathname, chunkOff_t offset)
     op.checkPermsFlag = true;
     op.setEofHintFlag = attr.numStripes > 1;
     DoMetaOpWithRetry(&op);
+    if (mProtocolWorker) {
+        mProtocolWorker->InvalidateBlockCache(attr.fileId);
+    }
     if (op.status != 0) {
         return GetOpStatus(op);
     }
@@ -4486,11 +4604,17 @@ KfsClientImpl::TruncateSelf(int fd, chunkOff_t offset)
     FdInfo(fd)->buffer.Invalidate();
 
     FileAttr *fa = FdAttr(fd);
+    if (mProtocolWorker) {
+        mProtocolWorker->InvalidateBlockCache(fa->fileId);
+    }
     TruncateOp op(0, FdInfo(fd)->pathname.c_str(), fa->fileId, offset);
     op.setEofHintFlag = fa->numStripes > 1;
     DoMetaOpWithRetry(&op);
     if (op.status == 0) {
         fa->fileSize = offset;
+        if (FdInfo(fd)->asyncWriteEnd) {
+            FdInfo(fd)->asyncWriteEnd->Reset();
+        }
         if (fa->fileSize == 0) {
             fa->subCount1 = 0;
         }
@@ -4511,6 +4635,7 @@ KfsClientImpl::PruneFromHead(int fd, chunkOff_t offset)
         return syncRes;
     }
 
+    QCStMutexLocker fdLock(GetFdMutex(fd));
     QCStMutexLocker l(mMutex);
 
     if (! valid_fd(fd)) {
@@ -4561,6 +4686,7 @@ int
 KfsClientImpl::GetDataLocation(int fd, chunkOff_t start, chunkOff_t len,
         vector< vector <string> >& locations, chunkOff_t* outBlkSize)
 {
+    QCStMutexLocker fdLock(GetFdMutex(fd));
     QCStMutexLocker l(mMutex);
     return GetDataLocationSelf(fd, start, len, locations, outBlkSize);
 }
@@ -4889,19 +5015,40 @@ KfsClientImpl::StartProtocolWorker()
     params.mResolverCacheSize         = mNetManager.GetResolverCacheSize();
     params.mResolverCacheExpiration   = mNetManager.GetResolverCacheExpiration();
     params.mNodeId                    = mNodeId;
-    mProtocolWorker = new KfsProtocolWorker(
+    params.mReadReplicaSelectionFlag  = mConfig.getValue(
+        "client.readReplicaSelection",
+        params.mReadReplicaSelectionFlag ? 1 : 0) != 0;
+    params.mReadHedgeMinDelayMs       = mConfig.getValue(
+        "client.readHedgeMinDelayMs", params.mReadHedgeMinDelayMs);
+    params.mReadHedgeDevMultiplier    = mConfig.getValue(
+        "client.readHedgeDevMultiplier", params.mReadHedgeDevMultiplier);
+    params.mLocalReadFlag             = mConfig.getValue(
+        "client.localRead", params.mLocalReadFlag ? 1 : 0) != 0;
+    params.mWorkerThreadCount         = mConfig.getValue(
+        "client.protocolWorkerThreads", params.mWorkerThreadCount);
+    params.mECComputeThreadCount      = mConfig.getValue(
+        "client.ecComputeThreads", params.mECComputeThreadCount);
+    params.mBlockCacheSize            = mConfig.getValue(
+        "client.blockCacheSize", params.mBlockCacheSize);
+    params.mRSWriteBehindSize         = mConfig.getValue(
+        "client.rsWriteBehindSize", params.mRSWriteBehindSize);
+    // Configure and start the worker before publishing it, the lock free
+    // EnsureProtocolWorker() fast path might use it as soon as the pointer is
+    // set.
+    KfsProtocolWorker* const worker = new KfsProtocolWorker(
         mMetaServerLoc.hostname,
         mMetaServerLoc.port,
         &params
     );
-    mProtocolWorker->SetOpTimeoutSec(mDefaultOpTimeout);
-    mProtocolWorker->SetMetaOpTimeoutSec(mDefaultMetaOpTimeout);
-    mProtocolWorker->SetMaxRetryCount(mMaxNumRetriesPerOp);
-    mProtocolWorker->SetMetaMaxRetryCount(mMaxNumRetriesPerOp);
-    mProtocolWorker->SetTimeSecBetweenRetries(mRetryDelaySec);
-    mProtocolWorker->SetMetaTimeSecBetweenRetries(mRetryDelaySec);
-    mProtocolWorker->SetCommonRpcHeaders(mCommonRpcHdrs, mShortCommonRpcHdrs);
-    mProtocolWorker->Start();
+    worker->SetOpTimeoutSec(mDefaultOpTimeout);
+    worker->SetMetaOpTimeoutSec(mDefaultMetaOpTimeout);
+    worker->SetMaxRetryCount(mMaxNumRetriesPerOp);
+    worker->SetMetaMaxRetryCount(mMaxNumRetriesPerOp);
+    worker->SetTimeSecBetweenRetries(mRetryDelaySec);
+    worker->SetMetaTimeSecBetweenRetries(mRetryDelaySec);
+    worker->SetCommonRpcHeaders(mCommonRpcHdrs, mShortCommonRpcHdrs);
+    worker->Start();
+    SyncSet(mProtocolWorker, worker);
 }
 
 int
@@ -4914,6 +5061,7 @@ KfsClientImpl::GetMaxRetryPerOp() const
 void
 KfsClientImpl::SetEOFMark(int fd, chunkOff_t offset)
 {
+    QCStMutexLocker fdLock(GetFdMutex(fd));
     QCStMutexLocker l(mMutex);
 
     if (! valid_fd(fd) || FdAttr(fd)->isDirectory) {
@@ -4931,6 +5079,7 @@ KfsClientImpl::Seek(int fd, chunkOff_t offset)
 chunkOff_t
 KfsClientImpl::Seek(int fd, chunkOff_t offset, int whence)
 {
+    QCStMutexLocker fdLock(GetFdMutex(fd));
     QCStMutexLocker l(mMutex);
 
     if (! valid_fd(fd)) {
@@ -4950,6 +5099,7 @@ KfsClientImpl::Seek(int fd, chunkOff_t offset, int whence)
         newOff = entry.currPos.fileOffset + offset;
         break;
     case SEEK_END:
+        entry.UpdateAsyncWriteFileSize();
         newOff = entry.fattr.fileSize + offset;
         break;
     default:
@@ -4967,6 +5117,7 @@ KfsClientImpl::Seek(int fd, chunkOff_t offset, int whence)
 chunkOff_t
 KfsClientImpl::Tell(int fd)
 {
+    QCStMutexLocker fdLock(GetFdMutex(fd));
     QCStMutexLocker l(mMutex);
 
     if (! valid_fd(fd)) {
@@ -5044,6 +5195,7 @@ KfsClientImpl::GetDefaultIoBufferSize() const
 ssize_t
 KfsClientImpl::SetIoBufferSize(int fd, size_t size)
 {
+    QCStMutexLocker fdLock(GetFdMutex(fd));
     QCStMutexLocker lock(mMutex);
     if (! valid_fd(fd)) {
         return -EBADF;
@@ -5075,6 +5227,7 @@ KfsClientImpl::SetIoBufferSize(FileTableEntry& entry, size_t size, bool optimalF
 ssize_t
 KfsClientImpl::GetIoBufferSize(int fd) const
 {
+    QCStMutexLocker fdLock(GetFdMutex(fd));
     QCStMutexLocker lock(const_cast<KfsClientImpl*>(this)->mMutex);
     if (! valid_fd(fd)) {
         return -EBADF;
@@ -5108,6 +5261,7 @@ KfsClientImpl::SetDefaultFullSparseFileSupport(bool flag)
 int
 KfsClientImpl::SetFullSparseFileSupport(int fd, bool flag)
 {
+    QCStMutexLocker fdLock(GetFdMutex(fd));
     QCStMutexLocker lock(mMutex);
     if (! valid_fd(fd)) {
         return -EBADF;
@@ -5183,6 +5337,7 @@ struct RespondingServer2
 int
 KfsClientImpl::UpdateFilesize(int fd)
 {
+    QCStMutexLocker fdLock(GetFdMutex(fd));
     QCStMutexLocker l(mMutex);
 
     if (! valid_fd(fd)) {
@@ -5211,7 +5366,7 @@ KfsClientImpl::UpdateFilesize(int fd)
         }
         entry.fattr = op.fattr;
         if (fa) {
-            *fa                    = op.fattr;
+            SetFAttr(*fa, op.fattr);
             fa->validatedTime      = now;
             fa->generation         = mFAttrCacheGeneration;
             fa->staleSubCountsFlag = false;
@@ -5554,6 +5709,15 @@ KfsClientImpl::DoMetaOpWithRetry(KfsOp* op)
 void
 KfsClientImpl::ExecuteMeta(KfsOp& op)
 {
+    MetaCacheSync        sync;
+    MetaCacheSync* const syncPtr =
+        (mMetaCacheLeaseFlag && ! op.metaCacheSync && mMutex.IsOwned()) ?
+        &sync : 0;
+    if (syncPtr) {
+        sync.seq         = mMetaCacheSeq;
+        sync.leaseSec    = mMetaCacheLeaseSec;
+        op.metaCacheSync = syncPtr;
+    }
     if (mMetaServer) {
         mMetaServer->GetNetManager().UpdateTimeNow();
         if (! mMetaServer->Enqueue(&op, this)) {
@@ -5574,6 +5738,10 @@ KfsClientImpl::ExecuteMeta(KfsOp& op)
         StartProtocolWorker();
         mProtocolWorker->ExecuteMeta(op);
     }
+    if (syncPtr) {
+        op.metaCacheSync = 0;
+        UpdateMetaCache(op, sync);
+    }
     KFS_LOG_STREAM_DEBUG <<
         "meta op done:" <<
         " seq: "          << op.seq <<
@@ -5649,7 +5817,7 @@ void
 KfsClientImpl::ValidateFAttrCache(time_t now, int maxScan)
 {
     FAttr*       p;
-    const time_t expire = now - mFileAttributeRevalidateTime;
+    const time_t expire = now - GetFAttrRevalidateTime();
     int          rem    = maxScan;
     while ((p = FAttrLru::Front(mFAttrLru)) &&
             (p->validatedTime < expire ||
@@ -5717,6 +5885,7 @@ KfsClientImpl::NewFAttr(kfsFileId_t parentFid, const string& name,
         FatalError();
     }
     fa->fidNameIt = res.first;
+    fa->fidIt     = mFidToFAttrMap.insert(make_pair(fa->fileId, fa));
     if (! pathname.empty() && pathname[0] == '/' &&
             name != ".." && name != ".") {
         pair<NameToFAttrMap::iterator, bool> const
@@ -5763,6 +5932,7 @@ KfsClientImpl::Delete(KfsClientImpl::FAttr* fa)
     }
     Validate(fa);
     mFidNameToFAttrMap.erase(fa->fidNameIt);
+    mFidToFAttrMap.erase(fa->fidIt);
     if (fa->nameIt != mPathCacheNone) {
         mPathCache.erase(fa->nameIt);
     }
@@ -5787,6 +5957,7 @@ KfsClientImpl::AllocFileTableEntry(kfsFileId_t parentFid, const string& name,
     FileTableEntry& entry =
         *(new FileTableEntry(parentFid, name, mFileInstance));
     mFileTable[fte] = &entry;
+    mFdTable.Set(fte, &entry);
     InitPendingRead(entry);
     entry.pathname = pathname;
     entry.ioBufferSize = mDefaultIoBufferSize;
@@ -5807,6 +5978,9 @@ KfsClientImpl::ReleaseFileTableEntry(int fte)
     assert(valid_fd(fte));
     FileTableEntry& entry = *(mFileTable[fte]);
     mFileTable[fte] = 0;
+    // The file descriptor mutex is held, unless the entry was never
+    // returned to the caller, i.e. on open failure.
+    mFdTable.Set(fte, 0);
     mFreeFileTableEntires.push_back(fte);
     KFS_LOG_STREAM_DEBUG <<
         "releasing:"
@@ -6414,6 +6588,7 @@ KfsClientImpl::VerifyDataChecksums(const char* pathname)
 int
 KfsClientImpl::VerifyDataChecksums(int fd)
 {
+    QCStMutexLocker fdLock(GetFdMutex(fd));
     QCStMutexLocker l(mMutex);
 
     if (! valid_fd(fd)) {
@@ -6641,6 +6816,7 @@ KfsClientImpl::RecursivelyApply(const char* pathname, T& functor,
 int
 KfsClientImpl::Chmod(int fd, kfsMode_t mode)
 {
+    QCStMutexLocker fdLock(GetFdMutex(fd));
     QCStMutexLocker l(mMutex);
 
     if (! valid_fd(fd)) {
@@ -6738,6 +6914,7 @@ KfsClientImpl::ChownSelf(int fd,
         return -EINVAL;
     }
 
+    QCStMutexLocker fdLock(GetFdMutex(fd));
     QCStMutexLocker l(mMutex);
 
     if (! valid_fd(fd)) {
@@ -7810,6 +7987,25 @@ KfsClientImpl::GetStats()
     QCStMutexLocker l(mMutex);
     StartProtocolWorker();
     Properties stats = mProtocolWorker->GetStats();
+    if (0 < mReadAheadMaxSize) {
+        const struct
+        {
+            const char*             name;
+            const volatile int64_t* value;
+        } counters[] = {
+            { "ReadAhead.Sequential", &mReadAheadCounters.mSequentialCount },
+            { "ReadAhead.Strided",    &mReadAheadCounters.mStridedCount    },
+            { "ReadAhead.Random",     &mReadAheadCounters.mRandomCount     },
+            { "ReadAhead.Grow",       &mReadAheadCounters.mGrowCount       },
+            { "ReadAhead.Shrink",     &mReadAheadCounters.mShrinkCount     }
+        };
+        string value;
+        for (size_t i = 0; i < sizeof(counters) / sizeof(counters[0]); i++) {
+            value.clear();
+            AppendDecIntToString(value, *counters[i].value);
+            stats.setValue(counters[i].name, value);
+        }
+    }
     if (stats.empty()) {
         return 0;
     }
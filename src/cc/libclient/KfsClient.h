@@ -619,6 +619,128 @@ public:
     ssize_t PRead(int fd, chunkOff_t pos, char* buf, size_t numBytes);
     ssize_t PWrite(int fd, chunkOff_t pos, const char* buf, size_t numBytes);
 
+    ///
+    /// Vectored positional read, intended for reading footers and column
+    /// chunks of columnar format files with a single call. The ranges that
+    /// are close to each other are coalesced, and the resulting reads are
+    /// issued to the chunk servers in parallel. The file position and read
+    /// ahead buffer are not used or changed. On return the status of each
+    /// range is set to the number of bytes read, which is less than size at
+    /// the end of file, or to negative error code. A range larger than
+    /// the maximum single read size, about 2GB, fails with -EINVAL.
+    /// @retval total number of bytes read, or the first error code.
+    ///
+    class ReadRange
+    {
+    public:
+        ReadRange(
+            chunkOff_t inPos  = -1,
+            char*      inBuf  = 0,
+            size_t     inSize = 0)
+            : pos(inPos),
+              buf(inBuf),
+              size(inSize),
+              status(0)
+            {}
+        chunkOff_t pos;
+        char*      buf;
+        size_t     size;
+        ssize_t    status;
+    };
+    ssize_t PReadV(int fd, ReadRange* ranges, int count);
+
+    ///
+    /// Asynchronous positional read or write request. Any number of
+    /// requests, including requests on the same fd, can be in flight at the
+    /// same time. The request and its buffer must remain valid, and the
+    /// write buffer must not be modified, until the request completes.
+    /// On completion status is set to the number of bytes read, which is less
+    /// than size at the end of file, or the number of bytes written, or to
+    /// negative error code. Write completion means that the buffer is no
+    /// longer referenced. Like with WriteAsync(), write errors are sticky,
+    /// and are also returned by the subsequent Sync() and Close().
+    ///
+    class AsyncIo
+    {
+    public:
+        enum Type
+        {
+            kTypeRead  = 0,
+            kTypeWrite = 1
+        };
+        AsyncIo(
+            Type       inType     = kTypeRead,
+            int        inFd       = -1,
+            chunkOff_t inPos      = -1,
+            char*      inBuf      = 0,
+            size_t     inSize     = 0,
+            void*      inUserData = 0)
+            : type(inType),
+              fd(inFd),
+              pos(inPos),
+              buf(inBuf),
+              size(inSize),
+              userData(inUserData),
+              status(0)
+            {}
+        Type       type;
+        int        fd;
+        chunkOff_t pos;
+        char*      buf;
+        size_t     size;
+        void*      userData;
+        ssize_t    status;
+    };
+    ///
+    /// Completion callback is invoked from the client's network thread, and
+    /// must not block, or invoke blocking KfsClient methods. If a request
+    /// fails validation, the callback is invoked from the submitting thread.
+    ///
+    class AsyncIoCompletion
+    {
+    public:
+        virtual void Done(AsyncIo& io) = 0;
+    protected:
+        AsyncIoCompletion()  {}
+        virtual ~AsyncIoCompletion() {}
+        AsyncIoCompletion(const AsyncIoCompletion&) {}
+        AsyncIoCompletion& operator=(const AsyncIoCompletion&)
+            { return *this; }
+    };
+    ///
+    /// Completion queue, that can be used instead of callbacks. The file
+    /// descriptor returned by GetFd() is readable while the queue is not
+    /// empty, and can be used with poll() or epoll().
+    ///
+    class AsyncIoQueue : public AsyncIoCompletion
+    {
+    public:
+        AsyncIoQueue();
+        virtual ~AsyncIoQueue();
+        virtual void Done(AsyncIo& io);
+        int GetFd() const;
+        ///
+        /// Dequeue up to maxCount completed requests, waiting up to timeoutMs
+        /// for the first completion. Negative timeout means no time limit.
+        /// @retval number of requests dequeued.
+        ///
+        int Get(AsyncIo** ios, int maxCount, int timeoutMs);
+    private:
+        class Impl;
+        Impl& mImpl;
+
+        AsyncIoQueue(const AsyncIoQueue&);
+        AsyncIoQueue& operator=(const AsyncIoQueue&);
+    };
+    ///
+    /// Submit a batch of asynchronous requests. Each submitted request
+    /// completes exactly once through the completion passed.
+    /// @retval number of requests submitted, or negative error code if the
+    /// client is not initialized.
+    ///
+    int AsyncIoSubmit(AsyncIo* const* ios, int count,
+        AsyncIoCompletion& completion);
+
     /// If there are any holes in a file, such as those at the end of
     /// a chunk, skip over them.
     void SkipHolesInFile(int fd);
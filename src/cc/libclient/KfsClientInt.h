@@ -32,28 +32,33 @@
 #include "common/kfstypes.h"
 #include "common/PoolAllocator.h"
 #include "common/BufferInputStream.h"
+#include "common/kfsatomic.h"
 #include "kfsio/NetManager.h"
 #include "kfsio/checksum.h"
 #include "kfsio/ClientAuthContext.h"
 #include "qcdio/QCDLList.h"
 #include "qcdio/QCMutex.h"
+#include "qcdio/qcstutils.h"
 
 #include "KfsNetClient.h"
 #include "KfsAttr.h"
 #include "KfsOps.h"
 #include "KfsClient.h"
+#include "KfsProtocolWorker.h"
 #include "Path.h"
 
 #include <string>
 #include <vector>
 #include <ostream>
 #include <map>
+#include <algorithm>
 
 namespace KFS {
 namespace client {
 
 using std::string;
 using std::map;
+using std::multimap;
 using std::vector;
 using std::pair;
 using std::less;
@@ -61,6 +66,7 @@ using std::map;
 using std::equal_to;
 using std::less;
 using std::ostream;
+using std::max;
 using std::streambuf;
 
 /// If an op fails because the server crashed, retry the op.  This
@@ -165,6 +171,41 @@ private:
     ReadBuffer& operator=(const ReadBuffer& buf);
 };
 
+///
+/// Per fd read access pattern state used by the adaptive read-ahead.
+///
+struct ReadAheadState
+{
+    ReadAheadState()
+        : prevPos(-1),
+          prevEnd(-1),
+          stride(0),
+          baseSize(0),
+          seqCount(0),
+          randomCount(0),
+          fixedFlag(false)
+        {}
+    // Resets pattern history, and sets the read-ahead size that sequential
+    // access window grows from.
+    void Reset(int inBaseSize)
+    {
+        prevPos     = -1;
+        prevEnd     = -1;
+        stride      = 0;
+        baseSize    = inBaseSize;
+        seqCount    = 0;
+        randomCount = 0;
+    }
+    chunkOff_t prevPos;
+    chunkOff_t prevEnd;
+    chunkOff_t stride;
+    int        baseSize;
+    int        seqCount;
+    int        randomCount;
+    // Set by SetReadAheadSize() -- the application fixed read-ahead size.
+    bool       fixedFlag;
+};
+
 class KfsClientImpl;
 
 ///
@@ -180,6 +221,60 @@ struct FilePosition {
     chunkOff_t fileOffset; // offset within the file
 };
 
+///
+/// End of the completed asynchronous writes, shared by the file table entry
+/// and the write requests in flight. The requests complete on the protocol
+/// worker thread, which must not take the client or the fd mutex, as the
+/// client threads wait for the protocol worker with these mutexes held.
+///
+class AsyncWriteEnd
+{
+public:
+    AsyncWriteEnd()
+        : mMutex(),
+          mEnd(-1),
+          mRefCount(1)
+        {}
+    void Ref()
+    {
+        QCStMutexLocker lock(mMutex);
+        mRefCount++;
+    }
+    void Unref()
+    {
+        QCStMutexLocker lock(mMutex);
+        if (--mRefCount <= 0) {
+            lock.Unlock();
+            delete this;
+        }
+    }
+    void Update(chunkOff_t end)
+    {
+        QCStMutexLocker lock(mMutex);
+        mEnd = max(mEnd, end);
+    }
+    void Reset()
+    {
+        QCStMutexLocker lock(mMutex);
+        mEnd = -1;
+    }
+    chunkOff_t Get()
+    {
+        QCStMutexLocker lock(mMutex);
+        return mEnd;
+    }
+private:
+    QCMutex    mMutex;
+    chunkOff_t mEnd;
+    int        mRefCount;
+
+    ~AsyncWriteEnd()
+        {}
+private:
+    AsyncWriteEnd(const AsyncWriteEnd&);
+    AsyncWriteEnd& operator=(const AsyncWriteEnd&);
+};
+
 ///
 /// \brief A table of entries that describe each open KFS file.
 ///
@@ -209,7 +304,9 @@ struct FileTableEntry {
     vector<KfsFileAttr>* dirEntries;
     int                  ioBufferSize;
     ReadBuffer           buffer;
+    ReadAheadState       readAhead;
     ReadRequest*         mReadQueue[1];
+    AsyncWriteEnd*       asyncWriteEnd;
 
     FileTableEntry(kfsFileId_t p, const string& n, unsigned int instance):
         parentFid(p),
@@ -228,11 +325,24 @@ struct FileTableEntry {
         pending(0),
         dirEntries(0),
         ioBufferSize(0),
-        buffer()
+        buffer(),
+        readAhead(),
+        asyncWriteEnd(0)
         { mReadQueue[0] = 0; }
     ~FileTableEntry()
     {
         delete dirEntries;
+        if (asyncWriteEnd) {
+            asyncWriteEnd->Unref();
+        }
+    }
+    // Extends the file size to the end of the completed asynchronous writes.
+    void UpdateAsyncWriteFileSize()
+    {
+        if (! asyncWriteEnd || fattr.fileSize < 0) {
+            return;
+        }
+        fattr.fileSize = max(fattr.fileSize, asyncWriteEnd->Get());
     }
 };
 
@@ -472,6 +582,11 @@ public:
     int WriteAsync(int fd, const char *buf, size_t numBytes);
     int WriteAsyncCompletionHandler(int fd);
 
+    int AsyncIoSubmit(KfsClient::AsyncIo* const* ios, int count,
+        KfsClient::AsyncIoCompletion& completion);
+
+    ssize_t ReadV(int fd, KfsClient::ReadRange* ranges, int count);
+
     ///
     /// Read/write the desired # of bytes to the file, starting at the
     /// "current" position of the file.
@@ -663,6 +778,27 @@ private:
      /// Slot 0 is not used to make Hypertable work.
     enum { MAX_FILES = 128 << 10 };
 
+    /// Adaptive read-ahead counters, updated by readers holding only the
+    /// file descriptor mutex.
+    struct ReadAheadCounters
+    {
+        ReadAheadCounters()
+            : mSequentialCount(0),
+              mStridedCount(0),
+              mRandomCount(0),
+              mGrowCount(0),
+              mShrinkCount(0)
+            {}
+        volatile int64_t mSequentialCount;
+        volatile int64_t mStridedCount;
+        volatile int64_t mRandomCount;
+        volatile int64_t mGrowCount;
+        volatile int64_t mShrinkCount;
+    };
+
+    /// Lock ordering: per file descriptor mutex, if any, must be acquired
+    /// before mMutex. Read and write data path only acquire the file
+    /// descriptor mutex, and acquire mMutex briefly when needed.
     QCMutex mMutex;
     QCMutex mReadCompletionMutex;
 
@@ -689,6 +825,11 @@ private:
         less<pair<kfsFileId_t, string> >,
         StdFastAllocator<pair<const pair<kfsFileId_t, string>, FAttr*> >
     > FidNameToFAttrMap;
+    typedef multimap<
+        kfsFileId_t, FAttr*,
+        less<kfsFileId_t>,
+        StdFastAllocator<pair<const kfsFileId_t, FAttr*> >
+    > FidToFAttrMap;
     class FAttr : public FileAttr
     {
     public:
@@ -699,6 +840,7 @@ private:
               generation(0),
               staleSubCountsFlag(false),
               fidNameIt(),
+              fidIt(),
               nameIt()
         {
             List::Init(*this);
@@ -713,6 +855,7 @@ private:
         unsigned int                generation;
         bool                        staleSubCountsFlag;
         FidNameToFAttrMap::iterator fidNameIt;
+        FidToFAttrMap::iterator     fidIt;
         NameToFAttrMap::iterator    nameIt;
     private:
         FAttr* mPrevPtr[1];
@@ -725,6 +868,76 @@ private:
 
     /// keep a table of open files/directory handles.
     typedef vector<FileTableEntry*> FileTable;
+    /// File descriptor slots used by the read and write data path. Each
+    /// slot has its own mutex that serializes the data path operations
+    /// on the file descriptor, and the operations that modify or delete the
+    /// corresponding file table entry. The slots are allocated in segments
+    /// that are never freed until the client is destroyed, thus the lookup
+    /// does not require mMutex. The entry pointer is set and cleared with
+    /// mMutex held, along with the corresponding mFileTable element.
+    class FdTable
+    {
+    public:
+        class Slot
+        {
+        public:
+            Slot()
+                : mMutex(),
+                  mEntryPtr(0)
+                {}
+            QCMutex                  mMutex;
+            FileTableEntry* volatile mEntryPtr;
+        private:
+            Slot(const Slot&);
+            Slot& operator=(const Slot&);
+        };
+        FdTable()
+        {
+            for (int i = 0; i < kSegmentCount; i++) {
+                mSegments[i] = 0;
+            }
+        }
+        ~FdTable()
+        {
+            for (int i = 0; i < kSegmentCount; i++) {
+                delete [] mSegments[i];
+            }
+        }
+        Slot* Get(int fd) const
+        {
+            if (fd < 0 || MAX_FILES <= fd) {
+                return 0;
+            }
+            Slot* const segment = SyncLoadAcquire(mSegments[fd >> kSegmentBits]);
+            return (segment ? segment + (fd & kSegmentMask) : 0);
+        }
+        FileTableEntry* GetEntry(int fd) const
+        {
+            Slot* const slot = Get(fd);
+            return (slot ? SyncLoadAcquire(slot->mEntryPtr) : 0);
+        }
+        void Set(int fd, FileTableEntry* entry)
+        {
+            assert(0 <= fd && fd < MAX_FILES);
+            Slot* segment = mSegments[fd >> kSegmentBits];
+            if (! segment) {
+                segment = new Slot[kSegmentSize];
+                SyncSet(mSegments[fd >> kSegmentBits], segment);
+            }
+            SyncSet(segment[fd & kSegmentMask].mEntryPtr, entry);
+        }
+    private:
+        enum {
+            kSegmentBits  = 10,
+            kSegmentSize  = 1 << kSegmentBits,
+            kSegmentMask  = kSegmentSize - 1,
+            kSegmentCount = (MAX_FILES + kSegmentSize - 1) >> kSegmentBits
+        };
+        mutable Slot* volatile mSegments[kSegmentCount];
+    private:
+        FdTable(const FdTable&);
+        FdTable& operator=(const FdTable&);
+    };
     typedef PoolAllocator <
         sizeof(FAttr),
         1  << 20,
@@ -774,7 +987,9 @@ private:
     };
 
     FileTable                      mFileTable;
+    FdTable                        mFdTable;
     FidNameToFAttrMap              mFidNameToFAttrMap;
+    FidToFAttrMap                  mFidToFAttrMap;
     NameToFAttrMap                 mPathCache;
     NameToFAttrMap::iterator const mPathCacheNone;
     FAttrPool                      mFAttrPool;
@@ -828,6 +1043,13 @@ private:
     ClientAuthContext              mAuthCtx;
     ClientAuthContext              mProtocolWorkerAuthCtx;
     int                            mTargetDiskIoSize;
+    int                            mReadVCoalesceGap;
+    int                            mReadVMaxCoalesceSize;
+    int                            mReadAheadMaxSize;
+    ReadAheadCounters              mReadAheadCounters;
+    bool                           mMetaCacheLeaseFlag;
+    int64_t                        mMetaCacheSeq;
+    int                            mMetaCacheLeaseSec;
     Properties                     mConfig;
     KfsNetClient* const            mMetaServer;
     string                         mCommonRpcHdrs;
@@ -855,7 +1077,14 @@ private:
     bool IsValid(const FAttr& fa, time_t now) const
     {
         return (fa.generation == mFAttrCacheGeneration &&
-            now <= fa.validatedTime + mFileAttributeRevalidateTime);
+            now <= fa.validatedTime + GetFAttrRevalidateTime());
+    }
+    // Meta server granted lease, if any, supersedes the configured attribute
+    // re-validate time.
+    int GetFAttrRevalidateTime() const
+    {
+        return (0 < mMetaCacheLeaseSec ?
+            mMetaCacheLeaseSec : mFileAttributeRevalidateTime);
     }
 
     void Shutdown();
@@ -938,6 +1167,21 @@ private:
         size_t startIdx, const ServerLocation &loc);
 
     FileTableEntry* FdInfo(int fd) { return mFileTable[fd]; }
+    /// Lock free file descriptor lookup, the result is only valid while
+    /// the file descriptor mutex is held.
+    FileTableEntry* GetFdEntry(int fd) const {
+        return mFdTable.GetEntry(fd);
+    }
+    QCMutex* GetFdMutex(int fd) const {
+        FdTable::Slot* const slot = mFdTable.Get(fd);
+        return (slot ? &slot->mMutex : 0);
+    }
+    void EnsureProtocolWorker() {
+        if (! SyncLoadAcquire(mProtocolWorker)) {
+            QCStMutexLocker l(mMutex);
+            StartProtocolWorker();
+        }
+    }
     FileAttr* FdAttr(int fd) { return &FdInfo(fd)->fattr; }
 
     virtual void OpDone(KfsOp* inOpPtr, bool inCanceledFlag,
@@ -1011,6 +1255,12 @@ private:
     int ReadDirectory(int fd, char *buf, size_t bufSize);
     ssize_t Write(int fd, const char *buf, size_t numBytes,
         bool asyncFlag, bool appendOnlyFlag, chunkOff_t* pos = 0);
+    void InitWriteOpenParams(int fd, FileTableEntry& entry,
+        KfsProtocolWorker::Request::Params& openParams);
+    int AsyncRead(KfsClient::AsyncIo& io,
+        KfsClient::AsyncIoCompletion& completion);
+    int AsyncWrite(KfsClient::AsyncIo& io,
+        KfsClient::AsyncIoCompletion& completion);
     void InitPendingRead(FileTableEntry& entry);
     void CancelPendingRead(FileTableEntry& entry);
     void CleanupPendingRead();
@@ -1019,6 +1269,15 @@ private:
         bool idempotentFlag);
     void StartProtocolWorker();
     void InvalidateAllCachedAttrs();
+    void InvalidateCachedAttrs(const string& fids, bool hexFlag);
+    void SetFAttr(FAttr& fa, const FileAttr& fattr);
+    void MarkStale(FAttr& fa, unsigned int staleGeneration) const
+    {
+        if (fa.generation == mFAttrCacheGeneration) {
+            fa.generation = staleGeneration;
+        }
+    }
+    void UpdateMetaCache(const KfsOp& op, const MetaCacheSync& sync);
     int GetUserAndGroup(const char* user, const char* group, kfsUid_t& uid, kfsGid_t& gid);
     template<typename T> int RecursivelyApply(
         string& path, const KfsFileAttr& attr, T& functor, bool fileIdAndTypeOnly = false);
@@ -1124,6 +1383,7 @@ private:
     int UpdateEUserAndEGroup();
     ssize_t ReadSelf(int fd, char *buf, size_t numBytes, chunkOff_t* pos,
         bool& outDirFlag);
+    void UpdateReadAhead(FileTableEntry& inEntry, int64_t inPos, int inSize);
     ssize_t WriteSelf(int fd, const char *buf, size_t numBytes,
         bool asyncFlag, bool appendOnlyFlag, chunkOff_t* pos);
     inline bool IsFileTableFull() const;
@@ -36,6 +36,7 @@
 #include "common/kfsdecls.h"
 #include "common/MsgLogger.h"
 #include "common/StdAllocator.h"
+#include "common/time.h"
 #include "qcdio/QCUtils.h"
 #include "qcdio/qcstutils.h"
 #include "qcdio/QCDLList.h"
@@ -1143,6 +1144,7 @@ private:
               mOwnerPtr(inOwnerPtr),
               mBufferPtr(inBufferPtr),
               mTime(0),
+              mStartUsec(0),
               mRetryCount(0),
               mExtraTimeout(max(0, inExtraTimeout)),
               mVrConnectPendingFlag(false)
@@ -1177,6 +1179,7 @@ private:
         OpOwner*  mOwnerPtr;
         IOBuffer* mBufferPtr;
         time_t    mTime;
+        int64_t   mStartUsec;
         int       mRetryCount;
         uint32_t  mExtraTimeout:31;
         bool      mVrConnectPendingFlag:1;
@@ -1999,6 +2002,7 @@ private:
         mOstream.Reset();
         // Start the timer.
         inEntry.mTime       = Now();
+        inEntry.mStartUsec  = microseconds();
         inEntry.mRetryCount = inRetryCount;
         mPendingBytesSend = mConnPtr->GetOutBuffer().BytesConsumable();
         if (inFlushFlag) {
@@ -2492,6 +2496,8 @@ private:
     {
         if (inCanceledFlag) {
             mStats.mOpsCancelledCount++;
+        } else if (0 < inIt->second.mStartUsec) {
+            mStats.mOpLatency.Update(microseconds() - inIt->second.mStartUsec);
         }
         const bool theScheduleNextOpFlag = mOutstandingOpPtr == &inIt->second;
         if (theScheduleNextOpFlag) {
@@ -27,6 +27,7 @@
 #define KFS_NET_CLIENT_H
 
 #include "common/kfstypes.h"
+#include "kfsio/LatencyHistogram.h"
 
 #include <cerrno>
 #include <string>
@@ -79,7 +80,8 @@ public:
               mOpsCancelledCount(0),
               mSleepTimeSec(0),
               mBytesReceivedCount(0),
-              mBytesSentCount(0)
+              mBytesSentCount(0),
+              mOpLatency()
             {}
         void Clear()
             { *this = Stats(); }
@@ -98,6 +100,7 @@ public:
             mSleepTimeSec               += inStats.mSleepTimeSec;
             mBytesReceivedCount         += inStats.mBytesReceivedCount;
             mBytesSentCount             += inStats.mBytesSentCount;
+            mOpLatency.Add(inStats.mOpLatency);
             return *this;
         }
         template<typename T>
@@ -116,6 +119,12 @@ public:
             inFunctor("SleepTimeSec",          mSleepTimeSec);
             inFunctor("BytesReceived",         mBytesReceivedCount);
             inFunctor("BytesSent",             mBytesSentCount);
+            inFunctor("OpLatencyCount",        mOpLatency.GetTotalCount());
+            inFunctor("OpLatencyP50",          mOpLatency.GetPercentile(50));
+            inFunctor("OpLatencyP90",          mOpLatency.GetPercentile(90));
+            inFunctor("OpLatencyP99",          mOpLatency.GetPercentile(99));
+            inFunctor("OpLatencyP999",         mOpLatency.GetPercentile(99.9));
+            inFunctor("OpLatencyMax",          mOpLatency.GetMaxValue());
         }
         Counter mConnectCount;
         Counter mConnectFailureCount;
@@ -129,6 +138,9 @@ public:
         Counter mSleepTimeSec;
         Counter mBytesReceivedCount;
         Counter mBytesSentCount;
+        // Request round trip time in microseconds, from the time the
+        // request was sent to the time the response was received.
+        LatencyHistogram mOpLatency;
     };
     enum {
         kErrorMaxRetryReached = -(10000 + ETIMEDOUT),
@@ -82,6 +82,10 @@ KfsOp::ParentHeaders(ReqOstream& os) const
         os << (shortRpcFormatFlag ? "w:" : "Max-wait-ms: ") <<
             maxWaitMillisec << "\r\n";
     }
+    if (metaCacheSync) {
+        os << (shortRpcFormatFlag ? "mcs:" : "Meta-cache-seq: ") <<
+            max(int64_t(0), metaCacheSync->seq) << "\r\n";
+    }
     return os;
 }
 
@@ -540,8 +544,11 @@ GetChunkMetadataOp::Request(ReqOstream& os)
         "GET_CHUNK_METADATA\r\n" << ReqHeaders(*this) <<
         (shortRpcFormatFlag ? "H:"  : "Chunk-handle: ") << chunkId << "\r\n" <<
         (shortRpcFormatFlag ? "RV:" : "Read-verify: ")  <<
-            (readVerifyFlag ? 1 : 0) << "\r\n" <<
-        Access() <<
+            (readVerifyFlag ? 1 : 0) << "\r\n";
+    if (localReadFlag) {
+        os << (shortRpcFormatFlag ? "LR:" : "Local-read: ") << 1 << "\r\n";
+    }
+    os << Access() <<
     "\r\n";
 }
 
@@ -1029,6 +1036,16 @@ KfsOp::ParseResponseHeader(const Properties& prop)
         shortRpcFormatFlag ? "l" : "Content-length", 0);
     statusMsg = prop.getValue(
         shortRpcFormatFlag ? "m" : "Status-message", string());
+    if (metaCacheSync) {
+        metaCacheSync->seq = prop.getValue(
+            shortRpcFormatFlag ? "mcs" : "Meta-cache-seq", int64_t(-1));
+        metaCacheSync->leaseSec = prop.getValue(
+            shortRpcFormatFlag ? "mcl" : "Meta-cache-lease", 0);
+        metaCacheSync->invalidateAllFlag = prop.getValue(
+            shortRpcFormatFlag ? "mca" : "Meta-cache-invalidate-all", 0) != 0;
+        metaCacheSync->invalidate = prop.getValue(
+            shortRpcFormatFlag ? "mci" : "Meta-cache-invalidate", string());
+    }
     ParseResponseHeaderSelf(prop);
 }
 
@@ -1555,6 +1572,21 @@ SizeOp::ParseResponseHeaderSelf(const Properties& prop)
     size = prop.getValue(shortRpcFormatFlag ? "S" : "Size", (long long) 0);
 }
 
+void
+GetChunkMetadataOp::ParseResponseHeaderSelf(const Properties& prop)
+{
+    chunkVersion        = prop.getValue(
+        shortRpcFormatFlag ? "V"  : "Chunk-version",     chunkVersion);
+    chunkSize           = prop.getValue(
+        shortRpcFormatFlag ? "S"  : "Size",              chunkOff_t(-1));
+    localReadHandle     = prop.getValue(
+        shortRpcFormatFlag ? "LH" : "Local-read-handle", int64_t(-1));
+    localReadPath       = prop.getValue(
+        shortRpcFormatFlag ? "LP" : "Local-read-path",   string());
+    localReadHeaderSize = prop.getValue(
+        shortRpcFormatFlag ? "LZ" : "Local-read-header-size", 0);
+}
+
 void
 ReadOp::ParseResponseHeaderSelf(const Properties& prop)
 {
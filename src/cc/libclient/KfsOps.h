@@ -133,6 +133,24 @@ enum KfsOp_t {
 
 typedef ReqOstreamT<ostream> ReqOstream;
 
+// Meta data cache lease state exchanged with the meta server. The request
+// carries the sequence of the last response received, the response carries
+// the new sequence, the lease time, and the ids of the directories and files
+// modified in between.
+struct MetaCacheSync {
+    int64_t seq;
+    int     leaseSec;
+    bool    invalidateAllFlag;
+    string  invalidate;
+
+    MetaCacheSync()
+        : seq(-1),
+          leaseSec(0),
+          invalidateAllFlag(false),
+          invalidate()
+        {}
+};
+
 struct KfsOp {
     class Display
     {
@@ -157,6 +175,7 @@ struct KfsOp {
     char*         contentBuf;
     string        statusMsg; // optional, mostly for debugging
     const string* extraHeaders;
+    MetaCacheSync* metaCacheSync;
     bool          shortRpcFormatFlag;
 
     KfsOp (KfsOp_t o, kfsSeq_t s)
@@ -171,6 +190,7 @@ struct KfsOp {
           contentBuf(0),
           statusMsg(),
           extraHeaders(0),
+          metaCacheSync(0),
           shortRpcFormatFlag(false),
           contentBufOwnerFlag(true)
         {}
@@ -1010,12 +1030,23 @@ operator<<(ReqOstream& os, const ChunkAccessOp::AccessReq& req)
 
 // Get the chunk metadata (aka checksums) stored on the chunkservers
 struct GetChunkMetadataOp: public ChunkAccessOp {
-    bool readVerifyFlag;
+    bool       readVerifyFlag;
+    bool       localReadFlag;       // request short circuit local read
+    chunkOff_t chunkSize;           // result
+    int64_t    localReadHandle;     // result
+    string     localReadPath;       // result
+    int        localReadHeaderSize; // result
     GetChunkMetadataOp(kfsSeq_t s, kfsChunkId_t c, bool verifyFlag)
         : ChunkAccessOp(CMD_GET_CHUNK_METADATA, s, c),
-          readVerifyFlag(verifyFlag)
+          readVerifyFlag(verifyFlag),
+          localReadFlag(false),
+          chunkSize(-1),
+          localReadHandle(-1),
+          localReadPath(),
+          localReadHeaderSize(0)
         {}
     void Request(ReqOstream& os);
+    virtual void ParseResponseHeaderSelf(const Properties& prop);
     virtual ostream& ShowSelf(ostream& os) const {
         os << "get chunk metadata:"
             " chunkId: " << chunkId <<
@@ -51,6 +51,9 @@
 #include "Writer.h"
 #include "Reader.h"
 #include "ClientPool.h"
+#include "ReplicaSelector.h"
+#include "ECComputePool.h"
+#include "BlockCache.h"
 
 #include <algorithm>
 #include <map>
@@ -84,7 +87,9 @@ public:
     Impl(
         string            inMetaHost,
         int               inMetaPort,
-        const Parameters& inParameters)
+        const Parameters& inParameters,
+        ECComputePool*    inComputePoolPtr,
+        BlockCache*       inBlockCachePtr)
         : QCRunnable(),
           ITimeout(),
           mNetManager(),
@@ -158,6 +163,15 @@ public:
                 0                            // inAuthContextPtr
             ) : 0
         ),
+        mLocalReadFlag(inParameters.mLocalReadFlag),
+        mRSWriteBehindSize(inParameters.mRSWriteBehindSize),
+        mComputePoolPtr(inComputePoolPtr),
+        mBlockCachePtr(inBlockCachePtr),
+        mReplicaSelector(
+            inParameters.mReadReplicaSelectionFlag,
+            inParameters.mReadHedgeMinDelayMs,
+            inParameters.mReadHedgeDevMultiplier
+        ),
         mReadStats(),
         mWriteStats(),
         mAppendStats()
@@ -538,6 +552,31 @@ public:
             mNetManager.Wakeup();
         }
     }
+    static Properties GetStats(
+        Impl* const* inImplPtrs,
+        int          inImplCount)
+    {
+        // Merge the counters and latency histograms of all worker threads,
+        // then enumerate, in order to compute the latency percentiles from
+        // the merged histograms.
+        ThreadStats theTotal;
+        for (int i = 0; i < inImplCount; i++) {
+            ThreadStats theStats;
+            inImplPtrs[i]->Execute(
+                kRequestTypeGetStatsOp,
+                1,
+                1,
+                0,
+                &theStats,
+                0,
+                0,
+                0
+            );
+            theTotal.Add(theStats);
+        }
+        return GetStats(theTotal,
+            0 < inImplCount ? inImplPtrs[0]->mBlockCachePtr : 0);
+    }
 private:
     class StopRequest : public Request
     {
@@ -760,14 +799,13 @@ private:
     void StatsRequest(
         Request& inRequest)
     {
-        Properties* const theStatsPtr =
-            reinterpret_cast<Properties*>(inRequest.mBufferPtr);
+        ThreadStats* const theStatsPtr =
+            reinterpret_cast<ThreadStats*>(inRequest.mBufferPtr);
         if (! theStatsPtr) {
             Done(inRequest, kErrParameters);
             return;
         }
-        Properties theStats = GetStats();
-        theStatsPtr->swap(theStats);
+        GetStats(*theStatsPtr);
         Done(inRequest, 0);
     }
     typedef QCDLList<SyncRequest, 0> FreeSyncRequests;
@@ -1149,7 +1187,9 @@ private:
                 min(max(4 << 20, inOwner.mMaxWriteSize),
                     max(inOwner.mMaxWriteSize, inMaxWriteSize)),
                 inLogPrefixPtr,
-                inOwner.mChunkServerInitialSeqNum
+                inOwner.mChunkServerInitialSeqNum,
+                inOwner.mComputePoolPtr,
+                inOwner.mRSWriteBehindSize
               ),
               mCurRequestPtr(0),
               mAsyncStatus(0)
@@ -1465,7 +1505,11 @@ private:
                 inOwner.mLeaseWaitTimeout,
                 inLogPrefixPtr,
                 inOwner.mChunkServerInitialSeqNum,
-                inOwner.mClientPoolPtr),
+                inOwner.mClientPoolPtr,
+                &inOwner.mReplicaSelector,
+                inOwner.mLocalReadFlag,
+                inOwner.mComputePoolPtr,
+                inOwner.mBlockCachePtr),
               mCurRequestPtr(0),
               mAsyncReadStatus(0),
               mAsyncReadDoneCount(0)
@@ -1717,6 +1761,11 @@ private:
     QCThread             mWorker;
     QCMutex              mMutex;
     ClientPool* const    mClientPoolPtr;
+    const bool           mLocalReadFlag;
+    const int            mRSWriteBehindSize;
+    ECComputePool* const mComputePoolPtr;
+    BlockCache* const    mBlockCachePtr;
+    ReplicaSelector      mReplicaSelector;
     FileReader::Stats    mReadStats;
     FileWriter::Stats    mWriteStats;
     Appender::Stats      mAppendStats;
@@ -1913,7 +1962,38 @@ private:
         StatsEnumerator& operator=(
             const StatsEnumerator& inEnumerator);
     };
-    Properties GetStats()
+    class ThreadStats
+    {
+    public:
+        ThreadStats()
+            : mReadStats(),
+              mWriteStats(),
+              mAppendStats(),
+              mMetaServerStats(),
+              mPoolStats(),
+              mPoolSize(-1)
+            {}
+        void Add(
+            const ThreadStats& inStats)
+        {
+            mReadStats.Add(inStats.mReadStats);
+            mWriteStats.Add(inStats.mWriteStats);
+            mAppendStats.Add(inStats.mAppendStats);
+            mMetaServerStats.Add(inStats.mMetaServerStats);
+            mPoolStats.Add(inStats.mPoolStats);
+            if (0 <= inStats.mPoolSize) {
+                mPoolSize = max(int64_t(0), mPoolSize) + inStats.mPoolSize;
+            }
+        }
+        FileReader::Stats   mReadStats;
+        FileWriter::Stats   mWriteStats;
+        Appender::Stats     mAppendStats;
+        KfsNetClient::Stats mMetaServerStats;
+        KfsNetClient::Stats mPoolStats;
+        int64_t             mPoolSize;
+    };
+    void GetStats(
+        ThreadStats& outStats)
     {
         mReadStats   = mTotalReadStats;
         mWriteStats  = mTotalWriteStats;
@@ -1923,27 +2003,46 @@ private:
                 ++theIt) {
             theIt->second->AddStats();
         }
+        outStats.mReadStats   = mReadStats;
+        outStats.mWriteStats  = mWriteStats;
+        outStats.mAppendStats = mAppendStats;
+        mMetaServer.GetStats(outStats.mMetaServerStats);
+        if (mClientPoolPtr) {
+            mClientPoolPtr->GetStats(outStats.mPoolStats);
+            outStats.mPoolSize = (int64_t)mClientPoolPtr->GetSize();
+        }
+    }
+    static Properties GetStats(
+        const ThreadStats& inStats,
+        BlockCache*        inBlockCachePtr)
+    {
         Properties      theRet;
         StatsEnumerator theEnumerator(theRet);
-        mReadStats.mStats.Enumerate(
+        inStats.mReadStats.mStats.Enumerate(
             theEnumerator.SetPrefix("Read."));
-        mReadStats.mCSStats.Enumerate(
+        inStats.mReadStats.mCSStats.Enumerate(
             theEnumerator.SetPrefix("Read.ChunkServer."));
-        mWriteStats.mStats.Enumerate(
+        inStats.mWriteStats.mStats.Enumerate(
             theEnumerator.SetPrefix("Write."));
-        mWriteStats.mCSStats.Enumerate(
+        inStats.mWriteStats.mCSStats.Enumerate(
             theEnumerator.SetPrefix("Write.ChunkServer."));
-        mAppendStats.mStats.Enumerate(
+        inStats.mAppendStats.mStats.Enumerate(
             theEnumerator.SetPrefix("Append."));
-        mAppendStats.mCSStats.Enumerate(
+        inStats.mAppendStats.mCSStats.Enumerate(
             theEnumerator.SetPrefix("Append.ChunkServer."));
-        KfsNetClient::Stats theStats;
-        mMetaServer.GetStats(theStats);
-        theStats.Enumerate(theEnumerator.SetPrefix("MetaServer."));
-        if (mClientPoolPtr) {
-            mClientPoolPtr->GetStats(theStats);
-            theStats.Enumerate(theEnumerator.SetPrefix("ChunkServer.Pool."));
-            theEnumerator("Size", mClientPoolPtr->GetSize());
+        inStats.mMetaServerStats.Enumerate(
+            theEnumerator.SetPrefix("MetaServer."));
+        if (0 <= inStats.mPoolSize) {
+            inStats.mPoolStats.Enumerate(
+                theEnumerator.SetPrefix("ChunkServer.Pool."));
+            theEnumerator("Size", inStats.mPoolSize);
+        }
+        // The block cache is shared by all worker threads, and the network
+        // counters are process wide.
+        if (inBlockCachePtr) {
+            BlockCache::Stats theCacheStats;
+            inBlockCachePtr->GetStats(theCacheStats);
+            theCacheStats.Enumerate(theEnumerator.SetPrefix("BlockCache."));
         }
         theEnumerator.SetPrefix("Network.");
         theEnumerator("Sockets",       globals().ctrOpenNetFds.GetValue());
@@ -2010,33 +2109,94 @@ KfsProtocolWorker::Request::~Request()
     QCRTASSERT(mState != kStateInFlight);
 }
 
+static int
+GetWorkerThreadCount(
+    const KfsProtocolWorker::Parameters* inParametersPtr)
+{
+    if (! inParametersPtr || inParametersPtr->mWorkerThreadCount <= 1) {
+        return 1;
+    }
+    if (inParametersPtr->mAuthContextPtr) {
+        // Authentication context is not thread safe, and can not be shared by
+        // the worker threads.
+        KFS_LOG_STREAM_WARN <<
+            "authentication is enabled, ignoring protocol worker threads: " <<
+                inParametersPtr->mWorkerThreadCount <<
+        KFS_LOG_EOM;
+        return 1;
+    }
+    const int kMaxWorkerThreadCount = 64;
+    return min(kMaxWorkerThreadCount, inParametersPtr->mWorkerThreadCount);
+}
+
 KfsProtocolWorker::KfsProtocolWorker(
         string                               inMetaHost,
         int                                  inMetaPort,
         const KfsProtocolWorker::Parameters* inParametersPtr /* = 0 */)
-    : mImpl(*(new Impl(
-        inMetaHost,
-        inMetaPort,
-        inParametersPtr ? *inParametersPtr : KfsProtocolWorker::Parameters()
-    )))
+    : mComputePoolPtr(
+        (inParametersPtr && 0 < inParametersPtr->mECComputeThreadCount) ?
+        new ECComputePool(inParametersPtr->mECComputeThreadCount) : 0),
+      mBlockCachePtr(
+        (inParametersPtr && 0 < inParametersPtr->mBlockCacheSize) ?
+        new BlockCache(inParametersPtr->mBlockCacheSize) : 0),
+      mImplCount(GetWorkerThreadCount(inParametersPtr)),
+      mImplPtrs(new Impl*[mImplCount])
 {
+    for (int i = 0; i < mImplCount; i++) {
+        mImplPtrs[i] = new Impl(
+            inMetaHost,
+            inMetaPort,
+            inParametersPtr ? *inParametersPtr : KfsProtocolWorker::Parameters(),
+            mComputePoolPtr,
+            mBlockCachePtr
+        );
+    }
 }
 
 KfsProtocolWorker::~KfsProtocolWorker()
 {
-    delete &mImpl;
+    for (int i = 0; i < mImplCount; i++) {
+        delete mImplPtrs[i];
+    }
+    delete [] mImplPtrs;
+    delete mComputePoolPtr;
+    delete mBlockCachePtr;
+}
+
+KfsProtocolWorker::Impl&
+KfsProtocolWorker::GetImpl(
+    KfsProtocolWorker::FileId inFileId) const
+{
+    if (mImplCount <= 1) {
+        return *mImplPtrs[0];
+    }
+    // File ids are assigned sequentially by the meta server, mix the bits
+    // to avoid correlation with the file creation order.
+    uint64_t theHash = (uint64_t)inFileId * 0x9E3779B97F4A7C15ULL;
+    theHash ^= theHash >> 29;
+    return *mImplPtrs[theHash % (uint64_t)mImplCount];
 }
 
 void
 KfsProtocolWorker::Start()
 {
-    mImpl.Start();
+    if (mComputePoolPtr) {
+        mComputePoolPtr->Start();
+    }
+    for (int i = 0; i < mImplCount; i++) {
+        mImplPtrs[i]->Start();
+    }
 }
 
 void
 KfsProtocolWorker::Stop()
 {
-    mImpl.Stop();
+    for (int i = 0; i < mImplCount; i++) {
+        mImplPtrs[i]->Stop();
+    }
+    if (mComputePoolPtr) {
+        mComputePoolPtr->Stop();
+    }
 }
 
 int64_t
@@ -2050,7 +2210,7 @@ KfsProtocolWorker::Execute(
     int                                       inMaxPending,
     int64_t                                   inOffset)
 {
-    return mImpl.Execute(
+    return GetImpl(inFileId).Execute(
         inRequestType,
         inFileInstance,
         inFileId,
@@ -2066,7 +2226,7 @@ void
 KfsProtocolWorker::ExecuteMeta(
     KfsOp& inOp)
 {
-    const int64_t theRet = mImpl.Execute(
+    const int64_t theRet = mImplPtrs[0]->Execute(
         kRequestTypeMetaOp,
         1,
         1,
@@ -2084,18 +2244,16 @@ KfsProtocolWorker::ExecuteMeta(
 Properties
 KfsProtocolWorker::GetStats()
 {
-    Properties theRet;
-    mImpl.Execute(
-        kRequestTypeGetStatsOp,
-        1,
-        1,
-        0,
-        &theRet,
-        0,
-        0,
-        0
-    );
-    return theRet;
+    return Impl::GetStats(mImplPtrs, mImplCount);
+}
+
+void
+KfsProtocolWorker::InvalidateBlockCache(
+    KfsProtocolWorker::FileId inFileId)
+{
+    if (mBlockCachePtr) {
+        mBlockCachePtr->Invalidate(inFileId);
+    }
 }
 
 void
@@ -2111,49 +2269,61 @@ KfsProtocolWorker::Enqueue(
         inRequest.Done(theStatus);
         return;
     }
-    mImpl.Enqueue(inRequest);
+    GetImpl(inRequest.mFileId).Enqueue(inRequest);
 }
 
 void
 KfsProtocolWorker::SetMetaMaxRetryCount(
     int inMaxRetryCount)
 {
-    mImpl.SetMetaMaxRetryCount(inMaxRetryCount);
+    for (int i = 0; i < mImplCount; i++) {
+        mImplPtrs[i]->SetMetaMaxRetryCount(inMaxRetryCount);
+    }
 }
 
 void
 KfsProtocolWorker::SetMetaTimeSecBetweenRetries(
     int inSecs)
 {
-    mImpl.SetMetaTimeSecBetweenRetries(inSecs);
+    for (int i = 0; i < mImplCount; i++) {
+        mImplPtrs[i]->SetMetaTimeSecBetweenRetries(inSecs);
+    }
 }
 
 void
 KfsProtocolWorker::SetMaxRetryCount(
     int inMaxRetryCount)
 {
-    mImpl.SetMaxRetryCount(inMaxRetryCount);
+    for (int i = 0; i < mImplCount; i++) {
+        mImplPtrs[i]->SetMaxRetryCount(inMaxRetryCount);
+    }
 }
 
 void
 KfsProtocolWorker::SetTimeSecBetweenRetries(
     int inSecs)
 {
-    mImpl.SetTimeSecBetweenRetries(inSecs);
+    for (int i = 0; i < mImplCount; i++) {
+        mImplPtrs[i]->SetTimeSecBetweenRetries(inSecs);
+    }
 }
 
 void
 KfsProtocolWorker::SetMetaOpTimeoutSec(
     int inSecs)
 {
-    mImpl.SetMetaOpTimeoutSec(inSecs);
+    for (int i = 0; i < mImplCount; i++) {
+        mImplPtrs[i]->SetMetaOpTimeoutSec(inSecs);
+    }
 }
 
 void
 KfsProtocolWorker::SetOpTimeoutSec(
     int inSecs)
 {
-    mImpl.SetOpTimeoutSec(inSecs);
+    for (int i = 0; i < mImplCount; i++) {
+        mImplPtrs[i]->SetOpTimeoutSec(inSecs);
+    }
 }
 
 void
@@ -2161,7 +2331,10 @@ KfsProtocolWorker::SetCommonRpcHeaders(
     const string& inCommonHeaders,
     const string& inCommonShortHeaders)
 {
-    mImpl.SetCommonRpcHeaders(inCommonHeaders, inCommonShortHeaders);
+    for (int i = 0; i < mImplCount; i++) {
+        mImplPtrs[i]->SetCommonRpcHeaders(
+            inCommonHeaders, inCommonShortHeaders);
+    }
 }
 
 }} /* namespace client KFS */
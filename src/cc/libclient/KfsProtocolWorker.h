@@ -43,8 +43,13 @@ namespace client
 using std::string;
 
 struct KfsOp;
+class ECComputePool;
+class BlockCache;
 // KFS client side protocol worker thread runs client side network io state
-// machines.
+// machines. With more than one worker thread configured, each thread runs its
+// own net manager, meta server connection, and chunk server connection pool,
+// and the files are assigned to the threads by file id, in order to ensure
+// that all requests for the given file are executed by the same thread.
 class KfsProtocolWorker
 {
 private:
@@ -214,7 +219,15 @@ public:
             bool               inResolverUseOsResolverFlag   = false,
             int                inResolverCacheSize           = 8 << 10,
             int                inResolverCacheExpiration     = -1,
-            const string&      inNodeId                      = string())
+            const string&      inNodeId                      = string(),
+            bool               inReadReplicaSelectionFlag    = false,
+            int                inReadHedgeMinDelayMs         = 0,
+            double             inReadHedgeDevMultiplier      = 4,
+            bool               inLocalReadFlag               = false,
+            int                inWorkerThreadCount           = 1,
+            int                inECComputeThreadCount        = 0,
+            int64_t            inBlockCacheSize              = 0,
+            int                inRSWriteBehindSize           = 0)
             : mMetaMaxRetryCount(inMetaMaxRetryCount),
               mMetaTimeSecBetweenRetries(inMetaTimeSecBetweenRetries),
               mMetaOpTimeoutSec(inMetaOpTimeoutSec),
@@ -244,7 +257,15 @@ public:
               mResolverUseOsResolverFlag(inResolverUseOsResolverFlag),
               mResolverCacheSize(inResolverCacheSize),
               mResolverCacheExpiration(inResolverCacheExpiration),
-              mNodeId(inNodeId)
+              mNodeId(inNodeId),
+              mReadReplicaSelectionFlag(inReadReplicaSelectionFlag),
+              mReadHedgeMinDelayMs(inReadHedgeMinDelayMs),
+              mReadHedgeDevMultiplier(inReadHedgeDevMultiplier),
+              mLocalReadFlag(inLocalReadFlag),
+              mWorkerThreadCount(inWorkerThreadCount),
+              mECComputeThreadCount(inECComputeThreadCount),
+              mBlockCacheSize(inBlockCacheSize),
+              mRSWriteBehindSize(inRSWriteBehindSize)
             {}
             int                 mMetaMaxRetryCount;
             int                 mMetaTimeSecBetweenRetries;
@@ -276,6 +297,14 @@ public:
             int                 mResolverCacheSize;
             int                 mResolverCacheExpiration;
             string              mNodeId;
+            bool                mReadReplicaSelectionFlag;
+            int                 mReadHedgeMinDelayMs;
+            double              mReadHedgeDevMultiplier;
+            bool                mLocalReadFlag;
+            int                 mWorkerThreadCount;
+            int                 mECComputeThreadCount;
+            int64_t             mBlockCacheSize;
+            int                 mRSWriteBehindSize;
     };
     KfsProtocolWorker(
         std::string       inMetaHost,
@@ -294,6 +323,10 @@ public:
     void ExecuteMeta(
         KfsOp& inOp);
     Properties GetStats();
+    // Removes the file's blocks from the block cache, if the cache is
+    // enabled. Invoked on local writes.
+    void InvalidateBlockCache(
+        FileId inFileId);
     void Enqueue(
         Request& inRequest);
     void Start();
@@ -315,7 +348,13 @@ public:
         const string& inCommonHeaders,
         const string& inCommonShortHeaders);
 private:
-    Impl& mImpl;
+    ECComputePool* const mComputePoolPtr;
+    BlockCache* const    mBlockCachePtr;
+    int const            mImplCount;
+    Impl** const         mImplPtrs;
+
+    Impl& GetImpl(
+        FileId inFileId) const;
 private:
     KfsProtocolWorker(
         const KfsProtocolWorker& inWorker);
@@ -27,6 +27,7 @@
 #include "KfsClientInt.h"
 #include "KfsProtocolWorker.h"
 #include "common/MsgLogger.h"
+#include "common/kfsatomic.h"
 #include "qcdio/qcstutils.h"
 #include "qcdio/QCDLList.h"
 #include "qcdio/qcdebug.h"
@@ -34,7 +35,9 @@
 
 #include <cerrno>
 #include <string>
+#include <vector>
 #include <limits>
+#include <algorithm>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -45,8 +48,10 @@ namespace client
 {
 
 using std::string;
+using std::vector;
 using std::max;
 using std::min;
+using std::sort;
 using std::numeric_limits;
 
 // Blocking read conditional variables with free/unused list "next" pointer.
@@ -121,12 +126,16 @@ public:
             delete this;
         }
     }
+    // The caller must hold the file descriptor mutex passed as inFdMutex, and
+    // must not hold the client mutex. The free condition variables list is
+    // shared by all file descriptors, and is protected by the completion
+    // mutex.
     int64_t Wait(
-        QCMutex&             inClientMutex,
+        QCMutex&             inFdMutex,
         ReadRequestCondVar*& ioFreeCondVarsHeadPtr,
         FileTableEntry&      inEntry)
     {
-        QCASSERT(inClientMutex.IsOwned() && &inClientMutex != &mMutex);
+        QCASSERT(inFdMutex.IsOwned() && &inFdMutex != &mMutex);
         QCStMutexLocker theLocker(mMutex);
         if (++mWaitingCount <= 1 && ! mDoneFlag) {
             QCRTASSERT(! mCondVarPtr);
@@ -139,13 +148,13 @@ public:
             }
         }
         if (! mDoneFlag) {
-            QCStMutexUnlocker theUnlockerClient(inClientMutex);
-            QCASSERT(! inClientMutex.IsOwned());
+            QCStMutexUnlocker theUnlockerFd(inFdMutex);
+            QCASSERT(! inFdMutex.IsOwned());
             while (! mDoneFlag) {
                 QCASSERT(mCondVarPtr);
                 mCondVarPtr->Wait(mMutex);
             }
-            // Release the request completion mutex and re-acquire client mutex,
+            // Release the request completion mutex and re-acquire fd mutex,
             // to maintain the lock acquisition ordering in order to avoid dead
             // lock.
             // Note that there is no race between mWaitingCount decrement below
@@ -175,6 +184,7 @@ public:
             mCondVarPtr->Notify();
         } else {
             if (mCondVarPtr) {
+                QCStMutexLocker theFreeListLocker(mMutex);
                 mCondVarPtr->mNextPtr = ioFreeCondVarsHeadPtr;
                 ioFreeCondVarsHeadPtr = mCondVarPtr;
                 mCondVarPtr = 0;
@@ -215,7 +225,7 @@ public:
         }
     }
     static int64_t Wait(
-        QCMutex&             inClientMutex,
+        QCMutex&             inFdMutex,
         ReadRequestCondVar*& ioFreeCondVarsHeadPtr,
         FileTableEntry&      inEntry,
         int64_t              inOffset,
@@ -229,7 +239,7 @@ public:
             const int64_t theReqEnd   = theReqStart + thePtr->GetSize();
             if (theReqStart < theEndPos && inOffset < theReqEnd) {
                 return thePtr->Wait(
-                    inClientMutex, ioFreeCondVarsHeadPtr, inEntry);
+                    inFdMutex, ioFreeCondVarsHeadPtr, inEntry);
             }
         }
         return 0;
@@ -269,7 +279,7 @@ public:
         Queue::Init(inEntry.mReadQueue);
     }
     static int GetReadAhead(
-        QCMutex&             inClientMutex,
+        QCMutex&             inFdMutex,
         ReadRequestCondVar*& ioFreeCondVarsHeadPtr,
         FileTableEntry&      inEntry,
         void*                inBufPtr,
@@ -289,7 +299,7 @@ public:
         }
         if (inEntry.buffer.mReadReq) {
             const int64_t theRet = inEntry.buffer.mReadReq->Wait(
-                inClientMutex, ioFreeCondVarsHeadPtr, inEntry);
+                inFdMutex, ioFreeCondVarsHeadPtr, inEntry);
             // The last thread leaving wait sets inEntry.buffer.mReadReq to 0,
             // this guarantees that read ahead buffer and result remains valid,
             // and corresponds to the read ahead request that was waited for.
@@ -474,6 +484,151 @@ private:
         const ReadRequest& inReq);
 };
 
+// Vectored read request. All requests issued by a single ReadV() call share
+// the completion mutex, condition and pending count.
+class ReadVRequest : public KfsProtocolWorker::Request
+{
+public:
+    class Batch
+    {
+    public:
+        Batch()
+            : mMutex(),
+              mCond(),
+              mPendingCount(0)
+            {}
+        void Wait()
+        {
+            QCStMutexLocker theLocker(mMutex);
+            while (0 < mPendingCount) {
+                mCond.Wait(mMutex);
+            }
+        }
+    private:
+        QCMutex   mMutex;
+        QCCondVar mCond;
+        int       mPendingCount;
+
+        friend class ReadVRequest;
+    private:
+        Batch(
+            const Batch& inBatch);
+        Batch& operator=(
+            const Batch& inBatch);
+    };
+    ReadVRequest()
+        : Request(),
+          mBatchPtr(0),
+          mTmpBufPtr(0),
+          mFirst(0),
+          mLast(0),
+          mStatus(0)
+        {}
+    virtual ~ReadVRequest()
+        { delete [] mTmpBufPtr; }
+    // Ranges [inFirst, inLast] of the sorted range index are read into the
+    // caller's buffer if there is only one, or into temporary buffer
+    // otherwise.
+    void Init(
+        Batch&                inBatch,
+        const Params&         inOpenParams,
+        FileTableEntry&       inEntry,
+        KfsClient::ReadRange* inRangesPtr,
+        const int*            inIdxPtr,
+        int                   inFirst,
+        int                   inLast,
+        int64_t               inStart,
+        int64_t               inEnd)
+    {
+        mBatchPtr = &inBatch;
+        mFirst    = inFirst;
+        mLast     = inLast;
+        mStatus   = 0;
+        char* theBufPtr;
+        if (inFirst == inLast) {
+            theBufPtr = inRangesPtr[inIdxPtr[inFirst]].buf;
+        } else {
+            theBufPtr = new char[(size_t)(inEnd - inStart)];
+            mTmpBufPtr = theBufPtr;
+        }
+        Reset(
+            KfsProtocolWorker::kRequestTypeReadAsync,
+            inEntry.instance + 1,
+            inEntry.fattr.fileId,
+            &inOpenParams,
+            theBufPtr,
+            (int)(inEnd - inStart),
+            0, // inMaxPending,
+            inStart
+        );
+        inBatch.mPendingCount++;
+    }
+    virtual void Done(
+        int64_t inStatus)
+    {
+        QCStMutexLocker theLocker(mBatchPtr->mMutex);
+        mStatus = inStatus;
+        if (--mBatchPtr->mPendingCount <= 0) {
+            mBatchPtr->mCond.Notify();
+        }
+    }
+    // Sets range status, and copies the data out of the temporary buffer.
+    // Returns the number of bytes read, or the error code.
+    int64_t Complete(
+        KfsClient::ReadRange* inRangesPtr,
+        const int*            inIdxPtr,
+        bool                  inSkipHolesFlag)
+    {
+        const int64_t theStatus =
+            (inSkipHolesFlag && mStatus == -ENOENT) ? 0 : mStatus;
+        int64_t       theRet    = 0;
+        for (int i = mFirst; i <= mLast; i++) {
+            KfsClient::ReadRange& theRange = inRangesPtr[inIdxPtr[i]];
+            if (theStatus < 0) {
+                theRange.status = (ssize_t)theStatus;
+                continue;
+            }
+            const int64_t theOffset = theRange.pos - GetOffset();
+            const int64_t theLen    = max(int64_t(0), min(
+                (int64_t)theRange.size, theStatus - theOffset));
+            if (0 < theLen && mTmpBufPtr) {
+                memcpy(theRange.buf, mTmpBufPtr + theOffset, (size_t)theLen);
+            }
+            theRange.status = (ssize_t)theLen;
+            theRet += theLen;
+        }
+        return (theStatus < 0 ? theStatus : theRet);
+    }
+private:
+    Batch*  mBatchPtr;
+    char*   mTmpBufPtr;
+    int     mFirst;
+    int     mLast;
+    int64_t mStatus;
+private:
+    ReadVRequest(
+        const ReadVRequest& inReq);
+    ReadVRequest& operator=(
+        const ReadVRequest& inReq);
+};
+
+class ReadRangeCompare
+{
+public:
+    ReadRangeCompare(
+        const KfsClient::ReadRange* inRangesPtr)
+        : mRangesPtr(inRangesPtr)
+        {}
+    bool operator()(
+        int inLhs,
+        int inRhs) const
+    {
+        return (mRangesPtr[inLhs].pos < mRangesPtr[inRhs].pos);
+    }
+private:
+    const KfsClient::ReadRange* const mRangesPtr;
+};
+
 void
 KfsClientImpl::InitPendingRead(
     FileTableEntry& inEntry)
@@ -510,15 +665,17 @@ KfsClientImpl::ReadPrefetch(
         return -EINVAL;
     }
 
-    QCStMutexLocker theLocker(mMutex);
+    QCMutex* const  theFdMutexPtr = GetFdMutex(inFd);
+    QCStMutexLocker theLocker(theFdMutexPtr);
 
-    if (! valid_fd(inFd)) {
+    FileTableEntry* const theEntryPtr = GetFdEntry(inFd);
+    if (! theEntryPtr) {
         KFS_LOG_STREAM_ERROR <<
             "read prefetch error invalid fd: " << inFd <<
         KFS_LOG_EOM;
         return -EBADF;
     }
-    FileTableEntry& theEntry = *mFileTable[inFd];
+    FileTableEntry& theEntry = *theEntryPtr;
     if (theEntry.openMode == O_WRONLY ||
             theEntry.currPos.fileOffset < 0 ||
             theEntry.cachedAttrFlag) {
@@ -535,7 +692,7 @@ KfsClientImpl::ReadPrefetch(
             ReadRequest::Find(theEntry, inBufPtr, (int64_t)inSize, theOffset)) {
         return 0;
     }
-    StartProtocolWorker();
+    EnsureProtocolWorker();
     ReadRequest* const theReqPtr = ReadRequest::Create(
         mReadCompletionMutex,
         theEntry,
@@ -550,7 +707,7 @@ KfsClientImpl::ReadPrefetch(
     theEntry.readUsedProtocolWorkerFlag = true;
     const int theRet = theReqPtr->GetSize();
     theLocker.Unlock();
-    QCASSERT(! mMutex.IsOwned());
+    QCASSERT(! theFdMutexPtr->IsOwned());
 
     mProtocolWorker->Enqueue(*theReqPtr);
     return theRet;
@@ -608,21 +765,24 @@ KfsClientImpl::ReadSelf(
     chunkOff_t* inPosPtr,
     bool&       outDirFlag)
 {
-    QCStMutexLocker theLocker(mMutex);
+    QCMutex* const  theFdMutexPtr = GetFdMutex(inFd);
+    QCStMutexLocker theLocker(theFdMutexPtr);
 
     outDirFlag = false;
-    if (! valid_fd(inFd)) {
+    FileTableEntry* const theEntryPtr = GetFdEntry(inFd);
+    if (! theEntryPtr) {
         KFS_LOG_STREAM_ERROR <<
             "read error invalid fd: " << inFd <<
         KFS_LOG_EOM;
         return -EBADF;
     }
-    FileTableEntry& theEntry = *mFileTable[inFd];
+    FileTableEntry& theEntry = *theEntryPtr;
     if (theEntry.openMode == O_WRONLY || theEntry.cachedAttrFlag) {
         return -EINVAL;
     }
     outDirFlag = theEntry.fattr.isDirectory;
     if (outDirFlag) {
+        QCStMutexLocker theClientLocker(mMutex);
         return ReadDirectory(inFd, inBufPtr, inSize);
     }
 
@@ -635,6 +795,7 @@ KfsClientImpl::ReadSelf(
     const KfsProtocolWorker::FileId       theFileId   = theEntry.fattr.fileId;
     const KfsProtocolWorker::FileInstance theInstance = theEntry.instance + 1;
 
+    theEntry.UpdateAsyncWriteFileSize();
     const int64_t kChunkSize       = (int64_t)CHUNKSIZE;
     const int64_t theEof           = ReadRequest::GetEof(theEntry);
     int           theRet           = 0;
@@ -645,6 +806,7 @@ KfsClientImpl::ReadSelf(
     if (theLen <= 0) {
         return 0;
     }
+    UpdateReadAhead(theEntry, thePos, theSize);
     // Wait for prefetch with this buffer, if any.
     ReadRequest* const theReqPtr = ReadRequest::Find(
         theEntry, inBufPtr, (int64_t)inSize, thePos);
@@ -653,7 +815,7 @@ KfsClientImpl::ReadSelf(
         const int64_t theReqPos  = theReqPtr->GetOffset();
         const int     theReqSize = theReqPtr->GetSize();
         int64_t       theRes     = theReqPtr->Wait(
-            mMutex, mFreeCondVarsHead, theEntry);
+            *theFdMutexPtr, mFreeCondVarsHead, theEntry);
         if (theSkipHolesFlag && theRes == -ENOENT) {
             theRes = 0;
         }
@@ -681,7 +843,7 @@ KfsClientImpl::ReadSelf(
         }
         // Request wait releases mutex, ensure that the fd wasn't closed by
         // other thread.
-        if (! valid_fd(inFd) || mFileTable[inFd] != &theEntry ||
+        if (GetFdEntry(inFd) != &theEntry ||
                 theEntry.instance + 1 != theInstance) {
             return theRet;
         }
@@ -704,12 +866,12 @@ KfsClientImpl::ReadSelf(
         ! theEntry.readUsedProtocolWorkerFlag &&
         mProtocolWorker &&
         theEntry.usedProtocolWorkerFlag;
-    StartProtocolWorker();
+    EnsureProtocolWorker();
     theEntry.readUsedProtocolWorkerFlag = true;
 
     bool theShortReadFlag = false;
     const int theRes = ReadRequest::GetReadAhead(
-        mMutex,
+        *theFdMutexPtr,
         mFreeCondVarsHead,
         theEntry,
         inBufPtr + theRet,
@@ -749,7 +911,7 @@ KfsClientImpl::ReadSelf(
             }
         }
         const int theRes = ReadRequest::GetReadAhead(
-            mMutex,
+            *theFdMutexPtr,
             mFreeCondVarsHead,
             theEntry,
             inBufPtr + theRet,
@@ -801,7 +963,7 @@ KfsClientImpl::ReadSelf(
     theOpenParams.mMsgLogId            = inFd;
 
     theLocker.Unlock();
-    QCASSERT(! mMutex.IsOwned());
+    QCASSERT(! theFdMutexPtr->IsOwned());
 
     if (KfsProtocolWorker::kRequestTypeUnknown != theCloseType) {
         KFS_LOG_STREAM_DEBUG <<
@@ -859,8 +1021,8 @@ KfsClientImpl::ReadSelf(
     }
     ReadRequest* theReadAheadReqPtr = 0;
     if (theRet > 0) {
-        QCStMutexLocker theLocker(mMutex);
-        if (! valid_fd(inFd) || mFileTable[inFd] != &theEntry) {
+        QCStMutexLocker theLocker(theFdMutexPtr);
+        if (GetFdEntry(inFd) != &theEntry) {
             return theRet;
         }
         if (theEntry.instance + 1 == theInstance && theFilePos == theFdPos) {
@@ -876,11 +1038,143 @@ KfsClientImpl::ReadSelf(
     return theRet;
 }
 
+ssize_t
+KfsClientImpl::ReadV(
+    int                   inFd,
+    KfsClient::ReadRange* inRangesPtr,
+    int                   inCount)
+{
+    if (inCount < 0 || (0 < inCount && ! inRangesPtr)) {
+        return -EINVAL;
+    }
+    QCMutex* const  theFdMutexPtr = GetFdMutex(inFd);
+    QCStMutexLocker theLocker(theFdMutexPtr);
+
+    FileTableEntry* const theEntryPtr = GetFdEntry(inFd);
+    if (! theEntryPtr) {
+        KFS_LOG_STREAM_ERROR <<
+            "read error invalid fd: " << inFd <<
+        KFS_LOG_EOM;
+        return -EBADF;
+    }
+    FileTableEntry& theEntry = *theEntryPtr;
+    if (theEntry.openMode == O_WRONLY || theEntry.cachedAttrFlag) {
+        return -EINVAL;
+    }
+    if (theEntry.fattr.isDirectory) {
+        return -EISDIR;
+    }
+    theEntry.UpdateAsyncWriteFileSize();
+    const int64_t theEof = ReadRequest::GetEof(theEntry);
+    vector<int>   theIdx;
+    theIdx.reserve(inCount);
+    ssize_t theRet = 0;
+    for (int i = 0; i < inCount; i++) {
+        KfsClient::ReadRange& theRange = inRangesPtr[i];
+        theRange.status = 0;
+        if (theRange.pos < 0 || (! theRange.buf && 0 < theRange.size) ||
+                kMaxReadSize < theRange.size) {
+            theRange.status = -EINVAL;
+            if (0 <= theRet) {
+                theRet = -EINVAL;
+            }
+            continue;
+        }
+        if (theRange.size <= 0 || theEof <= theRange.pos) {
+            continue;
+        }
+        theIdx.push_back(i);
+    }
+    if (theIdx.empty()) {
+        return theRet;
+    }
+    sort(theIdx.begin(), theIdx.end(), ReadRangeCompare(inRangesPtr));
+    // Coalesce ranges. Do not coalesce across the chunk boundaries with
+    // replicated files, in order to issue each read to a single chunk. The
+    // striped file reader splits reads by chunks and chunk servers.
+    const int64_t       theChunkSize      = (int64_t)CHUNKSIZE;
+    const bool          theChunkAlignFlag =
+        theEntry.fattr.striperType == KFS_STRIPED_FILE_TYPE_NONE ||
+        theEntry.fattr.numStripes <= 1;
+    const int64_t       theMaxSize        = min(
+        int64_t(mReadVMaxCoalesceSize), int64_t(kMaxReadSize));
+    const int           theCount          = (int)theIdx.size();
+    ReadVRequest* const theReqsPtr        = new ReadVRequest[theCount];
+    int                 theReqCount       = 0;
+    KfsProtocolWorker::Request::Params theOpenParams;
+    theOpenParams.mPathName            = theEntry.pathname;
+    theOpenParams.mFileSize            = theEntry.fattr.fileSize;
+    theOpenParams.mStriperType         = theEntry.fattr.striperType;
+    theOpenParams.mStripeSize          = theEntry.fattr.stripeSize;
+    theOpenParams.mStripeCount         = theEntry.fattr.numStripes;
+    theOpenParams.mRecoveryStripeCount = theEntry.fattr.numRecoveryStripes;
+    theOpenParams.mReplicaCount        = theEntry.fattr.numReplicas;
+    theOpenParams.mSkipHolesFlag       = theEntry.skipHoles;
+    theOpenParams.mFailShortReadsFlag  = theEntry.failShortReadsFlag;
+    theOpenParams.mMsgLogId            = inFd;
+    ReadVRequest::Batch theBatch;
+    for (int i = 0; i < theCount; ) {
+        const KfsClient::ReadRange& theRange = inRangesPtr[theIdx[i]];
+        const int64_t theStart = theRange.pos;
+        int64_t       theEnd   = min(theEof,
+            theStart + (int64_t)theRange.size);
+        const int64_t theChunkEnd = theChunkAlignFlag ?
+            theStart - theStart % theChunkSize + theChunkSize : theEof;
+        const int     theFirst = i;
+        while (++i < theCount) {
+            const KfsClient::ReadRange& theNext = inRangesPtr[theIdx[i]];
+            const int64_t theNextEnd = min(theEof,
+                theNext.pos + (int64_t)theNext.size);
+            if (theEnd + mReadVCoalesceGap < theNext.pos ||
+                    theChunkEnd < theNextEnd ||
+                    theMaxSize < max(theEnd, theNextEnd) - theStart) {
+                break;
+            }
+            theEnd = max(theEnd, theNextEnd);
+        }
+        theReqsPtr[theReqCount++].Init(
+            theBatch,
+            theOpenParams,
+            theEntry,
+            inRangesPtr,
+            &theIdx[0],
+            theFirst,
+            i - 1,
+            theStart,
+            theEnd
+        );
+    }
+    EnsureProtocolWorker();
+    theEntry.readUsedProtocolWorkerFlag = true;
+    const bool theSkipHolesFlag = theEntry.skipHoles;
+    theLocker.Unlock();
+    QCASSERT(! theFdMutexPtr->IsOwned());
+
+    for (int i = 0; i < theReqCount; i++) {
+        mProtocolWorker->Enqueue(theReqsPtr[i]);
+    }
+    theBatch.Wait();
+    for (int i = 0; i < theReqCount; i++) {
+        const int64_t theStatus = theReqsPtr[i].Complete(
+            inRangesPtr, &theIdx[0], theSkipHolesFlag);
+        if (theStatus < 0) {
+            if (0 <= theRet) {
+                theRet = (ssize_t)theStatus;
+            }
+        } else if (0 <= theRet) {
+            theRet += (ssize_t)theStatus;
+        }
+    }
+    delete [] theReqsPtr;
+    return theRet;
+}
+
 ssize_t
 KfsClientImpl::SetReadAheadSize(
     int    inFd,
     size_t inSize)
 {
+    QCStMutexLocker theFdLocker(GetFdMutex(inFd));
     QCStMutexLocker theLocker(mMutex);
     if (! valid_fd(inFd)) {
         KFS_LOG_STREAM_ERROR <<
@@ -888,6 +1182,7 @@ KfsClientImpl::SetReadAheadSize(
         KFS_LOG_EOM;
         return -EBADF;
     }
+    mFileTable[inFd]->readAhead.fixedFlag = true;
     return SetReadAheadSize(*mFileTable[inFd], inSize);
 }
 
@@ -914,13 +1209,100 @@ KfsClientImpl::SetReadAheadSize(
             theStride - 1) / theStride * theStride;
     }
     inEntry.buffer.SetBufSize(theSize);
+    inEntry.readAhead.Reset(inEntry.buffer.GetBufSize());
     return inEntry.buffer.GetBufSize();
 }
 
+void
+KfsClientImpl::UpdateReadAhead(
+    FileTableEntry& inEntry,
+    int64_t         inPos,
+    int             inSize)
+{
+    // Classify the access pattern by comparing the read with the previous
+    // one. Sequential stream grows read-ahead window by doubling it, up to
+    // the configured maximum rounded up to the full stripe for striped files.
+    // As the reader splits read-ahead request into chunk and stripe reads,
+    // large window keeps multiple chunk server requests in flight. Random
+    // access turns read-ahead off.
+    const int kMinSequentialCount = 2;
+    const int kMinRandomCount     = 2;
+
+    ReadAheadState& theState = inEntry.readAhead;
+    if (mReadAheadMaxSize <= 0 || theState.fixedFlag ||
+            theState.baseSize <= 0) {
+        return;
+    }
+    const int64_t thePrevPos = theState.prevPos;
+    const int64_t thePrevEnd = theState.prevEnd;
+    theState.prevPos = inPos;
+    theState.prevEnd = inPos + inSize;
+    if (thePrevPos < 0) {
+        return;
+    }
+    const int theCurSize = inEntry.buffer.GetBufSize();
+    int       theNewSize = theCurSize;
+    if (inPos == thePrevEnd) {
+        SyncAddAndFetch(mReadAheadCounters.mSequentialCount, int64_t(1));
+        theState.stride      = 0;
+        theState.randomCount = 0;
+        if (kMinSequentialCount <= ++theState.seqCount) {
+            int64_t         theMaxSize = mReadAheadMaxSize;
+            const FileAttr& theAttr    = inEntry.fattr;
+            if (theAttr.striperType != KFS_STRIPED_FILE_TYPE_NONE &&
+                    0 < theAttr.stripeSize && 0 < theAttr.numStripes) {
+                const int64_t theStride =
+                    (int64_t)theAttr.stripeSize * theAttr.numStripes;
+                theMaxSize = (theMaxSize + theStride - 1) /
+                    theStride * theStride;
+            }
+            theMaxSize = min(max(theMaxSize, (int64_t)theState.baseSize),
+                (int64_t)numeric_limits<int>::max());
+            theNewSize = theCurSize < theState.baseSize ?
+                theState.baseSize :
+                (int)min(2 * (int64_t)theCurSize, theMaxSize);
+        }
+    } else {
+        theState.seqCount = 0;
+        const int64_t theStride = inPos - thePrevPos;
+        if (theStride == theState.stride) {
+            SyncAddAndFetch(mReadAheadCounters.mStridedCount, int64_t(1));
+            theState.randomCount = 0;
+            // Short forward strides are served from the read-ahead buffer,
+            // with longer strides most of the read-ahead data is skipped.
+            theNewSize = (0 < theStride && theStride <= theState.baseSize) ?
+                max(theCurSize, theState.baseSize) : 0;
+        } else {
+            SyncAddAndFetch(mReadAheadCounters.mRandomCount, int64_t(1));
+            theState.stride = theStride;
+            if (kMinRandomCount <= ++theState.randomCount) {
+                theNewSize = 0;
+            }
+        }
+    }
+    if (theNewSize == theCurSize) {
+        return;
+    }
+    SyncAddAndFetch(theCurSize < theNewSize ?
+        mReadAheadCounters.mGrowCount : mReadAheadCounters.mShrinkCount,
+        int64_t(1));
+    KFS_LOG_STREAM_DEBUG <<
+        "read ahead: " << inEntry.fattr.fileId <<
+        " pos: "       << inPos <<
+        " size: "      << inSize <<
+        " window: "    << theCurSize <<
+        " => "         << theNewSize <<
+    KFS_LOG_EOM;
+    // Buffer re-allocation takes place with the next read-ahead request,
+    // the data that is still in the buffer remains available until then.
+    inEntry.buffer.SetBufSize(theNewSize);
+}
+
 ssize_t
 KfsClientImpl::GetReadAheadSize(
     int inFd) const
 {
+    QCStMutexLocker theFdLocker(GetFdMutex(inFd));
     QCStMutexLocker theLocker(const_cast<KfsClientImpl*>(this)->mMutex);
 
     if (! valid_fd(inFd)) {
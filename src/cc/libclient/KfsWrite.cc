@@ -108,15 +108,17 @@ ssize_t
 KfsClientImpl::WriteSelf(int fd, const char* buf, size_t numBytes,
     bool asyncFlag, bool appendOnlyFlag, chunkOff_t* pos)
 {
-    QCStMutexLocker lock(mMutex);
+    QCMutex* const  fdMutex = GetFdMutex(fd);
+    QCStMutexLocker lock(fdMutex);
 
-    if (! valid_fd(fd)) {
+    FileTableEntry* const entryPtr = GetFdEntry(fd);
+    if (! entryPtr) {
         KFS_LOG_STREAM_ERROR <<
             "write error invalid fd: " << fd <<
         KFS_LOG_EOM;
         return -EBADF;
     }
-    FileTableEntry& entry = *mFileTable[fd];
+    FileTableEntry& entry = *entryPtr;
     if (entry.openMode == O_RDONLY) {
         return -EINVAL;
     }
@@ -157,53 +159,16 @@ KfsClientImpl::WriteSelf(int fd, const char* buf, size_t numBytes,
         }
         filePos += numBytes;
     }
-    StartProtocolWorker();
+    EnsureProtocolWorker();
     KfsProtocolWorker::Request::Params        openParams;
     KfsProtocolWorker::Request::Params* const openParamsPtr =
         entry.usedProtocolWorkerFlag ? 0 : &openParams;
     if (openParamsPtr) {
-        if (0 < entry.fattr.fileSize &&
-                (KFS_STRIPED_FILE_TYPE_NONE != entry.fattr.striperType ||
-                0 == entry.fattr.numReplicas)) {
-            // Re-validate file size, in case truncate was issued, as for
-            // striped and object store files logical EOF has to be updated
-            // explicitly on close.
-            const FAttr* const fa = LookupFAttr(entry.fattr.fileId, entry.name);
-            if (! fa || fa->fileId != entry.fattr.fileId ||
-                    ! IsValid(*fa, time(0))) {
-                KfsFileAttr attr;
-                const bool computeFileSizeFlag = false;
-                const int ret = StatSelf(
-                    entry.pathname.c_str(), attr, computeFileSizeFlag);
-                if (0 == ret && entry.fattr.fileId == attr.fileId &&
-                        ! attr.isDirectory) {
-                    entry.fattr.fileSize = attr.fileSize;
-                }
-            } else {
-                entry.fattr.fileSize = fa->fileSize;
-            }
-        }
-        openParams.mPathName            = entry.pathname;
-        openParams.mFileSize            = entry.fattr.fileSize;
-        openParams.mStriperType         = entry.fattr.striperType;
-        openParams.mStripeSize          = entry.fattr.stripeSize;
-        openParams.mStripeCount         = entry.fattr.numStripes;
-        openParams.mRecoveryStripeCount = entry.fattr.numRecoveryStripes;
-        openParams.mReplicaCount        = entry.fattr.numReplicas;
-        openParams.mMsgLogId            = fd;
-        if(entry.fattr.striperType == KFS_STRIPED_FILE_TYPE_NONE) {
-            openParams.mDiskIoSize = entry.ioBufferSize;
-        } else {
-            const int kChecksumBlockSize = (int)CHECKSUM_BLOCKSIZE;
-            const int totalStripeCount   =
-               entry.fattr.numStripes + entry.fattr.numRecoveryStripes;
-            openParams.mDiskIoSize = (entry.ioBufferSize / totalStripeCount
-               + kChecksumBlockSize - 1) /
-               kChecksumBlockSize * kChecksumBlockSize;
-        }
+        InitWriteOpenParams(fd, entry, openParams);
     }
     entry.usedProtocolWorkerFlag = true;
     entry.pending += numBytes;
+    mProtocolWorker->InvalidateBlockCache(entry.fattr.fileId);
     const KfsProtocolWorker::FileId       fileId       = entry.fattr.fileId;
     const KfsProtocolWorker::FileInstance fileInstance = entry.instance;
     const string                          pathName     = entry.pathname;
@@ -256,12 +221,12 @@ KfsClientImpl::WriteSelf(int fd, const char* buf, size_t numBytes,
         return (ssize_t)status;
     }
     if (throttle && status > 0) {
-        QCStMutexLocker lock(mMutex);
+        QCStMutexLocker lock(fdMutex);
         // File can be closed by other thread, fd entry can be re-used.
         // In this cases close / sync should have returned the corresponding
         // status.
         // Throttle returns current number of bytes pending.
-        if (valid_fd(fd) && &entry == mFileTable[fd] &&
+        if (&entry == GetFdEntry(fd) &&
                 entry.instance == fileInstance) {
             KFS_LOG_STREAM_DEBUG <<
                 fd << "," << fileId << "," << fileInstance << "," << pathName <<
@@ -279,4 +244,50 @@ KfsClientImpl::WriteSelf(int fd, const char* buf, size_t numBytes,
     return numBytes;
 }
 
+void
+KfsClientImpl::InitWriteOpenParams(int fd, FileTableEntry& entry,
+    KfsProtocolWorker::Request::Params& openParams)
+{
+    if (0 < entry.fattr.fileSize &&
+            (KFS_STRIPED_FILE_TYPE_NONE != entry.fattr.striperType ||
+            0 == entry.fattr.numReplicas)) {
+        // Re-validate file size, in case truncate was issued, as for
+        // striped and object store files logical EOF has to be updated
+        // explicitly on close.
+        QCStMutexLocker clientLock(mMutex);
+        const FAttr* const fa = LookupFAttr(entry.fattr.fileId, entry.name);
+        if (! fa || fa->fileId != entry.fattr.fileId ||
+                ! IsValid(*fa, time(0))) {
+            KfsFileAttr attr;
+            const bool computeFileSizeFlag = false;
+            const int ret = StatSelf(
+                entry.pathname.c_str(), attr, computeFileSizeFlag);
+            if (0 == ret && entry.fattr.fileId == attr.fileId &&
+                    ! attr.isDirectory) {
+                entry.fattr.fileSize = attr.fileSize;
+            }
+        } else {
+            entry.fattr.fileSize = fa->fileSize;
+        }
+    }
+    openParams.mPathName            = entry.pathname;
+    openParams.mFileSize            = entry.fattr.fileSize;
+    openParams.mStriperType         = entry.fattr.striperType;
+    openParams.mStripeSize          = entry.fattr.stripeSize;
+    openParams.mStripeCount         = entry.fattr.numStripes;
+    openParams.mRecoveryStripeCount = entry.fattr.numRecoveryStripes;
+    openParams.mReplicaCount        = entry.fattr.numReplicas;
+    openParams.mMsgLogId            = fd;
+    if(entry.fattr.striperType == KFS_STRIPED_FILE_TYPE_NONE) {
+        openParams.mDiskIoSize = entry.ioBufferSize;
+    } else {
+        const int kChecksumBlockSize = (int)CHECKSUM_BLOCKSIZE;
+        const int totalStripeCount   =
+           entry.fattr.numStripes + entry.fattr.numRecoveryStripes;
+        openParams.mDiskIoSize = (entry.ioBufferSize / totalStripeCount
+           + kChecksumBlockSize - 1) /
+           kChecksumBlockSize * kChecksumBlockSize;
+    }
+}
+
 }}
@@ -26,6 +26,7 @@
 #include "RSStriper.h"
 #include "Writer.h"
 #include "ECMethod.h"
+#include "ECComputePool.h"
 
 #include "kfsio/IOBuffer.h"
 #include "kfsio/checksum.h"
@@ -415,6 +416,12 @@ public:
                 Write(mBuffersPtr[i]);
             }
         }
+        if (0 < mRecoveryStripeCount && 0 < GetWriteBehindSize() &&
+                1 < inWriteThreshold &&
+                mOffset - mRecoveryEndPos < max(1, GetWriteThreshold())) {
+            WriteBehind();
+            return 0;
+        }
         if (mOffset - mRecoveryEndPos < max(1, inWriteThreshold)) {
             Flush(inWriteThreshold);
             return 0;
@@ -777,6 +784,32 @@ private:
             " cur: "     << theCurThreshold <<
         KFS_LOG_EOM;
     }
+    void WriteBehind()
+    {
+        // Keep the partial stride until it is complete, or until flush or
+        // close, in order to encode each stride only once. Write encoded full
+        // strides into all data and recovery chunks at once, when the write
+        // behind size or write threshold is reached. The partial stride is
+        // less than the write threshold, therefore the pending size drops
+        // below the threshold once the queued writes complete.
+        const Offset thePartialSize = mOffset - mRecoveryEndPos;
+        const Offset theEncodedSize = mPendingCount - thePartialSize;
+        const int    theThreshold   = max(1, GetWriteThreshold());
+        if (theEncodedSize <= 0 || (
+                theEncodedSize < min(GetWriteBehindSize(), theThreshold) &&
+                mPendingCount < theThreshold)) {
+            return;
+        }
+        KFS_LOG_STREAM_DEBUG << mLogPrefix <<
+            "write behind:"
+            " encoded: " << theEncodedSize <<
+            " partial: " << thePartialSize <<
+            " thresh: "  << theThreshold <<
+        KFS_LOG_EOM;
+        for (int i = 0; i < mStripeCount + mRecoveryStripeCount; i++) {
+            Write(mBuffersPtr[i]);
+        }
+    }
     bool ComputeRecovery(
         int* ioPaddSizeWriteFrontTrimPtr = 0)
     {
@@ -889,8 +922,12 @@ private:
                     " len: " << theLen <<
                 KFS_LOG_EOM;
             }
-            const int theStatus = mEncoderPtr->Encode(
-                mStripeCount, mRecoveryStripeCount, theLen, mBufPtr);
+            ECComputePool* const thePoolPtr = GetComputePool();
+            const int theStatus = thePoolPtr ?
+                thePoolPtr->Encode(*mEncoderPtr,
+                    mStripeCount, mRecoveryStripeCount, theLen, mBufPtr) :
+                mEncoderPtr->Encode(
+                    mStripeCount, mRecoveryStripeCount, theLen, mBufPtr);
             if (theStatus != 0) {
                 KFS_LOG_STREAM_ERROR << mLogPrefix <<
                     "recovery:"
@@ -3516,13 +3553,23 @@ private:
                     " of: "   << theSize                <<
                 KFS_LOG_EOM;
             }
-            const int theRet = mDecoderPtr->Decode(
-                mStripeCount,
-                mRecoveryStripeCount,
-                max(theLen, (int)kAlign),
-                mBufPtr,
-                theMissingIdx
-            );
+            ECComputePool* const thePoolPtr = GetComputePool();
+            const int theRet = thePoolPtr ?
+                thePoolPtr->Decode(
+                    *mDecoderPtr,
+                    mStripeCount,
+                    mRecoveryStripeCount,
+                    max(theLen, (int)kAlign),
+                    mBufPtr,
+                    theMissingIdx
+                ) :
+                mDecoderPtr->Decode(
+                    mStripeCount,
+                    mRecoveryStripeCount,
+                    max(theLen, (int)kAlign),
+                    mBufPtr,
+                    theMissingIdx
+                );
             if (theRet != 0) {
                 KFS_LOG_STREAM_ERROR << mLogPrefix        <<
                     "read reocvery decode failure"
@@ -30,9 +30,13 @@
 #include "kfsio/checksum.h"
 #include "kfsio/ITimeout.h"
 #include "kfsio/ClientAuthContext.h"
+#include "kfsio/NetConnection.h"
+#include "kfsio/TcpSocket.h"
+#include "kfsio/DescriptorPassingFilter.h"
 
 #include "common/kfsdecls.h"
 #include "common/MsgLogger.h"
+#include "common/time.h"
 
 #include "qcdio/QCUtils.h"
 #include "qcdio/qcstutils.h"
@@ -44,6 +48,8 @@
 #include "KfsClient.h"
 #include "RSStriper.h"
 #include "ClientPool.h"
+#include "ReplicaSelector.h"
+#include "BlockCache.h"
 #include "Monitor.h"
 
 #include <sstream>
@@ -51,7 +57,13 @@
 #include <cerrno>
 #include <sstream>
 #include <limits>
+#include <map>
 #include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #if __cplusplus >= 201103L
 #include <random>
@@ -70,6 +82,7 @@ using std::ostringstream;
 using std::vector;
 using std::pair;
 using std::make_pair;
+using std::map;
 #if __cplusplus < 201103L
 using std::random_shuffle;
 #else
@@ -83,6 +96,7 @@ class Reader::Impl : public QCRefCountedObj
 {
 public:
     typedef QCRefCountedObj::StRef StRef;
+    typedef map<ServerLocation, time_t> LocalReadRemoteServers;
 
     enum
     {
@@ -111,8 +125,12 @@ public:
         int         inLeaseRetryTimeout,
         int         inLeaseWaitTimeout,
         string      inLogPrefix,
-        int64_t     inChunkServerInitialSeqNum,
-        ClientPool* inClientPoolPtr)
+        int64_t          inChunkServerInitialSeqNum,
+        ClientPool*      inClientPoolPtr,
+        ReplicaSelector* inReplicaSelectorPtr,
+        bool             inLocalReadFlag,
+        ECComputePool*   inComputePoolPtr,
+        BlockCache*      inBlockCachePtr)
         : QCRefCountedObj(),
           mOuter(inOuter),
           mMetaServer(inMetaServer),
@@ -134,6 +152,13 @@ public:
           mOpenChunkBlockSize(0),
           mChunkServerInitialSeqNum(inChunkServerInitialSeqNum),
           mClientPoolPtr(inClientPoolPtr),
+          mReplicaSelectorPtr(
+            (inReplicaSelectorPtr && inReplicaSelectorPtr->IsEnabled()) ?
+            inReplicaSelectorPtr : 0),
+          mLocalReadFlag(inLocalReadFlag),
+          mLocalReadRemoteServers(),
+          mComputePoolPtr(inComputePoolPtr),
+          mBlockCachePtr(inBlockCachePtr),
           mCompletionPtr(inCompletionPtr),
           mLogPrefix(inLogPrefix),
           mStats(),
@@ -345,6 +370,8 @@ private:
             typedef vector<RequestEntry> Requests;
 
             time_t    mOpStartTime;
+            int64_t   mStartUsec;
+            ReplicaSelector::Entry* mSelectorEntryPtr;
             IOBuffer  mBuffer;
             IOBuffer  mTmpBuffer;
             RequestId mRequestId;
@@ -353,6 +380,8 @@ private:
             bool      mRetryIfFailsFlag;
             bool      mFailShortReadFlag;
             bool      mCancelFlag;
+            bool      mLocalReadFlag;
+            bool      mCacheReadFlag;
 
             ReadOp(
                 int       inOpSize,
@@ -363,6 +392,8 @@ private:
                 bool      inFailShortReadFlag)
                 : KFS::client::ReadOp(-1, -1, -1),
                   mOpStartTime(0),
+                  mStartUsec(0),
+                  mSelectorEntryPtr(0),
                   mBuffer(),
                   mTmpBuffer(),
                   mRequestId(inRequestId),
@@ -370,7 +401,9 @@ private:
                   mRequests(),
                   mRetryIfFailsFlag(inRetryIfFailsFlag),
                   mFailShortReadFlag(inFailShortReadFlag),
-                  mCancelFlag(false)
+                  mCancelFlag(false),
+                  mLocalReadFlag(false),
+                  mCacheReadFlag(false)
             {
                 Queue::Init(*this);
                 numBytes                   = inOpSize;
@@ -396,6 +429,164 @@ private:
             ReadOp& operator=(
                 const ReadOp& inOp);
         };
+        // Exchanges local read handle for the chunk file descriptor over the
+        // chunk server's unix domain socket.
+        class LocalReadFdReceiver : public KfsCallbackObj
+        {
+        public:
+            LocalReadFdReceiver(
+                ChunkReader& inReader)
+                : KfsCallbackObj(),
+                  mReader(inReader),
+                  mConnPtr(),
+                  mFilter()
+                { SET_HANDLER(this, &LocalReadFdReceiver::EventHandler); }
+            ~LocalReadFdReceiver()
+                { LocalReadFdReceiver::Cancel(); }
+            int Start(
+                NetManager&   inNetManager,
+                const string& inPath,
+                int64_t       inHandle,
+                int           inTimeoutSec)
+            {
+                QCASSERT(! mConnPtr);
+                struct sockaddr_un theAddr;
+                memset(&theAddr, 0, sizeof(theAddr));
+                if (sizeof(theAddr.sun_path) <= inPath.size()) {
+                    return -ENAMETOOLONG;
+                }
+                theAddr.sun_family = AF_UNIX;
+                memcpy(theAddr.sun_path, inPath.data(), inPath.size());
+                const int theFd = socket(AF_UNIX, SOCK_STREAM, 0);
+                if (theFd < 0) {
+                    return (0 < errno ? -errno : -EINVAL);
+                }
+                fcntl(theFd, F_SETFD, FD_CLOEXEC);
+                // Unix domain socket connect does not block, it fails with
+                // EAGAIN if the server's listen queue is full.
+                if (fcntl(theFd, F_SETFL, O_NONBLOCK) ||
+                        connect(theFd,
+                            reinterpret_cast<const struct sockaddr*>(&theAddr),
+                            sizeof(theAddr))) {
+                    const int theErr = errno;
+                    close(theFd);
+                    return (0 < theErr ? -theErr : -EIO);
+                }
+                mConnPtr.reset(new NetConnection(
+                    new TcpSocket(theFd, TcpSocket::kTypeUnix), this));
+                mConnPtr->SetFilter(&mFilter, 0);
+                mConnPtr->SetMaxReadAhead((int)sizeof(int32_t));
+                mConnPtr->SetInactivityTimeout(inTimeoutSec);
+                mConnPtr->GetOutBuffer().CopyIn(
+                    reinterpret_cast<const char*>(&inHandle),
+                    (int)sizeof(inHandle));
+                // The request is sent by the net manager, the completion is
+                // never invoked from this method.
+                inNetManager.AddConnection(mConnPtr);
+                return 0;
+            }
+            bool Cancel()
+            {
+                if (! mConnPtr) {
+                    return false;
+                }
+                Close();
+                return true;
+            }
+            int EventHandler(
+                int   inCode,
+                void* inDataPtr)
+            {
+                int theStatus;
+                switch (inCode) {
+                    case EVENT_NET_READ: {
+                        QCASSERT(&mConnPtr->GetInBuffer() == inDataPtr);
+                        IOBuffer& theBuf        = mConnPtr->GetInBuffer();
+                        int32_t   theRespStatus = -EIO;
+                        if (theBuf.BytesConsumable() <
+                                (int)sizeof(theRespStatus)) {
+                            return 0;
+                        }
+                        theBuf.CopyOut(reinterpret_cast<char*>(&theRespStatus),
+                            (int)sizeof(theRespStatus));
+                        theBuf.Clear();
+                        // The descriptor is received with the first byte.
+                        const int theFd = mFilter.DetachReceivedFd();
+                        if (theRespStatus == 0 && 0 <= theFd) {
+                            theStatus = theFd;
+                        } else {
+                            if (0 <= theFd) {
+                                close(theFd);
+                            }
+                            theStatus = theRespStatus < 0 ?
+                                theRespStatus : -EIO;
+                        }
+                        break;
+                    }
+                    case EVENT_NET_WROTE:
+                        return 0;
+                    case EVENT_NET_ERROR:
+                        theStatus = mConnPtr->GetErrorCode();
+                        if (0 <= theStatus) {
+                            theStatus = -EIO;
+                        }
+                        break;
+                    case EVENT_INACTIVITY_TIMEOUT:
+                        theStatus = -ETIMEDOUT;
+                        break;
+                    default:
+                        QCRTASSERT(! "unexpected event");
+                        return 0;
+                }
+                Close();
+                if (theStatus < 0) {
+                    KFS_LOG_STREAM_INFO << mReader.mLogPrefix <<
+                        "local read: " << mReader.mLocalReadOp.localReadPath <<
+                        " chunk: "     << mReader.mLocalReadOp.chunkId <<
+                        " "            << QCUtils::SysError(-theStatus) <<
+                    KFS_LOG_EOM;
+                }
+                mReader.LocalReadFdDone(theStatus);
+                return 0;
+            }
+        private:
+            ChunkReader&            mReader;
+            NetConnectionPtr        mConnPtr;
+            DescriptorPassingFilter mFilter;
+
+            void Close()
+            {
+                mConnPtr->Close();
+                mConnPtr.reset();
+                const int theFd = mFilter.DetachReceivedFd();
+                if (0 <= theFd) {
+                    close(theFd);
+                }
+            }
+        private:
+            LocalReadFdReceiver(
+                const LocalReadFdReceiver& inReceiver);
+            LocalReadFdReceiver& operator=(
+                const LocalReadFdReceiver& inReceiver);
+        };
+        class LocalReadDoneTimer : public ITimeout
+        {
+        public:
+            LocalReadDoneTimer(
+                ChunkReader& inReader)
+                : ITimeout(),
+                  mReader(inReader)
+                {}
+            virtual void Timeout()
+                { mReader.LocalReadDoneTimeout(); }
+        private:
+            ChunkReader& mReader;
+        private:
+            LocalReadDoneTimer(
+                const LocalReadDoneTimer& inTimer);
+            LocalReadDoneTimer& operator=(
+                const LocalReadDoneTimer& inTimer);
+        };
 
         ChunkReader(
             Impl&         inOuter,
@@ -417,14 +608,13 @@ private:
                 // Just fail the op. Error handler will reset connection and
                 // cancel all pending ops by calling Stop()
                 false, // inResetConnectionOnOpTimeoutFlag
-                // Allow some slack and ensure that content size limit is
-                // reasonably large.
-                int(min(
-                    int64_t(inOuter.mMaxReadSize) + (64 << 10),
-                    int64_t(std::numeric_limits<int>::max())
-                ))
+                GetMaxContentLength(inOuter)
               ),
               mChunkServerPtr(0),
+              mOwnHedgeChunkServerPtr(0),
+              mHedgeChunkServerPtr(0),
+              mHedgedOpPtr(0),
+              mHedgeWonOpPtr(0),
               mErrorCode(0),
               mRetryCount(0),
               mOpenChunkBlockFileOffset(-1),
@@ -434,6 +624,17 @@ private:
               mLeaseRenewOp(0, -1, 0, ""),
               mLeaseRelinquishOp(0, -1, 0),
               mSizeOp(0, -1, 0),
+              mLocalReadOp(0, -1, false),
+              mLocalReadBuffer(),
+              mLocalReadChecksums(),
+              mLocalReadScratch(),
+              mLocalReadFd(-1),
+              mLocalReadHeaderSize(0),
+              mLocalReadDisabledFlag(false),
+              mLocalReadFdReceiver(*this),
+              mLocalReadDoneTimer(*this),
+              mLocalReadDoneCount(0),
+              mLocalReadDoneUsec(0),
               mChunkServerAccess(),
               mChunkAccess(),
               mLastOpPtr(0),
@@ -444,7 +645,9 @@ private:
               mLeaseWaitStartTime(0),
               mChunkServerAccessExpires(0),
               mLeaseRetryCount(0),
+              mHedgeCount(0),
               mSleepingFlag(false),
+              mHedgeTimerFlag(false),
               mClosingFlag(false),
               mChunkServerSetFlag(false),
               mNoCSAccessFlag(false),
@@ -460,6 +663,7 @@ private:
             Queue::Init(mPendingQueue);
             Queue::Init(mInFlightQueue);
             Queue::Init(mCompletionQueue);
+            Queue::Init(mHedgeQueue);
             Readers::Init(*this);
             Readers::PushFront(mOuter.mReaders, *this);
             mChunkServer.SetRetryConnectOnly(true);
@@ -477,6 +681,13 @@ private:
             ChunkServer::Stats theStats;
             mChunkServer.GetStats(theStats);
             mOuter.mChunkServersStats.Add(theStats);
+            if (mOwnHedgeChunkServerPtr) {
+                theStats.Clear();
+                mOwnHedgeChunkServerPtr->Stop();
+                mOwnHedgeChunkServerPtr->GetStats(theStats);
+                mOuter.mChunkServersStats.Add(theStats);
+                delete mOwnHedgeChunkServerPtr;
+            }
             Readers::Remove(mOuter.mReaders, *this);
             if (mDeletedFlagPtr) {
                 *mDeletedFlagPtr = true;
@@ -780,6 +991,10 @@ private:
         Impl&                mOuter;
         ChunkServer          mChunkServer;
         ChunkServer*         mChunkServerPtr;
+        ChunkServer*         mOwnHedgeChunkServerPtr;
+        ChunkServer*         mHedgeChunkServerPtr;
+        ReadOp*              mHedgedOpPtr;
+        ReadOp*              mHedgeWonOpPtr;
         int                  mErrorCode;
         int                  mRetryCount;
         Offset               mOpenChunkBlockFileOffset;
@@ -789,6 +1004,17 @@ private:
         LeaseRenewOp         mLeaseRenewOp;
         LeaseRelinquishOp    mLeaseRelinquishOp;
         SizeOp               mSizeOp;
+        GetChunkMetadataOp   mLocalReadOp;
+        IOBuffer             mLocalReadBuffer;
+        vector<uint32_t>     mLocalReadChecksums;
+        vector<char>         mLocalReadScratch;
+        int                  mLocalReadFd;
+        int                  mLocalReadHeaderSize;
+        bool                 mLocalReadDisabledFlag;
+        LocalReadFdReceiver  mLocalReadFdReceiver;
+        LocalReadDoneTimer   mLocalReadDoneTimer;
+        int                  mLocalReadDoneCount;
+        int64_t              mLocalReadDoneUsec;
         ChunkServerAccess    mChunkServerAccess;
         ChunkServerAccess    mChunkAccess;
         KfsOp*               mLastOpPtr;
@@ -799,7 +1025,9 @@ private:
         time_t               mLeaseWaitStartTime;
         time_t               mChunkServerAccessExpires;
         int                  mLeaseRetryCount;
+        int                  mHedgeCount;
         bool                 mSleepingFlag;
+        bool                 mHedgeTimerFlag;
         bool                 mClosingFlag;
         bool                 mChunkServerSetFlag;
         bool                 mNoCSAccessFlag;
@@ -814,6 +1042,7 @@ private:
         ReadOp*              mPendingQueue[1];
         ReadOp*              mInFlightQueue[1];
         ReadOp*              mCompletionQueue[1];
+        ReadOp*              mHedgeQueue[1];
         ChunkReader*         mPrevPtr[1];
         ChunkReader*         mNextPtr[1];
 
@@ -922,11 +1151,7 @@ private:
             }
             if (! mChunkServerSetFlag) {
                 QCASSERT(mChunkServerIdx < mGetAllocOp.chunkServers.size());
-                const bool theCSClearTextAllowedFlag =
-                    mOuter.IsChunkServerClearTextAllowed();
                 mChunkServerSetFlag = true;
-                mNoCSAccessFlag     = ! theCSClearTextAllowedFlag ||
-                    ! mLeaseAcquireOp.allowCSClearTextFlag;
                 const ServerLocation& theLocation =
                     mGetAllocOp.chunkServers[mChunkServerIdx];
                 if (mOuter.mClientPoolPtr) {
@@ -938,48 +1163,8 @@ private:
                         KfsNetClient::kRpcFormatShort :
                         KfsNetClient::kRpcFormatLong);
                 }
-                mChunkServerPtr->SetShutdownSsl(
-                    mLeaseAcquireOp.allowCSClearTextFlag &&
-                    theCSClearTextAllowedFlag
-                );
-                if (mChunkServerAccess.IsEmpty()) {
-                    mChunkServerPtr->SetKey(0, 0, 0, 0);
-                    mChunkServerPtr->SetAuthContext(0);
-                    mSizeOp.access.clear();
-                } else {
-                    CryptoKeys::Key theKey;
-                    const ChunkServerAccess::Entry* const thePtr =
-                        mChunkServerAccess.Get(
-                            theLocation,
-                            mGetAllocOp.chunkId,
-                            theKey
-                        );
-                    if (thePtr) {
-                        mChunkServerPtr->SetKey(
-                            thePtr->chunkServerAccessId.mPtr,
-                            thePtr->chunkServerAccessId.mLen,
-                            theKey.GetPtr(),
-                            theKey.GetSize()
-                        );
-                        if (mChunkAccess.IsEmpty()) {
-                            mSizeOp.access.assign(
-                                thePtr->chunkAccess.mPtr,
-                                thePtr->chunkAccess.mLen
-                            );
-                        } else {
-                            mSizeOp.access = mChunkAccess.GetChunkAccess(
-                                theLocation, mGetAllocOp.chunkId);
-                        }
-                        mNoCSAccessFlag = mSizeOp.access.empty();
-                    } else {
-                        mNoCSAccessFlag = true;
-                    }
-                    if (! mNoCSAccessFlag &&
-                            ! mChunkServerPtr->GetAuthContext()) {
-                        mChunkServerPtr->SetAuthContext(
-                            mOuter.mMetaServer.GetAuthContext());
-                    }
-                }
+                mNoCSAccessFlag = ! SetChunkServerAccess(
+                    *mChunkServerPtr, theLocation, mSizeOp.access);
                 if (mNoCSAccessFlag) {
                     mChunkServer.SetKey(0, 0, 0, 0);
                     mChunkServer.SetAuthContext(0);
@@ -1020,6 +1205,60 @@ private:
                 }
             }
         }
+        // Sets chunk server connection key, and returns chunk access for the
+        // chunk server specified. Returns false if the chunk server access is
+        // required but not available.
+        bool SetChunkServerAccess(
+            ChunkServer&          inServer,
+            const ServerLocation& inLocation,
+            string&               outAccess)
+        {
+            const bool theCSClearTextAllowedFlag =
+                mOuter.IsChunkServerClearTextAllowed();
+            bool theNoCSAccessFlag = ! theCSClearTextAllowedFlag ||
+                ! mLeaseAcquireOp.allowCSClearTextFlag;
+            inServer.SetShutdownSsl(
+                mLeaseAcquireOp.allowCSClearTextFlag &&
+                theCSClearTextAllowedFlag
+            );
+            if (mChunkServerAccess.IsEmpty()) {
+                inServer.SetKey(0, 0, 0, 0);
+                inServer.SetAuthContext(0);
+                outAccess.clear();
+                return ! theNoCSAccessFlag;
+            }
+            CryptoKeys::Key theKey;
+            const ChunkServerAccess::Entry* const thePtr =
+                mChunkServerAccess.Get(
+                    inLocation,
+                    mGetAllocOp.chunkId,
+                    theKey
+                );
+            if (thePtr) {
+                inServer.SetKey(
+                    thePtr->chunkServerAccessId.mPtr,
+                    thePtr->chunkServerAccessId.mLen,
+                    theKey.GetPtr(),
+                    theKey.GetSize()
+                );
+                if (mChunkAccess.IsEmpty()) {
+                    outAccess.assign(
+                        thePtr->chunkAccess.mPtr,
+                        thePtr->chunkAccess.mLen
+                    );
+                } else {
+                    outAccess = mChunkAccess.GetChunkAccess(
+                        inLocation, mGetAllocOp.chunkId);
+                }
+                theNoCSAccessFlag = outAccess.empty();
+            } else {
+                theNoCSAccessFlag = true;
+            }
+            if (! theNoCSAccessFlag && ! inServer.GetAuthContext()) {
+                inServer.SetAuthContext(mOuter.mMetaServer.GetAuthContext());
+            }
+            return ! theNoCSAccessFlag;
+        }
         void GetAlloc()
         {
             QCASSERT(mGetAllocOp.fileOffset >= 0 && mGetAllocOp.fid > 0);
@@ -1066,7 +1305,23 @@ private:
                 );
 #endif
             }
-            mChunkServerIdx = 0;
+            if (mOuter.mReplicaSelectorPtr) {
+                mOuter.mReplicaSelectorPtr->Order(
+                    mGetAllocOp.chunkServers,
+                    mGetAllocOp.serversOrderedFlag,
+                    microseconds()
+                );
+            }
+            if (mOuter.mBlockCachePtr) {
+                mOuter.mBlockCachePtr->Invalidate(
+                    mOuter.mFileId,
+                    mGetAllocOp.chunkId,
+                    mGetAllocOp.chunkVersion
+                );
+            }
+            mChunkServerIdx        = 0;
+            mHedgeCount            = 0;
+            mLocalReadDisabledFlag = false;
             StartRead();
         }
         void GetLease()
@@ -1319,23 +1574,298 @@ private:
                 return;
             }
             inReadOp.access = mSizeOp.access;
+            if (mOuter.mBlockCachePtr && CacheRead(inReadOp)) {
+                Done(inReadOp, false, &inReadOp.mTmpBuffer);
+                return;
+            }
+            if (0 <= mLocalReadFd) {
+                if (LocalRead(inReadOp)) {
+                    ScheduleLocalReadDone();
+                    return;
+                }
+                // Fall back to reading from the chunk server.
+                CloseLocalRead();
+                mLocalReadDisabledFlag = true;
+                inReadOp.mTmpBuffer.Clear();
+                inReadOp.mTmpBuffer.UseSpaceAvailable(
+                    &inReadOp.mBuffer, inReadOp.numBytes);
+            }
             mOuter.mStats.mOpsReadCount++;
+            if (mOuter.mReplicaSelectorPtr) {
+                inReadOp.mStartUsec       = microseconds();
+                inReadOp.mSelectorEntryPtr = &mOuter.mReplicaSelectorPtr->Get(
+                    mGetAllocOp.chunkServers[mChunkServerIdx]);
+                mOuter.mReplicaSelectorPtr->Start(
+                    *inReadOp.mSelectorEntryPtr, inReadOp.numBytes);
+            }
             Enqueue(inReadOp, &inReadOp.mTmpBuffer);
+            ScheduleHedge();
+        }
+        void ScheduleHedge()
+        {
+            if (! mOuter.mReplicaSelectorPtr ||
+                    mHedgeTimerFlag ||
+                    mSleepingFlag ||
+                    Queue::IsEmpty(mInFlightQueue) ||
+                    ! Queue::IsEmpty(mHedgeQueue) ||
+                    mGetAllocOp.chunkServers.size() <=
+                        (size_t)mHedgeCount + 1) {
+                return;
+            }
+            const ReadOp& theOp = *Queue::Front(mInFlightQueue);
+            if (! theOp.mSelectorEntryPtr) {
+                return;
+            }
+            const int64_t theDelay = mOuter.mReplicaSelectorPtr->
+                GetHedgeDelayUsec(*theOp.mSelectorEntryPtr);
+            if (theDelay < 0) {
+                return;
+            }
+            const int64_t theRemaining = max(int64_t(1000),
+                theOp.mStartUsec + theDelay - microseconds());
+            mHedgeTimerFlag = true;
+            const bool kResetTimerFlag = true;
+            SetTimeoutInterval(
+                (int)min(int64_t(std::numeric_limits<int>::max()),
+                    (theRemaining + 999) / 1000),
+                kResetTimerFlag
+            );
+            mOuter.mNetManager.RegisterTimeoutHandler(this);
+        }
+        void HedgeTimeout()
+        {
+            if (Queue::IsEmpty(mInFlightQueue) ||
+                    ! Queue::IsEmpty(mHedgeQueue)) {
+                return;
+            }
+            ReadOp& theOp = *Queue::Front(mInFlightQueue);
+            if (! theOp.mSelectorEntryPtr ||
+                    mGetAllocOp.chunkServers.size() <=
+                        (size_t)mHedgeCount + 1) {
+                return;
+            }
+            const int64_t theNow     = microseconds();
+            const int64_t theElapsed = theNow - theOp.mStartUsec;
+            const int64_t theDelay   = mOuter.mReplicaSelectorPtr->
+                GetHedgeDelayUsec(*theOp.mSelectorEntryPtr);
+            if (theDelay < 0) {
+                return;
+            }
+            if (theElapsed < theDelay) {
+                ScheduleHedge();
+                return;
+            }
+            // The read is past the replica's high latency percentile. Keep
+            // the read running, and issue the same read to the next replica.
+            // The first successful completion is used, and the other read is
+            // canceled. The chunk size and lease remain valid, therefore the
+            // read can be issued right away.
+            mHedgeCount++;
+            const ServerLocation& theLocation = mGetAllocOp.chunkServers[
+                (mChunkServerIdx + mHedgeCount) %
+                mGetAllocOp.chunkServers.size()];
+            ChunkServer& theServer = GetHedgeChunkServer(theLocation);
+            string theAccess;
+            if (&theServer == &GetChunkServer() ||
+                    ! SetChunkServerAccess(theServer, theLocation, theAccess)) {
+                KFS_LOG_STREAM_DEBUG << mLogPrefix <<
+                    "read hedge: " << mHedgeCount <<
+                    " no access to server: " << theLocation <<
+                KFS_LOG_EOM;
+                ScheduleHedge();
+                return;
+            }
+            if (&theServer == mOwnHedgeChunkServerPtr) {
+                theServer.SetServer(theLocation);
+            }
+            ReadOp& theHedgeOp = *(new ReadOp(
+                (int)theOp.numBytes,
+                theOp.offset,
+                RequestId(),
+                RequestId(),
+                true,
+                false
+            ));
+            theHedgeOp.chunkId           = theOp.chunkId;
+            theHedgeOp.chunkVersion      = theOp.chunkVersion;
+            theHedgeOp.access            = theAccess;
+            theHedgeOp.mOpStartTime      = Now();
+            theHedgeOp.mStartUsec        = theNow;
+            theHedgeOp.mSelectorEntryPtr =
+                &mOuter.mReplicaSelectorPtr->Get(theLocation);
+            mOuter.mReplicaSelectorPtr->Start(
+                *theHedgeOp.mSelectorEntryPtr, theHedgeOp.numBytes);
+            Queue::PushBack(mHedgeQueue, theHedgeOp);
+            mHedgedOpPtr = &theOp;
+            mOuter.mStats.mReadHedgeCount++;
+            KFS_LOG_STREAM_DEBUG << mLogPrefix <<
+                "read hedge: " << mHedgeCount <<
+                " elapsed: "   << theElapsed <<
+                " deadline: "  << theDelay <<
+                " server: "    << GetChunkServer().GetServerLocation() <<
+                " hedge: "     << theLocation <<
+                " op: "        << theOp.Show() <<
+            KFS_LOG_EOM;
+            EnqueueSelf(theHedgeOp, &theHedgeOp.mTmpBuffer, &theServer);
+        }
+        ChunkServer& GetHedgeChunkServer(
+            const ServerLocation& inLocation)
+        {
+            if (mOuter.mClientPoolPtr) {
+                mHedgeChunkServerPtr = &mOuter.mClientPoolPtr->Get(
+                    inLocation, mGetAllocOp.allCSShortRpcFlag);
+                return *mHedgeChunkServerPtr;
+            }
+            if (! mOwnHedgeChunkServerPtr) {
+                mOuter.mChunkServerInitialSeqNum += 10000;
+                mOwnHedgeChunkServerPtr = new ChunkServer(
+                    mOuter.mNetManager,
+                    string(), -1, // host, port
+                    0, // inMaxRetryCount
+                    0, // inTimeSecBetweenRetries,
+                    mOuter.mOpTimeoutSec,
+                    mOuter.mIdleTimeoutSec,
+                    mOuter.mChunkServerInitialSeqNum,
+                    mLogPrefix.c_str(),
+                    false, // inResetConnectionOnOpTimeoutFlag
+                    GetMaxContentLength(mOuter)
+                );
+                mOwnHedgeChunkServerPtr->SetRetryConnectOnly(true);
+            }
+            mOwnHedgeChunkServerPtr->SetRpcFormat(
+                mGetAllocOp.allCSShortRpcFlag ?
+                KfsNetClient::kRpcFormatShort :
+                KfsNetClient::kRpcFormatLong);
+            mHedgeChunkServerPtr = mOwnHedgeChunkServerPtr;
+            return *mHedgeChunkServerPtr;
+        }
+        void DoneHedge(
+            ReadOp&   inOp,
+            bool      inCanceledFlag,
+            IOBuffer* inBufferPtr)
+        {
+            QCASSERT(
+                inBufferPtr == &inOp.mTmpBuffer &&
+                Queue::IsInList(mHedgeQueue, inOp)
+            );
+            if (inOp.mSelectorEntryPtr) {
+                mOuter.mReplicaSelectorPtr->Done(
+                    *inOp.mSelectorEntryPtr,
+                    inOp.numBytes,
+                    inOp.mStartUsec,
+                    microseconds(),
+                    inOp.status < 0,
+                    inCanceledFlag
+                );
+                inOp.mSelectorEntryPtr = 0;
+            }
+            ReadOp* const theOpPtr = mHedgedOpPtr;
+            mHedgedOpPtr = 0;
+            // Use the duplicate read only if it is complete and valid,
+            // otherwise let the original read finish. Short read past the end
+            // of chunk is handled by the original read completion.
+            if (inCanceledFlag || ! theOpPtr || inOp.status < 0 ||
+                    inOp.numBytes < inOp.contentLength ||
+                    (size_t)inOp.mTmpBuffer.BytesConsumable() <
+                        inOp.contentLength ||
+                    (inOp.contentLength < inOp.numBytes &&
+                        inOp.offset + (Offset)inOp.numBytes <=
+                            mSizeOp.size) ||
+                    ! VerifyChecksum(inOp)) {
+                if (! inCanceledFlag) {
+                    KFS_LOG_STREAM_ERROR << mLogPrefix <<
+                        "read hedge failure: " << inOp.Show() <<
+                        " status: "            << inOp.status <<
+                        " msg: "               << inOp.statusMsg <<
+                        " length: "            << inOp.contentLength <<
+                    KFS_LOG_EOM;
+                }
+                inOp.Delete(mHedgeQueue);
+                if (! inCanceledFlag) {
+                    ScheduleHedge();
+                }
+                return;
+            }
+            // The duplicate read completed first. Cancel the original read,
+            // and complete it with the duplicate read's data.
+            ReadOp& theOp = *theOpPtr;
+            mHedgeWonOpPtr = &theOp;
+            GetChunkServer().Cancel(&theOp, this);
+            if (mHedgeWonOpPtr) {
+                mHedgeWonOpPtr = 0;
+                KFS_LOG_STREAM_ERROR << mLogPrefix <<
+                    "read hedge: failed to cancel: " << theOp.Show() <<
+                KFS_LOG_EOM;
+                inOp.Delete(mHedgeQueue);
+                return;
+            }
+            theOp.status        = inOp.status;
+            theOp.lastError     = inOp.lastError;
+            theOp.contentLength = inOp.contentLength;
+            theOp.diskIOTime    = inOp.diskIOTime;
+            theOp.statusMsg.swap(inOp.statusMsg);
+            theOp.checksums.swap(inOp.checksums);
+            theOp.mTmpBuffer.Clear();
+            theOp.mTmpBuffer.Move(&inOp.mTmpBuffer);
+            inOp.Delete(mHedgeQueue);
+            KFS_LOG_STREAM_DEBUG << mLogPrefix <<
+                "read hedge: " << mHedgeCount <<
+                " completed first: " << theOp.Show() <<
+            KFS_LOG_EOM;
+            Done(theOp, false, &theOp.mTmpBuffer);
+        }
+        void CancelHedge()
+        {
+            mHedgedOpPtr = 0;
+            ReadOp* const theOpPtr = Queue::Front(mHedgeQueue);
+            if (! theOpPtr) {
+                return;
+            }
+            QCASSERT(mHedgeChunkServerPtr);
+            mHedgeChunkServerPtr->Cancel(theOpPtr, this);
+            if (Queue::Front(mHedgeQueue) == theOpPtr) {
+                mOuter.InternalError("failed to cancel hedged read");
+            }
         }
         void Done(
             ReadOp&   inOp,
             bool      inCanceledFlag,
             IOBuffer* inBufferPtr)
         {
+            if (&inOp == mHedgeWonOpPtr) {
+                // Canceled by the duplicate read completion, see DoneHedge().
+                mHedgeWonOpPtr = 0;
+                return;
+            }
             QCASSERT(
                 inBufferPtr == &inOp.mTmpBuffer &&
                 Queue::IsInList(mInFlightQueue, inOp)
             );
+            if (&inOp == mHedgedOpPtr) {
+                CancelHedge();
+            }
+            if (inOp.mSelectorEntryPtr) {
+                mOuter.mReplicaSelectorPtr->Done(
+                    *inOp.mSelectorEntryPtr,
+                    inOp.numBytes,
+                    inOp.mStartUsec,
+                    microseconds(),
+                    inOp.status < 0,
+                    inCanceledFlag
+                );
+                inOp.mSelectorEntryPtr = 0;
+            }
             if (inOp.status == kErrorNoEntry &&
                     mGetAllocOp.status != kErrorNoEntry) {
                 inOp.status = kErrorIO;
             }
-            if (inCanceledFlag || inOp.status < 0 || ! VerifyChecksum(inOp) ||
+            const bool theLocalReadFlag = inOp.mLocalReadFlag;
+            const bool theCacheReadFlag = inOp.mCacheReadFlag;
+            inOp.mLocalReadFlag = false;
+            inOp.mCacheReadFlag = false;
+            if (inCanceledFlag || inOp.status < 0 ||
+                    (! theLocalReadFlag && ! theCacheReadFlag &&
+                        ! VerifyChecksum(inOp)) ||
                     ! VerifyRead(inOp)) {
                 Queue::Remove(mInFlightQueue, inOp);
                 Queue::PushBack(mPendingQueue, inOp);
@@ -1380,6 +1910,19 @@ private:
             inOp.mBuffer.RemoveSpaceAvailable();
             inOp.mBuffer.Move(&inOp.mTmpBuffer);
             QCASSERT(theDoneCount == inOp.mBuffer.BytesConsumable());
+            // Only cache the data read from the chunk server and verified by
+            // VerifyChecksum() above.
+            if (mOuter.mBlockCachePtr && ! theCacheReadFlag &&
+                    ! theLocalReadFlag && 0 < theDoneCount) {
+                mOuter.mBlockCachePtr->Put(
+                    mOuter.mFileId,
+                    mGetAllocOp.chunkId,
+                    mGetAllocOp.chunkVersion,
+                    inOp.offset,
+                    inOp.mBuffer,
+                    mSizeOp.size
+                );
+            }
             if (ReportCompletion(inOp, mInFlightQueue)) {
                 StartRead();
             }
@@ -1647,12 +2190,342 @@ private:
                 mLeaseAcquireOp.leaseId >= 0 &&
                 ! mSizeOpInFlightFlag
             );
+            CloseLocalRead();
+            if (IsLocalReadCandidate()) {
+                // Chunk meta data response has the chunk size, therefore
+                // it is used instead of size op.
+                Reset(mLocalReadOp);
+                mLocalReadOp.chunkId             = mGetAllocOp.chunkId;
+                mLocalReadOp.chunkVersion        = mGetAllocOp.chunkVersion;
+                mLocalReadOp.access              = mSizeOp.access;
+                mLocalReadOp.localReadFlag       = true;
+                mLocalReadOp.chunkSize           = -1;
+                mLocalReadOp.localReadHandle     = -1;
+                mLocalReadOp.localReadHeaderSize = 0;
+                mLocalReadOp.localReadPath.clear();
+                mLocalReadBuffer.Clear();
+                mSizeOpInFlightFlag = true;
+                Enqueue(mLocalReadOp, &mLocalReadBuffer);
+                return;
+            }
             Reset(mSizeOp);
             mSizeOp.chunkId      = mGetAllocOp.chunkId;
             mSizeOp.chunkVersion = mGetAllocOp.chunkVersion;
             mSizeOpInFlightFlag  = true;
             Enqueue(mSizeOp);
         }
+        bool IsLocalReadCandidate()
+        {
+            if (! mOuter.mLocalReadFlag ||
+                    mLocalReadDisabledFlag ||
+                    mGetAllocOp.chunkVersion < 0) {
+                return false;
+            }
+            LocalReadRemoteServers::iterator const theIt =
+                mOuter.mLocalReadRemoteServers.find(
+                    GetChunkServer().GetServerLocation());
+            if (theIt == mOuter.mLocalReadRemoteServers.end()) {
+                return true;
+            }
+            if (Now() < theIt->second) {
+                return false;
+            }
+            mOuter.mLocalReadRemoteServers.erase(theIt);
+            return true;
+        }
+        void SetLocalReadRemoteServer()
+        {
+            // Do not attempt local reads from this server for a while. The
+            // chunk server configuration, or the client's permissions might
+            // change, therefore the entry expires.
+            const time_t kLocalReadRetryIntervalSec = 5 * 60;
+            mOuter.mLocalReadRemoteServers[
+                GetChunkServer().GetServerLocation()] =
+                Now() + kLocalReadRetryIntervalSec;
+        }
+        void Done(
+            GetChunkMetadataOp& inOp,
+            bool                inCanceledFlag,
+            IOBuffer*           inBufferPtr)
+        {
+            QCASSERT(&mLocalReadOp == &inOp &&
+                inBufferPtr == &mLocalReadBuffer && mSizeOpInFlightFlag);
+            if (inCanceledFlag) {
+                mSizeOpInFlightFlag = false;
+                mLocalReadBuffer.Clear();
+                return;
+            }
+            const size_t kChecksumsSize =
+                CHUNKSIZE / CHECKSUM_BLOCKSIZE * sizeof(uint32_t);
+            int theRet = -EINVAL;
+            if (inOp.status != 0 || inOp.localReadPath.empty()) {
+                // Older chunk server, or the server is on the other host.
+                // Status errors, if any, will be handled by the size op.
+                SetLocalReadRemoteServer();
+            } else if (0 < inOp.localReadHandle &&
+                    0 <= inOp.chunkSize &&
+                    inOp.chunkSize <= (chunkOff_t)CHUNKSIZE &&
+                    inOp.chunkVersion == mGetAllocOp.chunkVersion &&
+                    0 < inOp.localReadHeaderSize &&
+                    mLocalReadBuffer.BytesConsumable() ==
+                        (int)kChecksumsSize) {
+                mLocalReadChecksums.resize(kChecksumsSize / sizeof(uint32_t));
+                mLocalReadBuffer.CopyOut(
+                    reinterpret_cast<char*>(&mLocalReadChecksums[0]),
+                    (int)kChecksumsSize);
+                mLocalReadBuffer.Clear();
+                // The size op remains "in flight" until the descriptor
+                // exchange completes.
+                theRet = mLocalReadFdReceiver.Start(
+                    mOuter.mNetManager,
+                    inOp.localReadPath,
+                    inOp.localReadHandle,
+                    max(1, mOuter.mOpTimeoutSec)
+                );
+                if (theRet == 0) {
+                    return;
+                }
+                KFS_LOG_STREAM_INFO << mLogPrefix <<
+                    "local read: " << inOp.localReadPath <<
+                    " chunk: "     << inOp.chunkId <<
+                    " "            << QCUtils::SysError(-theRet) <<
+                KFS_LOG_EOM;
+                if (theRet == -ENOENT || theRet == -EACCES ||
+                        theRet == -EPERM || theRet == -ECONNREFUSED) {
+                    // The socket is not accessible from this client.
+                    SetLocalReadRemoteServer();
+                }
+            }
+            mLocalReadBuffer.Clear();
+            LocalReadFdDone(theRet);
+        }
+        void LocalReadFdDone(
+            int inFd)
+        {
+            QCASSERT(mSizeOpInFlightFlag && mLocalReadFd < 0);
+            mSizeOpInFlightFlag = false;
+            if (0 <= inFd) {
+                mLocalReadFd         = inFd;
+                mLocalReadHeaderSize = mLocalReadOp.localReadHeaderSize;
+                mSizeOp.size         = mLocalReadOp.chunkSize;
+            } else {
+                mLocalReadChecksums.clear();
+                mLocalReadDisabledFlag = true;
+            }
+            StartRead();
+        }
+        void ScheduleLocalReadDone()
+        {
+            // Complete local read in the next net manager iteration, in order
+            // to avoid recursion with the completion issuing the next read.
+            mLocalReadDoneUsec = mOuter.mNetManager.NowUsec();
+            if (mLocalReadDoneCount++ <= 0) {
+                mLocalReadDoneTimer.SetTimeoutInterval(0);
+                mOuter.mNetManager.RegisterTimeoutHandler(
+                    &mLocalReadDoneTimer);
+                mOuter.mNetManager.Wakeup();
+            }
+        }
+        ReadOp* GetLocalReadDone()
+        {
+            Queue::Iterator theIt(mInFlightQueue);
+            ReadOp*         theOpPtr;
+            while ((theOpPtr = theIt.Next())) {
+                if (theOpPtr->mLocalReadFlag) {
+                    return theOpPtr;
+                }
+            }
+            return 0;
+        }
+        void LocalReadDoneTimeout()
+        {
+            if (mLocalReadDoneUsec == mOuter.mNetManager.NowUsec()) {
+                // Scheduled by the timer that ran in this iteration.
+                mOuter.mNetManager.Wakeup();
+                return;
+            }
+            mOuter.mNetManager.UnRegisterTimeoutHandler(&mLocalReadDoneTimer);
+            // The reads issued by the completions are scheduled again.
+            int theCount = mLocalReadDoneCount;
+            mLocalReadDoneCount = 0;
+            QCStDeleteNotifier theDeleteNotifier(mDeletedFlagPtr);
+            ReadOp*            theOpPtr;
+            while (0 < theCount-- && (theOpPtr = GetLocalReadDone())) {
+                Done(*theOpPtr, false, &theOpPtr->mTmpBuffer);
+                if (theDeleteNotifier.IsDeleted()) {
+                    return; // Unwind.
+                }
+            }
+        }
+        void CancelLocalReadDone()
+        {
+            if (mLocalReadDoneCount <= 0) {
+                return;
+            }
+            mLocalReadDoneCount = 0;
+            mOuter.mNetManager.UnRegisterTimeoutHandler(&mLocalReadDoneTimer);
+            ReadOp* theOpPtr;
+            while ((theOpPtr = GetLocalReadDone())) {
+                Done(*theOpPtr, true, &theOpPtr->mTmpBuffer);
+            }
+        }
+        void CloseLocalRead()
+        {
+            if (mLocalReadFd < 0) {
+                return;
+            }
+            close(mLocalReadFd);
+            mLocalReadFd = -1;
+            mLocalReadChecksums.clear();
+        }
+        class LocalFileReader : public IOBuffer::Reader
+        {
+        public:
+            LocalFileReader(
+                Offset inPos)
+                : IOBuffer::Reader(),
+                  mPos(inPos)
+                {}
+            virtual int Read(
+                int              inFd,
+                void*            inBufPtr,
+                IOBuffer::BufPos inNumRead)
+            {
+                const ssize_t theRet = pread(inFd, inBufPtr, inNumRead, mPos);
+                if (0 < theRet) {
+                    mPos += theRet;
+                }
+                return (int)theRet;
+            }
+        private:
+            Offset mPos;
+        };
+        bool LocalPRead(
+            Offset inPos,
+            Offset inEnd)
+        {
+            // Read [inPos, inEnd) into scratch buffer. The stored checksums
+            // are computed with the last block padded with zeros.
+            const size_t theLen = (size_t)(inEnd - inPos);
+            mLocalReadScratch.resize(CHECKSUM_BLOCKSIZE);
+            size_t theNRd = 0;
+            const Offset theFileEnd = min(inEnd, mSizeOp.size);
+            while (inPos + (Offset)theNRd < theFileEnd) {
+                const ssize_t theRet = pread(mLocalReadFd,
+                    &mLocalReadScratch[theNRd],
+                    (size_t)(theFileEnd - inPos) - theNRd,
+                    mLocalReadHeaderSize + inPos + theNRd);
+                if (theRet < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                if (theRet == 0) {
+                    break;
+                }
+                theNRd += theRet;
+            }
+            if (theNRd < theLen) {
+                memset(&mLocalReadScratch[theNRd], 0, theLen - theNRd);
+            }
+            return true;
+        }
+        bool CacheRead(
+            ReadOp& inOp)
+        {
+            const int theLen = (int)(min(
+                inOp.offset + (Offset)inOp.numBytes, mSizeOp.size) -
+                inOp.offset);
+            if (! mOuter.mBlockCachePtr->Get(
+                    mOuter.mFileId,
+                    mGetAllocOp.chunkId,
+                    mGetAllocOp.chunkVersion,
+                    inOp.offset,
+                    theLen,
+                    mSizeOp.size,
+                    inOp.mTmpBuffer)) {
+                return false;
+            }
+            // The data was verified when it was inserted into the cache.
+            inOp.status         = 0;
+            inOp.contentLength  = theLen;
+            inOp.mCacheReadFlag = true;
+            inOp.checksums.clear();
+            mOuter.mStats.mCacheReadCount++;
+            mOuter.mStats.mCacheReadByteCount += theLen;
+            return true;
+        }
+        bool LocalRead(
+            ReadOp& inOp)
+        {
+            const Offset theEnd = min(
+                inOp.offset + (Offset)inOp.numBytes, mSizeOp.size);
+            const int    theLen = (int)(theEnd - inOp.offset);
+            LocalFileReader theReader(mLocalReadHeaderSize + inOp.offset);
+            if (theLen <= 0 || inOp.mTmpBuffer.Read(
+                    mLocalReadFd, theLen, &theReader) != theLen) {
+                KFS_LOG_STREAM_ERROR << mLogPrefix <<
+                    "local read failure:"
+                    " chunk: "  << mGetAllocOp.chunkId <<
+                    " offset: " << inOp.offset <<
+                    " length: " << theLen <<
+                KFS_LOG_EOM;
+                return false;
+            }
+            // Verify checksums of all blocks that the read covers, using the
+            // chunk file content outside of the read range, if any.
+            const Offset kBlockSize = (Offset)CHECKSUM_BLOCKSIZE;
+            IOBuffer::BufPos theBufPos = 0;
+            for (Offset thePos = inOp.offset - inOp.offset % kBlockSize;
+                    thePos < theEnd;
+                    thePos += kBlockSize) {
+                const Offset theBlockEnd = thePos + kBlockSize;
+                const Offset theStart    = max(thePos, inOp.offset);
+                const Offset theDataEnd  = min(theBlockEnd, theEnd);
+                uint32_t     theChecksum = kKfsNullChecksum;
+                if (thePos < theStart) {
+                    if (! LocalPRead(thePos, theStart)) {
+                        return false;
+                    }
+                    theChecksum = ComputeBlockChecksum(theChecksum,
+                        &mLocalReadScratch[0], (size_t)(theStart - thePos));
+                }
+                theChecksum = ComputeBlockChecksumAt(&inOp.mTmpBuffer,
+                    theBufPos, (size_t)(theDataEnd - theStart), theChecksum);
+                theBufPos += (IOBuffer::BufPos)(theDataEnd - theStart);
+                if (theDataEnd < theBlockEnd) {
+                    if (! LocalPRead(theDataEnd, theBlockEnd)) {
+                        return false;
+                    }
+                    theChecksum = ComputeBlockChecksum(theChecksum,
+                        &mLocalReadScratch[0],
+                        (size_t)(theBlockEnd - theDataEnd));
+                }
+                const size_t theIdx = (size_t)(thePos / kBlockSize);
+                if (mLocalReadChecksums.size() <= theIdx ||
+                        mLocalReadChecksums[theIdx] != theChecksum) {
+                    KFS_LOG_STREAM_ERROR << mLogPrefix <<
+                        "local read checksum mismatch:"
+                        " chunk: "    << mGetAllocOp.chunkId <<
+                        " version: "  << mGetAllocOp.chunkVersion <<
+                        " offset: "   << thePos <<
+                        " expected: " << (theIdx < mLocalReadChecksums.size() ?
+                            (int64_t)mLocalReadChecksums[theIdx] :
+                            int64_t(-1)) <<
+                        " got: "      << theChecksum <<
+                    KFS_LOG_EOM;
+                    return false;
+                }
+            }
+            inOp.status         = 0;
+            inOp.contentLength  = theLen;
+            inOp.mLocalReadFlag = true;
+            inOp.checksums.clear();
+            mOuter.mStats.mLocalReadCount++;
+            mOuter.mStats.mLocalReadByteCount += theLen;
+            return true;
+        }
         void Done(
             SizeOp&   inOp,
             bool      inCanceledFlag,
@@ -1712,6 +2585,11 @@ private:
                 Done(mLeaseRelinquishOp, inCanceledFlag, inBufferPtr);
             } else if (&mSizeOp == inOpPtr) {
                 Done(mSizeOp, inCanceledFlag, inBufferPtr);
+            } else if (&mLocalReadOp == inOpPtr) {
+                Done(mLocalReadOp, inCanceledFlag, inBufferPtr);
+            } else if (inOpPtr && inOpPtr == Queue::Front(mHedgeQueue)) {
+                DoneHedge(*static_cast<ReadOp*>(inOpPtr),
+                    inCanceledFlag, inBufferPtr);
             } else if (inOpPtr && inOpPtr->op == CMD_READ) {
                 Done(*static_cast<ReadOp*>(inOpPtr),
                     inCanceledFlag, inBufferPtr);
@@ -1742,10 +2620,12 @@ private:
             mLastOpPtr = 0;
             StopChunkServer();
             mChunkServerSetFlag = false;
+            CloseLocalRead();
             QCASSERT(Queue::IsEmpty(mInFlightQueue));
-            if (mSleepingFlag) {
+            if (mSleepingFlag || mHedgeTimerFlag) {
                 mOuter.mNetManager.UnRegisterTimeoutHandler(this);
-                mSleepingFlag = false;
+                mSleepingFlag   = false;
+                mHedgeTimerFlag = false;
             }
         }
         static void Reset(
@@ -1990,6 +2870,10 @@ private:
             if (inSec <= 0 || mSleepingFlag) {
                 return false;
             }
+            if (mHedgeTimerFlag) {
+                mOuter.mNetManager.UnRegisterTimeoutHandler(this);
+                mHedgeTimerFlag = false;
+            }
             KFS_LOG_STREAM_DEBUG << mLogPrefix <<
                 "sleeping: " << inSec <<
                 (mRestartStartReadFlag ? "resetting restart flag" : "") <<
@@ -2004,6 +2888,12 @@ private:
         }
         virtual void Timeout()
         {
+            if (mHedgeTimerFlag) {
+                mOuter.mNetManager.UnRegisterTimeoutHandler(this);
+                mHedgeTimerFlag = false;
+                HedgeTimeout();
+                return;
+            }
             KFS_LOG_STREAM_DEBUG << mLogPrefix << "timeout" <<
             KFS_LOG_EOM;
             if (mSleepingFlag) {
@@ -2025,6 +2915,7 @@ private:
                     (inStatus >= 0 || inStatus == kErrorNoEntry)) {
                 // Reset retry counts on successful completion.
                 mRetryCount = 0;
+                mHedgeCount = 0;
             }
             return mOuter.ReportCompletion(
                 inLastError,
@@ -2167,6 +3058,11 @@ private:
         }
         void StopChunkServer()
         {
+            CancelHedge();
+            if (mLocalReadFdReceiver.Cancel()) {
+                mSizeOpInFlightFlag = false;
+            }
+            CancelLocalReadDone();
             if (&mChunkServer == mChunkServerPtr) {
                 mChunkServer.Stop();
                 return;
@@ -2176,6 +3072,7 @@ private:
             }
             if (mSizeOpInFlightFlag) {
                 mChunkServerPtr->Cancel(&mSizeOp, this);
+                mChunkServerPtr->Cancel(&mLocalReadOp, this);
             }
             if (! Queue::IsEmpty(mInFlightQueue)) {
                 mChunkServerPtr->CancelAllWithOwner(this);
@@ -2185,6 +3082,16 @@ private:
         {
             return (mChunkServerPtr ? *mChunkServerPtr : mChunkServer);
         }
+        static int GetMaxContentLength(
+            const Impl& inOuter)
+        {
+            // Allow some slack and ensure that content size limit is
+            // reasonably large.
+            return int(min(
+                int64_t(inOuter.mMaxReadSize) + (64 << 10),
+                int64_t(std::numeric_limits<int>::max())
+            ));
+        }
         bool WasChunkServerDisconnected()
         {
             return GetChunkServer().WasDisconnected();
@@ -2248,7 +3155,12 @@ private:
     Offset              mOffset;
     Offset              mOpenChunkBlockSize;
     int64_t             mChunkServerInitialSeqNum;
-    ClientPool* const   mClientPoolPtr;
+    ClientPool* const       mClientPoolPtr;
+    ReplicaSelector* const  mReplicaSelectorPtr;
+    const bool              mLocalReadFlag;
+    LocalReadRemoteServers  mLocalReadRemoteServers;
+    ECComputePool* const    mComputePoolPtr;
+    BlockCache* const       mBlockCachePtr;
     Completion*         mCompletionPtr;
     string const        mLogPrefix;
     Stats               mStats;
@@ -2714,6 +3626,12 @@ Reader::Striper::ReportInvalidChunk(
     );
 }
 
+ECComputePool*
+Reader::Striper::GetComputePool() const
+{
+    return mOuter.mComputePoolPtr;
+}
+
 Reader::Reader(
     Reader::MetaServer& inMetaServer,
     Reader::Completion* inCompletionPtr,
@@ -2726,7 +3644,11 @@ Reader::Reader(
     int                 inLeaseWaitTimeout,
     const char*         inLogPrefixPtr,
     int64_t             inChunkServerInitialSeqNum,
-    ClientPool*         inClientPoolPtr)
+    ClientPool*         inClientPoolPtr,
+    ReplicaSelector*    inReplicaSelectorPtr,
+    bool                inLocalReadFlag,
+    ECComputePool*      inComputePoolPtr,
+    BlockCache*         inBlockCachePtr)
     : mImpl(*new Reader::Impl(
         *this,
         inMetaServer,
@@ -2741,7 +3663,11 @@ Reader::Reader(
         (inLogPrefixPtr && inLogPrefixPtr[0]) ?
             (inLogPrefixPtr + string(" ")) : string(),
         inChunkServerInitialSeqNum,
-        inClientPoolPtr
+        inClientPoolPtr,
+        inReplicaSelectorPtr,
+        inLocalReadFlag,
+        inComputePoolPtr,
+        inBlockCachePtr
     ))
 {
     mImpl.Ref();
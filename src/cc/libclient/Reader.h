@@ -42,6 +42,9 @@ using std::string;
 using std::ostream;
 
 class ClientPool;
+class ReplicaSelector;
+class ECComputePool;
+class BlockCache;
 
 // Kfs client file read state machine.
 class Reader
@@ -93,7 +96,12 @@ public:
               mReadByteCount(0),
               mReadErrorsCount(0),
               mReadChecksumErrorsCount(0),
-              mReadRecoveriesCount(0)
+              mReadRecoveriesCount(0),
+              mReadHedgeCount(0),
+              mLocalReadCount(0),
+              mLocalReadByteCount(0),
+              mCacheReadCount(0),
+              mCacheReadByteCount(0)
             {}
         void Clear()
             { *this = Stats(); }
@@ -113,6 +121,11 @@ public:
             mReadErrorsCount         += inStats.mReadErrorsCount;
             mReadChecksumErrorsCount += inStats.mReadChecksumErrorsCount;
             mReadRecoveriesCount     += inStats.mReadRecoveriesCount;
+            mReadHedgeCount          += inStats.mReadHedgeCount;
+            mLocalReadCount          += inStats.mLocalReadCount;
+            mLocalReadByteCount      += inStats.mLocalReadByteCount;
+            mCacheReadCount          += inStats.mCacheReadCount;
+            mCacheReadByteCount      += inStats.mCacheReadByteCount;
             return *this;
         }
         template<typename T>
@@ -129,6 +142,11 @@ public:
             inFunctor("ReadErrors",         mReadErrorsCount);
             inFunctor("ReadChecksumErrors", mReadChecksumErrorsCount);
             inFunctor("ReadRecoveries",     mReadRecoveriesCount);
+            inFunctor("ReadHedges",         mReadHedgeCount);
+            inFunctor("LocalReads",         mLocalReadCount);
+            inFunctor("LocalReadBytes",     mLocalReadByteCount);
+            inFunctor("CacheReads",         mCacheReadCount);
+            inFunctor("CacheReadBytes",     mCacheReadByteCount);
             inFunctor("Reads",              mReadCount);
             inFunctor("ReadBytes",          mReadByteCount);
         }
@@ -145,6 +163,11 @@ public:
         Counter mReadErrorsCount;
         Counter mReadChecksumErrorsCount;
         Counter mReadRecoveriesCount;
+        Counter mReadHedgeCount;
+        Counter mLocalReadCount;
+        Counter mLocalReadByteCount;
+        Counter mCacheReadCount;
+        Counter mCacheReadByteCount;
     };
     class Striper
     {
@@ -216,6 +239,7 @@ public:
             int64_t      inChunkVersion,
             int          inStatus,
             const char*  inStatusMsgPtr);
+        ECComputePool* GetComputePool() const;
     private:
         Impl& mOuter;
     private:
@@ -237,7 +261,11 @@ public:
         int         inLeaseWaitTimeout,
         const char* inLogPrefixPtr,
         int64_t     inChunkServerInitialSeqNum,
-        ClientPool* inClientPoolPtr);
+        ClientPool* inClientPoolPtr,
+        ReplicaSelector* inReplicaSelectorPtr = 0,
+        bool        inLocalReadFlag = false,
+        ECComputePool* inComputePoolPtr = 0,
+        BlockCache* inBlockCachePtr = 0);
     virtual ~Reader();
     int Open(
         kfsFileId_t inFileId,
@@ -0,0 +1,293 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corporation. All rights reserved.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Chunk server read latency tracker, shared by all readers that run in the
+// same protocol worker thread. Keeps exponentially weighted moving average of
+// the read latency and its mean deviation per chunk server, along with the
+// number of bytes currently in flight, and uses these to order chunk replicas
+// and to compute the deadline past which a duplicate read is issued to another
+// replica.
+// The object is not thread safe, and is intended to be used from the protocol
+// worker's net manager thread only.
+//
+//----------------------------------------------------------------------------
+
+#ifndef REPLICA_SELECTOR_H
+#define REPLICA_SELECTOR_H
+
+#include "common/kfsdecls.h"
+#include "common/StdAllocator.h"
+
+#include <map>
+#include <vector>
+#include <algorithm>
+
+namespace KFS
+{
+namespace client
+{
+using std::map;
+using std::less;
+using std::pair;
+using std::vector;
+using std::max;
+using std::min;
+using std::stable_sort;
+
+class ReplicaSelector
+{
+public:
+    class Entry
+    {
+    public:
+        Entry()
+            : mAvgUsec(0),
+              mDevUsec(0),
+              mAvgBytes(0),
+              mInFlightBytes(0),
+              mLastSampleUsec(0),
+              mSampleCount(0),
+              mErrorCount(0)
+            {}
+        int64_t GetInFlightBytes() const
+            { return mInFlightBytes; }
+        int64_t GetAvgUsec() const
+            { return mAvgUsec; }
+        int64_t GetSampleCount() const
+            { return mSampleCount; }
+    private:
+        int64_t mAvgUsec;
+        int64_t mDevUsec;
+        int64_t mAvgBytes;
+        int64_t mInFlightBytes;
+        int64_t mLastSampleUsec;
+        int64_t mSampleCount;
+        int64_t mErrorCount;
+
+        friend class ReplicaSelector;
+    };
+
+    ReplicaSelector(
+        bool   inEnabledFlag         = false,
+        int    inHedgeMinDelayMs     = 0,
+        double inHedgeDevMultiplier  = 4,
+        double inLocalityBiasRatio   = 1.5,
+        int    inMaxSampleAgeSec     = 60)
+        : mEntries(),
+          mEnabledFlag(inEnabledFlag),
+          mHedgeMinDelayUsec(int64_t(max(0, inHedgeMinDelayMs)) * 1000),
+          mHedgeDevMultiplier(max(0., inHedgeDevMultiplier)),
+          mLocalityBiasRatio(max(1., inLocalityBiasRatio)),
+          mMaxSampleAgeUsec(int64_t(max(1, inMaxSampleAgeSec)) * 1000 * 1000),
+          mNextExpireUsec(0),
+          mTmp(),
+          mTmpServers()
+        {}
+    bool IsEnabled() const
+        { return mEnabledFlag; }
+    bool IsHedgeEnabled() const
+        { return (mEnabledFlag && 0 < mHedgeMinDelayUsec); }
+    Entry& Get(
+        const ServerLocation& inLocation)
+        { return mEntries[inLocation]; }
+    void Start(
+        Entry&  inEntry,
+        int64_t inBytes)
+        { inEntry.mInFlightBytes += inBytes; }
+    // Completion with inCanceledFlag set only updates in flight byte count,
+    // as the op latency is not known in this case.
+    void Done(
+        Entry&  inEntry,
+        int64_t inBytes,
+        int64_t inStartUsec,
+        int64_t inNowUsec,
+        bool    inErrorFlag,
+        bool    inCanceledFlag)
+    {
+        inEntry.mInFlightBytes = max(int64_t(0),
+            inEntry.mInFlightBytes - inBytes);
+        if (inCanceledFlag) {
+            return;
+        }
+        if (inErrorFlag) {
+            inEntry.mErrorCount++;
+        }
+        // Do not let a fast error make the server look attractive.
+        int64_t theUsec = max(int64_t(0), inNowUsec - inStartUsec);
+        if (inErrorFlag) {
+            theUsec = max(theUsec, 2 * inEntry.mAvgUsec);
+        }
+        AddSample(inEntry, theUsec, inBytes, inNowUsec);
+    }
+    // Returns the time in microseconds after which the read should be
+    // duplicated to the next replica, or -1 if there is not enough data yet.
+    // Mean plus four mean deviations, similarly to TCP retransmit timeout,
+    // approximates the high percentile of the latency distribution.
+    int64_t GetHedgeDelayUsec(
+        const Entry& inEntry) const
+    {
+        if (! IsHedgeEnabled() || inEntry.mSampleCount < kMinSampleCount) {
+            return -1;
+        }
+        return max(mHedgeMinDelayUsec, inEntry.mAvgUsec +
+            (int64_t)(mHedgeDevMultiplier * inEntry.mDevUsec));
+    }
+    // Order replicas by the expected completion time of the next read. If
+    // the meta server has already ordered the replicas by locality, the first
+    // replica is kept first unless its expected time exceeds the best by more
+    // than the locality bias ratio. Servers with no recent samples sort first
+    // in order to get their latency measured.
+    void Order(
+        vector<ServerLocation>& ioServers,
+        bool                    inOrderedByLocalityFlag,
+        int64_t                 inNowUsec)
+    {
+        if (! mEnabledFlag) {
+            return;
+        }
+        Expire(inNowUsec);
+        if (ioServers.size() <= 1) {
+            return;
+        }
+        mTmp.clear();
+        for (size_t i = 0; i < ioServers.size(); i++) {
+            mTmp.push_back(Item(
+                GetExpectedUsec(Get(ioServers[i]), inNowUsec), i));
+        }
+        stable_sort(mTmp.begin(), mTmp.end());
+        if (inOrderedByLocalityFlag && mTmp.front().mIdx != 0) {
+            size_t i = 1;
+            while (i < mTmp.size() && mTmp[i].mIdx != 0) {
+                i++;
+            }
+            if (i < mTmp.size() && mTmp[i].mUsec <=
+                    (int64_t)(mTmp.front().mUsec * mLocalityBiasRatio)) {
+                const Item theLocal = mTmp[i];
+                mTmp.erase(mTmp.begin() + i);
+                mTmp.insert(mTmp.begin(), theLocal);
+            }
+        }
+        mTmpServers.clear();
+        for (size_t i = 0; i < mTmp.size(); i++) {
+            mTmpServers.push_back(ioServers[mTmp[i].mIdx]);
+        }
+        ioServers.swap(mTmpServers);
+    }
+private:
+    enum { kMinSampleCount = 8 };
+    struct Item
+    {
+        Item(
+            int64_t inUsec = 0,
+            size_t  inIdx  = 0)
+            : mUsec(inUsec),
+              mIdx(inIdx)
+            {}
+        bool operator<(
+            const Item& inRhs) const
+            { return (mUsec < inRhs.mUsec); }
+        int64_t mUsec;
+        size_t  mIdx;
+    };
+    typedef map<
+        ServerLocation,
+        Entry,
+        less<ServerLocation>,
+        StdFastAllocator<pair<const ServerLocation, Entry> >
+    > Entries;
+
+    Entries                mEntries;
+    const bool             mEnabledFlag;
+    const int64_t          mHedgeMinDelayUsec;
+    const double           mHedgeDevMultiplier;
+    const double           mLocalityBiasRatio;
+    const int64_t          mMaxSampleAgeUsec;
+    int64_t                mNextExpireUsec;
+    vector<Item>           mTmp;
+    vector<ServerLocation> mTmpServers;
+
+    // Remove the entries of the servers with no reads in flight, and no
+    // samples within the max sample age, in order to keep the map size
+    // bounded by the number of recently used servers. Such entries have no
+    // effect on the ordering, and the in flight reads reference only the
+    // entries with non zero in flight bytes.
+    void Expire(
+        int64_t inNowUsec)
+    {
+        if (inNowUsec < mNextExpireUsec) {
+            return;
+        }
+        mNextExpireUsec = inNowUsec + mMaxSampleAgeUsec;
+        for (Entries::iterator theIt = mEntries.begin();
+                theIt != mEntries.end(); ) {
+            const Entry& theEntry = theIt->second;
+            if (theEntry.mInFlightBytes <= 0 &&
+                    theEntry.mLastSampleUsec + mMaxSampleAgeUsec < inNowUsec) {
+                mEntries.erase(theIt++);
+            } else {
+                ++theIt;
+            }
+        }
+    }
+    int64_t GetExpectedUsec(
+        const Entry& inEntry,
+        int64_t      inNowUsec) const
+    {
+        if (inEntry.mSampleCount <= 0 ||
+                inEntry.mLastSampleUsec + mMaxSampleAgeUsec < inNowUsec) {
+            return 0;
+        }
+        // Scale the latency by the number of reads of average size that are
+        // already queued to the server.
+        return (inEntry.mAvgUsec + inEntry.mAvgUsec *
+            inEntry.mInFlightBytes / max(int64_t(1), inEntry.mAvgBytes));
+    }
+    static void AddSample(
+        Entry&  inEntry,
+        int64_t inUsec,
+        int64_t inBytes,
+        int64_t inNowUsec)
+    {
+        if (inEntry.mSampleCount <= 0) {
+            inEntry.mAvgUsec  = inUsec;
+            inEntry.mDevUsec  = inUsec / 2;
+            inEntry.mAvgBytes = inBytes;
+        } else {
+            // Weights 1/8 and 1/4, same as TCP RTT estimator.
+            const int64_t theDiff = inUsec - inEntry.mAvgUsec;
+            inEntry.mAvgUsec  += theDiff / 8;
+            inEntry.mDevUsec  +=
+                ((theDiff < 0 ? -theDiff : theDiff) - inEntry.mDevUsec) / 4;
+            inEntry.mAvgBytes += (inBytes - inEntry.mAvgBytes) / 8;
+        }
+        inEntry.mLastSampleUsec = inNowUsec;
+        inEntry.mSampleCount++;
+    }
+private:
+    ReplicaSelector(
+        const ReplicaSelector& inSelector);
+    ReplicaSelector& operator=(
+        const ReplicaSelector& inSelector);
+};
+
+}} /* namespace client KFS */
+
+#endif /* REPLICA_SELECTOR_H */
@@ -92,8 +92,10 @@ public:
         int           inOpTimeoutSec,
         int           inIdleTimeoutSec,
         int           inMaxWriteSize,
-        const string& inLogPrefix,
-        int64_t       inChunkServerInitialSeqNum)
+        const string&  inLogPrefix,
+        int64_t        inChunkServerInitialSeqNum,
+        ECComputePool* inComputePoolPtr,
+        int            inWriteBehindSize)
         : QCRefCountedObj(),
           ITimeout(),
           KfsNetClient::OpOwner(),
@@ -131,7 +133,9 @@ public:
           mOpStartTime(0),
           mCompletionDepthCount(0),
           mStriperProcessCount(0),
-          mStriperPtr(0)
+          mStriperPtr(0),
+          mComputePoolPtr(inComputePoolPtr),
+          mWriteBehindSize(max(0, inWriteBehindSize))
         { Writers::Init(mWriters); }
     int Open(
         kfsFileId_t inFileId,
@@ -1760,6 +1764,8 @@ private:
     int                 mCompletionDepthCount;
     int                 mStriperProcessCount;
     Striper*            mStriperPtr;
+    ECComputePool*      mComputePoolPtr;
+    const int           mWriteBehindSize;
     ChunkWriter*        mWriters[1];
 
     void InternalError(
@@ -2195,6 +2201,24 @@ Writer::Striper::StartQueuedWrite(
     mOuter.StartQueuedWrite(inQueuedCount);
 }
 
+ECComputePool*
+Writer::Striper::GetComputePool() const
+{
+    return mOuter.mComputePoolPtr;
+}
+
+int
+Writer::Striper::GetWriteBehindSize() const
+{
+    return mOuter.mWriteBehindSize;
+}
+
+int
+Writer::Striper::GetWriteThreshold() const
+{
+    return mOuter.mWriteThreshold;
+}
+
 Writer::Writer(
     Writer::MetaServer& inMetaServer,
     Writer::Completion* inCompletionPtr,
@@ -2206,7 +2230,9 @@ Writer::Writer(
     int                 inIdleTimeoutSec,
     int                 inMaxWriteSize,
     const char*         inLogPrefixPtr,
-    int64_t             inChunkServerInitialSeqNum)
+    int64_t             inChunkServerInitialSeqNum,
+    ECComputePool*      inComputePoolPtr,
+    int                 inWriteBehindSize)
     : mImpl(*new Writer::Impl(
         *this,
         inMetaServer,
@@ -2220,7 +2246,9 @@ Writer::Writer(
         inMaxWriteSize,
         (inLogPrefixPtr && inLogPrefixPtr[0]) ?
             (inLogPrefixPtr + string(" ")) : string(),
-        inChunkServerInitialSeqNum
+        inChunkServerInitialSeqNum,
+        inComputePoolPtr,
+        inWriteBehindSize
     ))
 {
     mImpl.Ref();
@@ -40,6 +40,8 @@ namespace client
 {
 using std::string;
 
+class ECComputePool;
+
 // Kfs client write protocol state machine.
 class Writer
 {
@@ -179,6 +181,9 @@ public:
             Offset inQueuedCount);
         bool IsWriteQueued() const
             { return mWriteQueuedFlag; }
+        ECComputePool* GetComputePool() const;
+        int GetWriteBehindSize() const;
+        int GetWriteThreshold() const;
     private:
         Impl& mOuter;
         bool  mWriteQueuedFlag;
@@ -199,8 +204,10 @@ public:
         int         inOpTimeoutSec,
         int         inIdleTimeoutSec,
         int         inMaxWriteSize,
-        const char* inLogPrefixPtr,
-        int64_t     inChunkServerInitialSeqNum);
+        const char*    inLogPrefixPtr,
+        int64_t        inChunkServerInitialSeqNum,
+        ECComputePool* inComputePoolPtr = 0,
+        int            inWriteBehindSize = 0);
     virtual ~Writer();
     int Open(
         kfsFileId_t inFileId,
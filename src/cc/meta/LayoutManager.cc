@@ -2934,6 +2934,19 @@ LayoutManager::SetParameters(const Properties& props, int clientPort)
     mClientCSAllowClearTextFlag = props.getValue(
         "metaServer.clientCSAllowClearText",
         mClientCSAllowClearTextFlag ? 1 : 0) != 0;
+    bool clientCSKtlsOkFlag = true;
+    if (mClientCSAllowClearTextFlag && (
+            props.getValue("chunkServer.client.auth.psk.ktls", 0) != 0 ||
+            props.getValue("chunkServer.client.auth.X509.ktls", 0) != 0)) {
+        // Kernel tls state cannot be removed from the socket, and the chunk
+        // server would fail to switch to clear text after authentication.
+        KFS_LOG_STREAM_ERROR <<
+            "chunkServer.client.auth ktls is on, conflicts with"
+            " metaServer.clientCSAllowClearText, turning clear text off" <<
+        KFS_LOG_EOM;
+        mClientCSAllowClearTextFlag = false;
+        clientCSKtlsOkFlag          = false;
+    }
     mCSAccessValidForTimeSec = max(LEASE_INTERVAL_SECS, props.getValue(
         "metaServer.CSAccessValidForTimeSec", mCSAccessValidForTimeSec));
     mMinWriteLeaseTimeSec = props.getValue(
@@ -3073,8 +3086,8 @@ LayoutManager::SetParameters(const Properties& props, int clientPort)
         mVerifyAllOpsPermissionsParamFlag ||
         mClientAuthContext.IsAuthRequired();
     SetChunkServersProperties(props);
-    return (csOkFlag && cliOkFlag && validClusterKeyFlag &&
-        0 == userAndGroupErr && 0 == netDispatchErr);
+    return (csOkFlag && cliOkFlag && clientCSKtlsOkFlag &&
+        validClusterKeyFlag && 0 == userAndGroupErr && 0 == netDispatchErr);
 }
 
 bool
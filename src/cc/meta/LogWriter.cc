@@ -50,6 +50,8 @@
 #include "kfsio/PrngIsaac64.h"
 #include "kfsio/NetErrorSimulator.h"
 #include "kfsio/NetManagerWatcher.h"
+#include "kfsio/Globals.h"
+#include "kfsio/LatencyHistogram.h"
 
 #include "qcdio/QCThread.h"
 #include "qcdio/QCMutex.h"
@@ -68,6 +70,7 @@ namespace KFS
 {
 using std::ofstream;
 using std::vector;
+using libkfsio::globals;
 
 class LogWriter::Impl :
     private ITimeout,
@@ -159,6 +162,7 @@ public:
           mFailureSimulationInterval(0),
           mLogTimeUsec(0),
           mLogTimeOpsCount(0),
+          mLogTimeHistogram("Latency LOG_COMMIT usec"),
           mLogErrorOpsCount(0),
           mPrevLogTimeOpsCount(0),
           mPrevLogTimeUsec(0),
@@ -466,6 +470,7 @@ public:
             mNetManagerPtr->UnRegisterTimeoutHandler(this);
             mNetManagerPtr = 0;
         }
+        globals().counterManager.RemoveHistogram(&mLogTimeHistogram);
         mMetaVrSM.Shutdown();
         mLogTransmitter.Shutdown();
         NetErrorSimulatorConfigure(mNetManager, 0);
@@ -942,6 +947,7 @@ private:
     int64_t           mFailureSimulationInterval;
     int64_t           mLogTimeUsec;
     int64_t           mLogTimeOpsCount;
+    LatencyHistogram  mLogTimeHistogram;
     int64_t           mLogErrorOpsCount;
     int64_t           mPrevLogTimeOpsCount;
     int64_t           mPrevLogTimeUsec;
@@ -1242,6 +1248,7 @@ private:
         mThread.Start(this, kStackSize, "MetaLogWriter",
             QCThread::CpuAffinity(mCpuAffinityIndex));
         mNetManagerPtr->RegisterTimeoutHandler(this);
+        globals().counterManager.AddHistogram(&mLogTimeHistogram);
         return 0;
     }
     int Cancel(
@@ -1384,8 +1391,12 @@ private:
                 theFirstItemFlag = false;
                 if (META_LOG_WRITER_CONTROL != thePtr->op) {
                     if (0 == thePtr->status) {
-                        mLogTimeUsec += theStartTime - theReq.submitTime;
+                        const int64_t theLogTime =
+                            theStartTime - theReq.submitTime;
+                        mLogTimeUsec += theLogTime;
                         mLogTimeOpsCount++;
+                        mLogTimeHistogram.Update(theLogTime);
+                        theReq.logTime = theLogTime;
                     } else {
                         mLogErrorOpsCount++;
                     }
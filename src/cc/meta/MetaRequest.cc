@@ -51,6 +51,7 @@
 #include "common/time.h"
 #include "common/kfserrno.h"
 #include "common/StringIo.h"
+#include "common/SlabAllocator.h"
 
 #include "qcdio/QCThread.h"
 #include "qcdio/QCUtils.h"
@@ -67,6 +68,8 @@
 #include <sstream>
 #include <limits>
 #include <fstream>
+#include <deque>
+#include <algorithm>
 
 namespace KFS {
 
@@ -80,12 +83,227 @@ using std::make_pair;
 using std::numeric_limits;
 using std::hex;
 using std::ofstream;
+using std::deque;
+using std::pair;
+using std::lower_bound;
 using KFS::libkfsio::globals;
 
 static bool    gWormMode = false;
 static string  gChunkmapDumpDir(".");
 static const char* const ftypes[] = { "empty", "file", "dir" };
 
+// Log of the recent name space changes, used to piggyback client meta data
+// cache invalidations on the responses. The clients that opt in send the
+// sequence number of the last response they received, and get back the ids
+// of the directories and files modified since, or "invalidate all" if the log
+// no longer covers the range. The attributes cached by the client remain
+// valid for up to the lease time without re-validation, therefore the
+// staleness is bounded by the lease time for the clients that do not talk to
+// the meta server, and by the time until the next response otherwise.
+// The response sequence is captured right after the request is handled, in
+// order to report the changes that happen between handling the request and
+// sending the response with the next response, as the response attributes
+// might not reflect these changes.
+class MetaCacheChangeLog
+{
+public:
+    MetaCacheChangeLog()
+        : mMutex(),
+          mLog(),
+          mSeq(-1),
+          mMinSeq(-1),
+          mLeaseSec(0),
+          mMaxLogSize(8 << 10),
+          mMaxInvalidateCount(256)
+        {}
+    void SetParameters(
+        const Properties& props)
+    {
+        QCStMutexLocker locker(mMutex);
+        mLeaseSec = props.getValue(
+            "metaServer.clientMetaCacheLeaseSec", mLeaseSec);
+        mMaxLogSize = max(1, props.getValue(
+            "metaServer.clientMetaCacheLogSize", mMaxLogSize));
+        mMaxInvalidateCount = max(1, props.getValue(
+            "metaServer.clientMetaCacheMaxInvalidateCount",
+            mMaxInvalidateCount));
+        if (mLeaseSec <= 0) {
+            InvalidateAll();
+        }
+        Trim();
+    }
+    void Record(
+        const MetaRequest& req)
+    {
+        if (0 != req.status || req.replayFlag) {
+            return;
+        }
+        switch (req.op) {
+            case META_CREATE:
+                Add(static_cast<const MetaCreate&>(req).dir);
+                break;
+            case META_MKDIR:
+                Add(static_cast<const MetaMkdir&>(req).dir);
+                break;
+            case META_REMOVE:
+                Add(static_cast<const MetaRemove&>(req).dir);
+                break;
+            case META_RMDIR:
+                Add(static_cast<const MetaRmdir&>(req).dir);
+                break;
+            case META_LINK:
+                Add(static_cast<const MetaLink&>(req).dir);
+                break;
+            case META_SETMTIME:
+                Add(static_cast<const MetaSetMtime&>(req).dir,
+                    static_cast<const MetaSetMtime&>(req).fid);
+                break;
+            case META_CHMOD:
+                Add(static_cast<const MetaChmod&>(req).fid);
+                break;
+            case META_CHOWN:
+                Add(static_cast<const MetaChown&>(req).fid);
+                break;
+            case META_TRUNCATE:
+                Add(static_cast<const MetaTruncate&>(req).fid);
+                break;
+            case META_CHANGE_FILE_REPLICATION:
+                Add(static_cast<const MetaChangeFileReplication&>(req).fid);
+                break;
+            case META_COALESCE_BLOCKS:
+                Add(static_cast<const MetaCoalesceBlocks&>(req).srcFid,
+                    static_cast<const MetaCoalesceBlocks&>(req).dstFid);
+                break;
+            case META_RENAME: {
+                // Renamed directory invalidates the cached path names of
+                // the entire sub tree. Renamed file invalidates the source
+                // and destination directories entries, and the file.
+                const MetaRename& rename =
+                    static_cast<const MetaRename&>(req);
+                const MetaFattr* const fa = rename.srcFid < 0 ? 0 :
+                    metatree.getFattr(rename.srcFid);
+                if (! fa || KFS_DIR == fa->type || ! fa->parent) {
+                    QCStMutexLocker locker(mMutex);
+                    InvalidateAll();
+                } else {
+                    Add(rename.dir, fa->parent->id(), rename.srcFid);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    // Returns the current sequence, or -1 if the leases are not enabled.
+    int64_t GetSeq()
+    {
+        QCStMutexLocker locker(mMutex);
+        if (mLeaseSec <= 0) {
+            return -1;
+        }
+        if (mSeq < 0) {
+            // Start from the current time in order to make the sequences
+            // issued by a different meta server, or prior to restart, appear
+            // out of the range.
+            mSeq    = microseconds();
+            mMinSeq = mSeq;
+        }
+        return mSeq;
+    }
+    void Put(
+        const MetaRequest& req,
+        ReqOstream&        os)
+    {
+        if (req.metaCacheSeq < 0 || req.metaCacheEndSeq < 0) {
+            return;
+        }
+        QCStMutexLocker locker(mMutex);
+        if (mLeaseSec <= 0) {
+            return;
+        }
+        os <<
+            (req.shortRpcFormatFlag ? "mcs:" : "Meta-cache-seq: ") <<
+                req.metaCacheEndSeq << "\r\n" <<
+            (req.shortRpcFormatFlag ? "mcl:" : "Meta-cache-lease: ") <<
+                mLeaseSec << "\r\n"
+        ;
+        if (req.metaCacheSeq == req.metaCacheEndSeq) {
+            return;
+        }
+        Log::const_iterator it  = mLog.end();
+        Log::const_iterator end = mLog.end();
+        if (mMinSeq <= req.metaCacheSeq &&
+                req.metaCacheSeq < req.metaCacheEndSeq) {
+            it  = lower_bound(mLog.begin(), mLog.end(),
+                Entry(req.metaCacheSeq + 1, fid_t(-1)));
+            end = lower_bound(it, end,
+                Entry(req.metaCacheEndSeq + 1, fid_t(-1)));
+        }
+        if (it == end || mMaxInvalidateCount < end - it) {
+            os << (req.shortRpcFormatFlag ?
+                "mca:1\r\n" : "Meta-cache-invalidate-all: 1\r\n");
+            return;
+        }
+        os << (req.shortRpcFormatFlag ? "mci:" : "Meta-cache-invalidate: ");
+        const char* sep = "";
+        for (; it != end; ++it) {
+            os << sep << it->second;
+            sep = ",";
+        }
+        os << "\r\n";
+    }
+private:
+    typedef pair<int64_t, fid_t> Entry;
+    typedef deque<Entry>         Log;
+
+    QCMutex mMutex;
+    Log     mLog;
+    int64_t mSeq;
+    int64_t mMinSeq;
+    int     mLeaseSec;
+    int     mMaxLogSize;
+    int     mMaxInvalidateCount;
+
+    void Add(
+        fid_t fid,
+        fid_t otherFid = -1,
+        fid_t thirdFid = -1)
+    {
+        QCStMutexLocker locker(mMutex);
+        if (mLeaseSec <= 0 || mSeq < 0) {
+            return;
+        }
+        mLog.push_back(Entry(++mSeq, fid));
+        if (0 <= otherFid && otherFid != fid) {
+            mLog.push_back(Entry(mSeq, otherFid));
+        }
+        if (0 <= thirdFid && thirdFid != fid && thirdFid != otherFid) {
+            mLog.push_back(Entry(mSeq, thirdFid));
+        }
+        Trim();
+    }
+    void InvalidateAll()
+    {
+        mLog.clear();
+        if (0 <= mSeq) {
+            mMinSeq = ++mSeq;
+        }
+    }
+    void Trim()
+    {
+        while ((size_t)mMaxLogSize < mLog.size()) {
+            mMinSeq = mLog.front().first;
+            mLog.pop_front();
+        }
+    }
+private:
+    MetaCacheChangeLog(
+        const MetaCacheChangeLog&);
+    MetaCacheChangeLog& operator=(
+        const MetaCacheChangeLog&);
+};
+static MetaCacheChangeLog sMetaCacheChangeLog;
+
 class StIdempotentRequestHandler
 {
 public:
@@ -220,6 +438,7 @@ OkHeader(const MetaRequest* op, ReqOstream &os, bool checkStatus = true)
             "\r\n"
             "Status: 0\r\n"
         );
+        sMetaCacheChangeLog.Put(*op, os);
         return true;
     }
     os <<
@@ -241,6 +460,7 @@ OkHeader(const MetaRequest* op, ReqOstream &os, bool checkStatus = true)
             "\r\n";
         }
     }
+    sMetaCacheChangeLog.Put(*op, os);
     if (checkStatus && op->status < 0) {
         os << "\r\n";
     }
@@ -4181,6 +4401,7 @@ MetaStats::handle()
     ostringstream& os = GetTmpOStringStream();
     status = 0;
     globals().counterManager.Show(os);
+    MetaRequest::ShowAllocatorStats(os);
     stats = os.str();
 }
 
@@ -4572,6 +4793,10 @@ MetaRequest::SubmitEnd()
     if (suspended) {
         processTime = microseconds() - processTime;
     } else {
+        sMetaCacheChangeLog.Record(*this);
+        if (0 <= metaCacheSeq) {
+            metaCacheEndSeq = sMetaCacheChangeLog.GetSeq();
+        }
         gNetDispatch.Dispatch(this);
     }
 }
@@ -4592,6 +4817,32 @@ MetaRequest::Init()
     sMetaRequestCount++;
 }
 
+static SlabAllocator&
+GetMetaRequestAllocator()
+{
+    // Never destroyed, as requests can be deleted by static destructors.
+    static SlabAllocator& sAllocator = *(new SlabAllocator("Meta request"));
+    return sAllocator;
+}
+
+/* static */ void*
+MetaRequest::operator new(size_t size)
+{
+    return GetMetaRequestAllocator().Allocate(size);
+}
+
+/* static */ void
+MetaRequest::operator delete(void* ptr, size_t size)
+{
+    GetMetaRequestAllocator().Deallocate(ptr, size);
+}
+
+/* static */ void
+MetaRequest::ShowAllocatorStats(ostream& os)
+{
+    GetMetaRequestAllocator().Show(os);
+}
+
 /* virtual */
 MetaRequest::~MetaRequest()
 {
@@ -4634,6 +4885,7 @@ MetaRequest::SetParameters(const Properties& props)
         "metaServer.request.requireHeaderChecksum", 0) != 0;
     sVerifyHeaderChecksumFlag = props.getValue(
         "metaServer.request.verifyHeaderChecksum", 1) != 0;
+    sMetaCacheChangeLog.SetParameters(props);
 }
 
 /* static */ uint32_t
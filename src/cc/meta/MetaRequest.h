@@ -270,6 +270,7 @@ struct MetaRequest {
     int             clientRackId;    //!< set by client
     int64_t         submitTime;      //!< to time requests, optional.
     int64_t         processTime;     //!< same as previous
+    int64_t         logTime;         //!< log commit time, -1 if not logged
     string          statusMsg;       //!< optional human readable status message
     seq_t           opSeqno;         //!< command sequence # sent by the client
     seq_t           seqno;           //!< sequence no. global ordering
@@ -293,6 +294,8 @@ struct MetaRequest {
     kfsGid_t        egroup;
     int64_t         maxWaitMillisec;
     int64_t         sessionEndTime;
+    int64_t         metaCacheSeq; //!< client meta cache sequence, -1 if none
+    int64_t         metaCacheEndSeq; //!< meta cache sequence after handle()
     MetaRequest*    next;
     KfsCallbackObj* clnt;            //!< completion handler.
 
@@ -304,6 +307,7 @@ struct MetaRequest {
           clientRackId(-1),
           submitTime(0),
           processTime(0),
+          logTime(-1),
           statusMsg(),
           opSeqno(opSeq),
           seqno(-1),
@@ -327,6 +331,8 @@ struct MetaRequest {
           egroup(kKfsGroupNone),
           maxWaitMillisec(-1),
           sessionEndTime(0),
+          metaCacheSeq(-1),
+          metaCacheEndSeq(-1),
           next(0),
           clnt(0),
           recursionCount(0)
@@ -376,6 +382,7 @@ struct MetaRequest {
         .Def2("UserId",                  "u", &MetaRequest::euser,          kKfsUserNone)
         .Def2("GroupId",                 "g", &MetaRequest::egroup,        kKfsGroupNone)
         .Def2("Max-wait-ms",             "w", &MetaRequest::maxWaitMillisec, int64_t(-1))
+        .Def2("Meta-cache-seq",        "mcs", &MetaRequest::metaCacheSeq,    int64_t(-1))
         ;
     }
     template<typename T> static T& IoParserDef(T& parser)
@@ -443,6 +450,11 @@ struct MetaRequest {
     static LogWriter& GetLogWriter()
         { return sLogWriter; }
     static bool Initialize();
+    // Requests are allocated from the size class slab pools with per thread
+    // free lists, see common/SlabAllocator.h
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr, size_t size);
+    static void ShowAllocatorStats(ostream& os);
 protected:
     virtual void response(ReqOstream& /* os */) {}
     virtual ~MetaRequest();
@@ -455,6 +467,7 @@ protected:
         submitCount         = 0;
         submitTime          = 0;
         processTime         = 0;
+        logTime             = -1;
         statusMsg           = string();
         opSeqno             = -1;
         seqno               = -1;
@@ -477,6 +490,8 @@ protected:
         egroup              = kKfsGroupNone;
         maxWaitMillisec     = -1;
         sessionEndTime      = 0;
+        metaCacheSeq        = -1;
+        metaCacheEndSeq     = -1;
         next                = 0;
         clnt                = 0;
         recursionCount      = 0;
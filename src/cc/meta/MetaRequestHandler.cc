@@ -252,6 +252,7 @@ MakeMetaRequestHandler(
     .MakeParser("VR_GET_STATUS",
         META_VR_GET_STATUS,
         static_cast<const MetaVrGetStatus*>(0))
+    .MakeParsersDone()
     ;
 }
 
@@ -277,6 +278,7 @@ MakeMetaRequestLogXmitHandler(
     .MakeParser("VSV",
         META_VR_START_VIEW,
         static_cast<const MetaVrStartView*>(0))
+    .MakeParsersDone()
     ;
 }
 
@@ -720,7 +722,8 @@ MakeIoMetaRequestHandler(
 {
     const bool kShortNamesFlag = true;
     static T sHandler;
-    return AddMetaRequestLog(sHandler, kShortNamesFlag);
+    return AddMetaRequestLog(sHandler, kShortNamesFlag)
+    .MakeParsersDone();
 }
 
 typedef PropertiesTokenizerT<
@@ -842,6 +845,7 @@ MakeLogMetaRequestHandler(
     .MakeParser("CKE",
         META_CRYPTO_KEY_EXPIRED,
         static_cast<const MetaCryptoKeyExpired*>(0))
+    .MakeParsersDone()
     ;
 }
 
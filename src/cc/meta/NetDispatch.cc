@@ -46,6 +46,8 @@
 #include "kfsio/SslFilter.h"
 #include "kfsio/CryptoKeys.h"
 #include "kfsio/NetManagerWatcher.h"
+#include "kfsio/LatencyHistogram.h"
+#include "kfsio/TraceRing.h"
 
 #include "common/Properties.h"
 #include "common/MsgLogger.h"
@@ -521,7 +523,8 @@ NetDispatch::NetDispatch()
       mClientThreadCount(0),
       mClientThreadsStartCpuAffinity(-1),
       mWatchdog(),
-      mNetManagerWatcher("main", globalNetManager())
+      mNetManagerWatcher("main", globalNetManager()),
+      mMetricsExporter(globalNetManager(), "qfs_meta_")
 {
     mWatchdog.Register(mNetManagerWatcher);
 }
@@ -647,6 +650,7 @@ NetDispatch::Start(MetaDataSync& metaDataSync)
     } else {
         err = -EINVAL;
     }
+    mMetricsExporter.Shutdown();
     gChildProcessTracker.CancelAll();
     mMetaDataStore.Shutdown();
     mClientManager.Shutdown();
@@ -866,6 +870,22 @@ public:
         const int64_t reqTime     = reqTimeUsec > 0 ? reqTimeUsec : 0;
         const int64_t reqProcTime =
             reqProcTimeUsec > 0 ? reqProcTimeUsec : 0;
+        const int64_t reqWaitTime = reqTime - reqProcTime;
+        mWaitHistogram[  0].Update(reqWaitTime);
+        mExecHistogram[  0].Update(reqProcTime);
+        mWaitHistogram[idx].Update(reqWaitTime);
+        mExecHistogram[idx].Update(reqProcTime);
+        if (mTraceRing.Sample()) {
+            TraceRing::Record rec;
+            rec.mTimeUsec = timeNowUsec;
+            rec.mSeq      = op.opSeqno;
+            rec.mWaitUsec = reqWaitTime;
+            rec.mExecUsec = reqProcTime;
+            rec.mLogUsec  = op.logTime;
+            rec.mOp       = idx;
+            rec.mStatus   = op.status;
+            mTraceRing.Put(rec);
+        }
         mRequest[  0].mCnt++;
         mRequest[  0].mTime     += reqTime;
         mRequest[  0].mProcTime += reqProcTime;
@@ -942,6 +962,7 @@ public:
             mLogLevel = logLevel;
         }
         mNextTime += mStatsIntervalMicroSec;
+        mTraceRing.SetParameters("metaServer.statsGatherer.trace.", props);
     }
     void GetStatsCsv(
         ostream& os)
@@ -1005,7 +1026,8 @@ private:
         kReqTypeAllocNoLog = kOtherReqId + 1,
         kCpuUser           = kReqTypeAllocNoLog + 1,
         kCpuSys            = kCpuUser + 1,
-        kReqTypesCnt       = kCpuSys + 1
+        kReqTypesCnt       = kCpuSys + 1,
+        kReqHistogramsCnt  = kReqTypeAllocNoLog + 1
     };
     struct Counter
     {
@@ -1027,6 +1049,9 @@ private:
     int64_t             mSystemCpuMicroSec;
     MsgLogger::LogLevel mLogLevel;
     Counter             mRequest[kReqTypesCnt];
+    LatencyHistogram    mWaitHistogram[kReqHistogramsCnt];
+    LatencyHistogram    mExecHistogram[kReqHistogramsCnt];
+    TraceRing           mTraceRing;
     IOBuffer::WOStream  mWOStream;
 
     RequestStatsGatherer()
@@ -1036,8 +1061,28 @@ private:
           mUserCpuMicroSec(0),
           mSystemCpuMicroSec(0),
           mLogLevel(MsgLogger::kLogLevelNOTICE),
+          mTraceRing(),
           mWOStream()
-        {}
+    {
+        // Ensure that globals constructed first, as the histograms are
+        // removed from the counter manager by the destructor.
+        CounterManager& manager = globals().counterManager;
+        for (int i = 0; i < kReqHistogramsCnt; i++) {
+            const string name = string("Latency ") + GetRowName(i);
+            mWaitHistogram[i].SetName((name + " wait usec").c_str());
+            mExecHistogram[i].SetName((name + " exec usec").c_str());
+            manager.AddHistogram(&mWaitHistogram[i]);
+            manager.AddHistogram(&mExecHistogram[i]);
+        }
+    }
+    ~RequestStatsGatherer()
+    {
+        CounterManager& manager = globals().counterManager;
+        for (int i = 0; i < kReqHistogramsCnt; i++) {
+            manager.RemoveHistogram(&mWaitHistogram[i]);
+            manager.RemoveHistogram(&mExecHistogram[i]);
+        }
+    }
 
     static const char* GetRowName(
         int idx)
@@ -1084,8 +1129,15 @@ int NetDispatch::SetParameters(const Properties& props)
     globalNetManager().SetMaxAcceptsPerRead(props.getValue(
         "metaServer.net.maxAcceptsPerRead",
         globalNetManager().GetMaxAcceptsPerRead()));
+    globalNetManager().SetEdgeTriggered(props.getValue(
+        "metaServer.net.edgeTriggered",
+        globalNetManager().IsEdgeTriggered() ? 1 : 0) != 0);
+    globalNetManager().SetBusyPollUsec(props.getValue(
+        "metaServer.net.busyPollUsec",
+        globalNetManager().GetBusyPollUsec()));
 
     sReqStatsGatherer.SetParameters(props);
+    mMetricsExporter.SetParameters("metaServer.metrics.", props);
     mClientManager.SetParameters(props);
     mMetaDataStore.SetParameters("metaServer.dataStore.", props);
 
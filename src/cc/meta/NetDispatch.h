@@ -36,6 +36,7 @@
 #include "kfsio/DelegationToken.h"
 #include "kfsio/CryptoKeys.h"
 #include "kfsio/NetManagerWatcher.h"
+#include "kfsio/MetricsExporter.h"
 
 #include <ostream>
 
@@ -132,6 +133,7 @@ private:
     int                mClientThreadsStartCpuAffinity;
     Watchdog           mWatchdog;
     NetManagerWatcher  mNetManagerWatcher;
+    MetricsExporter    mMetricsExporter;
 private:
     NetDispatch(const NetDispatch&);
     NetDispatch& operator=(const NetDispatch&);
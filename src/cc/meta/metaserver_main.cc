@@ -587,6 +587,7 @@ MetaServer::SetParameters(const Properties& props)
            "metaServer.resolverCacheExpiration",
             globalNetManager().GetResolverCacheExpiration())
     );
+    Resolver::SetParameters("metaServer.resolver", props);
     if (mLogWriterRunningFlag) {
         MetaLogWriterControl* const op = new MetaLogWriterControl(
             MetaLogWriterControl::kSetParameters);
@@ -88,6 +88,9 @@ public:
           mIoVecPerThreadCount(0),
           mFreeFdHead(kFreeFdEnd),
           mReqWaitersCount(0),
+          mMaxWriteCoalesceCount(0),
+          mCoalescedWriteCount(0),
+          mCoalescedWriteBlockCount(0),
           mDebugTracerPtr(0),
           mIoStartObserverPtr(0),
           mRequestProcessorsPtr(0),
@@ -156,6 +159,21 @@ public:
         outReadBlockCount   = mPendingReadBlockCount;
         outWriteBlockCount  = mPendingWriteBlockCount;
     }
+    void SetMaxWriteCoalesceCount(
+        int inCount)
+    {
+        QCStMutexLocker theLocker(mMutex);
+        mMaxWriteCoalesceCount = Max(0, Min(int(kMaxWriteCoalesceCount),
+            inCount));
+    }
+    void GetCoalescedWriteCount(
+        int64_t& outRequestCount,
+        int64_t& outBlockCount)
+    {
+        QCStMutexLocker theLocker(mMutex);
+        outRequestCount = mCoalescedWriteCount;
+        outBlockCount   = mCoalescedWriteBlockCount;
+    }
     OpenFileStatus OpenFile(
         const char* inFileNamePtr,
         int64_t     inMaxFileSize,
@@ -175,6 +193,35 @@ public:
         Time          inTimeWaitNanoSec);
     Status AllocateFileSpace(
         FileIdx inFileIdx);
+    int DupFd(
+        FileIdx inFileIdx)
+    {
+        QCStMutexLocker theLocker(mMutex);
+        if (inFileIdx < 0 || inFileIdx >= mFileCount || mFdPtr[inFileIdx] < 0) {
+            return -EBADF;
+        }
+        if (mRequestProcessorsPtr) {
+            return -ENOTSUP;
+        }
+        // The descriptor can not change or be closed while the file is open,
+        // and the mutex is held.
+        const FileInfo& theInfo = mFileInfoPtr[inFileIdx];
+        if (theInfo.mOpenPendingFlag || theInfo.mClosedFlag) {
+            return -EAGAIN;
+        }
+        if (theInfo.mOpenError != kOpenErrorNone) {
+            return -Open2SysError(theInfo.mOpenError);
+        }
+        const int theFd = dup(mFdPtr[inFileIdx]);
+        if (theFd < 0 || fcntl(theFd, F_SETFD, FD_CLOEXEC)) {
+            const int theErr = errno;
+            if (0 <= theFd) {
+                close(theFd);
+            }
+            return (0 < theErr ? -theErr : -EBADF);
+        }
+        return theFd;
+    }
     EnqueueStatus Rename(
         const char*    inSrcFileNamePtr,
         const char*    inDstFileNamePtr,
@@ -467,6 +514,9 @@ private:
     int                mIoVecPerThreadCount;
     int                mFreeFdHead;
     int                mReqWaitersCount;
+    int                mMaxWriteCoalesceCount;
+    int64_t            mCoalescedWriteCount;
+    int64_t            mCoalescedWriteBlockCount;
     DebugTracer*       mDebugTracerPtr;
     IoStartObserver*   mIoStartObserverPtr;
     RequestProcessor** mRequestProcessorsPtr;
@@ -485,6 +535,12 @@ private:
         kRequestQueueCount
     };
     enum
+    {
+        // Max number of queued contiguous write requests to the same file
+        // issued as a single writev().
+        kMaxWriteCoalesceCount = 32
+    };
+    enum
     {
         kFreeFdOffset  = 2,
         kFreeFdEnd     = -1,
@@ -722,6 +778,17 @@ private:
         int*          inFdPtr,
         struct iovec* inIoVecPtr,
         int           inThreadIdx);
+    int CoalesceWrites(
+        Request&  inReq,
+        int       inThreadIdx,
+        Request** outReqsPtr);
+    Error WriteCoalesced(
+        int           inFd,
+        struct iovec* inIoVecPtr,
+        Request**     inReqsPtr,
+        int           inReqCount,
+        int64_t&      outIoByteCount,
+        int&          outSysError);
     void ProcessOpenOrCreate(
         Request& inReq,
         int      inThreadIdx);
@@ -1460,18 +1527,22 @@ QCDiskQueue::Queue::Process(
     if (mRequestProcessorsPtr && 0 < theAllocSize) {
         mFileInfoPtr[inReq.mFileIdx].mSpaceAllocPendingFlag = false;
     }
-    const RequestId theReqId = GetRequestId(inReq);
+    Request*  theReqs[kMaxWriteCoalesceCount];
+    const int theReqCount = CoalesceWrites(inReq, inThreadIdx, theReqs);
     QCStMutexUnlocker theUnlock(mMutex);
 
-    Trace("process", inReq);
-    if (mIoStartObserverPtr) {
-        mIoStartObserverPtr->Notify(
-            inReq.mReqType,
-            theReqId,
-            inReq.mFileIdx,
-            inReq.mBlockIdx,
-            inReq.mBufferCount
-        );
+    for (int i = 0; i < theReqCount; i++) {
+        Request& theReq = *theReqs[i];
+        Trace("process", theReq);
+        if (mIoStartObserverPtr) {
+            mIoStartObserverPtr->Notify(
+                theReq.mReqType,
+                GetRequestId(theReq),
+                theReq.mFileIdx,
+                theReq.mBlockIdx,
+                theReq.mBufferCount
+            );
+        }
     }
     if (mRequestProcessorsPtr) {
         const bool theGetBufFlag = ! theBufPtr[0] &&
@@ -1541,6 +1612,29 @@ QCDiskQueue::Queue::Process(
         theError    = kErrorSeek;
         theSysError = errno;
     }
+    if (1 < theReqCount) {
+        int64_t theIoByteCnt = 0;
+        if (theError == kErrorNone) {
+            theError = WriteCoalesced(theFd, inIoVecPtr, theReqs, theReqCount,
+                theIoByteCnt, theSysError);
+        }
+        theUnlock.Lock();
+        // Complete each request individually, attributing the bytes written
+        // in request order.
+        for (int i = 0; i < theReqCount; i++) {
+            Request&      theReq   = *theReqs[i];
+            const int64_t theSize  = int64_t(theReq.mBufferCount) * mBlockSize;
+            const int64_t theBytes = Min(theSize, theIoByteCnt);
+            theIoByteCnt -= theBytes;
+            const bool theDoneFlag = theError == kErrorNone || theBytes == theSize;
+            RequestComplete(theReq,
+                theDoneFlag ? kErrorNone : theError,
+                theDoneFlag ? 0 : theSysError,
+                theBytes
+            );
+        }
+        return;
+    }
     BuffersIterator theItr(*this, inReq, inReq.mBufferCount);
     int             theBufCnt    = inReq.mBufferCount;
     int64_t         theIoByteCnt = 0;
@@ -1601,6 +1695,95 @@ QCDiskQueue::Queue::Process(
     RequestComplete(inReq, theError, theSysError, theIoByteCnt, theGetBufFlag);
 }
 
+    int
+QCDiskQueue::Queue::CoalesceWrites(
+    Request&  inReq,
+    int       inThreadIdx,
+    Request** outReqsPtr)
+{
+    QCASSERT(mMutex.IsOwned());
+    outReqsPtr[0] = &inReq;
+    if (mMaxWriteCoalesceCount <= 1 || mRequestProcessorsPtr ||
+            inReq.mReqType != kReqTypeWrite ||
+            mFileInfoPtr[inReq.mFileIdx].mOpenPendingFlag) {
+        return 1;
+    }
+    // Pull queued writes that continue where the previous one ends, and issue
+    // these with the same writev(). Only the requests that are already queued
+    // are considered, in order not to add latency by waiting for more.
+    const int      theQueueIdx  = kIoQueueIdx +
+        (mRequestAffinityFlag ? inThreadIdx : 0);
+    const uint64_t theLastBlock = mFileInfoPtr[inReq.mFileIdx].mLastBlockIdx;
+    uint64_t       theNextBlock = inReq.mBlockIdx + inReq.mBufferCount;
+    int            theCount     = 1;
+    Request*       theReqPtr;
+    while (theCount < mMaxWriteCoalesceCount &&
+            (theReqPtr = Front(theQueueIdx)) &&
+            theReqPtr->mReqType == kReqTypeWrite &&
+            theReqPtr->mFileIdx == inReq.mFileIdx &&
+            theReqPtr->mBlockIdx == theNextBlock &&
+            0 < theReqPtr->mBufferCount &&
+            theNextBlock + theReqPtr->mBufferCount <= theLastBlock &&
+            GetBuffersPtr(*theReqPtr)[0]) {
+        RemoveWithSubRequests(*theReqPtr);
+        theReqPtr->mInFlightFlag = true;
+        theNextBlock += theReqPtr->mBufferCount;
+        mCoalescedWriteBlockCount += theReqPtr->mBufferCount;
+        mCoalescedWriteCount++;
+        outReqsPtr[theCount++] = theReqPtr;
+    }
+    return theCount;
+}
+
+    QCDiskQueue::Error
+QCDiskQueue::Queue::WriteCoalesced(
+    int           inFd,
+    struct iovec* inIoVecPtr,
+    Request**     inReqsPtr,
+    int           inReqCount,
+    int64_t&      outIoByteCount,
+    int&          outSysError)
+{
+    outIoByteCount = 0;
+    outSysError    = 0;
+    int     theIoVecCnt = 0;
+    ssize_t theIoBytes  = 0;
+    for (int i = 0; i < inReqCount; i++) {
+        Request&        theReq = *inReqsPtr[i];
+        BuffersIterator theItr(*this, theReq, theReq.mBufferCount);
+        char*           thePtr;
+        while ((thePtr = theItr.Get())) {
+            inIoVecPtr[theIoVecCnt  ].iov_base = thePtr;
+            inIoVecPtr[theIoVecCnt++].iov_len  = mBlockSize;
+            theIoBytes += mBlockSize;
+            if (theIoVecCnt < mIoVecPerThreadCount) {
+                continue;
+            }
+            const ssize_t theNWr = writev(inFd, inIoVecPtr, theIoVecCnt);
+            if (theNWr > 0) {
+                outIoByteCount += theNWr;
+            }
+            if (theNWr != theIoBytes) {
+                outSysError = errno;
+                return kErrorWrite;
+            }
+            theIoVecCnt = 0;
+            theIoBytes  = 0;
+        }
+    }
+    if (0 < theIoVecCnt) {
+        const ssize_t theNWr = writev(inFd, inIoVecPtr, theIoVecCnt);
+        if (theNWr > 0) {
+            outIoByteCount += theNWr;
+        }
+        if (theNWr != theIoBytes) {
+            outSysError = errno;
+            return kErrorWrite;
+        }
+    }
+    return kErrorNone;
+}
+
     void
 QCDiskQueue::Queue::ProcessOpenOrCreate(
     Request& inReq,
@@ -2576,6 +2759,28 @@ QCDiskQueue::GetPendingCount(
     }
 }
 
+    void
+QCDiskQueue::SetMaxWriteCoalesceCount(
+    int inCount)
+{
+    if (mQueuePtr) {
+        mQueuePtr->SetMaxWriteCoalesceCount(inCount);
+    }
+}
+
+    void
+QCDiskQueue::GetCoalescedWriteCount(
+    int64_t& outRequestCount,
+    int64_t& outBlockCount)
+{
+    if (mQueuePtr) {
+        mQueuePtr->GetCoalescedWriteCount(outRequestCount, outBlockCount);
+    } else {
+        outRequestCount = 0;
+        outBlockCount   = 0;
+    }
+}
+
     QCDiskQueue::CompletionStatus
 QCDiskQueue::SyncIo(
     QCDiskQueue::ReqType         inReqType,
@@ -2737,3 +2942,10 @@ QCDiskQueue::AllocateFileSpace(
         Status(kErrorParameter)
     );
 }
+
+    int
+QCDiskQueue::DupFd(
+    QCDiskQueue::FileIdx inFileIdx)
+{
+    return (mQueuePtr ? mQueuePtr->DupFd(inFileIdx) : -EINVAL);
+}
@@ -428,6 +428,16 @@ public:
         int64_t& outReadBlockCount,
         int64_t& outWriteBlockCount);
 
+    // Set max number of queued contiguous write requests to the same file
+    // that can be issued with a single writev(). 0 or 1 turns coalescing off.
+    // Has no effect with request processors.
+    void SetMaxWriteCoalesceCount(
+        int inCount);
+
+    void GetCoalescedWriteCount(
+        int64_t& outRequestCount,
+        int64_t& outBlockCount);
+
     OpenFileStatus OpenFile(
         const char* inFileNamePtr,
         int64_t     inMaxFileSize           = -1,
@@ -476,6 +486,12 @@ public:
     Status AllocateFileSpace(
         FileIdx inFileIdx);
 
+    // Returns duplicate of the open file descriptor, or negative error code.
+    // The duplicate shares file status flags, including O_DIRECT, with the
+    // queue's descriptor. Not supported with request processors.
+    int DupFd(
+        FileIdx inFileIdx);
+
 private:
     class Queue;
     class RequestWaiter;
@@ -71,6 +71,8 @@ private:
 class QCFdPoll::Impl : public QCFdPollImplBase
 {
 public:
+    static bool IsEdgeTriggeredSupported()
+        { return false; }
     Impl(
         QCFdPollImplBase::Waker* inWakerPtr)
         : QCFdPollImplBase(inWakerPtr),
@@ -309,6 +311,8 @@ class QCFdPoll::Impl : public QCFdPollImplBase
 {
 public:
     enum { kFdCountHint = 1 << 10 };
+    static bool IsEdgeTriggeredSupported()
+        { return true; }
 
     Impl(
         QCFdPollImplBase::Waker* inWakerPtr)
@@ -416,6 +420,9 @@ private:
         if ((inOpType & kOpTypePri) != 0) {
             theRet += EPOLLPRI;
         }
+        if ((inOpType & kOpTypeEdgeTriggered) != 0) {
+            theRet |= EPOLLET;
+        }
         return theRet;
     }
     int FdPollMask(
@@ -475,6 +482,8 @@ private:
 class QCFdPoll::Impl : public QCFdPollImplBase
 {
 public:
+    static bool IsEdgeTriggeredSupported()
+        { return false; }
     Impl(
         QCFdPollImplBase::Waker* inWakerPtr)
         : QCFdPollImplBase(inWakerPtr),
@@ -937,6 +946,12 @@ QCFdPoll::Remove(
     return mImpl.Remove(inFd);
 }
 
+    /* static */ bool
+QCFdPoll::IsEdgeTriggeredSupported()
+{
+    return Impl::IsEdgeTriggeredSupported();
+}
+
     bool
 QCFdPoll::Wakeup()
 {
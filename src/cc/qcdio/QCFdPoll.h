@@ -41,7 +41,10 @@ public:
         kOpTypeOut   = 0x02,
         kOpTypePri   = 0x04,
         kOpTypeError = 0x08,
-        kOpTypeHup   = 0x10
+        kOpTypeHup   = 0x10,
+        // Add / Set only: report state changes, instead of the current
+        // state. Ignored if edge triggered mode is not supported.
+        kOpTypeEdgeTriggered = 0x20
     };
     typedef int Fd;
     QCFdPoll(
@@ -77,6 +80,7 @@ public:
         void*& outUserDataPtr);
     int Close();
     bool Wakeup();
+    static bool IsEdgeTriggeredSupported();
 private:
     class Impl;
     Impl& mImpl;
@@ -29,11 +29,17 @@
 #include "qcdebug.h"
 #include "qcstutils.h"
 #include "QCDLList.h"
+#include "QCThread.h"
 
 #include <sys/mman.h>
 #include <errno.h>
 #include <unistd.h>
 
+#ifdef QC_OS_NAME_LINUX
+#include <sys/syscall.h>
+#include <sched.h>
+#endif
+
 #if defined(QC_IO_BUFFER_POOL_TRACE_PUT)
 #include <execinfo.h>
 #endif
@@ -55,7 +61,8 @@ public:
           mFreeListPtr(0),
           mTotalCnt(0),
           mFreeCnt(0),
-          mBufSizeShift(0)
+          mBufSizeShift(0),
+          mNumaNode(-1)
         { List::Init(*this); }
 
     ~Partition()
@@ -64,7 +71,8 @@ public:
     int Create(
         int  inNumBuffers,
         int  inBufferSize,
-        bool inLockMemoryFlag)
+        bool inLockMemoryFlag,
+        int  inNumaNode)
     {
         int theBufSizeShift = -1;
         for (int i = inBufferSize; i > 0; i >>= 1, theBufSizeShift++)
@@ -90,6 +98,10 @@ public:
             mAllocPtr = 0;
             return (theRet == 0 ? -1 : theRet);
         }
+        if (0 <= inNumaNode) {
+            SetNumaNode(inNumaNode);
+            mNumaNode = inNumaNode;
+        }
         if (inLockMemoryFlag && mlock(mAllocPtr, mAllocSize) != 0) {
             const int theRet = errno;
             Destroy();
@@ -109,6 +121,24 @@ public:
         return 0;
     }
 
+    void SetNumaNode(
+        int inNumaNode)
+    {
+#if defined(QC_OS_NAME_LINUX) && defined(SYS_mbind)
+        // Prefer the node's memory. The memory is not touched yet, therefore
+        // the policy applies to all pages. The policy is advisory, ignore
+        // errors, for example when the kernel has no numa support.
+        const int     kMpolPreferred = 1;
+        unsigned long theNodeMask    = 0;
+        if (inNumaNode < (int)sizeof(theNodeMask) * 8) {
+            theNodeMask = 1UL << inNumaNode;
+            syscall(SYS_mbind, mAllocPtr, mAllocSize, kMpolPreferred,
+                &theNodeMask, sizeof(theNodeMask) * 8 + 1, 0);
+        }
+#else
+        (void)inNumaNode;
+#endif
+    }
     void Destroy()
     {
         delete [] mFreeListPtr;
@@ -122,6 +152,7 @@ public:
         mTotalCnt     = 0;
         mFreeCnt      = 0;
         mBufSizeShift = 0;
+        mNumaNode     = -1;
     }
 
     char* Get()
@@ -236,6 +267,9 @@ public:
     bool IsFull() const
         { return (mFreeCnt >= mTotalCnt); }
 
+    int GetNumaNode() const
+        { return mNumaNode; }
+
     typedef QCDLList<Partition, 0> List;
 
 private:
@@ -249,6 +283,7 @@ private:
     int          mTotalCnt;
     int          mFreeCnt;
     int          mBufSizeShift;
+    int          mNumaNode;
     Partition*   mPrevPtr[1];
     Partition*   mNextPtr[1];
 };
@@ -271,10 +306,14 @@ QCIoBufferPool::QCIoBufferPool()
     : mMutex(),
       mBufferSize(0),
       mFreeCnt(0),
-      mTotalCnt(0)
+      mTotalCnt(0),
+      mNumaFlag(false)
 {
     QCIoBufferPoolClientList::Init(mClientListPtr);
     Partition::List::Init(mPartitionListPtr);
+    for (int i = 0; i < kMaxNumaCpus; i++) {
+        mCpuNumaNode[i] = -1;
+    }
 }
 
 QCIoBufferPool::~QCIoBufferPool()
@@ -294,17 +333,34 @@ QCIoBufferPool::Create(
     int          inPartitionCount,
     int          inPartitionBufferCount,
     int          inBufferSize,
-    bool         inLockMemoryFlag)
+    bool         inLockMemoryFlag,
+    int          inNumaNodeCount /* = 0 */,
+    const int*   inNumaNodesPtr  /* = 0 */)
 {
     QCStMutexLocker theLock(mMutex);
     Destroy();
     mBufferSize = inBufferSize;
+    for (int i = 0; inNumaNodesPtr && i < inNumaNodeCount; i++) {
+        const QCThread::CpuAffinity theCpus =
+            QCThread::GetNumaNodeCpus(inNumaNodesPtr[i]);
+        if (theCpus == QCThread::CpuAffinity::None()) {
+            continue;
+        }
+        for (int k = 0; k < kMaxNumaCpus; k++) {
+            if (theCpus.IsSet(k) && mCpuNumaNode[k] < 0) {
+                mCpuNumaNode[k] = inNumaNodesPtr[i];
+                mNumaFlag       = true;
+            }
+        }
+    }
     int theErr = 0;
     for (int i = 0; i < inPartitionCount; i++) {
         Partition& thePart = *(new Partition());
         Partition::List::PushBack(mPartitionListPtr, thePart);
         theErr = thePart.Create(
-            inPartitionBufferCount, inBufferSize, inLockMemoryFlag);
+            inPartitionBufferCount, inBufferSize, inLockMemoryFlag,
+            (0 < inNumaNodeCount && inNumaNodesPtr) ?
+                inNumaNodesPtr[i % inNumaNodeCount] : -1);
         if (theErr) {
             Destroy();
             break;
@@ -325,6 +381,50 @@ QCIoBufferPool::Destroy()
     }
     mBufferSize = 0;
     mFreeCnt    = 0;
+    mNumaFlag   = false;
+    for (int i = 0; i < kMaxNumaCpus; i++) {
+        mCpuNumaNode[i] = -1;
+    }
+}
+
+int
+QCIoBufferPool::GetCurrentNumaNode() const
+{
+#ifdef QC_OS_NAME_LINUX
+    if (! mNumaFlag) {
+        return -1;
+    }
+    const int theCpu = sched_getcpu();
+    return ((0 <= theCpu && theCpu < kMaxNumaCpus) ?
+        mCpuNumaNode[theCpu] : -1);
+#else
+    return -1;
+#endif
+}
+
+QCIoBufferPool::Partition*
+QCIoBufferPool::GetPartition(
+    int inNumaNode)
+{
+    QCASSERT(mMutex.IsOwned());
+    // Always start from the first partition, to try to keep next
+    // partitions full, and be able to reclaim these if needed.
+    // With numa nodes, prefer the first partition allocated on the node.
+    Partition::List::Iterator theItr(mPartitionListPtr);
+    Partition* thePtr;
+    Partition* theFirstPtr = 0;
+    while ((thePtr = theItr.Next())) {
+        if (thePtr->IsEmpty()) {
+            continue;
+        }
+        if (inNumaNode < 0 || thePtr->GetNumaNode() == inNumaNode) {
+            return thePtr;
+        }
+        if (! theFirstPtr) {
+            theFirstPtr = thePtr;
+        }
+    }
+    return theFirstPtr;
 }
 
 char*
@@ -336,13 +436,8 @@ QCIoBufferPool::Get(
         return 0;
     }
     QCASSERT(mFreeCnt >= 1);
-    // Always start from the first partition, to try to keep next
-    // partitions full, and be able to reclaim these if needed.
-    Partition::List::Iterator theItr(mPartitionListPtr);
-    Partition* thePtr;
-    while ((thePtr = theItr.Next()) && thePtr->IsEmpty())
-        {}
-    char* const theBufPtr = thePtr ? thePtr->Get() : 0;
+    Partition* const thePtr    = GetPartition(GetCurrentNumaNode());
+    char* const      theBufPtr = thePtr ? thePtr->Get() : 0;
     QCASSERT(theBufPtr && mFreeCnt > 0);
     mFreeCnt--;
     return theBufPtr;
@@ -362,11 +457,9 @@ QCIoBufferPool::Get(
         return false;
     }
     QCASSERT(mFreeCnt >= inBufCnt);
-    Partition::List::Iterator theItr(mPartitionListPtr);
+    const int theNumaNode = GetCurrentNumaNode();
     for (int i = 0; i < inBufCnt; ) {
-        Partition* thePPtr;
-        while ((thePPtr = theItr.Next()) && thePPtr->IsEmpty())
-            {}
+        Partition* const thePPtr = GetPartition(theNumaNode);
         QCASSERT(thePPtr);
         for (char* theBPtr; i < inBufCnt && (theBPtr = thePPtr->Get()); i++) {
             mFreeCnt--;
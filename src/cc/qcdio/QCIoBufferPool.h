@@ -107,11 +107,16 @@ public:
 
     QCIoBufferPool();
     ~QCIoBufferPool();
+    // If numa nodes are specified, then the partitions memory is allocated
+    // from the nodes in round robin order, and Get() prefers the partitions
+    // allocated on the node of the cpu the caller runs on.
     int Create(
         int          inPartitionCount,
         int          inPartitionBufferCount,
         int          inBufferSize,
-        bool         inLockMemoryFlag);
+        bool         inLockMemoryFlag,
+        int          inNumaNodeCount = 0,
+        const int*   inNumaNodesPtr  = 0);
     void Destroy();
     char* Get(
         RefillReqId inRefillReqId = kRefillReqIdUndefined);
@@ -148,13 +153,19 @@ public:
         bool           inFlag);
 private:
     class Partition;
+    enum { kMaxNumaCpus = 64 };
     QCMutex    mMutex;
     Client*    mClientListPtr[1];
     Partition* mPartitionListPtr[1];
     int        mBufferSize;
     int        mFreeCnt;
     int        mTotalCnt;
+    bool       mNumaFlag;
+    int        mCpuNumaNode[kMaxNumaCpus];
 
+    int GetCurrentNumaNode() const;
+    Partition* GetPartition(
+        int inNumaNode);
     bool TryToRefill(
         RefillReqId inReqId,
         int         inBufCnt);
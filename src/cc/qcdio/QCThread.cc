@@ -32,6 +32,7 @@
 #include "qcdebug.h"
 
 #include <limits.h>
+#include <stdio.h>
 
 #ifdef QC_OS_NAME_LINUX
 #include <sys/types.h>
@@ -262,6 +263,49 @@ QCThread::SetCurrentThreadAffinity(CpuAffinity inAffinity)
     return 0;
 }
 
+    /* static */ QCThread::CpuAffinity
+QCThread::GetNumaNodeCpus(
+    int inNode)
+{
+    if (inNode < 0) {
+        return CpuAffinity::None();
+    }
+#ifdef QC_OS_NAME_LINUX
+    char theName[64];
+    snprintf(theName, sizeof(theName),
+        "/sys/devices/system/node/node%d/cpulist", inNode);
+    FILE* const theFilePtr = fopen(theName, "r");
+    if (! theFilePtr) {
+        return CpuAffinity::None();
+    }
+    // The list format is: 0-3,8-11
+    CpuAffinity theRet;
+    int         theFirst = -1;
+    int         theLast  = -1;
+    char        theSep   = 0;
+    while (fscanf(theFilePtr, "%d", &theFirst) == 1) {
+        theLast = theFirst;
+        if ((theSep = (char)fgetc(theFilePtr)) == '-') {
+            if (fscanf(theFilePtr, "%d", &theLast) != 1) {
+                break;
+            }
+            theSep = (char)fgetc(theFilePtr);
+        }
+        // CpuAffinity presently supports only first 64 cpus.
+        for (int i = theFirst; i <= theLast && i < 64; i++) {
+            theRet.Set(i);
+        }
+        if (theSep != ',') {
+            break;
+        }
+    }
+    fclose(theFilePtr);
+    return (theRet == CpuAffinity() ? CpuAffinity::None() : theRet);
+#else
+    return CpuAffinity::None();
+#endif
+}
+
     /* static */ int
 QCThread::SetName(
     const char* inNamePtr)
@@ -137,6 +137,10 @@ public:
         int inErrorCode);
     static int GetThreadCount();
     static int SetCurrentThreadAffinity(CpuAffinity inAffinity);
+    /// Return cpus of the numa node from /sys/devices/system/node on Linux,
+    /// or CpuAffinity::None() if the node does not exist.
+    static CpuAffinity GetNumaNodeCpus(
+        int inNode);
     static int SetName(
         const char* inNamePtr);
 
@@ -20,7 +20,7 @@
 // implied. See the License for the specific language governing
 // permissions and limitations under the License.
 //
-// Disk queue and io buffer pool unit test.
+// Disk queue and io buffer pool unit test, including write coalescing.
 //
 //----------------------------------------------------------------------------
 
@@ -35,6 +35,11 @@
 #include <iomanip>
 #include <iostream>
 #include <fstream>
+#include <map>
+
+#include <string.h>
+#include <signal.h>
+#include <sys/resource.h>
 
 using namespace std;
 
@@ -416,6 +421,353 @@ public:
         return 0;
     }
 
+    // Holds the io thread in the io start notification, in order to queue
+    // requests deterministically behind the request being processed.
+    class BlockingObserver : public QCDiskQueue::IoStartObserver
+    {
+    public:
+        BlockingObserver()
+            : mMutex(),
+              mCond(),
+              mHoldFlag(false),
+              mHeldFlag(false)
+            {}
+        virtual ~BlockingObserver()
+            {}
+        virtual void Notify(
+            QCDiskQueue::ReqType   /* inReqType */,
+            QCDiskQueue::RequestId /* inRequestId */,
+            QCDiskQueue::FileIdx   /* inFileIdx */,
+            QCDiskQueue::BlockIdx  /* inStartBlockIdx */,
+            int                    /* inBufferCount */)
+        {
+            QCStMutexLocker theLock(mMutex);
+            if (! mHoldFlag) {
+                return;
+            }
+            mHeldFlag = true;
+            mCond.NotifyAll();
+            while (mHoldFlag) {
+                mCond.Wait(mMutex);
+            }
+            mHeldFlag = false;
+        }
+        void Hold()
+        {
+            QCStMutexLocker theLock(mMutex);
+            mHoldFlag = true;
+        }
+        void WaitHeld()
+        {
+            QCStMutexLocker theLock(mMutex);
+            while (! mHeldFlag) {
+                mCond.Wait(mMutex);
+            }
+        }
+        void Release()
+        {
+            QCStMutexLocker theLock(mMutex);
+            mHoldFlag = false;
+            mCond.NotifyAll();
+        }
+    private:
+        QCMutex   mMutex;
+        QCCondVar mCond;
+        bool      mHoldFlag;
+        bool      mHeldFlag;
+
+    private:
+        BlockingObserver(
+            const BlockingObserver& inObserver);
+        BlockingObserver& operator=(
+            const BlockingObserver& inObserver);
+    };
+
+    // Records completion status of the write requests by start block index.
+    class WriteWaiter : public RequestWaiter
+    {
+    public:
+        struct Result
+        {
+            Result()
+                : mError(QCDiskQueue::kErrorNone),
+                  mIoByteCount(-1)
+                {}
+            QCDiskQueue::Error mError;
+            int64_t            mIoByteCount;
+        };
+        typedef map<QCDiskQueue::BlockIdx, Result> Results;
+
+        WriteWaiter()
+            : RequestWaiter(),
+              mResultsMutex(),
+              mResults()
+            {}
+        virtual bool Done(
+            QCDiskQueue::RequestId      inRequestId,
+            QCDiskQueue::FileIdx        inFileIdx,
+            QCDiskQueue::BlockIdx       inStartBlockIdx,
+            QCDiskQueue::InputIterator& inBufferItr,
+            int                         inBufferCount,
+            QCDiskQueue::Error          inCompletionCode,
+            int                         inSysErrorCode,
+            int64_t                     inIoByteCount)
+        {
+            QCStMutexLocker theLock(mResultsMutex);
+            Result& theResult = mResults[inStartBlockIdx];
+            theResult.mError       = inCompletionCode;
+            theResult.mIoByteCount = inIoByteCount;
+            theLock.Unlock();
+            return RequestWaiter::Done(
+                inRequestId,
+                inFileIdx,
+                inStartBlockIdx,
+                inBufferItr,
+                inBufferCount,
+                inCompletionCode,
+                inSysErrorCode,
+                inIoByteCount
+            );
+        }
+        Result Get(
+            QCDiskQueue::BlockIdx inBlockIdx)
+        {
+            QCStMutexLocker theLock(mResultsMutex);
+            return mResults[inBlockIdx];
+        }
+    private:
+        QCMutex mResultsMutex;
+        Results mResults;
+    };
+
+    static char BlockPattern(
+        QCDiskQueue::BlockIdx inBlockIdx)
+        { return (char)('a' + inBlockIdx % 26); }
+
+    static int Write(
+        QCDiskQueue&          inQueue,
+        QCIoBufferPool&       inBufPool,
+        RequestWaiter&        inWaiter,
+        QCDiskQueue::BlockIdx inBlockIdx,
+        int                   inBufferCount)
+    {
+        Iterator theItr(inBufferCount);
+        if (! inBufPool.Get(theItr, inBufferCount)) {
+            cerr << "failed to get " << inBufferCount << " buffers" << endl;
+            return 1;
+        }
+        theItr.Reset();
+        for (int i = 0; i < inBufferCount; i++) {
+            memset(theItr.Get(), BlockPattern(inBlockIdx + i),
+                inBufPool.GetBufferSize());
+        }
+        QCDiskQueue::EnqueueStatus const theStatus = inWaiter.Add(
+            inQueue.Write(0, inBlockIdx, &theItr.Reset(), inBufferCount,
+                &inWaiter));
+        if (theStatus.IsError()) {
+            cerr << "write: " << ToString(theStatus) << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    struct WriteReq
+    {
+        QCDiskQueue::BlockIdx mBlockIdx;
+        int                   mBufferCount;
+        QCDiskQueue::Error    mError;
+        int64_t               mIoByteCount;
+    };
+
+    // Queues the requests behind the held one, and validates completion
+    // status, coalesced request count, and the data written.
+    int RunCoalesceCase(
+        const char*       inNamePtr,
+        QCDiskQueue&      inQueue,
+        QCIoBufferPool&   inBufPool,
+        BlockingObserver& inObserver,
+        const WriteReq*   inReqsPtr,
+        int               inReqCount,
+        int64_t           inExpectedCoalescedCount)
+    {
+        cout << "write coalesce test: " << inNamePtr << endl;
+        int64_t theReqCount   = 0;
+        int64_t theBlockCount = 0;
+        inQueue.GetCoalescedWriteCount(theReqCount, theBlockCount);
+        const int64_t thePrevCount = theReqCount;
+        WriteWaiter   theWaiter;
+        inObserver.Hold();
+        for (int i = 0; i < inReqCount; i++) {
+            if (Write(inQueue, inBufPool, theWaiter,
+                    inReqsPtr[i].mBlockIdx, inReqsPtr[i].mBufferCount)) {
+                inObserver.Release();
+                return 1;
+            }
+            if (i == 0) {
+                inObserver.WaitHeld();
+            }
+        }
+        inObserver.Release();
+        theWaiter.Wait();
+        inQueue.GetCoalescedWriteCount(theReqCount, theBlockCount);
+        if (theReqCount - thePrevCount != inExpectedCoalescedCount) {
+            cerr << inNamePtr << ": coalesced requests: " <<
+                (theReqCount - thePrevCount) <<
+                " expected: " << inExpectedCoalescedCount << endl;
+            return 1;
+        }
+        const int theBufSize = inBufPool.GetBufferSize();
+        for (int i = 0; i < inReqCount; i++) {
+            const WriteReq&           theReq    = inReqsPtr[i];
+            const WriteWaiter::Result theResult =
+                theWaiter.Get(theReq.mBlockIdx);
+            if (theResult.mError != theReq.mError ||
+                    theResult.mIoByteCount != theReq.mIoByteCount) {
+                cerr << inNamePtr << ": block: " << theReq.mBlockIdx <<
+                    " status: " << QCDiskQueue::ToString(theResult.mError) <<
+                    " io bytes: " << theResult.mIoByteCount <<
+                    " expected: " << QCDiskQueue::ToString(theReq.mError) <<
+                    " io bytes: " << theReq.mIoByteCount <<
+                endl;
+                return 1;
+            }
+            const int theBlockCnt = (int)(theResult.mIoByteCount / theBufSize);
+            if (theBlockCnt <= 0) {
+                continue;
+            }
+            Iterator theItr(theBlockCnt, &inBufPool);
+            const QCDiskQueue::CompletionStatus theStatus = inQueue.SyncRead(
+                0, theReq.mBlockIdx, 0, theBlockCnt, &theItr);
+            if (theStatus.IsError()) {
+                cerr << inNamePtr << ": read: " << ToString(theStatus) << endl;
+                return 1;
+            }
+            theItr.Reset();
+            for (int k = 0; k < theBlockCnt; k++) {
+                const char* const thePtr = theItr.Get();
+                const char        theSym = BlockPattern(theReq.mBlockIdx + k);
+                for (int n = 0; n < theBufSize; n++) {
+                    if (thePtr[n] != theSym) {
+                        cerr << inNamePtr << ": data mismatch: block: " <<
+                            (theReq.mBlockIdx + k) << " pos: " << n << endl;
+                        return 1;
+                    }
+                }
+            }
+        }
+        return 0;
+    }
+
+    int DoWriteCoalesceTest(
+        const char* inFileNamePtr)
+    {
+        const int     theBufferSize     = 4 << 10;
+        const int     theReqBufCount    = 4;
+        const int     theFileBlockCount = 128;
+        const int64_t theReqSize        =
+            int64_t(theReqBufCount) * theBufferSize;
+        if (AllocFileSpace(1, &inFileNamePtr,
+                int64_t(theFileBlockCount) * theBufferSize)) {
+            return 1;
+        }
+        QCIoBufferPool theBufPool;
+        int theSysErr = theBufPool.Create(1, 256, theBufferSize, false);
+        if (theSysErr) {
+            cerr << "failed to create buffer pool: " <<
+                QCUtils::SysError(theSysErr) << endl;
+            return 1;
+        }
+        BlockingObserver theObserver;
+        QCDiskQueue      theQueue;
+        // Single io thread, and buffered io, in order to make partial write
+        // with file size limit possible.
+        const int theErrCode = theQueue.Start(
+            1,
+            64,
+            64,
+            1,
+            &inFileNamePtr,
+            theBufPool,
+            &theObserver,
+            QCDiskQueue::CpuAffinity::None(),
+            0,
+            true
+        );
+        if (theErrCode != 0) {
+            cerr << "failed to create disk queue: " <<
+                QCUtils::SysError(theErrCode) << endl;
+            return 1;
+        }
+        const QCDiskQueue::Error kOk  = QCDiskQueue::kErrorNone;
+        const QCDiskQueue::Error kErr = QCDiskQueue::kErrorWrite;
+        theQueue.SetMaxWriteCoalesceCount(8);
+        // The first request is held by the observer, the second is picked by
+        // the io thread, and the rest are coalesced with the second.
+        const WriteReq kAdjacent[] = {
+            {  0, theReqBufCount, kOk, theReqSize },
+            {  4, theReqBufCount, kOk, theReqSize },
+            {  8, theReqBufCount, kOk, theReqSize },
+            { 12, theReqBufCount, kOk, theReqSize }
+        };
+        if (RunCoalesceCase("adjacent", theQueue, theBufPool, theObserver,
+                kAdjacent, 4, 2)) {
+            return 1;
+        }
+        const WriteReq kNonAdjacent[] = {
+            { 16, theReqBufCount, kOk, theReqSize },
+            { 20, theReqBufCount, kOk, theReqSize },
+            { 28, theReqBufCount, kOk, theReqSize },
+            { 24, theReqBufCount, kOk, theReqSize }
+        };
+        if (RunCoalesceCase("non-adjacent", theQueue, theBufPool, theObserver,
+                kNonAdjacent, 4, 0)) {
+            return 1;
+        }
+        theQueue.SetMaxWriteCoalesceCount(2);
+        const WriteReq kMaxCount[] = {
+            { 32, theReqBufCount, kOk, theReqSize },
+            { 36, theReqBufCount, kOk, theReqSize },
+            { 40, theReqBufCount, kOk, theReqSize },
+            { 44, theReqBufCount, kOk, theReqSize }
+        };
+        if (RunCoalesceCase("max-count", theQueue, theBufPool, theObserver,
+                kMaxCount, 4, 1)) {
+            return 1;
+        }
+        theQueue.SetMaxWriteCoalesceCount(8);
+        // Limit file size in the middle of the second coalesced request, in
+        // order to get partial writev(). The bytes written must be attributed
+        // in request order: the first request completes, the second fails
+        // with half of its bytes written, and the third fails with none.
+        struct rlimit thePrevLimit;
+        if (getrlimit(RLIMIT_FSIZE, &thePrevLimit)) {
+            cerr << "getrlimit: " << QCUtils::SysError(errno) << endl;
+            return 1;
+        }
+        struct rlimit theLimit = thePrevLimit;
+        theLimit.rlim_cur = rlim_t(58) * theBufferSize;
+        signal(SIGXFSZ, SIG_IGN);
+        if (setrlimit(RLIMIT_FSIZE, &theLimit)) {
+            cerr << "setrlimit: " << QCUtils::SysError(errno) << endl;
+            return 1;
+        }
+        const WriteReq kErrorSplit[] = {
+            { 48, theReqBufCount, kOk,  theReqSize     },
+            { 52, theReqBufCount, kOk,  theReqSize     },
+            { 56, theReqBufCount, kErr, theReqSize / 2 },
+            { 60, theReqBufCount, kErr, 0              }
+        };
+        const int theRet = RunCoalesceCase("error-split", theQueue, theBufPool,
+            theObserver, kErrorSplit, 4, 2);
+        setrlimit(RLIMIT_FSIZE, &thePrevLimit);
+        signal(SIGXFSZ, SIG_DFL);
+        theQueue.Stop();
+        if (theRet == 0) {
+            cout << "write coalesce test passed" << endl;
+        }
+        return theRet;
+    }
+
     QCDiskQueueTest()
         {}
     ~QCDiskQueueTest()
@@ -437,5 +789,9 @@ main(int argc, char** argv)
     }
 
     QCDiskQueueTest theTest;
-    return theTest.DoTest(argc - 1, (const char**)(argv + 1));
+    const int theRet = theTest.DoTest(argc - 1, (const char**)(argv + 1));
+    if (theRet != 0) {
+        return theRet;
+    }
+    return theTest.DoWriteCoalesceTest(argv[1]);
 }
@@ -113,6 +113,9 @@ extern "C" {
   struct qfs_iter;
 
   // qfs_connect connects to the specified metaserver, returning a QFS handle.
+  // The client configuration is loaded from the file or the properties
+  // specified by QFS_CLIENT_CONFIG_<host>_<port> or QFS_CLIENT_CONFIG
+  // environment variable, if set.
   // On error, this function will return NULL.
   struct QFS* qfs_connect(const char* host, int port);
 
@@ -299,6 +302,74 @@ extern "C" {
   // file position.
   ssize_t qfs_pwrite(struct QFS* qfs, int fd, const void *buf, size_t len, off_t offset);
 
+  // qfs_preadv reads count ranges from fd without updating the file position.
+  // Nearby ranges are coalesced, and the reads are issued in parallel. On
+  // return, the result of each range is set to the number of bytes read, or to
+  // a negative error code. Returns the total number of bytes read, or the first
+  // error code. A range with len larger than the maximum single read size,
+  // about 2GB, is not read, and its result is set to -EINVAL.
+  struct qfs_read_range {
+    off_t   offset;
+    void*   buf;
+    size_t  len;
+    ssize_t result;
+  };
+  ssize_t qfs_preadv(struct QFS* qfs, int fd, struct qfs_read_range* ranges,
+    int count);
+
+  // qfs_aio describes an asynchronous positional read or write request. Any
+  // number of requests, including requests on the same fd, can be in flight.
+  // The request and buf must remain valid, and must not be modified, until the
+  // request completes.
+  enum qfs_aio_op {
+    QFS_AIO_READ  = 0,
+    QFS_AIO_WRITE = 1
+  };
+
+  struct qfs_aio {
+    enum qfs_aio_op op;
+    int             fd;
+    off_t           offset;
+    void*           buf;
+    size_t          len;
+    void*           user_data;
+    // callback, when not NULL, is invoked on completion instead of posting the
+    // request to the completion queue. The callback is invoked from the qfs
+    // client network thread, and must not block or call blocking qfs
+    // functions.
+    void            (*callback)(struct qfs_aio* aio);
+    // result is set on completion to the number of bytes read or written, or
+    // to a negative error code. Write errors are also returned by the
+    // subsequent qfs_sync and qfs_close calls.
+    ssize_t         result;
+  };
+
+  // qfs_aio_queue is an opaque completion queue.
+  struct qfs_aio_queue;
+
+  // qfs_aio_queue_create creates a new completion queue, or returns NULL on
+  // error. The queue must not be released while requests posting to it are
+  // in flight.
+  struct qfs_aio_queue* qfs_aio_queue_create(void);
+  void qfs_aio_queue_release(struct qfs_aio_queue* queue);
+
+  // qfs_aio_queue_fd returns the file descriptor that is readable while the
+  // queue has completed requests, to be used with poll, select, or epoll.
+  int qfs_aio_queue_fd(struct qfs_aio_queue* queue);
+
+  // qfs_aio_submit submits count requests. The requests without callback are
+  // posted to queue on completion, queue can be NULL if all requests have
+  // callbacks. Returns the number of requests submitted, or a negative error
+  // code if none were submitted.
+  int qfs_aio_submit(struct QFS* qfs, struct qfs_aio** aios, int count,
+    struct qfs_aio_queue* queue);
+
+  // qfs_aio_getevents dequeues up to max completed requests, waiting up to
+  // timeout_ms milliseconds for the first completion. Negative timeout_ms
+  // means no time limit. Returns the number of requests dequeued.
+  int qfs_aio_getevents(struct qfs_aio_queue* queue, struct qfs_aio** aios,
+    int max, int timeout_ms);
+
   // qfs_set_skipholes instructs the client to skip holes when reading fd.
   void qfs_set_skipholes(struct QFS* qfs, int fd);
 
@@ -23,6 +23,7 @@
 //----------------------------------------------------------------------------
 
 #include "libclient/KfsClient.h"
+#include "common/Properties.h"
 #include "qfs.h"
 
 #include <vector>
@@ -60,7 +61,14 @@ static int qfs_get_data_locations_inner(struct QFS* qfs,
 struct QFS* qfs_connect(const char* host, int port) {
   struct QFS* qfs = new QFS;
 
-  qfs->client.Init(host, port);
+  // Load the client configuration the same way as KfsClient::Connect().
+  Properties  props;
+  const char* cfg = 0;
+  if (KfsClient::LoadProperties(host, port, 0, props, cfg) != 0) {
+    delete qfs;
+    return NULL;
+  }
+  qfs->client.Init(host, port, (cfg && *cfg) ? &props : 0);
 
   if (!qfs->client.IsInitialized()) {
     delete qfs;
@@ -415,6 +423,119 @@ ssize_t qfs_pwrite(struct QFS* qfs, int fd, const void* buf, size_t len, off_t o
   return qfs->client.PWrite(fd, offset, (char*) buf, len);
 }
 
+ssize_t qfs_preadv(struct QFS* qfs, int fd, struct qfs_read_range* ranges,
+    int count) {
+  if (count < 0 || (count > 0 && !ranges)) {
+    return -EINVAL;
+  }
+  if (count == 0) {
+    return 0;
+  }
+  vector<KfsClient::ReadRange> reqs;
+  reqs.reserve(count);
+  for (int i = 0; i < count; i++) {
+    reqs.push_back(KfsClient::ReadRange(
+      ranges[i].offset, (char*) ranges[i].buf, ranges[i].len));
+  }
+  const ssize_t ret = qfs->client.PReadV(fd, &reqs[0], count);
+  for (int i = 0; i < count; i++) {
+    ranges[i].result = reqs[i].status;
+  }
+  return ret;
+}
+
+struct qfs_aio_queue {
+  KfsClient::AsyncIoQueue queue;
+};
+
+// qfs_aio_req binds c request to the client request, and is deleted on
+// completion, or when the request is dequeued from the completion queue.
+class qfs_aio_req : public KfsClient::AsyncIo {
+public:
+  qfs_aio_req(struct qfs_aio* aio, struct qfs_aio_queue* queue)
+    : KfsClient::AsyncIo(
+        aio->op == QFS_AIO_WRITE ?
+          KfsClient::AsyncIo::kTypeWrite : KfsClient::AsyncIo::kTypeRead,
+        aio->fd, aio->offset, (char*) aio->buf, aio->len, aio),
+      queue(queue) {}
+  struct qfs_aio_queue* const queue;
+};
+
+class qfs_aio_completion : public KfsClient::AsyncIoCompletion {
+public:
+  virtual void Done(KfsClient::AsyncIo& io) {
+    qfs_aio_req* const req = static_cast<qfs_aio_req*>(&io);
+    struct qfs_aio* const aio = (struct qfs_aio*) req->userData;
+    aio->result = io.status;
+    if (aio->callback) {
+      delete req;
+      aio->callback(aio);
+    } else {
+      req->queue->queue.Done(io);
+    }
+  }
+};
+
+static qfs_aio_completion qfs_aio_completion_instance;
+
+struct qfs_aio_queue* qfs_aio_queue_create(void) {
+  struct qfs_aio_queue* const queue = new qfs_aio_queue;
+  if (queue->queue.GetFd() < 0) {
+    delete queue;
+    return NULL;
+  }
+  return queue;
+}
+
+void qfs_aio_queue_release(struct qfs_aio_queue* queue) {
+  delete queue;
+}
+
+int qfs_aio_queue_fd(struct qfs_aio_queue* queue) {
+  return queue->queue.GetFd();
+}
+
+int qfs_aio_submit(struct QFS* qfs, struct qfs_aio** aios, int count,
+    struct qfs_aio_queue* queue) {
+  if (!aios || count < 0) {
+    return -EINVAL;
+  }
+  vector<KfsClient::AsyncIo*> reqs;
+  reqs.reserve(count);
+  for (int i = 0; i < count; i++) {
+    if (!aios[i] || (!aios[i]->callback && !queue)) {
+      break;
+    }
+    reqs.push_back(new qfs_aio_req(aios[i], queue));
+  }
+  if (reqs.empty()) {
+    return count <= 0 ? 0 : -EINVAL;
+  }
+  const int ret = qfs->client.AsyncIoSubmit(
+    &reqs[0], (int) reqs.size(), qfs_aio_completion_instance);
+  if (ret < 0) {
+    for (size_t i = 0; i < reqs.size(); i++) {
+      delete static_cast<qfs_aio_req*>(reqs[i]);
+    }
+  }
+  return ret;
+}
+
+int qfs_aio_getevents(struct qfs_aio_queue* queue, struct qfs_aio** aios,
+    int max, int timeout_ms) {
+  if (!aios || max <= 0) {
+    return 0;
+  }
+  vector<KfsClient::AsyncIo*> ios(max);
+  const int count = queue->queue.Get(&ios[0], max, timeout_ms);
+  for (int i = 0; i < count; i++) {
+    qfs_aio_req* const req = static_cast<qfs_aio_req*>(ios[i]);
+    aios[i] = (struct qfs_aio*) req->userData;
+    delete req;
+  }
+  return count;
+}
+
 void qfs_set_skipholes(struct QFS* qfs, int fd) {
   qfs->client.SkipHolesInFile(fd);
 }
@@ -23,10 +23,14 @@
 //----------------------------------------------------------------------------
 
 #include <stdio.h>
+#include <errno.h>
 #include <stdarg.h>
 #include <stdint.h>
 #include <string.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #include "qfs.h"
 
@@ -325,6 +329,380 @@ static char* test_qfs_pread() {
   return 0;
 }
 
+// Returns the byte written by test_large_write at offset: the byte sequence in
+// the first chunk, and the same sequence xor 0xA in the second chunk.
+static char large_write_byte(off_t offset, off_t chunksize) {
+  const char v = (char)(offset % chunksize);
+  return offset < chunksize ? v : (char)(v ^ (char)0xA);
+}
+
+// Returns the index of the first byte that does not match test_large_write
+// data, or -1 if all match.
+static ssize_t check_large_write_data(const char* buf, size_t len,
+    off_t offset, off_t chunksize) {
+  size_t i;
+  for(i = 0; i < len; i++) {
+    if(buf[i] != large_write_byte(offset + (off_t)i, chunksize)) {
+      return (ssize_t)i;
+    }
+  }
+  return -1;
+}
+
+static char* test_qfs_preadv() {
+  ssize_t chunksize = qfs_get_chunksize(qfs, "/unit-test/file");
+  static char buf[4][4096];
+  struct qfs_read_range ranges[4];
+  ssize_t res;
+  ssize_t pos;
+  int i;
+
+  memset(buf, 0, sizeof(buf));
+  memset(ranges, 0, sizeof(ranges));
+  // Two nearby ranges to be coalesced, one range that spans the first and
+  // second chunks, and a short read at the end of file.
+  ranges[0].offset = 1000;
+  ranges[0].len    = 3000;
+  ranges[1].offset = 5000;
+  ranges[1].len    = 100;
+  ranges[2].offset = chunksize - 2048;
+  ranges[2].len    = 4096;
+  ranges[3].offset = chunksize * 2;
+  ranges[3].len    = 4096;
+  for(i = 0; i < 4; i++) {
+    ranges[i].buf    = buf[i];
+    ranges[i].result = -1;
+  }
+  check_qfs_call(res = qfs_preadv(qfs, fd, ranges, 4));
+  check(res == (ssize_t)(3000 + 100 + 4096 + strlen(testdata)),
+    "unexpected total read length: %ld", (long)res);
+  for(i = 0; i < 3; i++) {
+    check(ranges[i].result == (ssize_t)ranges[i].len,
+      "range %d: unexpected result: %ld != %ld",
+      i, (long)ranges[i].result, (long)ranges[i].len);
+    pos = check_large_write_data(
+      buf[i], ranges[i].len, ranges[i].offset, chunksize);
+    check(pos < 0, "range %d: data mismatch at %ld", i, (long)pos);
+  }
+  check(ranges[3].result == (ssize_t)strlen(testdata),
+    "short read: unexpected result: %ld", (long)ranges[3].result);
+  check(strcmp(buf[3], testdata) == 0,
+    "expected data should be read: %s != %s", buf[3], testdata);
+
+  // A range larger than the maximum read size fails, and the other ranges
+  // are still read.
+  ranges[1].len = ((size_t)1 << 31) + 4096;
+  for(i = 0; i < 2; i++) {
+    ranges[i].result = -1;
+  }
+  res = qfs_preadv(qfs, fd, ranges, 2);
+  check(res == -EINVAL, "oversized range should fail: %ld", (long)res);
+  check(ranges[1].result == -EINVAL,
+    "oversized range: unexpected result: %ld", (long)ranges[1].result);
+  check(ranges[0].result == (ssize_t)ranges[0].len,
+    "range 0: unexpected result: %ld", (long)ranges[0].result);
+
+  // File position must not change.
+  check_qfs_call(res = qfs_tell(qfs, fd));
+  check(res == 0, "file position should be at start");
+
+  return 0;
+}
+
+static int aio_callback_count;
+
+static void aio_callback(struct qfs_aio* aio) {
+  // Invoked from the client network thread.
+  __sync_fetch_and_add((int*)aio->user_data, 1);
+}
+
+static char* test_qfs_aio_read() {
+  ssize_t chunksize = qfs_get_chunksize(qfs, "/unit-test/file");
+  static char buf[3][4096];
+  struct qfs_aio aio[3];
+  struct qfs_aio* aios[3];
+  struct qfs_aio_queue* queue;
+  struct pollfd pfd;
+  ssize_t pos;
+  int done = 0;
+  int res;
+  int i;
+
+  check((queue = qfs_aio_queue_create()) != NULL,
+    "completion queue should be created");
+  memset(buf, 0, sizeof(buf));
+  memset(aio, 0, sizeof(aio));
+  aio[0].offset = 0;
+  aio[1].offset = chunksize + 100;
+  aio[2].offset = chunksize * 2;
+  aio[2].callback  = aio_callback;
+  aio[2].user_data = &aio_callback_count;
+  for(i = 0; i < 3; i++) {
+    aio[i].op     = QFS_AIO_READ;
+    aio[i].fd     = fd;
+    aio[i].buf    = buf[i];
+    aio[i].len    = sizeof(buf[i]);
+    aio[i].result = -1;
+    aios[i]       = &aio[i];
+  }
+  check_qfs_call(res = qfs_aio_submit(qfs, aios, 3, queue));
+  check(res == 3, "all requests should be submitted: %d", res);
+
+  // The first two requests are posted to the queue.
+  while(done < 2) {
+    pfd.fd      = qfs_aio_queue_fd(queue);
+    pfd.events  = POLLIN;
+    pfd.revents = 0;
+    check(poll(&pfd, 1, 60 * 1000) == 1,
+      "completion queue fd should become readable");
+    res = qfs_aio_getevents(queue, aios + done, 2 - done, 0);
+    check(0 < res, "completed requests should be dequeued: %d", res);
+    done += res;
+  }
+  check(qfs_aio_getevents(queue, aios, 3, 0) == 0,
+    "no other requests should be queued");
+  for(i = 0; i < 100 * 60 &&
+      __sync_fetch_and_add(&aio_callback_count, 0) < 1; i++) {
+    usleep(10 * 1000);
+  }
+  check(aio_callback_count == 1,
+    "callback should be invoked once: %d", aio_callback_count);
+  qfs_aio_queue_release(queue);
+
+  for(i = 0; i < 2; i++) {
+    check(aio[i].result == (ssize_t)aio[i].len,
+      "request %d: unexpected result: %ld", i, (long)aio[i].result);
+    pos = check_large_write_data(
+      buf[i], aio[i].len, aio[i].offset, chunksize);
+    check(pos < 0, "request %d: data mismatch at %ld", i, (long)pos);
+  }
+  check(aio[2].result == (ssize_t)strlen(testdata),
+    "short read: unexpected result: %ld", (long)aio[2].result);
+  check(strcmp(buf[2], testdata) == 0,
+    "expected data should be read: %s != %s", buf[2], testdata);
+
+  return 0;
+}
+
+#define QFS_TEST_FD_THREADS    8
+#define QFS_TEST_FD_ITERATIONS 200
+
+struct fd_thread_arg {
+  off_t chunksize;
+  int   index;
+  int   failures;
+  int   error;
+};
+
+// Opens, reads, and closes the test file in a loop. The threads share the
+// client, and run the file descriptor table lookups concurrently with the
+// other threads' open and close.
+static void* fd_thread(void* ptr) {
+  struct fd_thread_arg* const arg = (struct fd_thread_arg*)ptr;
+  char buf[512];
+  off_t offset;
+  ssize_t res;
+  int rfd;
+  int i;
+
+  for(i = 0; i < QFS_TEST_FD_ITERATIONS; i++) {
+    offset = ((off_t)arg->index * 4099 + (off_t)i * 8191) %
+      (arg->chunksize * 2 - (off_t)sizeof(buf));
+    if((rfd = qfs_open(qfs, "/unit-test/file")) < 0) {
+      arg->error = rfd;
+      arg->failures++;
+      continue;
+    }
+    res = qfs_pread(qfs, rfd, buf, sizeof(buf), offset);
+    if(res != (ssize_t)sizeof(buf) ||
+        0 <= check_large_write_data(buf, sizeof(buf), offset, arg->chunksize)) {
+      arg->error = res < 0 ? (int)res : -EIO;
+      arg->failures++;
+    }
+    if((res = qfs_close(qfs, rfd)) < 0) {
+      arg->error = (int)res;
+      arg->failures++;
+    }
+  }
+  return 0;
+}
+
+static char* test_concurrent_open_read_close() {
+  pthread_t threads[QFS_TEST_FD_THREADS];
+  struct fd_thread_arg args[QFS_TEST_FD_THREADS];
+  char msg[128];
+  int i;
+
+  memset(args, 0, sizeof(args));
+  for(i = 0; i < QFS_TEST_FD_THREADS; i++) {
+    args[i].chunksize = qfs_get_chunksize(qfs, "/unit-test/file");
+    args[i].index     = i;
+    check(pthread_create(&threads[i], NULL, fd_thread, &args[i]) == 0,
+      "thread %d should be created", i);
+  }
+  for(i = 0; i < QFS_TEST_FD_THREADS; i++) {
+    check(pthread_join(threads[i], NULL) == 0,
+      "thread %d should be joined", i);
+  }
+  for(i = 0; i < QFS_TEST_FD_THREADS; i++) {
+    check(args[i].failures == 0, "thread %d: %d failures, last: %s",
+      i, args[i].failures, qfs_strerror(args[i].error, msg, sizeof(msg)));
+  }
+
+  return 0;
+}
+
+#define QFS_TEST_AIO_FILE "/unit-test/aio-file"
+
+static char* test_qfs_aio_write() {
+  static char wbuf[2][4096];
+  static char rbuf[2 * 4096];
+  struct qfs_aio aio[2];
+  struct qfs_aio* aios[2];
+  struct qfs_aio_queue* queue;
+  int wfd;
+  int done = 0;
+  int res;
+  int i;
+
+  check_qfs_call(wfd = qfs_create(qfs, QFS_TEST_AIO_FILE));
+  check((queue = qfs_aio_queue_create()) != NULL,
+    "completion queue should be created");
+  memset(aio, 0, sizeof(aio));
+  for(i = 0; i < 2; i++) {
+    memset(wbuf[i], 'a' + i, sizeof(wbuf[i]));
+    // Submit the second half first.
+    aio[i].op     = QFS_AIO_WRITE;
+    aio[i].fd     = wfd;
+    aio[i].offset = (off_t)(1 - i) * sizeof(wbuf[i]);
+    aio[i].buf    = wbuf[1 - i];
+    aio[i].len    = sizeof(wbuf[i]);
+    aio[i].result = -1;
+    aios[i]       = &aio[i];
+  }
+  check_qfs_call(res = qfs_aio_submit(qfs, aios, 2, queue));
+  check(res == 2, "all requests should be submitted: %d", res);
+  while(done < 2) {
+    res = qfs_aio_getevents(queue, aios + done, 2 - done, 60 * 1000);
+    check(0 < res, "completed requests should be dequeued: %d", res);
+    done += res;
+  }
+  qfs_aio_queue_release(queue);
+  for(i = 0; i < 2; i++) {
+    check(aio[i].result == (ssize_t)aio[i].len,
+      "request %d: unexpected result: %ld", i, (long)aio[i].result);
+  }
+  // The completed writes extend the file size seen through the fd.
+  check_qfs_call(res = (int)qfs_seek(qfs, wfd, 0, SEEK_END));
+  check(res == (int)sizeof(rbuf), "unexpected file size: %d", res);
+  check_qfs_call(qfs_seek(qfs, wfd, 0, SEEK_SET));
+  check_qfs_call(qfs_close(qfs, wfd));
+
+  check_qfs_call(wfd = qfs_open(qfs, QFS_TEST_AIO_FILE));
+  memset(rbuf, 0, sizeof(rbuf));
+  check_qfs_call(res = qfs_pread(qfs, wfd, rbuf, sizeof(rbuf), 0));
+  check(res == (int)sizeof(rbuf), "unexpected read length: %d", res);
+  check(memcmp(rbuf, wbuf[0], sizeof(wbuf[0])) == 0 &&
+    memcmp(rbuf + sizeof(wbuf[0]), wbuf[1], sizeof(wbuf[1])) == 0,
+    "written data should be read");
+  check_qfs_call(qfs_close(qfs, wfd));
+
+  return 0;
+}
+
+// With the client block cache enabled (client.blockCacheSize), the re-read
+// after the write must not return the cached blocks.
+static char* test_block_cache_invalidation() {
+  static char rbuf[4096];
+  static char wbuf[4096];
+  int rfd;
+  int wfd;
+  int res;
+  int i;
+
+  check_qfs_call(rfd = qfs_open(qfs, QFS_TEST_AIO_FILE));
+  // Read twice, to have the blocks cached and referenced more than once.
+  for(i = 0; i < 2; i++) {
+    memset(rbuf, 0, sizeof(rbuf));
+    check_qfs_call(res = qfs_pread(qfs, rfd, rbuf, sizeof(rbuf), 0));
+    check(res == (int)sizeof(rbuf) && rbuf[0] == 'a' &&
+      rbuf[sizeof(rbuf) - 1] == 'a', "unexpected data: %d", res);
+  }
+  check_qfs_call(qfs_close(qfs, rfd));
+
+  check_qfs_call(wfd = qfs_open_file(qfs, QFS_TEST_AIO_FILE, O_RDWR, 0, ""));
+  memset(wbuf, 'c', sizeof(wbuf));
+  check_qfs_call(qfs_pwrite(qfs, wfd, wbuf, sizeof(wbuf), 0));
+  check_qfs_call(qfs_close(qfs, wfd));
+
+  check_qfs_call(rfd = qfs_open(qfs, QFS_TEST_AIO_FILE));
+  memset(rbuf, 0, sizeof(rbuf));
+  check_qfs_call(res = qfs_pread(qfs, rfd, rbuf, sizeof(rbuf), 0));
+  check(res == (int)sizeof(rbuf) && memcmp(rbuf, wbuf, sizeof(wbuf)) == 0,
+    "re-read should return the written data: %d %c", res, rbuf[0]);
+  check_qfs_call(qfs_close(qfs, rfd));
+
+  return 0;
+}
+
+#define QFS_TEST_LEASE_FILE "/unit-test/lease-file"
+#define QFS_TEST_LEASE_DIR  "/unit-test/lease-dir"
+
+static char* test_meta_cache_lease() {
+  // The meta server lease time, the test runs only if the meta server and
+  // the client have the meta data cache leases enabled.
+  const char* const lease_env = getenv("QFS_TEST_META_CACHE_LEASE_SEC");
+  const int lease_sec = lease_env ? atoi(lease_env) : 0;
+  struct QFS* other;
+  struct qfs_attr attr;
+  int lfd;
+
+  if(lease_sec <= 0) {
+    return 0;
+  }
+  check_qfs_call(lfd = qfs_create(qfs, QFS_TEST_LEASE_FILE));
+  check_qfs_call(qfs_close(qfs, lfd));
+  check_qfs_call(qfs_chmod(qfs, QFS_TEST_LEASE_FILE, 0644));
+  other = qfs_connect(metaserver_host, metaserver_port);
+  check(other, "other client should be non null");
+
+  // Grant: the attributes are served from the cache within the lease time,
+  // the other client's change is not visible yet.
+  check_qfs_call(qfs_stat(qfs, QFS_TEST_LEASE_FILE, &attr));
+  check(attr.mode == 0644, "mode should be 644: %o", attr.mode);
+  check_qfs_call(qfs_chmod(other, QFS_TEST_LEASE_FILE, 0600));
+  check_qfs_call(qfs_stat(qfs, QFS_TEST_LEASE_FILE, &attr));
+  check(attr.mode == 0644,
+    "cached mode should be 644 within the lease time: %o", attr.mode);
+
+  // Invalidation: the next meta server response carries the ids changed by
+  // the other client.
+  check_qfs_call(qfs_mkdir(qfs, QFS_TEST_LEASE_DIR, 0755));
+  check_qfs_call(qfs_stat(qfs, QFS_TEST_LEASE_FILE, &attr));
+  check(attr.mode == 0600,
+    "mode should be 600 after invalidation: %o", attr.mode);
+
+  // Expiry: without meta server requests, the attributes are re-validated
+  // once the lease expires.
+  check_qfs_call(qfs_chmod(other, QFS_TEST_LEASE_FILE, 0640));
+  check_qfs_call(qfs_stat(qfs, QFS_TEST_LEASE_FILE, &attr));
+  check(attr.mode == 0600,
+    "cached mode should be 600 within the lease time: %o", attr.mode);
+  sleep(lease_sec + 1);
+  check_qfs_call(qfs_stat(qfs, QFS_TEST_LEASE_FILE, &attr));
+  check(attr.mode == 0640,
+    "mode should be 640 after lease expiry: %o", attr.mode);
+
+  // Renew: the re-validated attributes are cached for the new lease time.
+  check_qfs_call(qfs_chmod(other, QFS_TEST_LEASE_FILE, 0604));
+  check_qfs_call(qfs_stat(qfs, QFS_TEST_LEASE_FILE, &attr));
+  check(attr.mode == 0640,
+    "cached mode should be 640 within the renewed lease: %o", attr.mode);
+
+  qfs_release(other);
+  return 0;
+}
+
 static char* test_qfs_get_data_locations() {
   check_qfs_call(qfs_close(qfs, fd)); // shut it down
   struct qfs_iter* iter = NULL;
@@ -426,7 +804,13 @@ static char * all_tests() {
   run(test_qfs_close);
   run(test_qfs_open);
   run(test_qfs_pread);
+  run(test_qfs_preadv);
+  run(test_qfs_aio_read);
+  run(test_concurrent_open_read_close);
   run(test_qfs_get_data_locations);
+  run(test_qfs_aio_write);
+  run(test_block_cache_invalidation);
+  run(test_meta_cache_lease);
   run(test_qfs_cleanup);
   run(test_qfs_release);
   return 0;
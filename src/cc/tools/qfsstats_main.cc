@@ -33,6 +33,8 @@
 #include <iostream>
 #include <string>
 
+#include <string.h>
+
 
 using namespace KFS;
 using namespace KFS_MON;
@@ -59,6 +61,9 @@ BasicStatsChunkServer(MonClient& client, int numSecs);
 static int
 RpcStatsChunkServer(MonClient& client, int numSecs);
 
+static void
+PrintLatencyStats(const Properties& prop);
+
 static void
 PrintChunkBasicStatsHeader();
 
@@ -166,6 +171,22 @@ PrintRpcStat(const string &statName, Properties &prop)
     cout << statName << " = " << prop.getValue(statName, "0") << "\n";
 }
 
+static void
+PrintLatencyStats(const Properties& prop)
+{
+    // Latency histograms: count,p50,p90,p99,p99.9,max
+    // The empty histograms are not reported by the server.
+    const char* const prefix    = "Latency ";
+    const size_t      prefixLen = strlen(prefix);
+    for (Properties::iterator it = prop.begin(); it != prop.end(); ++it) {
+        if (prefixLen <= it->first.GetSize() &&
+                memcmp(it->first.GetPtr(), prefix, prefixLen) == 0) {
+            cout << it->first.GetPtr() << " = " << it->second.GetPtr() <<
+                "\n";
+        }
+    }
+}
+
 
 int
 StatsMetaServer(MonClient& client, bool rpcStats, int numSecs)
@@ -217,6 +238,7 @@ RpcStatsMetaServer(MonClient& client, int numSecs)
         PrintRpcStat("Number of Chunks", op.stats);
         PrintRpcStat("Number of Hits in Path->Fid Cache", op.stats);
         PrintRpcStat("Number of Misses in Path->Fid Cache", op.stats);
+        PrintLatencyStats(op.stats);
 
         cout << "----------------------------------" << "\n";
         if (numSecs == 0) {
@@ -306,6 +328,7 @@ RpcStatsChunkServer(MonClient& client, int numSecs)
         PrintRpcStat("Heartbeat", op.stats);
         PrintRpcStat("Change Chunk Vers", op.stats);
         PrintRpcStat("Num ops", op.stats);
+        PrintLatencyStats(op.stats);
         cout << "----------------------------------" << "\n";
         if (numSecs == 0) {
             break;
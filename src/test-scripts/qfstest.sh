@@ -222,6 +222,7 @@ minrequreddiskspacefanoutsort=${minrequreddiskspacefanoutsort-11e9}
 lowrequreddiskspace=${lowrequreddiskspace-20e9}
 lowrequreddiskspacefanoutsort=${lowrequreddiskspacefanoutsort-30e9}
 csheartbeatinterval=${csheartbeatinterval-5}
+metacacheleasesec=${metacacheleasesec-5}
 cptestextraopts=${cptestextraopts-}
 mkcerts=`dirname "$0"`
 mkcerts="`cd "$mkcerts" && pwd`/qfsmkcerts.sh"
@@ -617,6 +618,7 @@ metaServer.maxSpaceUtilizationThreshold = 0.99999
 metaServer.clientCSAllowClearText = $csallowcleartext
 metaServer.appendPlacementIgnoreMasterSlave = 1
 metaServer.clientThreadCount = $metaserverclithreads
+metaServer.clientMetaCacheLeaseSec = $metacacheleasesec
 metaServer.startupAbortOnPanic = 1
 metaServer.objectStoreEnabled  = 1
 metaServer.objectStoreDeleteDelay = 2
@@ -1167,8 +1169,22 @@ cppid=$!
 echo "$cppid" > "$cppidf"
 
 qfscpidf="qfsctest${pidsuf}"
+# Run with block cache enabled, to test cache invalidation on write, and
+# with meta data cache leases enabled.
+clientpropqfsc="$clientprop.qfsc.prp"
+if [ -f "$clientprop" ]; then
+    cp "$clientprop" "$clientpropqfsc" || exit
+else
+    cp /dev/null "$clientpropqfsc" || exit
+fi
+cat >> "$clientpropqfsc" << EOF
+client.blockCacheSize = 8388608
+client.metaCacheLease = 1
+EOF
 cp /dev/null test-qfsc.out
 QFS_CLIENT_LOG_LEVEL=DEBUG \
+QFS_TEST_META_CACHE_LEASE_SEC=$metacacheleasesec \
+QFS_CLIENT_CONFIG="FILE:${clientpropqfsc}" \
     test-qfsc "$metahost:$metasrvport" 1>>test-qfsc.out 2>test-qfsc.log &
 qfscpid=$!
 echo "$qfscpid" > "$qfscpidf"